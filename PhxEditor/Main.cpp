@@ -14,6 +14,8 @@
 #include "EmberGfx/phxShaderCompiler.h"
 #include "phxCommandLineArgs.h"
 
+#include "phxCompressedFileSystem.h"
+#include "phxMemory.h"
 #include "phxVFS.h"
 #include "phxSystemTime.h"
 
@@ -91,11 +93,17 @@ public:
 		std::filesystem::path assetsPath = projectDirPath / "assets";
 		std::filesystem::path assetsCachePath = projectDirPath / "assets/.cache";
 
-		m_fs->Mount("/native", phx::FileSystemFactory::CreateNativeFileSystem());
+		std::shared_ptr<phx::IFileSystem> nativeFs = phx::FileSystemFactory::CreateNativeFileSystem(phx::Memory::GetHeapIfInitialized());
+		m_fs->Mount("/native", nativeFs);
 		m_fs->Mount("/shaders", applicationShaderPath);
 		m_fs->Mount("/shaders_engine", frameworkShaderPath);
 		m_fs->Mount("/assets", assetsPath);
-		m_fs->Mount("/assets_cache", assetsCachePath);
+
+		// Cached artifacts are compressed, uncompressed ones already there are still read as is.
+		const phx::Codec::Type cacheCodec = phx::Codec::IsAvailable(phx::Codec::Type::Zstd) ? phx::Codec::Type::Zstd : phx::Codec::Type::Lz4;
+		m_fs->Mount("/assets_cache", std::make_shared<phx::CompressedFileSystem>(
+			phx::FileSystemFactory::CreateRelativeFileSystem(nativeFs, assetsCachePath),
+			cacheCodec));
 
 		// Try to load asset
 		phx::gfx::GpuDevice* device = phx::gfx::EmberGfx::GetDevice();
@@ -4,6 +4,7 @@
 #include "phxD3D12GpuDevice.h"
 #include "phxGfxCommonD3D12.h"
 
+using namespace phx;
 using namespace phx::gfx;
 
 using namespace phx::gfx::platform;
@@ -347,7 +348,7 @@ void phx::gfx::platform::CommandCtxD3D12::WriteTexture(TextureHandle texture, ui
             IID_PPV_ARGS(&intermediateResource)));
 
 
-    std::vector<D3D12_SUBRESOURCE_DATA> subresources(numSubresources);
+    D3D12_SUBRESOURCE_DATA* subresources = Memory::GetFrameRingAllocator().AllocArray<D3D12_SUBRESOURCE_DATA>(numSubresources);
     for (int i = 0; i < numSubresources; ++i)
     {
         auto& subresource = subresources[i];
@@ -362,8 +363,8 @@ void phx::gfx::platform::CommandCtxD3D12::WriteTexture(TextureHandle texture, ui
         intermediateResource.Get(),
         0,
         firstSubresource,
-        subresources.size(),
-        subresources.data());
+        numSubresources,
+        subresources);
 
     D3D12GpuDevice::Instance()->DeleteResource(intermediateResource);
 }
@@ -371,7 +372,7 @@ void phx::gfx::platform::CommandCtxD3D12::WriteTexture(TextureHandle texture, ui
 
 void  phx::gfx::platform::CommandCtxD3D12::SetRenderTargets(Span<TextureHandle> renderTargets, TextureHandle depthStencil)
 {
-    std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> renderTargetViews(renderTargets.Size());
+    D3D12_CPU_DESCRIPTOR_HANDLE* renderTargetViews = Memory::GetFrameRingAllocator().AllocArray<D3D12_CPU_DESCRIPTOR_HANDLE>(renderTargets.Size());
     for (int i = 0; i < renderTargets.Size(); i++)
     {
         auto textureImpl = D3D12GpuDevice::Instance()->GetRegistry().Textures.Get(renderTargets[i]);
@@ -387,8 +388,8 @@ void  phx::gfx::platform::CommandCtxD3D12::SetRenderTargets(Span<TextureHandle>
     }
 
     this->m_commandList->OMSetRenderTargets(
-        renderTargetViews.size(),
-        renderTargetViews.data(),
+        renderTargets.Size(),
+        renderTargetViews,
         hasDepth,
         hasDepth ? &depthView : nullptr);
 }
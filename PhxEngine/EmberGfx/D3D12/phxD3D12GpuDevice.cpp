@@ -717,6 +717,12 @@ phx::gfx::D3D12GpuDevice::~D3D12GpuDevice()
 void phx::gfx::D3D12GpuDevice::Initialize(SwapChainDesc const& swapChainDesc, bool enableValidation, void* windowHandle)
 {
 	m_enableDebugLayers = enableValidation;
+	m_bindlessRetireType = m_retirementQueue.RegisterBatchType(
+		[this](Span<uint64_t> indices)
+		{
+			m_bindlessDescritorTable.Free(indices);
+		});
+
 	Initialize();
 	InitializeResourcePools();
 	CreateSwapChain(swapChainDesc, static_cast<HWND>(windowHandle));
@@ -729,6 +735,7 @@ void phx::gfx::D3D12GpuDevice::Initialize(SwapChainDesc const& swapChainDesc, bo
 void phx::gfx::D3D12GpuDevice::Finalize()
 {
 	WaitForIdle();
+	RunGarbageCollection();
 
 	m_swapChain.Rtv.Free();
 	for (auto& backBuffer : m_swapChain.BackBuffers)
@@ -785,7 +792,15 @@ void phx::gfx::D3D12GpuDevice::SubmitFrame()
 	SubmitCommandLists();
 	Present();
 	PollDebugMessages();
-	RunGarbageCollection();
+
+	// Present has waited on the frame fences, so everything older than the frames in flight is done.
+	if (m_frameCount > kBufferCount)
+	{
+		RunGarbageCollection(m_frameCount - kBufferCount - 1);
+	}
+
+	// Recording data stays in the previous region if its frame is somehow still in flight.
+	std::ignore = Memory::GetFrameRingAllocator().BeginFrame(m_frameCount, m_frameCount > kBufferCount ? m_frameCount - kBufferCount : 0);
 }
 
 DynamicMemoryPage phx::gfx::D3D12GpuDevice::AllocateDynamicMemoryPage(size_t pageSize)
@@ -1065,16 +1080,12 @@ PipelineStateHandle phx::gfx::D3D12GpuDevice::CreatePipeline(PipelineStateDesc2
 
 void phx::gfx::D3D12GpuDevice::DeletePipeline(PipelineStateHandle handle)
 {
-	DeferredItem d =
-	{
+	m_retirementQueue.Retire(
 		m_frameCount,
-		[=]()
+		[this, handle]()
 		{
 			m_pipelineStatePool.Release(handle);
-		}
-	};
-
-	m_deferredQueue.push_back(d);
+		});
 }
 
 GfxPipelineHandle phx::gfx::D3D12GpuDevice::CreateGfxPipeline(GfxPipelineDesc const& desc)
@@ -1084,16 +1095,12 @@ GfxPipelineHandle phx::gfx::D3D12GpuDevice::CreateGfxPipeline(GfxPipelineDesc co
 
 void phx::gfx::D3D12GpuDevice::DeleteResource(GfxPipelineHandle handle)
 {
-	DeferredItem d =
-	{
+	m_retirementQueue.Retire(
 		m_frameCount,
-		[=]()
+		[this, handle]()
 		{
 			m_resourceRegistry.GfxPipelines.Release(handle);
-		}
-	};
-
-	m_deferredQueue.push_back(d);
+		});
 }
 
 TextureHandle phx::gfx::D3D12GpuDevice::CreateTexture(TextureDesc const& desc, SubresourceData* initialData)
@@ -1207,6 +1214,7 @@ TextureHandle phx::gfx::D3D12GpuDevice::CreateTexture(TextureDesc const& desc, S
 	textureImpl.D3D12Resource->SetName(debugName.c_str());
 
 	TextureHandle textureHandle = m_resourceRegistry.Textures.Emplace(textureImpl);
+	m_resourceRegistry.Textures.GetCold(textureHandle)->DebugName = desc.DebugName;
 
 	if (initialData)
 	{
@@ -1324,6 +1332,7 @@ int phx::gfx::D3D12GpuDevice::CreateSubresource(BufferHandle buffer, BufferDesc
 int phx::gfx::D3D12GpuDevice::CreateShaderResourceView(BufferHandle buffer, BufferDesc const& desc, size_t offset, size_t size)
 {
 	D3D12Buffer* bufferImpl = m_resourceRegistry.Buffers.Get(buffer);
+	D3D12BufferCold* bufferCold = m_resourceRegistry.Buffers.GetCold(buffer);
 
 	D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
 	srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
@@ -1391,13 +1400,14 @@ int phx::gfx::D3D12GpuDevice::CreateShaderResourceView(BufferHandle buffer, Buff
 		return -1;
 	}
 
-	bufferImpl->SrvSubresourcesAlloc.push_back(view);
-	return bufferImpl->SrvSubresourcesAlloc.size() - 1;
+	bufferCold->SrvSubresourcesAlloc.push_back(view);
+	return bufferCold->SrvSubresourcesAlloc.size() - 1;
 }
 
 int phx::gfx::D3D12GpuDevice::CreateUnorderedAccessView(BufferHandle buffer, BufferDesc const& desc, size_t offset, size_t size)
 {
-	D3D12Buffer* bufferImpl = m_resourceRegistry.Buffers.Get(buffer);;
+	D3D12Buffer* bufferImpl = m_resourceRegistry.Buffers.Get(buffer);
+	D3D12BufferCold* bufferCold = m_resourceRegistry.Buffers.GetCold(buffer);
 
 	D3D12_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
 	uavDesc.ViewDimension = D3D12_UAV_DIMENSION_BUFFER;
@@ -1486,14 +1496,15 @@ int phx::gfx::D3D12GpuDevice::CreateUnorderedAccessView(BufferHandle buffer, Buf
 		return -1;
 	}
 
-	bufferImpl->UavSubresourcesAlloc.push_back(view);
-	return bufferImpl->UavSubresourcesAlloc.size() - 1;
+	bufferCold->UavSubresourcesAlloc.push_back(view);
+	return bufferCold->UavSubresourcesAlloc.size() - 1;
 }
 
 int phx::gfx::D3D12GpuDevice::CreateShaderResourceView(TextureHandle texture, TextureDesc const& desc, uint32_t firstSlice, uint32_t sliceCount, uint32_t firstMip, uint32_t mipCount)
 {
 	// TODO: Make use of parameters.
 	D3D12Texture* textureImpl = m_resourceRegistry.Textures.Get(texture);
+	D3D12TextureCold* textureCold = m_resourceRegistry.Textures.GetCold(texture);
 
 	auto dxgiFormatMapping = GetDxgiFormatMapping(desc.Format);
 	D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
@@ -1605,13 +1616,14 @@ int phx::gfx::D3D12GpuDevice::CreateShaderResourceView(TextureHandle texture, Te
 		return -1;
 	}
 
-	textureImpl->SrvSubresourcesAlloc.push_back(view);
-	return textureImpl->SrvSubresourcesAlloc.size() - 1;
+	textureCold->SrvSubresourcesAlloc.push_back(view);
+	return textureCold->SrvSubresourcesAlloc.size() - 1;
 }
 
 int phx::gfx::D3D12GpuDevice::CreateRenderTargetView(TextureHandle texture, TextureDesc const& desc, uint32_t firstSlice, uint32_t sliceCount, uint32_t firstMip, uint32_t mipCount)
 {
 	D3D12Texture* textureImpl = m_resourceRegistry.Textures.Get(texture);
+	D3D12TextureCold* textureCold = m_resourceRegistry.Textures.GetCold(texture);
 
 	auto dxgiFormatMapping = GetDxgiFormatMapping(desc.Format);
 	D3D12_RENDER_TARGET_VIEW_DESC rtvDesc = {};
@@ -1681,13 +1693,14 @@ int phx::gfx::D3D12GpuDevice::CreateRenderTargetView(TextureHandle texture, Text
 		return -1;
 	}
 
-	textureImpl->RtvSubresourcesAlloc.push_back(view);
-	return textureImpl->RtvSubresourcesAlloc.size() - 1;
+	textureCold->RtvSubresourcesAlloc.push_back(view);
+	return textureCold->RtvSubresourcesAlloc.size() - 1;
 }
 
 int phx::gfx::D3D12GpuDevice::CreateDepthStencilView(TextureHandle texture, TextureDesc const& desc, uint32_t firstSlice, uint32_t sliceCount, uint32_t firstMip, uint32_t mipCount)
 {
 	D3D12Texture* textureImpl = m_resourceRegistry.Textures.Get(texture);
+	D3D12TextureCold* textureCold = m_resourceRegistry.Textures.GetCold(texture);
 
 	auto dxgiFormatMapping = GetDxgiFormatMapping(desc.Format);
 	D3D12_DEPTH_STENCIL_VIEW_DESC dsvDesc = {};
@@ -1756,13 +1769,14 @@ int phx::gfx::D3D12GpuDevice::CreateDepthStencilView(TextureHandle texture, Text
 		return -1;
 	}
 
-	textureImpl->DsvSubresourcesAlloc.push_back(view);
-	return textureImpl->DsvSubresourcesAlloc.size() - 1;
+	textureCold->DsvSubresourcesAlloc.push_back(view);
+	return textureCold->DsvSubresourcesAlloc.size() - 1;
 }
 
 int phx::gfx::D3D12GpuDevice::CreateUnorderedAccessView(TextureHandle texture, TextureDesc const& desc, uint32_t firstSlice, uint32_t sliceCount, uint32_t firstMip, uint32_t mipCount)
 {
 	D3D12Texture* textureImpl = m_resourceRegistry.Textures.Get(texture);
+	D3D12TextureCold* textureCold = m_resourceRegistry.Textures.GetCold(texture);
 
 	auto dxgiFormatMapping = GetDxgiFormatMapping(desc.Format);
 	D3D12_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
@@ -1844,42 +1858,51 @@ int phx::gfx::D3D12GpuDevice::CreateUnorderedAccessView(TextureHandle texture, T
 		return -1;
 	}
 
-	textureImpl->UavSubresourcesAlloc.push_back(view);
-	return textureImpl->UavSubresourcesAlloc.size() - 1;
+	textureCold->UavSubresourcesAlloc.push_back(view);
+	return textureCold->UavSubresourcesAlloc.size() - 1;
 }
 
 void phx::gfx::D3D12GpuDevice::DeleteTexture(TextureHandle handle)
 {
-	DeferredItem d =
+	if (!m_resourceRegistry.Textures.Contains(handle))
 	{
-		m_frameCount,
-		[=]()
+		return;
+	}
+
+	// Everything happens in the callback, where releasing the handle and its bindless indices is a
+	// single step. Deleting the same handle twice queues two callbacks, the second finds nothing.
+	const uint64_t frame = m_frameCount;
+	m_retirementQueue.Retire(
+		frame,
+		[this, handle, frame]()
 		{
 			auto* impl = m_resourceRegistry.Textures.Get(handle);
-			if (impl)
+			if (!impl)
+			{
+				return;
+			}
+			auto* cold = m_resourceRegistry.Textures.GetCold(handle);
+
+			// Bindless indices are handed back in one batch, on the next collect as frame has completed.
+			for (auto& view : cold->SrvSubresourcesAlloc)
 			{
-				for (auto& view : impl->SrvSubresourcesAlloc)
+				if (view.BindlessIndex != cInvalidDescriptorIndex)
 				{
-					if (view.BindlessIndex != cInvalidDescriptorIndex)
-					{
-						m_bindlessDescritorTable.Free(view.BindlessIndex);
-					}
+					m_retirementQueue.Retire(m_bindlessRetireType, frame, view.BindlessIndex);
 				}
+			}
 
-				for (auto& view : impl->UavSubresourcesAlloc)
+			for (auto& view : cold->UavSubresourcesAlloc)
+			{
+				if (view.BindlessIndex != cInvalidDescriptorIndex)
 				{
-					if (view.BindlessIndex != cInvalidDescriptorIndex)
-					{
-						m_bindlessDescritorTable.Free(view.BindlessIndex);
-					}
+					m_retirementQueue.Retire(m_bindlessRetireType, frame, view.BindlessIndex);
 				}
-				impl->DisposeViews();
-				GetRegistry().Textures.Release(handle);
 			}
-		}
-	};
 
-	m_deferredQueue.push_back(d);
+			impl->DisposeViews(*cold);
+			GetRegistry().Textures.Release(handle);
+		});
 }
 
 InputLayoutHandle phx::gfx::D3D12GpuDevice::CreateInputLayout(Span<VertexAttributeDesc> desc)
@@ -1933,6 +1956,7 @@ BufferHandle phx::gfx::D3D12GpuDevice::CreateBuffer(BufferDesc const& desc)
 {
 	BufferHandle buffer = m_resourceRegistry.Buffers.Emplace();
 	D3D12Buffer& bufferImpl = *m_resourceRegistry.Buffers.Get(buffer);
+	m_resourceRegistry.Buffers.GetCold(buffer)->DebugName = desc.DebugName;
 
 	D3D12_RESOURCE_FLAGS resourceFlags = D3D12_RESOURCE_FLAG_NONE;
 	if ((desc.Binding & BindingFlags::UnorderedAccess) == BindingFlags::UnorderedAccess)
@@ -2078,56 +2102,66 @@ BufferHandle phx::gfx::D3D12GpuDevice::CreateBuffer(BufferDesc const& desc)
 
 void phx::gfx::D3D12GpuDevice::DeleteBuffer(BufferHandle handle)
 {
-	DeferredItem d =
+	if (!m_resourceRegistry.Buffers.Contains(handle))
 	{
-		m_frameCount,
-		[=]()
+		return;
+	}
+
+	// As with textures, the handle and its bindless indices are released together in the callback.
+	const uint64_t frame = m_frameCount;
+	m_retirementQueue.Retire(
+		frame,
+		[this, handle, frame]()
 		{
 			auto* impl = m_resourceRegistry.Buffers.Get(handle);
-			if (impl)
+			if (!impl)
 			{
-				for (auto& view : impl->SrvSubresourcesAlloc)
+				return;
+			}
+			auto* cold = m_resourceRegistry.Buffers.GetCold(handle);
+
+			for (auto& view : cold->SrvSubresourcesAlloc)
+			{
+				if (view.BindlessIndex != cInvalidDescriptorIndex)
 				{
-					if (view.BindlessIndex != cInvalidDescriptorIndex)
-					{
-						m_bindlessDescritorTable.Free(view.BindlessIndex);
-					}
+					m_retirementQueue.Retire(m_bindlessRetireType, frame, view.BindlessIndex);
 				}
+			}
 
-				for (auto& view : impl->UavSubresourcesAlloc)
+			for (auto& view : cold->UavSubresourcesAlloc)
+			{
+				if (view.BindlessIndex != cInvalidDescriptorIndex)
 				{
-					if (view.BindlessIndex != cInvalidDescriptorIndex)
-					{
-						m_bindlessDescritorTable.Free(view.BindlessIndex);
-					}
+					m_retirementQueue.Retire(m_bindlessRetireType, frame, view.BindlessIndex);
 				}
-				impl->DisposeViews();
-				GetRegistry().Buffers.Release(handle);
 			}
-		}
-	};
 
-	m_deferredQueue.push_back(d);
+			impl->DisposeViews(*cold);
+			GetRegistry().Buffers.Release(handle);
+		});
 }
 
 
 void phx::gfx::D3D12GpuDevice::DeleteResource(Microsoft::WRL::ComPtr<ID3D12Resource> resource)
 {
-	DeferredItem d =
+	if (!resource)
 	{
+		return;
+	}
+
+	// Hold the reference as a raw pointer so the callback stays trivially copyable.
+	m_retirementQueue.Retire(
 		m_frameCount,
-		[ptr = std::move(resource)]()
+		[ptr = resource.Detach()]()
 		{
-			ptr->GetDesc();
-		}
-	};
-
-	m_deferredQueue.push_back(d);
+			ptr->Release();
+		});
 }
 
 DescriptorIndex phx::gfx::D3D12GpuDevice::GetDescriptorIndex(TextureHandle handle, SubresouceType type, int subResource)
 {
 	const D3D12Texture* texture = m_resourceRegistry.Textures.Get(handle);
+	const D3D12TextureCold* textureCold = m_resourceRegistry.Textures.GetCold(handle);
 
 	if (!texture)
 	{
@@ -2139,25 +2173,25 @@ DescriptorIndex phx::gfx::D3D12GpuDevice::GetDescriptorIndex(TextureHandle handl
 	case SubresouceType::SRV:
 		return subResource == -1
 			? texture->Srv.BindlessIndex
-			: texture->SrvSubresourcesAlloc[subResource].BindlessIndex;
+			: textureCold->SrvSubresourcesAlloc[subResource].BindlessIndex;
 		break;
 
 	case SubresouceType::UAV:
 		return subResource == -1
 			? texture->UavAllocation.BindlessIndex
-			: texture->UavSubresourcesAlloc[subResource].BindlessIndex;
+			: textureCold->UavSubresourcesAlloc[subResource].BindlessIndex;
 		break;
 
 	case SubresouceType::RTV:
 		return subResource == -1
 			? texture->RtvAllocation.BindlessIndex
-			: texture->RtvSubresourcesAlloc[subResource].BindlessIndex;
+			: textureCold->RtvSubresourcesAlloc[subResource].BindlessIndex;
 		break;
 
 	case SubresouceType::DSV:
 		return subResource == -1
 			? texture->DsvAllocation.BindlessIndex
-			: texture->DsvSubresourcesAlloc[subResource].BindlessIndex;
+			: textureCold->DsvSubresourcesAlloc[subResource].BindlessIndex;
 		break;
 	default:
 		throw std::runtime_error("Unsupported enum type");
@@ -2167,6 +2201,7 @@ DescriptorIndex phx::gfx::D3D12GpuDevice::GetDescriptorIndex(TextureHandle handl
 DescriptorIndex phx::gfx::D3D12GpuDevice::GetDescriptorIndex(BufferHandle handle, SubresouceType type, int subResource)
 {
 	const D3D12Buffer* bufferImpl = m_resourceRegistry.Buffers.Get(handle);
+	const D3D12BufferCold* bufferCold = m_resourceRegistry.Buffers.GetCold(handle);
 
 	if (!bufferImpl)
 	{
@@ -2178,12 +2213,12 @@ DescriptorIndex phx::gfx::D3D12GpuDevice::GetDescriptorIndex(BufferHandle handle
 	case SubresouceType::SRV:
 		return subResource == -1
 			? bufferImpl->Srv.BindlessIndex
-			: bufferImpl->SrvSubresourcesAlloc[subResource].BindlessIndex;
+			: bufferCold->SrvSubresourcesAlloc[subResource].BindlessIndex;
 
 	case SubresouceType::UAV:
 		return subResource == -1
 			? bufferImpl->UavAllocation.BindlessIndex
-			: bufferImpl->UavSubresourcesAlloc[subResource].BindlessIndex;
+			: bufferCold->UavSubresourcesAlloc[subResource].BindlessIndex;
 	default:
 		throw std::runtime_error("Unsupported enum type");
 	}
@@ -2278,19 +2313,7 @@ void phx::gfx::D3D12GpuDevice::Present()
 
 void phx::gfx::D3D12GpuDevice::RunGarbageCollection(uint64_t completedFrame)
 {
-	while (!m_deferredQueue.empty())
-	{
-		DeferredItem& DeferredItem = m_deferredQueue.front();
-		if (DeferredItem.Frame + kBufferCount < completedFrame)
-		{
-			DeferredItem.DeferredFunc();
-			m_deferredQueue.pop_front();
-		}
-		else
-		{
-			break;
-		}
-	}
+	m_retirementQueue.Collect(completedFrame);
 }
 
 void phx::gfx::D3D12GpuDevice::PollDebugMessages()
@@ -2386,6 +2409,32 @@ void phx::gfx::D3D12GpuDevice::FinalizeResourcePools()
 {
 	m_shaderPool.Finalize();
 	m_pipelineStatePool.Finalize();
+
+	// Anything still registered leaked, hand its descriptors back before the heaps go away.
+	size_t numLeakedTextures = 0;
+	m_resourceRegistry.Textures.ForEach([&](Handle<Texture> handle, D3D12Texture& texture)
+		{
+			D3D12TextureCold& cold = *m_resourceRegistry.Textures.GetCold(handle);
+			PHX_CORE_WARN("[D3D12] - Texture '{}' was not deleted", cold.DebugName);
+			texture.DisposeViews(cold);
+			numLeakedTextures++;
+		});
+
+	size_t numLeakedBuffers = 0;
+	m_resourceRegistry.Buffers.ForEach([&](Handle<Buffer> handle, D3D12Buffer& buffer)
+		{
+			D3D12BufferCold& cold = *m_resourceRegistry.Buffers.GetCold(handle);
+			PHX_CORE_WARN("[D3D12] - Buffer '{}' was not deleted", cold.DebugName);
+			buffer.DisposeViews(cold);
+			numLeakedBuffers++;
+		});
+
+	if (numLeakedTextures > 0 || numLeakedBuffers > 0)
+	{
+		PHX_CORE_WARN("[D3D12] - {} textures and {} buffers were not deleted", numLeakedTextures, numLeakedBuffers);
+	}
+
+	m_resourceRegistry.Finalize();
 }
 
 void phx::gfx::D3D12GpuDevice::InitializeD3D12Context(IDXGIAdapter* gpuAdapter)
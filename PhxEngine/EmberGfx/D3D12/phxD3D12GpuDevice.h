@@ -8,6 +8,7 @@
 #include "d3d12ma/D3D12MemAlloc.h"
 #include "phxGfxResourceRegistryD3D12.h"
 #include "phxDynamicMemoryPageAllocatorD3D12.h"
+#include "phxRetirementQueue.h"
 
 #include <deque>
 #include <mutex>
@@ -186,6 +187,7 @@ namespace phx::gfx
 	public:
 		DescriptorIndex Allocate() { return this->m_descriptorIndexPool.Allocate(); }
 		void Free(DescriptorIndex index) { this->m_descriptorIndexPool.Release(index); }
+		void Free(Span<uint64_t> indices) { this->m_descriptorIndexPool.Release(indices); }
 
 		D3D12_CPU_DESCRIPTOR_HANDLE GetCpuHandle(DescriptorIndex index) const { return this->m_allocation.GetCpuHandle(index); }
 		D3D12_GPU_DESCRIPTOR_HANDLE GetGpuHandle(DescriptorIndex index) const { return this->m_allocation.GetGpuHandle(index); }
@@ -217,6 +219,15 @@ namespace phx::gfx
 				IndexQueue.push_back(Index);
 			}
 
+			void Release(Span<uint64_t> indices)
+			{
+				std::scoped_lock Guard(this->IndexMutex);
+				for (uint64_t index : indices)
+				{
+					IndexQueue.push_back(static_cast<DescriptorIndex>(index));
+				}
+			}
+
 			std::mutex IndexMutex;
 			std::deque<DescriptorIndex> IndexQueue;
 			size_t Index = 0;
@@ -360,7 +371,8 @@ namespace phx::gfx
 
 		void SubmitCommandLists();
 		void Present();
-		void RunGarbageCollection(uint64_t completedFrame = ~0ul);
+		// Destroys everything deleted on or before completedFrame.
+		void RunGarbageCollection(uint64_t completedFrame = ~0ull);
 
 		int CreateSubresource(TextureHandle texture, TextureDesc const& desc, SubresouceType subresourceType, uint32_t firstSlice, uint32_t sliceCount, uint32_t firstMip, uint32_t mipCount);
 
@@ -404,12 +416,8 @@ namespace phx::gfx
 
 		std::array<EnumArray<Microsoft::WRL::ComPtr<ID3D12Fence>, CommandQueueType>, kBufferCount> m_frameFences;
 		uint64_t m_frameCount = 0;
-		struct DeferredItem
-		{
-			uint64_t Frame;
-			std::function<void()> DeferredFunc;
-		};
-		std::deque<DeferredItem> m_deferredQueue;
+		RetirementQueue m_retirementQueue;
+		RetireTypeId m_bindlessRetireType = 0;
 
 		std::atomic_uint32_t m_activeCmdCount = 0;
 		std::vector<std::unique_ptr<platform::CommandCtxD3D12>> m_commandPool;
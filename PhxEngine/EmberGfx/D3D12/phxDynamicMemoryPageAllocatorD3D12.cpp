@@ -24,22 +24,23 @@ void phx::gfx::GpuRingAllocator::Initialize(size_t bufferSize)
 
 void phx::gfx::GpuRingAllocator::Finalize()
 {
-	while (!this->m_inUseRegions.empty())
+	while (this->m_oldestRegion)
 	{
-		auto& region = this->m_inUseRegions.front();
-		if (region.Fence->GetCompletedValue() != 1)
+		UsedRegion* region = this->m_oldestRegion;
+		if (region->Fence->GetCompletedValue() != 1)
 		{
-			region.Fence->SetEventOnCompletion(1, NULL);
+			region->Fence->SetEventOnCompletion(1, NULL);
 		}
 
-		this->m_inUseRegions.pop_front();
+		this->m_oldestRegion = region->Next;
+		this->m_regionPool.Delete(region);
 	}
+	this->m_newestRegion = nullptr;
 
 	this->m_data = nullptr;
 	this->m_gpuAddress = 0;
 	this->m_fencePool.clear();
 
-	this->m_inUseRegions.clear();
 	this->m_availableFences.clear();
 
 	auto* device = D3D12GpuDevice::Instance();
@@ -48,20 +49,9 @@ void phx::gfx::GpuRingAllocator::Finalize()
 
 void phx::gfx::GpuRingAllocator::EndFrame(ID3D12CommandQueue* q)
 {
-	while (!this->m_inUseRegions.empty())
+	while (this->m_oldestRegion && this->m_oldestRegion->Fence->GetCompletedValue() == 1)
 	{
-		auto& region = this->m_inUseRegions.front();
-		if (region.Fence->GetCompletedValue() != 1)
-		{
-			break;
-		}
-
-		region.Fence->Signal(0);
-		this->m_availableFences.push_back(region.Fence);
-
-		m_head += region.UsedSize;
-
-		this->m_inUseRegions.pop_front();
+		this->RetireOldestRegion();
 	}
 
 	ID3D12Fence* fence = nullptr;
@@ -81,9 +71,43 @@ void phx::gfx::GpuRingAllocator::EndFrame(ID3D12CommandQueue* q)
 	}
 
 	q->Signal(fence, 1);
-	this->m_inUseRegions.push_front(UsedRegion{
-		.UsedSize = m_tail - m_headAtStartOfFrame,
-		.Fence = fence });
+	const uint32_t usedSize = m_tail - m_headAtStartOfFrame;
+	UsedRegion* region = this->m_regionPool.New(UsedRegion{ .UsedSize = usedSize, .Fence = fence });
+	if (!region && this->m_oldestRegion)
+	{
+		// Every region slot is in flight, free one up by waiting for the oldest frame.
+		PHX_CORE_WARN("[GPU QUEUE] Out of ring regions, stalling");
+		this->WaitAndRetireOldestRegion();
+		region = this->m_regionPool.New(UsedRegion{ .UsedSize = usedSize, .Fence = fence });
+	}
+
+	if (!region)
+	{
+		// The pool couldn't commit memory for a slot, so this frame can't be tracked. Space is
+		// retired in order, so wait for every older frame and then this one.
+		PHX_CORE_ERROR("[GPU QUEUE] Unable to allocate a ring region, waiting for the frame to complete");
+		while (this->m_oldestRegion)
+		{
+			this->WaitAndRetireOldestRegion();
+		}
+		fence->SetEventOnCompletion(1, NULL);
+		fence->Signal(0);
+		this->m_availableFences.push_back(fence);
+		m_head += usedSize;
+		m_headAtStartOfFrame = m_tail;
+		return;
+	}
+
+	// Regions are retired in submission order, append the newest at the back.
+	if (this->m_newestRegion)
+	{
+		this->m_newestRegion->Next = region;
+	}
+	else
+	{
+		this->m_oldestRegion = region;
+	}
+	this->m_newestRegion = region;
 
 	m_headAtStartOfFrame = m_tail;
 }
@@ -100,21 +124,14 @@ DynamicMemoryPage phx::gfx::GpuRingAllocator::Allocate(uint32_t allocSize)
 
 	if (((m_tail - m_head) + allocSize) >= GetBufferSize())
 	{
-		while (!this->m_inUseRegions.empty())
+		while (this->m_oldestRegion)
 		{
-			auto& region = this->m_inUseRegions.front();
-			if (region.Fence->GetCompletedValue() != 1)
+			if (this->m_oldestRegion->Fence->GetCompletedValue() != 1)
 			{
 				PHX_CORE_WARN("[GPU QUEUE] Stalling waiting for space");
-				region.Fence->SetEventOnCompletion(1, NULL);
 			}
 
-			region.Fence->Signal(0);
-			this->m_availableFences.push_back(region.Fence);
-
-			m_head += region.UsedSize;
-
-			this->m_inUseRegions.pop_front();
+			this->WaitAndRetireOldestRegion();
 		}
 	}
 
@@ -127,3 +144,30 @@ DynamicMemoryPage phx::gfx::GpuRingAllocator::Allocate(uint32_t allocSize)
 		.Data = reinterpret_cast<uint8_t*>(this->m_data + offset),
 	};
 }
+
+void phx::gfx::GpuRingAllocator::WaitAndRetireOldestRegion()
+{
+	ID3D12Fence* fence = this->m_oldestRegion->Fence;
+	if (fence->GetCompletedValue() != 1)
+	{
+		fence->SetEventOnCompletion(1, NULL);
+	}
+
+	this->RetireOldestRegion();
+}
+
+void phx::gfx::GpuRingAllocator::RetireOldestRegion()
+{
+	UsedRegion* region = this->m_oldestRegion;
+	region->Fence->Signal(0);
+	this->m_availableFences.push_back(region->Fence);
+
+	m_head += region->UsedSize;
+
+	this->m_oldestRegion = region->Next;
+	if (!this->m_oldestRegion)
+	{
+		this->m_newestRegion = nullptr;
+	}
+	this->m_regionPool.Delete(region);
+}
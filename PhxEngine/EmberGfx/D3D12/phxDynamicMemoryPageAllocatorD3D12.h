@@ -2,6 +2,7 @@
 
 #include "phxDynamicMemoryPageAllocatorD3D12.h"
 #include "EmberGfx/phxGfxDeviceResources.h"
+#include "phxObjectPool.h"
 #include <deque>
 #include <mutex>
 namespace phx::gfx
@@ -18,6 +19,17 @@ namespace phx::gfx
 
 		uint32_t GetBufferSize() { return (this->m_bufferMask + 1); }
 
+	private:
+		struct UsedRegion
+		{
+			uint32_t UsedSize = 0;
+			ID3D12Fence* Fence;
+			UsedRegion* Next = nullptr;
+		};
+
+		void WaitAndRetireOldestRegion();
+		void RetireOldestRegion();
+
 	private:
 		BufferHandle m_buffer;
 		D3D12_GPU_VIRTUAL_ADDRESS m_gpuAddress = 0;
@@ -32,12 +44,11 @@ namespace phx::gfx
 
 		std::vector<Microsoft::WRL::ComPtr<ID3D12Fence>> m_fencePool;
 		std::deque<ID3D12Fence*> m_availableFences;
-		struct UsedRegion
-		{
-			uint32_t UsedSize = 0;
-			ID3D12Fence* Fence;
-		};
-		std::deque<UsedRegion> m_inUseRegions;
+
+		// One region per frame, oldest first. Nodes come from a slab instead of deque blocks.
+		ObjectPool<UsedRegion, 8> m_regionPool{ 1024 };
+		UsedRegion* m_oldestRegion = nullptr;
+		UsedRegion* m_newestRegion = nullptr;
 	};
 
 }
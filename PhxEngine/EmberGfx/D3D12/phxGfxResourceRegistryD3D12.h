@@ -36,62 +36,74 @@ namespace phx::gfx
 		uint32_t SliceCount = 0;
 	};
 
+	// Rarely touched texture data, kept apart from D3D12Texture so Get() stays cache friendly.
+	struct D3D12TextureCold final
+	{
+		std::string DebugName;
+
+		std::vector<DescriptorView> RtvSubresourcesAlloc = {};
+		std::vector<DescriptorView> DsvSubresourcesAlloc = {};
+		std::vector<DescriptorView> SrvSubresourcesAlloc = {};
+		std::vector<DescriptorView> UavSubresourcesAlloc = {};
+	};
+
 	struct D3D12Texture final
 	{
 		Microsoft::WRL::ComPtr<ID3D12Resource> D3D12Resource;
 		Microsoft::WRL::ComPtr<D3D12MA::Allocation> Allocation;
 		// -- The views ---
 		DescriptorView RtvAllocation;
-		std::vector<DescriptorView> RtvSubresourcesAlloc = {};
-
 		DescriptorView DsvAllocation;
-		std::vector<DescriptorView> DsvSubresourcesAlloc = {};
-
 		DescriptorView Srv;
-		std::vector<DescriptorView> SrvSubresourcesAlloc = {};
-
 		DescriptorView UavAllocation;
-		std::vector<DescriptorView> UavSubresourcesAlloc = {};
 
 		uint16_t MipLevels;
 		uint16_t ArraySize;
 
-		void DisposeViews()
+		void DisposeViews(D3D12TextureCold& cold)
 		{
 			RtvAllocation.Allocation.Free();
-			for (auto& view : RtvSubresourcesAlloc)
+			for (auto& view : cold.RtvSubresourcesAlloc)
 			{
 				view.Allocation.Free();
 			}
-			RtvSubresourcesAlloc.clear();
+			cold.RtvSubresourcesAlloc.clear();
 			RtvAllocation = {};
 
 			DsvAllocation.Allocation.Free();
-			for (auto& view : DsvSubresourcesAlloc)
+			for (auto& view : cold.DsvSubresourcesAlloc)
 			{
 				view.Allocation.Free();
 			}
-			DsvSubresourcesAlloc.clear();
+			cold.DsvSubresourcesAlloc.clear();
 			DsvAllocation = {};
 
 			Srv.Allocation.Free();
-			for (auto& view : SrvSubresourcesAlloc)
+			for (auto& view : cold.SrvSubresourcesAlloc)
 			{
 				view.Allocation.Free();
 			}
-			SrvSubresourcesAlloc.clear();
+			cold.SrvSubresourcesAlloc.clear();
 			Srv = {};
 
 			UavAllocation.Allocation.Free();
-			for (auto& view : UavSubresourcesAlloc)
+			for (auto& view : cold.UavSubresourcesAlloc)
 			{
 				view.Allocation.Free();
 			}
-			UavSubresourcesAlloc.clear();
+			cold.UavSubresourcesAlloc.clear();
 			UavAllocation = {};
 		}
 	};
 
+	struct D3D12BufferCold final
+	{
+		std::string DebugName;
+
+		std::vector<DescriptorView> SrvSubresourcesAlloc = {};
+		std::vector<DescriptorView> UavSubresourcesAlloc = {};
+	};
+
 	struct D3D12Buffer final
 	{
 		Microsoft::WRL::ComPtr<ID3D12Resource> D3D12Resource;
@@ -102,30 +114,27 @@ namespace phx::gfx
 
 		// -- Views ---
 		DescriptorView Srv;
-		std::vector<DescriptorView> SrvSubresourcesAlloc = {};
-
 		DescriptorView UavAllocation;
-		std::vector<DescriptorView> UavSubresourcesAlloc = {};
 
 		D3D12_VERTEX_BUFFER_VIEW VertexView = {};
 		D3D12_INDEX_BUFFER_VIEW IndexView = {};
 
-		void DisposeViews()
+		void DisposeViews(D3D12BufferCold& cold)
 		{
 			Srv.Allocation.Free();
-			for (auto& view : SrvSubresourcesAlloc)
+			for (auto& view : cold.SrvSubresourcesAlloc)
 			{
 				view.Allocation.Free();
 			}
-			SrvSubresourcesAlloc.clear();
+			cold.SrvSubresourcesAlloc.clear();
 			Srv = {};
 
 			UavAllocation.Allocation.Free();
-			for (auto& view : UavSubresourcesAlloc)
+			for (auto& view : cold.UavSubresourcesAlloc)
 			{
 				view.Allocation.Free();
 			}
-			UavSubresourcesAlloc.clear();
+			cold.UavSubresourcesAlloc.clear();
 			UavAllocation = {};
 		}
 	};
@@ -140,8 +149,8 @@ namespace phx::gfx
 
 	using HandlePoolInputLayout = HandlePool<D3D12InputLayout, InputLayout>;
 	using HandlePoolGfxPipeline = HandlePool<D3D12GfxPipeline, GfxPipeline>;
-	using HandlePoolTexture = HandlePool<D3D12Texture, Texture>;
-	using HandlePoolBuffer = HandlePool<D3D12Buffer, Buffer>;
+	using HandlePoolTexture = ConcurrentHandlePool<D3D12Texture, Texture, D3D12TextureCold>;
+	using HandlePoolBuffer = ConcurrentHandlePool<D3D12Buffer, Buffer, D3D12BufferCold>;
 
 	struct ResourceRegistryD3D12
 	{
@@ -237,18 +237,14 @@ void phx::gfx::platform::VulkanGpuDevice::Finalize()
 
 void phx::gfx::platform::VulkanGpuDevice::RunGarbageCollection(uint64_t completedFrame)
 {
-    while (!m_deferredQueue.empty())
+    m_retirementQueue.Collect(completedFrame);
+}
+
+void phx::gfx::platform::VulkanGpuDevice::RetireBindlessIndex(BindlessDescriptorHeap& heap, DescriptorIndex index, uint64_t frame)
+{
+    if (index != cInvalidDescriptorIndex)
     {
-        DeferredItem& DeferredItem = m_deferredQueue.front();
-        if (DeferredItem.Frame + kBufferCount < completedFrame)
-        {
-            DeferredItem.DeferredFunc();
-            m_deferredQueue.pop_front();
-        }
-        else
-        {
-            break;
-        }
+        m_retirementQueue.Retire(heap.RetireType, frame, index);
     }
 }
 
@@ -378,7 +374,15 @@ void phx::gfx::platform::VulkanGpuDevice::SubmitFrame()
 {
     SubmitCommandCtx();
     Present();
-    RunGarbageCollection();
+
+    // Present has waited on the frame fences, so everything older than the frames in flight is done.
+    if (m_frameCount > kBufferCount)
+    {
+        RunGarbageCollection(m_frameCount - kBufferCount - 1);
+    }
+
+    // Recording data stays in the previous region if its frame is somehow still in flight.
+    std::ignore = Memory::GetFrameRingAllocator().BeginFrame(m_frameCount, m_frameCount > kBufferCount ? m_frameCount - kBufferCount : 0);
 }
 
 void phx::gfx::platform::VulkanGpuDevice::WaitForIdle()
@@ -461,10 +465,9 @@ ShaderHandle phx::gfx::platform::VulkanGpuDevice::CreateShader(ShaderDesc const&
 
 void phx::gfx::platform::VulkanGpuDevice::DeleteShader(ShaderHandle handle)
 {
-    DeferredItem d =
-    {
+    m_retirementQueue.Retire(
         m_frameCount,
-        [=]()
+        [this, handle]()
         {
             Shader_VK* impl = m_shaderPool.Get(handle);
             if (impl)
@@ -472,10 +475,7 @@ void phx::gfx::platform::VulkanGpuDevice::DeleteShader(ShaderHandle handle)
                 vkDestroyShaderModule(m_vkDevice, impl->ShaderModule, nullptr);
                 m_shaderPool.Release(handle);
             }
-        }
-    };
-
-    m_deferredQueue.push_back(d);
+        });
 }
 
 PipelineStateHandle phx::gfx::platform::VulkanGpuDevice::CreatePipeline(PipelineStateDesc2 const& desc, RenderPassInfo* renderPassInfo)
@@ -826,10 +826,9 @@ PipelineStateHandle phx::gfx::platform::VulkanGpuDevice::CreatePipeline(Pipeline
 
 void phx::gfx::platform::VulkanGpuDevice::DeletePipeline(PipelineStateHandle handle)
 {
-    DeferredItem d =
-    {
+    m_retirementQueue.Retire(
         m_frameCount,
-        [=]()
+        [this, handle]()
         {
             PipelineState_Vk* impl = m_pipelineStatePool.Get(handle);
             if (impl)
@@ -840,10 +839,7 @@ void phx::gfx::platform::VulkanGpuDevice::DeletePipeline(PipelineStateHandle han
 
                 m_pipelineStatePool.Release(handle);
             }
-        }
-    };
-
-    m_deferredQueue.push_back(d);
+        });
 }
 
 BufferHandle phx::gfx::platform::VulkanGpuDevice::CreateBuffer(BufferDesc const& desc)
@@ -1022,52 +1018,44 @@ BufferHandle phx::gfx::platform::VulkanGpuDevice::CreateBuffer(BufferDesc const&
 
 void phx::gfx::platform::VulkanGpuDevice::DeleteBuffer(BufferHandle handle)
 {
-    DeferredItem d =
+    if (!m_bufferPool.Contains(handle))
     {
-        m_frameCount,
-        [=]()
+        return;
+    }
+
+    // The handle and its bindless indices are released together in the callback, so deleting a
+    // buffer twice can't hand its indices back twice.
+    const uint64_t frame = m_frameCount;
+    m_retirementQueue.Retire(
+        frame,
+        [this, handle, frame]()
         {
             Buffer_VK* impl = m_bufferPool.Get(handle);
             // TODO: Move into the deconstructor of struct
             if (impl)
             {
+                // Handed back in one batch per heap on the next collect.
                 if (impl->Srv.IsValid())
                 {
-                    if (impl->Srv.IsTyped)
-                    {
-                        m_bindlessUniformTexelBuffers.Free(impl->Srv.Index);
-                    }
-                    else
-                    {
-                        m_bindlessStorageBuffers.Free(impl->Srv.Index);
-                    }
-
-                    if (impl->Srv.ViewVk != VK_NULL_HANDLE)
-                        vkDestroyBufferView(m_vkDevice, impl->Uav.ViewVk, nullptr);
-                    impl->Srv = {};
+                    RetireBindlessIndex(impl->Srv.IsTyped ? m_bindlessUniformTexelBuffers : m_bindlessStorageBuffers, impl->Srv.Index, frame);
                 }
                 if (impl->Uav.IsValid())
                 {
-                    if (impl->Uav.IsTyped)
-                    {
-                        m_bindlessStorageTexelBuffers.Free(impl->Uav.Index);
-                    }
-                    else
-                    {
-                        m_bindlessStorageBuffers.Free(impl->Uav.Index);
-                    }
-
-                    if (impl->Uav.ViewVk != VK_NULL_HANDLE)
-                        vkDestroyBufferView(m_vkDevice, impl->Uav.ViewVk, nullptr);
-                    impl->Uav = {};
+                    RetireBindlessIndex(impl->Uav.IsTyped ? m_bindlessStorageTexelBuffers : m_bindlessStorageBuffers, impl->Uav.Index, frame);
                 }
+
+                if (impl->Srv.ViewVk != VK_NULL_HANDLE)
+                    vkDestroyBufferView(m_vkDevice, impl->Srv.ViewVk, nullptr);
+                impl->Srv = {};
+
+                if (impl->Uav.ViewVk != VK_NULL_HANDLE)
+                    vkDestroyBufferView(m_vkDevice, impl->Uav.ViewVk, nullptr);
+                impl->Uav = {};
+
                 vmaDestroyBuffer(m_vmaAllocator, impl->BufferVk, impl->Allocation);
             }
             m_bufferPool.Release(handle);
-        }
-    };
-
-    m_deferredQueue.push_back(d);
+        });
 }
 
 TextureHandle phx::gfx::platform::VulkanGpuDevice::CreateTexture(TextureDesc const& desc, SubresourceData* initData)
@@ -1363,26 +1351,32 @@ TextureHandle phx::gfx::platform::VulkanGpuDevice::CreateTexture(TextureDesc con
 
 void phx::gfx::platform::VulkanGpuDevice::DeleteTexture(TextureHandle handle)
 {
-    DeferredItem d =
+    if (!m_texturePool.Contains(handle))
     {
-        m_frameCount,
-        [=]()
+        return;
+    }
+
+    // As with buffers, the bindless indices are retired by the callback that releases the handle.
+    const uint64_t frame = m_frameCount;
+    m_retirementQueue.Retire(
+        frame,
+        [this, handle, frame]()
         {
-            
             Texture_VK* impl = m_texturePool.Get(handle);
             // TODO: Move into the deconstructor of struct
             if (impl)
             {
                 if (impl->Srv.IsValid())
                 {
-                    m_bindlessSampledImages.Free(impl->Srv.Index);
-                    impl->Srv = {};
+                    RetireBindlessIndex(m_bindlessSampledImages, impl->Srv.Index, frame);
                 }
                 if (impl->Uav.IsValid())
                 {
-                    m_bindlessStorageImages.Free(impl->Uav.Index);
-                    impl->Uav = {};
+                    RetireBindlessIndex(m_bindlessStorageImages, impl->Uav.Index, frame);
                 }
+
+                impl->Srv = {};
+                impl->Uav = {};
                 if (impl->Rtv.ViewVk != VK_NULL_HANDLE)
                 {
                     vkDestroyImageView(m_vkDevice, impl->Rtv.ViewVk, nullptr);
@@ -1397,10 +1391,7 @@ void phx::gfx::platform::VulkanGpuDevice::DeleteTexture(TextureHandle handle)
                 vmaDestroyImage(m_vmaAllocator, impl->ImageVk, impl->Allocation);
                 m_texturePool.Release(handle);
             }
-        }
-    };
-
-    m_deferredQueue.push_back(d);
+        });
 }
 
 void* phx::gfx::platform::VulkanGpuDevice::GetMappedData(BufferHandle handle)
@@ -2345,6 +2336,22 @@ void phx::gfx::platform::VulkanGpuDevice::InitializeDescriptorHeaps()
     {
         m_bindlessAccelerationStructures.Initialize(m_vkDevice, VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR, 32);
     }
+
+    for (BindlessDescriptorHeap* heap : {
+        &m_bindlessSampledImages,
+        &m_bindlessUniformTexelBuffers,
+        &m_bindlessStorageBuffers,
+        &m_bindlessStorageImages,
+        &m_bindlessStorageTexelBuffers,
+        &m_bindlessSamplers,
+        &m_bindlessAccelerationStructures })
+    {
+        heap->RetireType = m_retirementQueue.RegisterBatchType(
+            [heap](Span<uint64_t> indices)
+            {
+                heap->Free(indices);
+            });
+    }
 }
 
 void phx::gfx::platform::VulkanGpuDevice::CreateVma()
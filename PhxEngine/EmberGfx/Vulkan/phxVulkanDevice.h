@@ -9,6 +9,7 @@
 #include "EmberGfx/phxGpuDeviceInterface.h"
 #include "EmberGfx/phxGfxDeviceResources.h"
 #include "EmberGfx/phxHandlePool.h"
+#include "phxRetirementQueue.h"
 
 #include "phxVulkanManager.h"
 #include "phxVulkanCommandCtx.h"
@@ -235,6 +236,18 @@ namespace phx::gfx::platform
 			std::scoped_lock _(AllocMutex);
 			FreeList.push_back(index);
 		}
+
+		void Free(Span<uint64_t> indices)
+		{
+			std::scoped_lock _(AllocMutex);
+			for (uint64_t index : indices)
+			{
+				FreeList.push_back(static_cast<DescriptorIndex>(index));
+			}
+		}
+
+		// Batch type used to free this heap's indices through the device's retirement queue.
+		RetireTypeId RetireType = 0;
 	};
 
 	struct CommandQueue
@@ -327,7 +340,9 @@ namespace phx::gfx::platform
 		void SubmitCommandCtx();
 		void Present();
 
-		void RunGarbageCollection(uint64_t completedFrame = ~0ul);
+		// Destroys everything deleted on or before completedFrame.
+		void RunGarbageCollection(uint64_t completedFrame = ~0ull);
+		void RetireBindlessIndex(BindlessDescriptorHeap& heap, DescriptorIndex index, uint64_t frame);
 
 	private:
 		bool m_enableValidationLayers;
@@ -390,12 +405,7 @@ namespace phx::gfx::platform
 		std::array< VkSemaphore, kBufferCount> m_renderFinishedSemaphore;
 
 
-		struct DeferredItem
-		{
-			uint64_t Frame;
-			std::function<void()> DeferredFunc;
-		};
-		std::deque<DeferredItem> m_deferredQueue;
+		RetirementQueue m_retirementQueue;
 
 		VkPipelineCache m_vkPipelineCache;
 
@@ -409,8 +419,8 @@ namespace phx::gfx::platform
 
 		HandlePool<PipelineState_Vk, PipelineState> m_pipelineStatePool;
 		HandlePool<Shader_VK, Shader> m_shaderPool;
-		HandlePool<Buffer_VK, Buffer> m_bufferPool;
-		HandlePool<Texture_VK, Texture> m_texturePool;
+		ConcurrentHandlePool<Buffer_VK, Buffer> m_bufferPool;
+		ConcurrentHandlePool<Texture_VK, Texture> m_texturePool;
 
 
 		std::mutex m_commandPoolLock;
@@ -29,7 +29,10 @@ namespace phx::gfx
 		uint32_t m_index;
 		uint32_t m_generation;
 
-		template<typename ImplT, typename HT>
+		template<typename ImplT, typename HT, typename ColdT>
 		friend class HandlePool;
+
+		template<typename ImplT, typename HT, typename ColdT>
+		friend class ConcurrentHandlePool;
 	};
 }
\ No newline at end of file
@@ -1,25 +1,42 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <cstring>
+#include <iterator>
+#include <memory>
+#include <mutex>
 #include <utility>
 #include <limits>
+#include <vector>
 #include <assert.h>
 #include "phxHandle.h"
+#include "phxMemory.h"
+#include "phxSpan.h"
 #include <stdexcept>
+#include <type_traits>
 
 #include <iostream>
 namespace phx::gfx
 {
-	template<typename ImplT, typename HT>
+	// Entries live in fixed size pages that are allocated on demand and never move, so pointers
+	// returned by Get() stay valid until the handle is released and growing never copies entries.
+	// Live handles are also kept in a dense array so they can be walked without scanning free slots.
+	// Optionally ColdT holds rarely touched data (debug names, view lists) in a separate array, so
+	// lookups through Get() only pull the hot ImplT into cache.
+	template<typename ImplT, typename HT, typename ColdT = void>
 	class HandlePool
 	{
+	public:
+		static constexpr size_t kPageSizeLog2 = 8;
+		static constexpr size_t kPageSize = size_t(1) << kPageSizeLog2;
+		static constexpr size_t kPageMask = kPageSize - 1;
+
 	public:
 		HandlePool()
 			: m_size(0)
 			, m_numActiveEntries(0)
-			, m_data(nullptr)
-			, m_generations(nullptr)
-			, m_freeList(nullptr)
 		{
 		}
 
@@ -28,67 +45,49 @@ namespace phx::gfx
 			this->Finalize();
 		}
 
+		HandlePool(HandlePool const&) = delete;
+		HandlePool& operator=(HandlePool const&) = delete;
+
 		void Initialize(size_t initCapacity = 16)
 		{
-			this->m_size = initCapacity;
-			this->m_numActiveEntries = 0;
-
-			this->m_data = new ImplT[this->m_size];
-			this->m_generations = new uint32_t[this->m_size];
-			this->m_freeList = new uint32_t[this->m_size];
-
-			std::memset(this->m_data, 0, this->m_size * sizeof(ImplT));
-			std::memset(this->m_generations, 0, this->m_size * sizeof(uint32_t));
-			std::memset(this->m_freeList, 0, this->m_size * sizeof(uint32_t));
-
-			for (size_t i = 0; i < this->m_size; i++)
-			{
-				this->m_generations[i] = 1;
-			}
+			this->Finalize();
 
-			this->m_freeListPosition = this->m_size - 1;
-			for (size_t i = 0; i < this->m_size; i++)
+			const size_t numPages = (std::max<size_t>(initCapacity, 1) + kPageMask) >> kPageSizeLog2;
+			for (size_t i = 0; i < numPages; i++)
 			{
-				this->m_freeList[i] = static_cast<uint32_t>((this->m_size - 1) - i);
+				this->AddPage();
 			}
 		}
 
 		void Finalize()
 		{
-			if (this->m_data)
-			{
-				for (int i = 0; i < this->m_size; i++)
-				{
-					this->m_data[i].~ImplT();
-				}
-
-				delete[] this->m_data;
-				this->m_data = nullptr;
-			}
-
-			if (this->m_freeList)
-			{
-				delete[] this->m_freeList;
-				this->m_freeList = nullptr;
-			}
+			// Pages own their entries, destroying a page runs every entry's destructor.
+			this->m_pages.clear();
+			this->m_freeList.clear();
+			this->m_liveHandles.clear();
+			this->m_size = 0;
+			this->m_numActiveEntries = 0;
+		}
 
-			if (this->m_generations)
+		ImplT* Get(Handle<HT> handle)
+		{
+			if (!this->Contains(handle))
 			{
-				delete[] this->m_generations;
-				this->m_generations = nullptr;
+				return nullptr;
 			}
 
-			this->m_size = 0;
+			return &this->GetPage(handle.m_index).Data[handle.m_index & kPageMask];
 		}
 
-		ImplT* Get(Handle<HT> handle)
+		template<typename C = ColdT> requires (!std::is_void_v<C>)
+		C* GetCold(Handle<HT> handle)
 		{
 			if (!this->Contains(handle))
 			{
 				return nullptr;
 			}
 
-			return this->m_data + handle.m_index;
+			return &this->GetPage(handle.m_index).Cold[handle.m_index & kPageMask];
 		}
 
 		bool Contains(Handle<HT> handle) const
@@ -96,26 +95,33 @@ namespace phx::gfx
 			return
 				handle.IsValid() &&
 				handle.m_index < this->m_size &&
-				this->m_generations[handle.m_index] == handle.m_generation;
+				this->GetPage(handle.m_index).Generations[handle.m_index & kPageMask] == handle.m_generation;
 		}
 
 
 		template<typename... Args>
 		Handle<HT> Emplace(Args&&... args)
 		{
-			if (!this->HasSpace())
+			if (this->m_freeList.empty())
 			{
-				this->Resize();
+				this->AddPage();
 			}
 
 			Handle<HT> handle;
 			// Get a free index
-			handle.m_index = this->m_freeList[this->m_freeListPosition];
-			handle.m_generation = this->m_generations[handle.m_index];
-			this->m_freeListPosition--;
+			handle.m_index = this->m_freeList.back();
+			this->m_freeList.pop_back();
+
+			Page& page = this->GetPage(handle.m_index);
+			const size_t slot = handle.m_index & kPageMask;
+			handle.m_generation = page.Generations[slot];
 			this->m_numActiveEntries++;
 
-			new (this->m_data + handle.m_index) ImplT(std::forward<Args>(args)...);
+			page.Data[slot].~ImplT();
+			new (&page.Data[slot]) ImplT(std::forward<Args>(args)...);
+
+			page.DenseIndex[slot] = static_cast<uint32_t>(this->m_liveHandles.size());
+			this->m_liveHandles.push_back(handle);
 
 			return handle;
 		}
@@ -132,83 +138,389 @@ namespace phx::gfx
 				return;
 			}
 
-			this->Get(handle)->~ImplT();
-			new (this->m_data + handle.m_index) ImplT();
-			this->m_generations[handle.m_index] += 1;
+			Page& page = this->GetPage(handle.m_index);
+			const size_t slot = handle.m_index & kPageMask;
+
+			page.Data[slot].~ImplT();
+			new (&page.Data[slot]) ImplT();
+			if constexpr (kHasCold)
+			{
+				page.Cold[slot] = ColdT{};
+			}
+			page.Generations[slot] += 1;
+			this->m_numActiveEntries--;
+
+			// Swap remove from the dense array, patching the moved entry's position
+			const uint32_t denseIndex = page.DenseIndex[slot];
+			const Handle<HT> movedHandle = this->m_liveHandles.back();
+			this->m_liveHandles[denseIndex] = movedHandle;
+			this->GetPage(movedHandle.m_index).DenseIndex[movedHandle.m_index & kPageMask] = denseIndex;
+			this->m_liveHandles.pop_back();
 
 			// To prevent the risk of re assignment, block index for being allocated
-			if (this->m_generations[handle.m_index] == std::numeric_limits<uint32_t>::max())
+			if (page.Generations[slot] == std::numeric_limits<uint32_t>::max())
 			{
 				return;
 			}
 
-			this->m_freeList[++this->m_freeListPosition] = handle.m_index;
-			this->m_numActiveEntries--;
+			this->m_freeList.push_back(handle.m_index);
 		}
 
 		bool IsEmpty() const { return this->m_numActiveEntries == 0; }
+		size_t GetNumActiveEntries() const { return this->m_numActiveEntries; }
+		size_t GetCapacity() const { return this->m_size; }
+
+		// Handles of every live entry, contiguous. Invalidated by Emplace and Release.
+		Span<Handle<HT>> GetLiveHandles() const { return Span<Handle<HT>>(this->m_liveHandles); }
+
+		// Calls fn(handle, entry) for every live entry. fn must not Emplace or Release.
+		template<typename F>
+		void ForEach(F&& fn)
+		{
+			for (Handle<HT> handle : this->m_liveHandles)
+			{
+				fn(handle, this->GetPage(handle.m_index).Data[handle.m_index & kPageMask]);
+			}
+		}
 
 	private:
-		void Resize()
+		static constexpr bool kHasCold = !std::is_void_v<ColdT>;
+		struct NoColdData {};
+
+		struct Page
 		{
+			ImplT Data[kPageSize] = {};
+			uint32_t Generations[kPageSize];
+			uint32_t DenseIndex[kPageSize];
+			[[no_unique_address]] std::conditional_t<kHasCold, std::array<std::conditional_t<kHasCold, ColdT, char>, kPageSize>, NoColdData> Cold = {};
 
-			if (this->m_size == 0)
+			Page()
 			{
-				this->Initialize(16);
-				return;
+				std::fill(std::begin(this->Generations), std::end(this->Generations), 1u);
 			}
+		};
 
-			size_t newSize = this->m_size * 2;
-			auto* newDataArray = new ImplT[newSize];
-			auto* newFreeListArray = new uint32_t[newSize];
-			auto* newGenerations = new uint32_t[newSize];
+		Page& GetPage(uint32_t index) { return *this->m_pages[index >> kPageSizeLog2]; }
+		Page const& GetPage(uint32_t index) const { return *this->m_pages[index >> kPageSizeLog2]; }
 
-			std::memset(newDataArray, 0, newSize * sizeof(ImplT));
-			std::memset(newFreeListArray, 0, newSize * sizeof(uint32_t));
+		void AddPage()
+		{
+			if (this->m_size + kPageSize > std::numeric_limits<uint32_t>::max())
+			{
+				throw std::runtime_error("Handle pool is full");
+			}
+
+			this->m_pages.push_back(std::make_unique<Page>());
 
-			for (size_t i = 0; i < newSize; i++)
+			// Push in reverse so the lowest index is handed out first.
+			const uint32_t firstIndex = static_cast<uint32_t>(this->m_size);
+			this->m_size += kPageSize;
+			this->m_freeList.reserve(this->m_freeList.size() + kPageSize);
+			for (size_t i = kPageSize; i > 0; i--)
 			{
-				newGenerations[i] = 1;
+				this->m_freeList.push_back(firstIndex + static_cast<uint32_t>(i - 1));
 			}
+		}
 
-			// Copy data over
-			std::memcpy(newDataArray, this->m_data, this->m_size * sizeof(ImplT));
-			// No need to copy the free list as we need to re-populate it.
-			// std::memcpy(newFreeListArray, this->m_freeList, this->m_size * sizeof(uint32_t));
-			std::memcpy(newGenerations, this->m_generations, this->m_size * sizeof(uint32_t));
+	private:
+		size_t m_size;
+		size_t m_numActiveEntries;
 
-			delete[] this->m_data;
-			delete[] this->m_freeList;
-			delete[] this->m_generations;
+		// Free indices, used as a stack
+		std::vector<uint32_t> m_freeList;
 
-			this->m_data = newDataArray;
-			this->m_freeList = newFreeListArray;
-			this->m_generations = newGenerations;
+		// Entry pages, never reallocated once created
+		std::vector<std::unique_ptr<Page>> m_pages;
 
-			this->m_freeListPosition = this->m_size - 1;
+		// Dense list of live handles
+		std::vector<Handle<HT>> m_liveHandles;
+	};
 
-			this->m_size = newSize;
-			for (size_t i = 0; i < this->m_size - 1; i++)
+	// Thread safe variant of HandlePool. Slots come from a lock free free list whose head is tagged
+	// with a counter to avoid ABA, and Get/Contains are wait free as they only read the page table
+	// and the generation counter. Emplace/Release also take a short lock to keep the dense list of
+	// live handles, and ColdT works as in HandlePool. As with HandlePool, releasing a handle while
+	// another thread is still using the entry is the caller's responsibility (see the deferred
+	// release queue).
+	template<typename ImplT, typename HT, typename ColdT = void>
+	class ConcurrentHandlePool
+	{
+	public:
+		static constexpr size_t kPageSizeLog2 = 8;
+		static constexpr size_t kPageSize = size_t(1) << kPageSizeLog2;
+		static constexpr size_t kPageMask = kPageSize - 1;
+		static constexpr size_t kMaxPages = 4096;
+
+	public:
+		ConcurrentHandlePool() = default;
+
+		~ConcurrentHandlePool()
+		{
+			this->Finalize();
+		}
+
+		ConcurrentHandlePool(ConcurrentHandlePool const&) = delete;
+		ConcurrentHandlePool& operator=(ConcurrentHandlePool const&) = delete;
+
+		void Initialize(size_t initCapacity = 16)
+		{
+			const size_t numPages = std::min((std::max<size_t>(initCapacity, 1) + kPageMask) >> kPageSizeLog2, kMaxPages);
+			for (size_t i = 0; i < numPages; i++)
 			{
-				this->m_freeList[i] = static_cast<uint32_t>((this->m_size - 1) - i);
+				this->EnsurePage(i);
 			}
 		}
 
-		bool HasSpace() const { return this->m_numActiveEntries < this->m_size; }
+		// Not thread safe, no other thread may be using the pool.
+		void Finalize()
+		{
+			for (auto& pagePtr : this->m_pages)
+			{
+				delete pagePtr.exchange(nullptr, std::memory_order_relaxed);
+			}
+
+			this->m_liveHandles.clear();
+			this->m_freeHead.store(kEmptyFreeList, std::memory_order_relaxed);
+			this->m_nextUnusedIndex.store(0, std::memory_order_relaxed);
+			this->m_numActiveEntries.store(0, std::memory_order_relaxed);
+		}
+
+		ImplT* Get(Handle<HT> handle)
+		{
+			Page* page = this->FindPage(handle);
+			if (!page)
+			{
+				return nullptr;
+			}
+
+			return &page->Data[handle.m_index & kPageMask];
+		}
+
+		template<typename C = ColdT> requires (!std::is_void_v<C>)
+		C* GetCold(Handle<HT> handle)
+		{
+			Page* page = this->FindPage(handle);
+			if (!page)
+			{
+				return nullptr;
+			}
+
+			return &page->Cold[handle.m_index & kPageMask];
+		}
+
+		bool Contains(Handle<HT> handle) const
+		{
+			return this->FindPage(handle) != nullptr;
+		}
+
+		template<typename... Args>
+		Handle<HT> Emplace(Args&&... args)
+		{
+			uint32_t index = this->PopFreeIndex();
+			if (index == kInvalidIndex)
+			{
+				index = this->m_nextUnusedIndex.fetch_add(1, std::memory_order_relaxed);
+				if (index >= kMaxPages * kPageSize)
+				{
+					throw std::runtime_error("Concurrent handle pool is full");
+				}
+
+				this->EnsurePage(index >> kPageSizeLog2);
+			}
+
+			Page& page = *this->m_pages[index >> kPageSizeLog2].load(std::memory_order_acquire);
+			const size_t slot = index & kPageMask;
+
+			page.Data[slot].~ImplT();
+			new (&page.Data[slot]) ImplT(std::forward<Args>(args)...);
+			this->m_numActiveEntries.fetch_add(1, std::memory_order_relaxed);
+
+			Handle<HT> handle;
+			handle.m_index = index;
+			handle.m_generation = page.Generations[slot].load(std::memory_order_acquire);
+
+			{
+				std::scoped_lock _(this->m_liveMutex);
+				page.DenseIndex[slot] = static_cast<uint32_t>(this->m_liveHandles.size());
+				this->m_liveHandles.push_back(handle);
+			}
+
+			return handle;
+		}
+
+		Handle<HT> Insert(ImplT const& Data)
+		{
+			return this->Emplace(Data);
+		}
+
+		void Release(Handle<HT> handle)
+		{
+			Page* page = this->FindPage(handle);
+			if (!page)
+			{
+				return;
+			}
+
+			const size_t slot = handle.m_index & kPageMask;
+
+			// Only one of several racing releases of the same handle wins the generation bump.
+			uint32_t expected = handle.m_generation;
+			if (!page->Generations[slot].compare_exchange_strong(expected, expected + 1, std::memory_order_acq_rel))
+			{
+				return;
+			}
+
+			page->Data[slot].~ImplT();
+			new (&page->Data[slot]) ImplT();
+			if constexpr (kHasCold)
+			{
+				page->Cold[slot] = ColdT{};
+			}
+			this->m_numActiveEntries.fetch_sub(1, std::memory_order_relaxed);
+
+			// Swap remove from the dense array before the slot can be handed out again
+			{
+				std::scoped_lock _(this->m_liveMutex);
+				const uint32_t denseIndex = page->DenseIndex[slot];
+				const Handle<HT> movedHandle = this->m_liveHandles.back();
+				this->m_liveHandles[denseIndex] = movedHandle;
+				this->m_pages[movedHandle.m_index >> kPageSizeLog2].load(std::memory_order_acquire)->DenseIndex[movedHandle.m_index & kPageMask] = denseIndex;
+				this->m_liveHandles.pop_back();
+			}
+
+			// To prevent the risk of re assignment, block index for being allocated
+			if (expected + 1 == std::numeric_limits<uint32_t>::max())
+			{
+				return;
+			}
+
+			this->PushFreeIndex(handle.m_index);
+		}
+
+		bool IsEmpty() const { return this->m_numActiveEntries.load(std::memory_order_relaxed) == 0; }
+		size_t GetNumActiveEntries() const { return this->m_numActiveEntries.load(std::memory_order_relaxed); }
+
+		// Handles of every live entry, contiguous. Invalidated by Emplace and Release, so no other
+		// thread may use the pool while the span is held.
+		Span<Handle<HT>> GetLiveHandles() const { return Span<Handle<HT>>(this->m_liveHandles); }
+
+		// Calls fn(handle, entry) for every live entry. Meant for teardown and debugging, no other
+		// thread may Emplace or Release while this runs and fn must not either.
+		template<typename F>
+		void ForEach(F&& fn)
+		{
+			for (Handle<HT> handle : this->m_liveHandles)
+			{
+				Page* page = this->m_pages[handle.m_index >> kPageSizeLog2].load(std::memory_order_acquire);
+				fn(handle, page->Data[handle.m_index & kPageMask]);
+			}
+		}
 
 	private:
-		size_t m_size;
-		size_t m_numActiveEntries;
-		size_t m_freeListPosition;
+		static constexpr uint32_t kInvalidIndex = ~0u;
+		static constexpr uint64_t kEmptyFreeList = kInvalidIndex;
+		static constexpr bool kHasCold = !std::is_void_v<ColdT>;
+		struct NoColdData {};
 
-		// free array
-		uint32_t* m_freeList;
+		struct Page
+		{
+			ImplT Data[kPageSize] = {};
+			std::atomic<uint32_t> Generations[kPageSize];
+			std::atomic<uint32_t> NextFree[kPageSize];
+			// Guarded by m_liveMutex
+			uint32_t DenseIndex[kPageSize];
+			[[no_unique_address]] std::conditional_t<kHasCold, std::array<std::conditional_t<kHasCold, ColdT, char>, kPageSize>, NoColdData> Cold = {};
+
+			Page()
+			{
+				for (size_t i = 0; i < kPageSize; i++)
+				{
+					this->Generations[i].store(1, std::memory_order_relaxed);
+					this->NextFree[i].store(kInvalidIndex, std::memory_order_relaxed);
+				}
+			}
+		};
 
-		// Generation array
-		uint32_t* m_generations;
+		Page* FindPage(Handle<HT> handle) const
+		{
+			const size_t pageIndex = handle.m_index >> kPageSizeLog2;
+			if (!handle.IsValid() || pageIndex >= kMaxPages)
+			{
+				return nullptr;
+			}
 
-		// Data Array
-		ImplT* m_data;
+			Page* page = this->m_pages[pageIndex].load(std::memory_order_acquire);
+			if (!page || page->Generations[handle.m_index & kPageMask].load(std::memory_order_acquire) != handle.m_generation)
+			{
+				return nullptr;
+			}
+
+			return page;
+		}
+
+		void EnsurePage(size_t pageIndex)
+		{
+			if (this->m_pages[pageIndex].load(std::memory_order_acquire))
+			{
+				return;
+			}
+
+			// Threads racing to create the same page, the loser throws its copy away.
+			Page* newPage = new Page();
+			Page* expected = nullptr;
+			if (!this->m_pages[pageIndex].compare_exchange_strong(expected, newPage, std::memory_order_acq_rel))
+			{
+				delete newPage;
+			}
+		}
+
+		std::atomic<uint32_t>& NextFree(uint32_t index)
+		{
+			return this->m_pages[index >> kPageSizeLog2].load(std::memory_order_acquire)->NextFree[index & kPageMask];
+		}
+
+		// Head is packed as (tag << 32) | index, the tag changes on every update.
+		uint32_t PopFreeIndex()
+		{
+			uint64_t head = this->m_freeHead.load(std::memory_order_acquire);
+			while (true)
+			{
+				const uint32_t index = static_cast<uint32_t>(head);
+				if (index == kInvalidIndex)
+				{
+					return kInvalidIndex;
+				}
+
+				const uint64_t next = this->NextFree(index).load(std::memory_order_relaxed);
+				const uint64_t newHead = (((head >> 32) + 1) << 32) | next;
+				if (this->m_freeHead.compare_exchange_weak(head, newHead, std::memory_order_acq_rel, std::memory_order_acquire))
+				{
+					return index;
+				}
+			}
+		}
+
+		void PushFreeIndex(uint32_t index)
+		{
+			uint64_t head = this->m_freeHead.load(std::memory_order_relaxed);
+			uint64_t newHead;
+			do
+			{
+				this->NextFree(index).store(static_cast<uint32_t>(head), std::memory_order_relaxed);
+				newHead = (((head >> 32) + 1) << 32) | index;
+			} while (!this->m_freeHead.compare_exchange_weak(head, newHead, std::memory_order_release, std::memory_order_relaxed));
+		}
+
+	private:
+		std::atomic<uint64_t> m_freeHead = kEmptyFreeList;
+		std::atomic<uint32_t> m_nextUnusedIndex = 0;
+		std::atomic<size_t> m_numActiveEntries = 0;
+
+		std::array<std::atomic<Page*>, kMaxPages> m_pages = {};
+
+		// Dense list of live handles, only touched under the lock
+		std::mutex m_liveMutex;
+		std::vector<Handle<HT>> m_liveHandles;
 	};
 
 	template<typename ImplT, typename HT>
@@ -224,7 +536,7 @@ namespace phx::gfx
 			{
 				VirtualMemorySize = virtualMemorySize;
 				PageSize = pageSize;
-				VirtualPtr = static_cast<uint8_t*>(VirtualAlloc(NULL, VirtualMemorySize, MEM_RESERVE, PAGE_READWRITE));
+				VirtualPtr = static_cast<uint8_t*>(phx::VirtualMemReserve(VirtualMemorySize));
 				Grow();
 			}
 
@@ -234,14 +546,15 @@ namespace phx::gfx
 					throw std::runtime_error("Ran out of virtual memory");
 
 				// Commit data
-				VirtualAlloc(VirtualPtr + TotalMemoryCommited, PageSize, MEM_COMMIT, PAGE_READWRITE);
+				if (!phx::VirtualMemCommit(VirtualPtr + TotalMemoryCommited, PageSize))
+					throw std::runtime_error("Failed to commit virtual memory");
 				TotalMemoryCommited += PageSize;
 			}
 
 			~VirtualPageAllocator()
 			{
 				// Free the committed memory
-				if (!VirtualFree(reinterpret_cast<void*>(VirtualPtr), 0, MEM_RELEASE))
+				if (!phx::VirtualMemFree(reinterpret_cast<void*>(VirtualPtr), VirtualMemorySize))
 				{
 					std::cerr << "Memory deallocation failed." << std::endl;
 				}
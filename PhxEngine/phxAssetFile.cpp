@@ -2,41 +2,148 @@
 #include "phxAssetFile.h"
 #include "phxVFS.h"
 
-bool phx::assets::LoadBinaryFile(IFileSystem* fs, const char* path, AssetFile& assetFile)
+#include <assert.h>
+#include <cstring>
+#include <utility>
+
+using namespace phx::assets;
+using namespace phx::assets::FileFormat;
+
+namespace
 {
-    return false;
+	uint64_t AlignOffset(uint64_t offset, uint64_t alignment)
+	{
+		return (offset + alignment - 1) & ~(alignment - 1);
+	}
+
+	bool IsInFile(uint64_t offset, uint64_t size, uint64_t fileSize)
+	{
+		return offset <= fileSize && size <= fileSize - offset;
+	}
 }
 
-bool phx::assets::SaveBinaryFile(IFileSystem* fs, const char* path, AssetFile const& assetFile)
+phx::assets::AssetFileView::AssetFileView() = default;
+phx::assets::AssetFileView::~AssetFileView() = default;
+
+phx::assets::AssetFileView::AssetFileView(AssetFileView&& other) noexcept
 {
+	*this = std::move(other);
+}
 
-	std::stringstream ss;
+AssetFileView& phx::assets::AssetFileView::operator=(AssetFileView&& other) noexcept
+{
+	this->m_blob = std::move(other.m_blob);
+	this->m_data = std::exchange(other.m_data, nullptr);
+	this->m_header = std::exchange(other.m_header, nullptr);
+	this->m_sections = std::exchange(other.m_sections, nullptr);
+	return *this;
+}
 
-	ss << assetFile.ID;
-	ss << assetFile.Version;
-	ss << (uint32_t)assetFile.json.size();
+std::string_view phx::assets::AssetFileView::GetJson() const
+{
+	return std::string_view(this->m_data + this->m_header->JsonOffset, static_cast<size_t>(this->m_header->JsonSize));
+}
 
-	fs->WriteFile(path, fileData);
-	
-	outfile.write(file.type, 4);
-	uint32_t version = file.version;
-	//version
-	outfile.write((const char*)&version, sizeof(uint32_t));
+phx::Span<char> phx::assets::AssetFileView::GetSection(size_t index) const
+{
+	assert(index < this->m_header->NumSections);
+	const SectionEntry& section = this->m_sections[index];
+	return Span<char>(this->m_data + section.Offset, static_cast<size_t>(section.Size));
+}
 
-	//json length
-	uint32_t length = file.json.size();
-	outfile.write((const char*)&length, sizeof(uint32_t));
+bool phx::assets::LoadBinaryFile(IFileSystem* fs, const char* path, AssetFileView& assetFile)
+{
+	assetFile = {};
+
+	std::unique_ptr<IBlob> blob = fs->MapFile(path);
+	if (!blob || blob->Size() < sizeof(FileHeader))
+	{
+		PHX_CORE_ERROR("Unable to load asset file '{}'", path);
+		return false;
+	}
 
-	//blob length
-	uint32_t bloblength = file.binaryBlob.size();
-	outfile.write((const char*)&bloblength, sizeof(uint32_t));
+	// Mapped data is page aligned, so the header and tables can be used in place.
+	const char* data = static_cast<const char*>(blob->Data());
+	const uint64_t fileSize = blob->Size();
+	const FileHeader* header = reinterpret_cast<const FileHeader*>(data);
+	if (header->Magic != kMagic || header->ContainerVersion != kContainerVersion || header->FileSize != fileSize)
+	{
+		PHX_CORE_ERROR("'{}' is not a valid asset file", path);
+		return false;
+	}
 
-	//json stream
-	outfile.write(file.json.data(), length);
-	//blob data
-	outfile.write(file.binaryBlob.data(), file.binaryBlob.size());
+	// The json is followed by its terminator, so it must end strictly before the file does. Compared
+	// without adding one to JsonSize, which a corrupt header could overflow.
+	const uint64_t sectionTableSize = static_cast<uint64_t>(header->NumSections) * sizeof(SectionEntry);
+	if (!IsInFile(header->SectionTableOffset, sectionTableSize, fileSize) ||
+		header->SectionTableOffset % alignof(SectionEntry) != 0 ||
+		header->JsonOffset > fileSize ||
+		header->JsonSize >= fileSize - header->JsonOffset ||
+		data[header->JsonOffset + header->JsonSize] != '\0')
+	{
+		PHX_CORE_ERROR("'{}' has an invalid layout", path);
+		return false;
+	}
 
-	outfile.close();
+	const SectionEntry* sections = reinterpret_cast<const SectionEntry*>(data + header->SectionTableOffset);
+	for (uint32_t i = 0; i < header->NumSections; i++)
+	{
+		if (!IsInFile(sections[i].Offset, sections[i].Size, fileSize))
+		{
+			PHX_CORE_ERROR("'{}' has a section out of range", path);
+			return false;
+		}
+	}
 
+	assetFile.m_blob = std::move(blob);
+	assetFile.m_data = data;
+	assetFile.m_header = header;
+	assetFile.m_sections = sections;
 	return true;
 }
+
+bool phx::assets::SaveBinaryFile(IFileSystem* fs, const char* path, AssetFile const& assetFile)
+{
+	FileHeader header = {};
+	header.Magic = kMagic;
+	header.ContainerVersion = kContainerVersion;
+	header.ID = assetFile.ID;
+	header.Version = assetFile.Version;
+	header.NumSections = static_cast<uint32_t>(assetFile.Sections.size());
+	header.SectionTableOffset = sizeof(FileHeader);
+	header.JsonOffset = header.SectionTableOffset + assetFile.Sections.size() * sizeof(SectionEntry);
+	header.JsonSize = assetFile.Json.size();
+
+	std::vector<SectionEntry> sections(assetFile.Sections.size());
+	uint64_t offset = header.JsonOffset + header.JsonSize + 1;
+	for (size_t i = 0; i < sections.size(); i++)
+	{
+		offset = AlignOffset(offset, kSectionAlignment);
+		sections[i] = { .Offset = offset, .Size = assetFile.Sections[i].size() };
+		offset += sections[i].Size;
+	}
+	header.FileSize = offset;
+
+	// Built in one buffer so the file system writes it, and replaces any old file, in one go.
+	std::vector<char> fileData(static_cast<size_t>(header.FileSize), 0);
+	std::memcpy(fileData.data(), &header, sizeof(FileHeader));
+	if (!sections.empty())
+	{
+		std::memcpy(fileData.data() + header.SectionTableOffset, sections.data(), sections.size() * sizeof(SectionEntry));
+	}
+
+	if (!assetFile.Json.empty())
+	{
+		std::memcpy(fileData.data() + header.JsonOffset, assetFile.Json.data(), assetFile.Json.size());
+	}
+
+	for (size_t i = 0; i < sections.size(); i++)
+	{
+		if (sections[i].Size > 0)
+		{
+			std::memcpy(fileData.data() + sections[i].Offset, assetFile.Sections[i].data(), static_cast<size_t>(sections[i].Size));
+		}
+	}
+
+	return fs->WriteFile(path, Span<char>(fileData.data(), fileData.size()));
+}
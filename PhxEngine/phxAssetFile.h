@@ -1,24 +1,99 @@
 #pragma once
 
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "phxSpan.h"
+
 #define MAKE_ID(a,b,c,d)		(((d) << 24) | ((c) << 16) | ((b) << 8) | ((a)))
 
 
 namespace phx
 {
 	class IFileSystem;
+	class IBlob;
 }
 namespace phx::assets
 {
 	constexpr uint32_t kCurrentFileVersion = 1;
+
+	// Layout on disk:
+	//   FileHeader
+	//   SectionEntry[NumSections]
+	//   Json, null terminated
+	//   Sections, each starting on kSectionAlignment
+	// Everything is referenced by offset, so a mapped file is usable as is.
+	namespace FileFormat
+	{
+		constexpr uint32_t kMagic = MAKE_ID('P', 'H', 'X', 'A');
+		constexpr uint32_t kContainerVersion = 1;
+		constexpr uint64_t kSectionAlignment = 64;
+
+		struct FileHeader
+		{
+			uint32_t Magic;
+			uint32_t ContainerVersion;
+			uint32_t ID;
+			uint32_t Version;
+			uint64_t FileSize;
+			uint64_t JsonOffset;
+			uint64_t JsonSize;
+			uint64_t SectionTableOffset;
+			uint32_t NumSections;
+			uint32_t Reserved;
+		};
+
+		struct SectionEntry
+		{
+			uint64_t Offset;
+			uint64_t Size;
+		};
+
+		static_assert(sizeof(FileHeader) == 56);
+		static_assert(sizeof(SectionEntry) == 16);
+	}
+
 	struct AssetFile
 	{
 		uint32_t ID;
 		uint32_t Version = kCurrentFileVersion;
-		std::string json;
-		std::vector<char> BinaryBlob;
+		std::string Json;
+		std::vector<std::vector<char>> Sections;
 	};
 
-	bool LoadBinaryFile(IFileSystem* fs, const char* path, AssetFile& assetFile);
+	// A loaded asset file. The json and sections point into the mapped file and stay valid for the
+	// lifetime of the view.
+	class AssetFileView
+	{
+	public:
+		AssetFileView();
+		~AssetFileView();
+
+		AssetFileView(AssetFileView&&) noexcept;
+		AssetFileView& operator=(AssetFileView&&) noexcept;
+
+		[[nodiscard]] bool IsValid() const { return this->m_header != nullptr; }
+
+		[[nodiscard]] uint32_t GetID() const { return this->m_header->ID; }
+		[[nodiscard]] uint32_t GetVersion() const { return this->m_header->Version; }
+
+		// Null terminated, for parsers that want a C string.
+		[[nodiscard]] std::string_view GetJson() const;
+
+		[[nodiscard]] size_t GetNumSections() const { return this->m_header->NumSections; }
+		[[nodiscard]] Span<char> GetSection(size_t index) const;
+
+	private:
+		friend bool LoadBinaryFile(IFileSystem* fs, const char* path, AssetFileView& assetFile);
+
+		std::unique_ptr<IBlob> m_blob;
+		const char* m_data = nullptr;
+		const FileFormat::FileHeader* m_header = nullptr;
+		const FileFormat::SectionEntry* m_sections = nullptr;
+	};
+
+	bool LoadBinaryFile(IFileSystem* fs, const char* path, AssetFileView& assetFile);
 	bool SaveBinaryFile(IFileSystem* fs, const char* path, AssetFile const& assetFile);
 }
-
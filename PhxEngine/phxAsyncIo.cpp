@@ -0,0 +1,717 @@
+#include "pch.h"
+#include "phxAsyncIo.h"
+
+#include "phxMemory.h"
+
+#include <algorithm>
+#include <atomic>
+
+#ifdef PHX_PLATFORM_LINUX
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace phx;
+
+IoThreadPool& phx::IoThreadPool::Get()
+{
+	static IoThreadPool pool(std::clamp(std::thread::hardware_concurrency() / 2, 1u, 4u));
+	return pool;
+}
+
+IoThreadPool& phx::IoThreadPool::GetWorkers()
+{
+	static IoThreadPool pool(std::max(std::thread::hardware_concurrency(), 2u) - 1);
+	return pool;
+}
+
+namespace
+{
+	std::atomic<uint32_t> gMaxParallelForThreads = 0;
+}
+
+void phx::SetMaxParallelForThreads(uint32_t numThreads)
+{
+	gMaxParallelForThreads.store(numThreads, std::memory_order_relaxed);
+}
+
+uint32_t phx::GetMaxParallelForThreads()
+{
+	const uint32_t numThreads = gMaxParallelForThreads.load(std::memory_order_relaxed);
+	return numThreads ? numThreads : std::max(std::thread::hardware_concurrency(), 1u);
+}
+
+phx::IoThreadPool::IoThreadPool(uint32_t numThreads)
+{
+	this->m_threads.reserve(numThreads);
+	for (uint32_t i = 0; i < numThreads; i++)
+	{
+		this->m_threads.emplace_back([this]() { this->WorkerLoop(); });
+	}
+}
+
+phx::IoThreadPool::~IoThreadPool()
+{
+	{
+		std::scoped_lock _(this->m_mutex);
+		this->m_stop = true;
+	}
+
+	this->m_workAvailable.notify_all();
+	for (std::thread& thread : this->m_threads)
+	{
+		thread.join();
+	}
+}
+
+void phx::IoThreadPool::Submit(IoPriority priority, std::function<void()>&& work)
+{
+	{
+		std::scoped_lock _(this->m_mutex);
+		this->m_queues[static_cast<size_t>(priority)].emplace_back(std::move(work));
+	}
+
+	this->m_workAvailable.notify_one();
+}
+
+void phx::IoThreadPool::WorkerLoop()
+{
+	while (true)
+	{
+		std::function<void()> work;
+		{
+			std::unique_lock lock(this->m_mutex);
+			auto findQueue = [this]() -> std::deque<std::function<void()>>*
+				{
+					for (auto& queue : this->m_queues)
+					{
+						if (!queue.empty())
+						{
+							return &queue;
+						}
+					}
+					return nullptr;
+				};
+
+			std::deque<std::function<void()>>* queue = nullptr;
+			this->m_workAvailable.wait(lock, [&]() { return (queue = findQueue()) != nullptr || this->m_stop; });
+
+			// Queued work is drained before the pool shuts down.
+			if (!queue)
+			{
+				return;
+			}
+
+			work = std::move(queue->front());
+			queue->pop_front();
+		}
+
+		work();
+	}
+}
+
+WriteBehindQueue& phx::WriteBehindQueue::Get()
+{
+	static WriteBehindQueue queue;
+	return queue;
+}
+
+phx::WriteBehindQueue::WriteBehindQueue()
+{
+	this->m_thread = std::thread([this]() { this->WriterLoop(); });
+}
+
+phx::WriteBehindQueue::~WriteBehindQueue()
+{
+	{
+		std::scoped_lock _(this->m_mutex);
+		this->m_stop = true;
+	}
+
+	this->m_workAvailable.notify_all();
+	this->m_thread.join();
+}
+
+void phx::WriteBehindQueue::Enqueue(IFileSystem* fs, std::filesystem::path const& name, std::vector<char>&& data, WriteFileCallback&& onComplete)
+{
+	std::string key = std::to_string(reinterpret_cast<uintptr_t>(fs)) + "|" + name.lexically_normal().generic_string();
+	{
+		std::scoped_lock _(this->m_mutex);
+		auto it = this->m_pendingIndex.find(key);
+		if (it != this->m_pendingIndex.end())
+		{
+			PendingWrite& pending = this->m_pending[it->second];
+			pending.Data = std::move(data);
+			if (onComplete)
+			{
+				pending.Callbacks.emplace_back(std::move(onComplete));
+			}
+			return;
+		}
+
+		this->m_pendingIndex.emplace(std::move(key), this->m_pending.size());
+		PendingWrite& pending = this->m_pending.emplace_back();
+		pending.FS = fs;
+		pending.Path = name;
+		pending.Data = std::move(data);
+		if (onComplete)
+		{
+			pending.Callbacks.emplace_back(std::move(onComplete));
+		}
+
+		this->m_outstanding[fs]++;
+		this->m_numOutstanding++;
+	}
+
+	this->m_workAvailable.notify_one();
+}
+
+void phx::WriteBehindQueue::Flush(IFileSystem* fs)
+{
+	std::unique_lock lock(this->m_mutex);
+	this->m_writeFinished.wait(lock, [&]()
+		{
+			if (!fs)
+			{
+				return this->m_numOutstanding == 0;
+			}
+
+			auto it = this->m_outstanding.find(fs);
+			return it == this->m_outstanding.end();
+		});
+}
+
+void phx::WriteBehindQueue::WriterLoop()
+{
+	while (true)
+	{
+		std::vector<PendingWrite> batch;
+		{
+			std::unique_lock lock(this->m_mutex);
+			this->m_workAvailable.wait(lock, [this]() { return !this->m_pending.empty() || this->m_stop; });
+
+			// Queued writes are finished before shutting down.
+			if (this->m_pending.empty())
+			{
+				return;
+			}
+
+			batch.swap(this->m_pending);
+			this->m_pendingIndex.clear();
+		}
+
+		for (PendingWrite& write : batch)
+		{
+			const bool success = write.FS->WriteFile(write.Path, Span<char>(write.Data.data(), write.Data.size()));
+			for (WriteFileCallback& callback : write.Callbacks)
+			{
+				callback(success);
+			}
+
+			// Free the data before waking anyone flushing, they may be waiting on memory.
+			write.Data = {};
+
+			{
+				std::scoped_lock _(this->m_mutex);
+				auto it = this->m_outstanding.find(write.FS);
+				if (--it->second == 0)
+				{
+					this->m_outstanding.erase(it);
+				}
+				this->m_numOutstanding--;
+			}
+
+			this->m_writeFinished.notify_all();
+		}
+	}
+}
+
+#ifdef PHX_PLATFORM_LINUX
+namespace
+{
+	// io_uring driven through the raw syscalls, one thread owns the ring. Pending requests are
+	// pulled in priority order whenever a slot frees up, so up to kQueueDepth reads are in flight.
+	class UringReader
+	{
+	public:
+		static constexpr uint32_t kQueueDepth = 64;
+
+		UringReader()
+		{
+			// Large files are passed on to the pool, make sure it outlives the ring thread.
+			IoThreadPool::Get();
+
+			if (this->InitializeRing())
+			{
+				this->m_thread = std::thread([this]() { this->RingLoop(); });
+			}
+		}
+
+		~UringReader()
+		{
+			if (this->m_thread.joinable())
+			{
+				{
+					std::scoped_lock _(this->m_mutex);
+					this->m_stop = true;
+				}
+
+				this->m_workAvailable.notify_one();
+				this->m_thread.join();
+			}
+
+			this->FinalizeRing();
+		}
+
+		bool IsAvailable() const { return this->m_thread.joinable(); }
+
+		void Submit(Span<ReadFileRequest> requests, IFileSystem* fallbackFs, TlsfAllocator* heap, size_t memoryMapThreshold)
+		{
+			{
+				std::scoped_lock _(this->m_mutex);
+				for (const ReadFileRequest& request : requests)
+				{
+					this->m_pending[static_cast<size_t>(request.Priority)].push_back({
+						.Request = request,
+						.FallbackFs = fallbackFs,
+						.Heap = heap,
+						.MemoryMapThreshold = memoryMapThreshold });
+				}
+			}
+
+			this->m_workAvailable.notify_one();
+		}
+
+	private:
+		struct PendingRead
+		{
+			ReadFileRequest Request;
+			IFileSystem* FallbackFs;
+			TlsfAllocator* Heap;
+			size_t MemoryMapThreshold;
+		};
+
+		struct InFlightRead
+		{
+			ReadFileCallback OnComplete;
+			TlsfAllocator* Heap;
+			int Fd;
+			char* Data;
+			size_t Size;
+			size_t Offset;
+		};
+
+		bool InitializeRing()
+		{
+			io_uring_params params = {};
+			this->m_ringFd = static_cast<int>(syscall(__NR_io_uring_setup, kQueueDepth, &params));
+			if (this->m_ringFd < 0)
+			{
+				return false;
+			}
+
+			this->m_sqRingSize = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+			this->m_cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+			const bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+			if (singleMap)
+			{
+				this->m_sqRingSize = this->m_cqRingSize = std::max(this->m_sqRingSize, this->m_cqRingSize);
+			}
+
+			void* sqRing = mmap(nullptr, this->m_sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, this->m_ringFd, IORING_OFF_SQ_RING);
+			if (sqRing == MAP_FAILED)
+			{
+				this->FinalizeRing();
+				return false;
+			}
+			this->m_sqRing = static_cast<uint8_t*>(sqRing);
+
+			if (singleMap)
+			{
+				this->m_cqRing = this->m_sqRing;
+			}
+			else
+			{
+				void* cqRing = mmap(nullptr, this->m_cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, this->m_ringFd, IORING_OFF_CQ_RING);
+				if (cqRing == MAP_FAILED)
+				{
+					this->FinalizeRing();
+					return false;
+				}
+				this->m_cqRing = static_cast<uint8_t*>(cqRing);
+			}
+
+			this->m_sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+			void* sqes = mmap(nullptr, this->m_sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, this->m_ringFd, IORING_OFF_SQES);
+			if (sqes == MAP_FAILED)
+			{
+				this->FinalizeRing();
+				return false;
+			}
+			this->m_sqes = static_cast<io_uring_sqe*>(sqes);
+
+			this->m_sqTail = reinterpret_cast<uint32_t*>(this->m_sqRing + params.sq_off.tail);
+			this->m_sqMask = *reinterpret_cast<uint32_t*>(this->m_sqRing + params.sq_off.ring_mask);
+			this->m_sqArray = reinterpret_cast<uint32_t*>(this->m_sqRing + params.sq_off.array);
+			this->m_cqHead = reinterpret_cast<uint32_t*>(this->m_cqRing + params.cq_off.head);
+			this->m_cqTail = reinterpret_cast<uint32_t*>(this->m_cqRing + params.cq_off.tail);
+			this->m_cqMask = *reinterpret_cast<uint32_t*>(this->m_cqRing + params.cq_off.ring_mask);
+			this->m_cqes = reinterpret_cast<io_uring_cqe*>(this->m_cqRing + params.cq_off.cqes);
+
+			// IORING_OP_READ arrived in 5.6, the same release as the probe, so a failed probe means no support.
+			constexpr uint32_t kNumProbeOps = 256;
+			std::vector<uint8_t> probeMemory(sizeof(io_uring_probe) + kNumProbeOps * sizeof(io_uring_probe_op), 0);
+			auto* probe = reinterpret_cast<io_uring_probe*>(probeMemory.data());
+			const long probeResult = syscall(__NR_io_uring_register, this->m_ringFd, IORING_REGISTER_PROBE, probe, kNumProbeOps);
+			if (probeResult < 0 || probe->last_op < IORING_OP_READ || !(probe->ops[IORING_OP_READ].flags & IO_URING_OP_SUPPORTED))
+			{
+				this->FinalizeRing();
+				return false;
+			}
+
+			return true;
+		}
+
+		void FinalizeRing()
+		{
+			if (this->m_sqes)
+			{
+				munmap(this->m_sqes, this->m_sqesSize);
+				this->m_sqes = nullptr;
+			}
+
+			if (this->m_cqRing && this->m_cqRing != this->m_sqRing)
+			{
+				munmap(this->m_cqRing, this->m_cqRingSize);
+			}
+			this->m_cqRing = nullptr;
+
+			if (this->m_sqRing)
+			{
+				munmap(this->m_sqRing, this->m_sqRingSize);
+				this->m_sqRing = nullptr;
+			}
+
+			if (this->m_ringFd >= 0)
+			{
+				close(this->m_ringFd);
+				this->m_ringFd = -1;
+			}
+		}
+
+		PendingRead* FindPending()
+		{
+			for (auto& queue : this->m_pending)
+			{
+				if (!queue.empty())
+				{
+					return &queue.front();
+				}
+			}
+
+			return nullptr;
+		}
+
+		void PopPending()
+		{
+			for (auto& queue : this->m_pending)
+			{
+				if (!queue.empty())
+				{
+					queue.pop_front();
+					return;
+				}
+			}
+		}
+
+		void RingLoop()
+		{
+			std::vector<PendingRead> starting;
+			starting.reserve(kQueueDepth);
+
+			while (true)
+			{
+				{
+					std::unique_lock lock(this->m_mutex);
+					if (this->m_numInFlight == 0)
+					{
+						this->m_workAvailable.wait(lock, [this]() { return this->m_stop || this->FindPending(); });
+					}
+
+					// Pending and in flight reads are drained before the ring shuts down.
+					if (this->m_stop && this->m_numInFlight == 0 && !this->FindPending())
+					{
+						return;
+					}
+
+					while (this->m_numInFlight + starting.size() < kQueueDepth)
+					{
+						PendingRead* pending = this->FindPending();
+						if (!pending)
+						{
+							break;
+						}
+
+						starting.emplace_back(std::move(*pending));
+						this->PopPending();
+					}
+				}
+
+				// Opening runs outside the lock so producers are never blocked on the file system.
+				for (PendingRead& pending : starting)
+				{
+					this->StartRead(std::move(pending));
+				}
+				starting.clear();
+
+				if (this->m_numInFlight == 0)
+				{
+					continue;
+				}
+
+				const long submitted = syscall(__NR_io_uring_enter, this->m_ringFd, this->m_numUnsubmitted, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+				if (submitted > 0)
+				{
+					this->m_numUnsubmitted -= static_cast<uint32_t>(submitted);
+				}
+
+				this->ReapCompletions();
+			}
+		}
+
+		void StartRead(PendingRead&& pending)
+		{
+			ReadFileRequest& request = pending.Request;
+			const int fd = open(request.Path.c_str(), O_RDONLY | O_CLOEXEC);
+			if (fd < 0)
+			{
+				Finish(request.OnComplete, nullptr);
+				return;
+			}
+
+			struct stat fileStat = {};
+			if (fstat(fd, &fileStat) != 0)
+			{
+				close(fd);
+				Finish(request.OnComplete, nullptr);
+				return;
+			}
+
+			const size_t size = static_cast<size_t>(fileStat.st_size);
+			if (size == 0)
+			{
+				close(fd);
+				Finish(request.OnComplete, FileSystemFactory::CreateBlob(nullptr, 0));
+				return;
+			}
+
+			if (size >= pending.MemoryMapThreshold)
+			{
+				// Large files are mapped rather than read, which is a blocking call of its own.
+				close(fd);
+				IoThreadPool::Get().Submit(
+					request.Priority,
+					[fs = pending.FallbackFs, path = std::move(request.Path), onComplete = std::move(request.OnComplete)]()
+					{
+						Finish(onComplete, fs->ReadFile(path));
+					});
+				return;
+			}
+
+			char* data = pending.Heap
+				? static_cast<char*>(pending.Heap->Allocate(size))
+				: static_cast<char*>(malloc(size));
+
+			if (!data)
+			{
+				close(fd);
+				PHX_CORE_ERROR("Out of memory");
+				Finish(request.OnComplete, nullptr);
+				return;
+			}
+
+			InFlightRead* read = new InFlightRead{
+				.OnComplete = std::move(request.OnComplete),
+				.Heap = pending.Heap,
+				.Fd = fd,
+				.Data = data,
+				.Size = size,
+				.Offset = 0 };
+
+			this->m_numInFlight++;
+			this->QueueRead(read);
+		}
+
+		void QueueRead(InFlightRead* read)
+		{
+			// Each read in flight owns at most one SQE, so with kQueueDepth entries the ring never overflows.
+			const uint32_t tail = *this->m_sqTail;
+			const uint32_t index = tail & this->m_sqMask;
+
+			io_uring_sqe* sqe = &this->m_sqes[index];
+			std::memset(sqe, 0, sizeof(io_uring_sqe));
+			sqe->opcode = IORING_OP_READ;
+			sqe->fd = read->Fd;
+			sqe->addr = reinterpret_cast<uint64_t>(read->Data + read->Offset);
+			sqe->len = static_cast<uint32_t>(std::min<size_t>(read->Size - read->Offset, 1u << 30));
+			sqe->off = read->Offset;
+			sqe->user_data = reinterpret_cast<uint64_t>(read);
+
+			this->m_sqArray[index] = index;
+			std::atomic_ref<uint32_t>(*this->m_sqTail).store(tail + 1, std::memory_order_release);
+			this->m_numUnsubmitted++;
+		}
+
+		void ReapCompletions()
+		{
+			uint32_t head = *this->m_cqHead;
+			const uint32_t tail = std::atomic_ref<uint32_t>(*this->m_cqTail).load(std::memory_order_acquire);
+
+			while (head != tail)
+			{
+				const io_uring_cqe& cqe = this->m_cqes[head & this->m_cqMask];
+				InFlightRead* read = reinterpret_cast<InFlightRead*>(cqe.user_data);
+				const int result = cqe.res;
+				head++;
+
+				if (result == -EINTR || result == -EAGAIN)
+				{
+					this->QueueRead(read);
+				}
+				else if (result < 0)
+				{
+					this->CompleteRead(read, false);
+				}
+				else
+				{
+					read->Offset += static_cast<size_t>(result);
+
+					// A zero byte read means the file shrank underneath us, keep what was read.
+					if (result == 0)
+					{
+						read->Size = read->Offset;
+					}
+
+					if (read->Offset < read->Size)
+					{
+						this->QueueRead(read);
+					}
+					else
+					{
+						this->CompleteRead(read, true);
+					}
+				}
+			}
+
+			std::atomic_ref<uint32_t>(*this->m_cqHead).store(head, std::memory_order_release);
+		}
+
+		void CompleteRead(InFlightRead* read, bool succeeded)
+		{
+			close(read->Fd);
+			this->m_numInFlight--;
+
+			std::unique_ptr<IBlob> blob;
+			if (succeeded)
+			{
+				blob = read->Heap
+					? FileSystemFactory::CreateBlob(read->Data, read->Size, read->Heap)
+					: FileSystemFactory::CreateBlob(read->Data, read->Size);
+			}
+			else
+			{
+				PHX_CORE_ERROR("Reading error");
+				if (read->Heap)
+				{
+					read->Heap->Free(read->Data);
+				}
+				else
+				{
+					free(read->Data);
+				}
+			}
+
+			Finish(read->OnComplete, std::move(blob));
+			delete read;
+		}
+
+		static void Finish(ReadFileCallback const& onComplete, std::unique_ptr<IBlob> blob)
+		{
+			if (onComplete)
+			{
+				onComplete(std::move(blob));
+			}
+		}
+
+	private:
+		int m_ringFd = -1;
+		uint8_t* m_sqRing = nullptr;
+		uint8_t* m_cqRing = nullptr;
+		size_t m_sqRingSize = 0;
+		size_t m_cqRingSize = 0;
+		size_t m_sqesSize = 0;
+
+		uint32_t* m_sqTail = nullptr;
+		uint32_t m_sqMask = 0;
+		uint32_t* m_sqArray = nullptr;
+		io_uring_sqe* m_sqes = nullptr;
+
+		uint32_t* m_cqHead = nullptr;
+		uint32_t* m_cqTail = nullptr;
+		uint32_t m_cqMask = 0;
+		io_uring_cqe* m_cqes = nullptr;
+
+		// -- Ring thread only ---
+		uint32_t m_numInFlight = 0;
+		uint32_t m_numUnsubmitted = 0;
+
+		std::mutex m_mutex;
+		std::condition_variable m_workAvailable;
+		std::array<std::deque<PendingRead>, static_cast<size_t>(IoPriority::Count)> m_pending;
+		bool m_stop = false;
+		std::thread m_thread;
+	};
+
+	UringReader& GetUringReader()
+	{
+		static UringReader reader;
+		return reader;
+	}
+}
+#endif
+
+namespace phx::AsyncIo
+{
+	bool IsUringAvailable()
+	{
+#ifdef PHX_PLATFORM_LINUX
+		return GetUringReader().IsAvailable();
+#else
+		return false;
+#endif
+	}
+
+	bool SubmitUringReads(Span<ReadFileRequest> requests, IFileSystem* fallbackFs, TlsfAllocator* heap, size_t memoryMapThreshold)
+	{
+#ifdef PHX_PLATFORM_LINUX
+		UringReader& reader = GetUringReader();
+		if (reader.IsAvailable())
+		{
+			reader.Submit(requests, fallbackFs, heap, memoryMapThreshold);
+			return true;
+		}
+#else
+		(void)requests;
+		(void)fallbackFs;
+		(void)heap;
+		(void)memoryMapThreshold;
+#endif
+		return false;
+	}
+}
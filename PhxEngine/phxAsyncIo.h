@@ -0,0 +1,155 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <latch>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "phxVFS.h"
+
+namespace phx
+{
+	// Small pool of threads for blocking file I/O. Queued work runs highest priority first.
+	class IoThreadPool
+	{
+	public:
+		static IoThreadPool& Get();
+
+		// Pool sized to the machine for CPU bound work, such as compression, run with ParallelFor.
+		static IoThreadPool& GetWorkers();
+
+		explicit IoThreadPool(uint32_t numThreads);
+		~IoThreadPool();
+
+		IoThreadPool(IoThreadPool const&) = delete;
+		IoThreadPool& operator=(IoThreadPool const&) = delete;
+
+		void Submit(IoPriority priority, std::function<void()>&& work);
+
+	private:
+		void WorkerLoop();
+
+	private:
+		std::mutex m_mutex;
+		std::condition_variable m_workAvailable;
+		std::array<std::deque<std::function<void()>>, static_cast<size_t>(IoPriority::Count)> m_queues;
+		std::vector<std::thread> m_threads;
+		bool m_stop = false;
+	};
+
+	// Caps the threads ParallelFor runs on, the calling thread included, for tools sharing the machine
+	// or to measure how work scales. 0, the default, uses one thread per core.
+	void SetMaxParallelForThreads(uint32_t numThreads);
+	uint32_t GetMaxParallelForThreads();
+
+	// Runs fn(i) for every i below count across IoThreadPool::GetWorkers, with the calling thread
+	// taking items too. Returns once every item has run; workers that start late find nothing left.
+	template<typename Fn>
+	void ParallelFor(uint32_t count, Fn const& fn)
+	{
+		struct State
+		{
+			std::atomic<uint32_t> Next = 0;
+			std::latch Done;
+			uint32_t Count;
+			Fn const* Work;
+
+			explicit State(uint32_t count, Fn const* work)
+				: Done(count)
+				, Count(count)
+				, Work(work)
+			{}
+
+			void Run()
+			{
+				for (uint32_t i = this->Next.fetch_add(1); i < this->Count; i = this->Next.fetch_add(1))
+				{
+					(*this->Work)(i);
+					this->Done.count_down();
+				}
+			}
+		};
+
+		if (count <= 1)
+		{
+			for (uint32_t i = 0; i < count; i++)
+			{
+				fn(i);
+			}
+			return;
+		}
+
+		auto state = std::make_shared<State>(count, &fn);
+		const uint32_t numHelpers = std::min<uint32_t>(count, GetMaxParallelForThreads()) - 1;
+		for (uint32_t i = 0; i < numHelpers; i++)
+		{
+			IoThreadPool::GetWorkers().Submit(IoPriority::High, [state]() { state->Run(); });
+		}
+
+		state->Run();
+		state->Done.wait();
+	}
+
+	// Single background thread that writes files queued with IFileSystem::WriteFileAsync. One writer
+	// keeps writes to the same file in order, and it takes everything queued at once so writes
+	// queued while it's busy get merged.
+	class WriteBehindQueue
+	{
+	public:
+		static WriteBehindQueue& Get();
+
+		WriteBehindQueue();
+		~WriteBehindQueue();
+
+		WriteBehindQueue(WriteBehindQueue const&) = delete;
+		WriteBehindQueue& operator=(WriteBehindQueue const&) = delete;
+
+		void Enqueue(IFileSystem* fs, std::filesystem::path const& name, std::vector<char>&& data, WriteFileCallback&& onComplete);
+
+		// Waits for writes queued through fs, or all writes when fs is null.
+		void Flush(IFileSystem* fs = nullptr);
+
+	private:
+		struct PendingWrite
+		{
+			IFileSystem* FS;
+			std::filesystem::path Path;
+			std::vector<char> Data;
+			std::vector<WriteFileCallback> Callbacks;
+		};
+
+		void WriterLoop();
+
+	private:
+		std::mutex m_mutex;
+		std::condition_variable m_workAvailable;
+		std::condition_variable m_writeFinished;
+		std::vector<PendingWrite> m_pending;
+		std::unordered_map<std::string, size_t> m_pendingIndex;
+		std::unordered_map<IFileSystem*, uint32_t> m_outstanding;
+		uint32_t m_numOutstanding = 0;
+		std::thread m_thread;
+		bool m_stop = false;
+	};
+
+	namespace AsyncIo
+	{
+		// True when reads can go through io_uring, which needs Linux 5.6 or later.
+		bool IsUringAvailable();
+
+		// Reads whole native files through io_uring, keeping many requests in flight. Files at or
+		// above memoryMapThreshold are handed to fallbackFs->ReadFile on the I/O thread pool so they
+		// still get mapped. Data is allocated from heap when one is given. Returns false, without
+		// queueing anything, when io_uring is unavailable.
+		bool SubmitUringReads(Span<ReadFileRequest> requests, IFileSystem* fallbackFs, TlsfAllocator* heap, size_t memoryMapThreshold);
+	}
+}
@@ -0,0 +1,270 @@
+#include "pch.h"
+#include "phxCachedFileSystem.h"
+
+#include <cstring>
+
+using namespace phx;
+
+namespace
+{
+	class SharedBlob : public IBlob
+	{
+	public:
+		explicit SharedBlob(std::shared_ptr<IBlob> blob)
+			: m_blob(std::move(blob))
+		{}
+
+		[[nodiscard]] const void* Data() const override { return this->m_blob->Data(); }
+		[[nodiscard]] size_t Size() const override { return this->m_blob->Size(); }
+
+	private:
+		std::shared_ptr<IBlob> m_blob;
+	};
+
+	std::string MakeKey(std::filesystem::path const& name)
+	{
+		return name.lexically_normal().generic_string();
+	}
+}
+
+phx::CachedFileSystem::CachedFileSystem(std::shared_ptr<IFileSystem> fs, size_t budgetBytes, bool checkWriteTime)
+	: m_underlyingFS(std::move(fs))
+	, m_budgetBytes(budgetBytes)
+	, m_checkWriteTime(checkWriteTime)
+{
+	this->m_stats.BudgetBytes = budgetBytes;
+}
+
+bool phx::CachedFileSystem::FileExists(std::filesystem::path const& name)
+{
+	return this->m_underlyingFS->FileExists(name);
+}
+
+bool phx::CachedFileSystem::FolderExists(std::filesystem::path const& name)
+{
+	return this->m_underlyingFS->FolderExists(name);
+}
+
+std::unique_ptr<IBlob> phx::CachedFileSystem::ReadFile(std::filesystem::path const& name)
+{
+	std::string key = MakeKey(name);
+	std::shared_ptr<IBlob> blob = this->FindCurrent(key, name);
+	if (blob)
+	{
+		return std::make_unique<SharedBlob>(std::move(blob));
+	}
+
+	// Taking the time before reading means a write racing the read leaves a stale time behind,
+	// which the next hit catches.
+	std::filesystem::file_time_type writeTime = {};
+	const bool hasWriteTime = this->m_checkWriteTime && this->m_underlyingFS->GetLastWriteTime(name, writeTime);
+
+	blob = this->m_underlyingFS->ReadFile(name);
+	if (!blob)
+	{
+		return nullptr;
+	}
+
+	this->Insert(std::move(key), blob, writeTime, hasWriteTime);
+	return std::make_unique<SharedBlob>(std::move(blob));
+}
+
+bool phx::CachedFileSystem::WriteFile(std::filesystem::path const& name, Span<char> Data)
+{
+	const bool result = this->m_underlyingFS->WriteFile(name, Data);
+	this->Invalidate(name);
+	return result;
+}
+
+std::unique_ptr<IBlob> phx::CachedFileSystem::MapFile(std::filesystem::path const& name, MapAdvice advice)
+{
+	// Mapped files are left to the OS page cache rather than taking up the budget.
+	std::shared_ptr<IBlob> blob = this->FindCurrent(MakeKey(name), name);
+	if (blob)
+	{
+		return std::make_unique<SharedBlob>(std::move(blob));
+	}
+
+	return this->m_underlyingFS->MapFile(name, advice);
+}
+
+bool phx::CachedFileSystem::ReadFileRange(std::filesystem::path const& name, uint64_t offset, size_t size, void* destination)
+{
+	std::shared_ptr<IBlob> blob = this->FindCurrent(MakeKey(name), name);
+	if (!blob)
+	{
+		return this->m_underlyingFS->ReadFileRange(name, offset, size, destination);
+	}
+
+	if (offset > blob->Size() || size > blob->Size() - offset)
+	{
+		return false;
+	}
+
+	if (size > 0)
+	{
+		std::memcpy(destination, static_cast<const uint8_t*>(blob->Data()) + offset, size);
+	}
+
+	return true;
+}
+
+bool phx::CachedFileSystem::GetLastWriteTime(std::filesystem::path const& name, std::filesystem::file_time_type& outTime)
+{
+	return this->m_underlyingFS->GetLastWriteTime(name, outTime);
+}
+
+bool phx::CachedFileSystem::RemoveFile(std::filesystem::path const& name)
+{
+	const bool result = this->m_underlyingFS->RemoveFile(name);
+	this->Invalidate(name);
+	return result;
+}
+
+FileWatchHandle phx::CachedFileSystem::WatchDirectory(std::filesystem::path const& directory, FileChangeCallback&& onChange)
+{
+	return this->m_underlyingFS->WatchDirectory(
+		directory,
+		[this, onChange = std::move(onChange)](Span<FileChangeEvent> changes)
+		{
+			for (FileChangeEvent const& change : changes)
+			{
+				if (change.Type == FileChangeType::Rescan)
+				{
+					this->InvalidateAll();
+				}
+				else
+				{
+					this->Invalidate(change.Path);
+				}
+			}
+
+			onChange(changes);
+		});
+}
+
+void phx::CachedFileSystem::Unwatch(FileWatchHandle handle)
+{
+	this->m_underlyingFS->Unwatch(handle);
+}
+
+void phx::CachedFileSystem::Invalidate(std::filesystem::path const& name)
+{
+	const std::string key = MakeKey(name);
+
+	std::scoped_lock _(this->m_mutex);
+	auto it = this->m_entries.find(key);
+	if (it != this->m_entries.end())
+	{
+		this->EraseLocked(it);
+		this->m_stats.Invalidations++;
+	}
+}
+
+void phx::CachedFileSystem::InvalidateAll()
+{
+	std::scoped_lock _(this->m_mutex);
+	this->m_stats.Invalidations += this->m_entries.size();
+	this->m_entries.clear();
+	this->m_lru.clear();
+	this->m_stats.NumEntries = 0;
+	this->m_stats.CachedBytes = 0;
+}
+
+BlobCacheStats phx::CachedFileSystem::GetStats()
+{
+	std::scoped_lock _(this->m_mutex);
+	return this->m_stats;
+}
+
+std::shared_ptr<IBlob> phx::CachedFileSystem::FindCurrent(std::string const& key, std::filesystem::path const& name)
+{
+	std::shared_ptr<IBlob> blob;
+	std::filesystem::file_time_type cachedTime;
+	bool hasCachedTime = false;
+	{
+		std::scoped_lock _(this->m_mutex);
+		auto it = this->m_entries.find(key);
+		if (it == this->m_entries.end())
+		{
+			this->m_stats.Misses++;
+			return nullptr;
+		}
+
+		blob = it->second->Blob;
+		cachedTime = it->second->WriteTime;
+		hasCachedTime = it->second->HasWriteTime;
+	}
+
+	// Query the time outside the lock, it can hit the disk.
+	bool isCurrent = true;
+	if (this->m_checkWriteTime)
+	{
+		std::filesystem::file_time_type writeTime;
+		const bool hasWriteTime = this->m_underlyingFS->GetLastWriteTime(name, writeTime);
+		isCurrent = hasWriteTime == hasCachedTime && (!hasWriteTime || writeTime == cachedTime);
+	}
+
+	std::scoped_lock _(this->m_mutex);
+	auto it = this->m_entries.find(key);
+	if (!isCurrent)
+	{
+		// Another thread may have replaced the entry meanwhile, only drop the one that was checked.
+		if (it != this->m_entries.end() && it->second->Blob == blob)
+		{
+			this->EraseLocked(it);
+			this->m_stats.Invalidations++;
+		}
+
+		this->m_stats.Misses++;
+		return nullptr;
+	}
+
+	if (it != this->m_entries.end())
+	{
+		this->m_lru.splice(this->m_lru.begin(), this->m_lru, it->second);
+	}
+
+	this->m_stats.Hits++;
+	return blob;
+}
+
+void phx::CachedFileSystem::Insert(std::string&& key, std::shared_ptr<IBlob> const& blob, std::filesystem::file_time_type writeTime, bool hasWriteTime)
+{
+	const size_t size = blob->Size();
+	if (size > this->m_budgetBytes)
+	{
+		return;
+	}
+
+	std::scoped_lock _(this->m_mutex);
+	auto existing = this->m_entries.find(key);
+	if (existing != this->m_entries.end())
+	{
+		this->EraseLocked(existing);
+	}
+
+	this->m_lru.push_front({
+		.Key = std::move(key),
+		.Blob = blob,
+		.WriteTime = writeTime,
+		.HasWriteTime = hasWriteTime });
+	this->m_entries.emplace(this->m_lru.front().Key, this->m_lru.begin());
+	this->m_stats.NumEntries++;
+	this->m_stats.CachedBytes += size;
+
+	while (this->m_stats.CachedBytes > this->m_budgetBytes)
+	{
+		this->EraseLocked(this->m_entries.find(this->m_lru.back().Key));
+		this->m_stats.Evictions++;
+	}
+}
+
+void phx::CachedFileSystem::EraseLocked(std::unordered_map<std::string, std::list<Entry>::iterator>::iterator it)
+{
+	auto entry = it->second;
+	this->m_stats.NumEntries--;
+	this->m_stats.CachedBytes -= entry->Blob->Size();
+	this->m_entries.erase(it);
+	this->m_lru.erase(entry);
+}
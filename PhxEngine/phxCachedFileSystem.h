@@ -0,0 +1,75 @@
+#pragma once
+
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "phxVFS.h"
+
+namespace phx
+{
+	struct BlobCacheStats
+	{
+		uint64_t Hits = 0;
+		uint64_t Misses = 0;
+		uint64_t Evictions = 0;
+		uint64_t Invalidations = 0;
+		size_t NumEntries = 0;
+		size_t CachedBytes = 0;
+		size_t BudgetBytes = 0;
+	};
+
+	// Keeps recently read files in memory, up to a byte budget, evicting the least recently used.
+	// Blobs handed out share the cached data, so they stay valid after eviction. Wraps any file
+	// system and can be mounted in its place, e.g. under /shaders.
+	class CachedFileSystem final : public IFileSystem
+	{
+	public:
+		// With checkWriteTime, every hit compares the underlying modification time and drops the
+		// entry if the file changed. Leave it off for file systems that never change.
+		CachedFileSystem(std::shared_ptr<IFileSystem> fs, size_t budgetBytes, bool checkWriteTime = true);
+
+		bool FileExists(std::filesystem::path const& name) override;
+		bool FolderExists(std::filesystem::path const& name) override;
+		std::unique_ptr<IBlob> ReadFile(std::filesystem::path const& name) override;
+		bool WriteFile(std::filesystem::path const& name, Span<char> Data) override;
+		std::unique_ptr<IBlob> MapFile(std::filesystem::path const& name, MapAdvice advice) override;
+		bool ReadFileRange(std::filesystem::path const& name, uint64_t offset, size_t size, void* destination) override;
+		bool GetLastWriteTime(std::filesystem::path const& name, std::filesystem::file_time_type& outTime) override;
+		bool RemoveFile(std::filesystem::path const& name) override;
+		// Changes reported through the cache also drop the changed files from it, a rescan drops
+		// everything.
+		FileWatchHandle WatchDirectory(std::filesystem::path const& directory, FileChangeCallback&& onChange) override;
+		void Unwatch(FileWatchHandle handle) override;
+
+		void Invalidate(std::filesystem::path const& name);
+		void InvalidateAll();
+
+		BlobCacheStats GetStats();
+
+	private:
+		struct Entry
+		{
+			std::string Key;
+			std::shared_ptr<IBlob> Blob;
+			std::filesystem::file_time_type WriteTime;
+			bool HasWriteTime;
+		};
+
+		// Cached blob for key if it's still current, counting the hit or miss.
+		std::shared_ptr<IBlob> FindCurrent(std::string const& key, std::filesystem::path const& name);
+		void Insert(std::string&& key, std::shared_ptr<IBlob> const& blob, std::filesystem::file_time_type writeTime, bool hasWriteTime);
+		void EraseLocked(std::unordered_map<std::string, std::list<Entry>::iterator>::iterator it);
+
+	private:
+		std::shared_ptr<IFileSystem> m_underlyingFS;
+		size_t m_budgetBytes;
+		bool m_checkWriteTime;
+
+		std::mutex m_mutex;
+		std::list<Entry> m_lru; // Most recently used at the front.
+		std::unordered_map<std::string, std::list<Entry>::iterator> m_entries;
+		BlobCacheStats m_stats;
+	};
+}
@@ -0,0 +1,449 @@
+#include "pch.h"
+#include "phxCodec.h"
+
+#include "phxAsyncIo.h"
+#include "phxGDeflate.h"
+#include "phxLz4.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <vector>
+
+#if __has_include(<zstd.h>)
+#include <zstd.h>
+#define PHX_HAS_ZSTD
+#endif
+
+using namespace phx;
+using namespace phx::Codec;
+
+namespace
+{
+	constexpr size_t kMaxGDeflateTiles = UINT16_MAX;
+
+	size_t TileCompressBound(Type codec, size_t tileSize)
+	{
+		switch (codec)
+		{
+		case Type::Lz4:
+			return Lz4::CompressBound(tileSize);
+#ifdef PHX_HAS_ZSTD
+		case Type::Zstd:
+			return ZSTD_compressBound(tileSize);
+#endif
+		case Type::GDeflate:
+			return GDeflate::CompressBound(tileSize);
+		default:
+			return 0;
+		}
+	}
+
+	size_t CompressTile(Type codec, const void* src, size_t srcSize, void* dst, size_t dstCapacity, int level)
+	{
+		switch (codec)
+		{
+		case Type::Lz4:
+			return Lz4::Compress(src, srcSize, dst, dstCapacity);
+#ifdef PHX_HAS_ZSTD
+		case Type::Zstd:
+		{
+			const size_t result = ZSTD_compress(dst, dstCapacity, src, srcSize, level ? level : ZSTD_CLEVEL_DEFAULT);
+			return ZSTD_isError(result) ? 0 : result;
+		}
+#endif
+		case Type::GDeflate:
+			return GDeflate::Compress(src, srcSize, dst, dstCapacity, level);
+		default:
+			return 0;
+		}
+	}
+
+	bool DecompressTileData(Type codec, const void* src, size_t srcSize, void* dst, size_t dstSize)
+	{
+		switch (codec)
+		{
+		case Type::Lz4:
+			return Lz4::Decompress(src, srcSize, dst, dstSize);
+#ifdef PHX_HAS_ZSTD
+		case Type::Zstd:
+			return ZSTD_decompress(dst, dstSize, src, srcSize) == dstSize;
+#endif
+		case Type::GDeflate:
+			return GDeflate::Decompress(src, srcSize, dst, dstSize);
+		default:
+			return false;
+		}
+	}
+
+	uint64_t GetNumTiles(uint64_t size, uint32_t tileSize)
+	{
+		return (size + tileSize - 1) / tileSize;
+	}
+
+	size_t GetHeaderSize(Type codec)
+	{
+		return codec == Type::GDeflate ? sizeof(GDeflate::StreamHeader) : sizeof(TileStreamHeader);
+	}
+
+	size_t TileStreamBound(Type codec, size_t srcSize, uint32_t tileSize)
+	{
+		if (!IsValidTileSize(codec, tileSize))
+		{
+			return 0;
+		}
+
+		const size_t numTiles = GetNumTiles(srcSize, tileSize);
+		if (codec == Type::GDeflate && numTiles > kMaxGDeflateTiles)
+		{
+			return 0;
+		}
+		return GetHeaderSize(codec) + numTiles * (sizeof(uint32_t) + TileCompressBound(codec, tileSize));
+	}
+
+	// GDeflate streams store offsets, with the last tile's size up front, and can't mark raw tiles.
+	void WriteHeader(Type codec, size_t srcSize, uint32_t tileSize, std::vector<uint32_t> const& tileSizes, uint8_t* dst)
+	{
+		const uint32_t numTiles = static_cast<uint32_t>(tileSizes.size());
+		std::vector<uint32_t> table(tileSizes);
+		if (codec == Type::GDeflate)
+		{
+			const GDeflate::StreamHeader header = {
+				.Id = GDeflate::kStreamId,
+				.Magic = static_cast<uint8_t>(GDeflate::kStreamId ^ 0xff),
+				.NumTiles = static_cast<uint16_t>(numTiles),
+				.TileSizeIndex = 1,
+				.LastTileSize = static_cast<uint32_t>(srcSize % GDeflate::kTileSize),
+				.Reserved = 0 };
+			std::memcpy(dst, &header, sizeof(header));
+
+			uint32_t offset = 0;
+			for (uint32_t tile = 0; tile < numTiles; tile++)
+			{
+				table[tile] = offset;
+				offset += tileSizes[tile];
+			}
+			if (numTiles > 0)
+			{
+				table[0] = tileSizes[numTiles - 1];
+			}
+		}
+		else
+		{
+			const TileStreamHeader header = {
+				.Magic = kTileStreamMagic,
+				.TileCodec = codec,
+				.Reserved = {},
+				.TileSize = tileSize,
+				.NumTiles = numTiles };
+			std::memcpy(dst, &header, sizeof(header));
+		}
+
+		if (numTiles > 0)
+		{
+			std::memcpy(dst + GetHeaderSize(codec), table.data(), table.size() * sizeof(uint32_t));
+		}
+	}
+
+	// Tiles compress in place at a fixed stride, then get packed down behind the table.
+	size_t CompressTileStream(Type codec, const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstCapacity, int level, uint32_t streamTileSize)
+	{
+		const size_t bound = TileStreamBound(codec, srcSize, streamTileSize);
+		if (bound == 0 || dstCapacity < bound)
+		{
+			return 0;
+		}
+
+		const uint32_t numTiles = static_cast<uint32_t>(GetNumTiles(srcSize, streamTileSize));
+		const size_t tileStride = TileCompressBound(codec, streamTileSize);
+		const size_t dataStart = GetHeaderSize(codec) + static_cast<size_t>(numTiles) * sizeof(uint32_t);
+
+		std::vector<uint32_t> tileSizes(numTiles);
+		std::atomic<bool> failed = false;
+		ParallelFor(numTiles, [&](uint32_t tile)
+			{
+				const size_t offset = static_cast<size_t>(tile) * streamTileSize;
+				const size_t tileSize = std::min<size_t>(streamTileSize, srcSize - offset);
+				uint8_t* out = dst + dataStart + tile * tileStride;
+
+				const size_t compressedSize = CompressTile(codec, src + offset, tileSize, out, tileStride, level);
+				if (codec == Type::GDeflate)
+				{
+					if (compressedSize == 0)
+					{
+						failed.store(true, std::memory_order_relaxed);
+					}
+					tileSizes[tile] = static_cast<uint32_t>(compressedSize);
+				}
+				else if (compressedSize == 0 || compressedSize >= tileSize)
+				{
+					std::memcpy(out, src + offset, tileSize);
+					tileSizes[tile] = static_cast<uint32_t>(tileSize) | kTileStoredRaw;
+				}
+				else
+				{
+					tileSizes[tile] = static_cast<uint32_t>(compressedSize);
+				}
+			});
+
+		// GDeflate offsets are 32 bits.
+		uint64_t dataSize = 0;
+		for (uint32_t tileSize : tileSizes)
+		{
+			dataSize += tileSize & ~kTileStoredRaw;
+		}
+
+		if (failed.load() || (codec == Type::GDeflate && dataSize > UINT32_MAX))
+		{
+			return 0;
+		}
+
+		size_t packedEnd = dataStart;
+		for (uint32_t tile = 0; tile < numTiles; tile++)
+		{
+			const size_t tileSize = tileSizes[tile] & ~kTileStoredRaw;
+			std::memmove(dst + packedEnd, dst + dataStart + tile * tileStride, tileSize);
+			packedEnd += tileSize;
+		}
+
+		WriteHeader(codec, srcSize, streamTileSize, tileSizes, dst);
+		return packedEnd;
+	}
+
+	bool DecompressTileStream(Type codec, const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstSize)
+	{
+		TileTable table;
+		if (!ReadTileTable(codec, src, srcSize, dstSize, table) || table.Offsets.back() > srcSize)
+		{
+			return false;
+		}
+
+		std::atomic<bool> failed = false;
+		ParallelFor(table.GetNumTiles(), [&](uint32_t tile)
+			{
+				const size_t outOffset = static_cast<size_t>(tile) * table.TileSize;
+				if (!DecompressTile(codec, table, tile, src + table.Offsets[tile], dst + outOffset))
+				{
+					failed.store(true, std::memory_order_relaxed);
+				}
+			});
+
+		return !failed.load();
+	}
+}
+
+size_t phx::Codec::TileTable::GetTileSize(uint32_t tile) const
+{
+	return static_cast<size_t>(std::min<uint64_t>(this->TileSize, this->UncompressedSize - static_cast<uint64_t>(tile) * this->TileSize));
+}
+
+char const* phx::Codec::ToString(Type codec)
+{
+	switch (codec)
+	{
+	case Type::None:
+		return "None";
+	case Type::Lz4:
+		return "LZ4";
+	case Type::Zstd:
+		return "Zstd";
+	case Type::GDeflate:
+		return "GDeflate";
+	default:
+		return "Unknown";
+	}
+}
+
+bool phx::Codec::IsValidTileSize(Type codec, uint32_t tileSize)
+{
+	if (codec == Type::GDeflate)
+	{
+		return tileSize == GDeflate::kTileSize;
+	}
+	return tileSize >= kMinTileSize && tileSize <= kMaxTileSize && (tileSize & (tileSize - 1)) == 0;
+}
+
+bool phx::Codec::IsAvailable(Type codec)
+{
+	switch (codec)
+	{
+	case Type::None:
+	case Type::Lz4:
+	case Type::GDeflate:
+		return true;
+	case Type::Zstd:
+#ifdef PHX_HAS_ZSTD
+		return true;
+#else
+		return false;
+#endif
+	default:
+		return false;
+	}
+}
+
+size_t phx::Codec::CompressBound(Type codec, size_t srcSize, uint32_t tileSize)
+{
+	if (codec == Type::None)
+	{
+		return srcSize;
+	}
+	return IsAvailable(codec) ? TileStreamBound(codec, srcSize, tileSize) : 0;
+}
+
+size_t phx::Codec::Compress(Type codec, const void* src, size_t srcSize, void* dst, size_t dstCapacity, int level, uint32_t tileSize)
+{
+	if (codec == Type::None)
+	{
+		if (dstCapacity < srcSize)
+		{
+			return 0;
+		}
+		if (srcSize > 0)
+		{
+			std::memcpy(dst, src, srcSize);
+		}
+		return srcSize;
+	}
+
+	if (!IsAvailable(codec))
+	{
+		return 0;
+	}
+	return CompressTileStream(codec, static_cast<const uint8_t*>(src), srcSize, static_cast<uint8_t*>(dst), dstCapacity, level, tileSize);
+}
+
+bool phx::Codec::Decompress(Type codec, const void* src, size_t srcSize, void* dst, size_t dstSize)
+{
+	if (codec == Type::None)
+	{
+		if (srcSize != dstSize)
+		{
+			return false;
+		}
+		if (srcSize > 0)
+		{
+			std::memcpy(dst, src, srcSize);
+		}
+		return true;
+	}
+
+	if (!IsAvailable(codec))
+	{
+		return false;
+	}
+	return DecompressTileStream(codec, static_cast<const uint8_t*>(src), srcSize, static_cast<uint8_t*>(dst), dstSize);
+}
+
+size_t phx::Codec::GetTileTableSize(Type codec, const void* src, size_t srcSize, uint64_t uncompressedSize)
+{
+	if (codec == Type::None || srcSize < GetHeaderSize(codec))
+	{
+		return 0;
+	}
+
+	uint64_t numTiles;
+	if (codec == Type::GDeflate)
+	{
+		GDeflate::StreamHeader header;
+		std::memcpy(&header, src, sizeof(header));
+		numTiles = GetNumTiles(uncompressedSize, GDeflate::kTileSize);
+		if (header.Id != GDeflate::kStreamId || header.Magic != (GDeflate::kStreamId ^ 0xff) || header.TileSizeIndex != 1 ||
+			header.NumTiles != numTiles || header.LastTileSize != uncompressedSize % GDeflate::kTileSize)
+		{
+			return 0;
+		}
+	}
+	else
+	{
+		// The tile size is whatever the stream was written with.
+		TileStreamHeader header;
+		std::memcpy(&header, src, sizeof(header));
+		if (header.Magic != kTileStreamMagic || header.TileCodec != codec || !IsValidTileSize(codec, header.TileSize))
+		{
+			return 0;
+		}
+
+		numTiles = GetNumTiles(uncompressedSize, header.TileSize);
+		if (header.NumTiles != numTiles)
+		{
+			return 0;
+		}
+	}
+
+	return GetHeaderSize(codec) + static_cast<size_t>(numTiles) * sizeof(uint32_t);
+}
+
+bool phx::Codec::ReadTileTable(Type codec, const void* src, size_t srcSize, uint64_t uncompressedSize, TileTable& outTable)
+{
+	const size_t tableSize = GetTileTableSize(codec, src, srcSize, uncompressedSize);
+	if (tableSize == 0 || tableSize > srcSize)
+	{
+		return false;
+	}
+
+	const size_t headerSize = GetHeaderSize(codec);
+	const uint32_t numTiles = static_cast<uint32_t>((tableSize - headerSize) / sizeof(uint32_t));
+	std::vector<uint32_t> entries(numTiles);
+	if (numTiles > 0)
+	{
+		std::memcpy(entries.data(), static_cast<const uint8_t*>(src) + headerSize, entries.size() * sizeof(uint32_t));
+	}
+
+	if (codec == Type::GDeflate)
+	{
+		outTable.TileSize = GDeflate::kTileSize;
+	}
+	else
+	{
+		TileStreamHeader header;
+		std::memcpy(&header, src, sizeof(header));
+		outTable.TileSize = header.TileSize;
+	}
+	outTable.UncompressedSize = uncompressedSize;
+	outTable.Offsets.resize(static_cast<size_t>(numTiles) + 1);
+	outTable.StoredRaw.assign(numTiles, 0);
+	outTable.Offsets[0] = tableSize;
+	for (uint32_t tile = 0; tile < numTiles; tile++)
+	{
+		uint64_t storedSize;
+		if (codec == Type::GDeflate)
+		{
+			// Entries past the first are offsets, the first holds the size of the last tile.
+			const uint64_t nextOffset = tile + 1 < numTiles ? entries[tile + 1] : outTable.Offsets[tile] - tableSize + entries[0];
+			const uint64_t offset = tile > 0 ? entries[tile] : 0;
+			if (nextOffset < offset || offset != outTable.Offsets[tile] - tableSize)
+			{
+				return false;
+			}
+			storedSize = nextOffset - offset;
+		}
+		else
+		{
+			storedSize = entries[tile] & ~kTileStoredRaw;
+			outTable.StoredRaw[tile] = (entries[tile] & kTileStoredRaw) != 0;
+		}
+
+		outTable.Offsets[tile + 1] = outTable.Offsets[tile] + storedSize;
+	}
+
+	return true;
+}
+
+bool phx::Codec::DecompressTile(Type codec, TileTable const& table, uint32_t tile, const void* src, void* dst)
+{
+	const size_t storedSize = static_cast<size_t>(table.Offsets[tile + 1] - table.Offsets[tile]);
+	const size_t tileSize = table.GetTileSize(tile);
+	if (table.StoredRaw[tile])
+	{
+		if (storedSize != tileSize)
+		{
+			return false;
+		}
+
+		std::memcpy(dst, src, tileSize);
+		return true;
+	}
+
+	return DecompressTileData(codec, src, storedSize, dst, tileSize);
+}
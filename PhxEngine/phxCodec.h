@@ -0,0 +1,95 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+namespace phx
+{
+	// General purpose codecs for archive regions and other large buffers, all run on the CPU.
+	//
+	// Every codec but None splits its input into tiles that are compressed on their own, so they
+	// can be compressed and decompressed across IoThreadPool::GetWorkers and ranged reads only
+	// decode the tiles they touch. GDeflate streams follow the layout DirectStorage uses for them
+	// (see phxGDeflate.h) and always have 64KiB tiles. LZ4 and zstd write a tile stream, its tile
+	// size picked by the writer and recorded in the header:
+	//   TileStreamHeader
+	//   uint32_t TileSizes[NumTiles], kTileStoredRaw set when a tile didn't compress
+	//   Tile data
+	namespace Codec
+	{
+		enum class Type : uint8_t
+		{
+			None = 0,
+			Lz4,
+			Zstd,
+			GDeflate,
+		};
+
+		constexpr uint32_t kTileStreamMagic = 0x54584850; // 'PHXT'
+		constexpr uint32_t kDefaultTileSize = 64u << 10;
+		constexpr uint32_t kMinTileSize = 4u << 10;
+		constexpr uint32_t kMaxTileSize = 16u << 20;
+		constexpr uint32_t kTileStoredRaw = 0x80000000u;
+
+		struct TileStreamHeader
+		{
+			uint32_t Magic;
+			Type TileCodec;
+			uint8_t Reserved[3];
+			uint32_t TileSize;
+			uint32_t NumTiles;
+		};
+
+		static_assert(sizeof(TileStreamHeader) == 16);
+
+		// Where each tile of a stream is, to decompress part of it without reading the rest.
+		struct TileTable
+		{
+			uint32_t TileSize = 0;
+			uint64_t UncompressedSize = 0;
+			std::vector<uint64_t> Offsets;	// From the start of the stream, NumTiles + 1 entries.
+			std::vector<uint8_t> StoredRaw;
+
+			uint32_t GetNumTiles() const { return static_cast<uint32_t>(this->StoredRaw.size()); }
+			size_t GetTileSize(uint32_t tile) const;
+		};
+
+		// Streams start with a header of at most this many bytes, followed by the tile table.
+		constexpr size_t kMaxStreamHeaderSize = sizeof(TileStreamHeader);
+
+		char const* ToString(Type codec);
+
+		// None, LZ4 and GDeflate are always available. Zstd needs its library in the build.
+		bool IsAvailable(Type codec);
+
+		// Tile streams take a power of two from kMinTileSize to kMaxTileSize, GDeflate only 64KiB.
+		// Larger tiles compress better, smaller ones waste less on ranged reads.
+		bool IsValidTileSize(Type codec, uint32_t tileSize);
+
+		// 0 if the codec isn't available or the tile size isn't valid for it, or for GDeflate if
+		// srcSize needs more than 65535 tiles.
+		size_t CompressBound(Type codec, size_t srcSize, uint32_t tileSize = kDefaultTileSize);
+
+		// Returns the compressed size, or 0 if the codec isn't available, the tile size isn't valid
+		// for it or dstCapacity is below CompressBound. level is codec specific, 0 picks the codec's
+		// default. None ignores tileSize.
+		size_t Compress(Type codec, const void* src, size_t srcSize, void* dst, size_t dstCapacity, int level = 0, uint32_t tileSize = kDefaultTileSize);
+
+		// Fails on malformed input or if the data doesn't decode to exactly dstSize bytes.
+		bool Decompress(Type codec, const void* src, size_t srcSize, void* dst, size_t dstSize);
+
+		// Size of the header and tile table of a stream holding uncompressedSize bytes, from its first
+		// srcSize bytes, which should be kMaxStreamHeaderSize or the whole stream if it's shorter.
+		// Returns 0 if the header doesn't match, and for None, which has no tiles.
+		size_t GetTileTableSize(Type codec, const void* src, size_t srcSize, uint64_t uncompressedSize);
+
+		// src holds at least the header and tile table. Offsets are only checked against each other,
+		// not against the size of the stream.
+		bool ReadTileTable(Type codec, const void* src, size_t srcSize, uint64_t uncompressedSize, TileTable& outTable);
+
+		// src points at the tile's data, dst receives TileTable::GetTileSize(tile) bytes.
+		bool DecompressTile(Type codec, TileTable const& table, uint32_t tile, const void* src, void* dst);
+	}
+}
@@ -0,0 +1,221 @@
+#include "pch.h"
+#include "phxCompressedFileSystem.h"
+
+#include "phxAsyncIo.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+using namespace phx;
+using namespace phx::CompressedFormat;
+
+namespace
+{
+	bool IsCompressedHeader(FileHeader const& header)
+	{
+		return header.Magic == kMagic;
+	}
+
+	bool IsValidHeader(FileHeader const& header)
+	{
+		return header.Version == kVersion && Codec::IsAvailable(header.StreamCodec);
+	}
+}
+
+phx::CompressedFileSystem::CompressedFileSystem(std::shared_ptr<IFileSystem> fs, Codec::Type codec, int level, uint32_t tileSize)
+	: m_underlyingFS(std::move(fs))
+	, m_codec(Codec::IsAvailable(codec) ? codec : Codec::Type::Lz4)
+	, m_level(level)
+	, m_tileSize(Codec::IsValidTileSize(this->m_codec, tileSize) ? tileSize : Codec::kDefaultTileSize)
+{
+	if (this->m_codec != codec)
+	{
+		PHX_CORE_WARN("{} compression isn't available in this build, using {}", Codec::ToString(codec), Codec::ToString(this->m_codec));
+	}
+
+	if (this->m_tileSize != tileSize)
+	{
+		PHX_CORE_WARN("{} can't use {} byte tiles, using {}", Codec::ToString(this->m_codec), tileSize, this->m_tileSize);
+	}
+}
+
+bool phx::CompressedFileSystem::FileExists(std::filesystem::path const& name)
+{
+	return this->m_underlyingFS->FileExists(name);
+}
+
+bool phx::CompressedFileSystem::FolderExists(std::filesystem::path const& name)
+{
+	return this->m_underlyingFS->FolderExists(name);
+}
+
+std::unique_ptr<IBlob> phx::CompressedFileSystem::ReadFile(std::filesystem::path const& name)
+{
+	// Mapping avoids copying the compressed data before it's decoded.
+	std::unique_ptr<IBlob> source = this->m_underlyingFS->MapFile(name, MapAdvice::Sequential);
+	if (!source || source->Size() < sizeof(FileHeader))
+	{
+		return source;
+	}
+
+	const uint8_t* sourceData = static_cast<const uint8_t*>(source->Data());
+	FileHeader header;
+	std::memcpy(&header, sourceData, sizeof(FileHeader));
+	if (!IsCompressedHeader(header))
+	{
+		return source;
+	}
+
+	if (!IsValidHeader(header))
+	{
+		PHX_CORE_ERROR("Unsupported compressed file '{}'", name.generic_string());
+		return nullptr;
+	}
+
+	uint8_t* data = static_cast<uint8_t*>(malloc(std::max<size_t>(static_cast<size_t>(header.UncompressedSize), 1)));
+	if (!data)
+	{
+		return nullptr;
+	}
+
+	if (!Codec::Decompress(header.StreamCodec, sourceData + sizeof(FileHeader), source->Size() - sizeof(FileHeader), data, static_cast<size_t>(header.UncompressedSize)))
+	{
+		PHX_CORE_ERROR("Failed to decompress '{}'", name.generic_string());
+		free(data);
+		return nullptr;
+	}
+
+	return FileSystemFactory::CreateBlob(data, static_cast<size_t>(header.UncompressedSize));
+}
+
+bool phx::CompressedFileSystem::WriteFile(std::filesystem::path const& name, Span<char> Data)
+{
+	FileHeader header = {
+		.Magic = kMagic,
+		.Version = kVersion,
+		.StreamCodec = this->m_codec,
+		.Reserved = 0,
+		.UncompressedSize = Data.Size() };
+
+	std::vector<char> output(sizeof(FileHeader) + Codec::CompressBound(this->m_codec, Data.Size(), this->m_tileSize));
+	size_t compressedSize = Codec::Compress(this->m_codec, Data.begin(), Data.Size(), output.data() + sizeof(FileHeader), output.size() - sizeof(FileHeader), this->m_level, this->m_tileSize);
+
+	// Only inputs too large for the codec's stream get here, those are stored as is.
+	if (compressedSize == 0 && Data.Size() > 0)
+	{
+		header.StreamCodec = Codec::Type::None;
+		output.resize(sizeof(FileHeader) + Data.Size());
+		compressedSize = Codec::Compress(Codec::Type::None, Data.begin(), Data.Size(), output.data() + sizeof(FileHeader), Data.Size());
+	}
+
+	std::memcpy(output.data(), &header, sizeof(FileHeader));
+	output.resize(sizeof(FileHeader) + compressedSize);
+	return this->m_underlyingFS->WriteFile(name, Span<char>(output.data(), output.size()));
+}
+
+bool phx::CompressedFileSystem::ReadFileRange(std::filesystem::path const& name, uint64_t offset, size_t size, void* destination)
+{
+	FileHeader header;
+	if (!this->m_underlyingFS->ReadFileRange(name, 0, sizeof(FileHeader), &header) || !IsCompressedHeader(header))
+	{
+		return this->m_underlyingFS->ReadFileRange(name, offset, size, destination);
+	}
+
+	if (!IsValidHeader(header) || offset > header.UncompressedSize || size > header.UncompressedSize - offset)
+	{
+		return false;
+	}
+
+	if (size == 0)
+	{
+		return true;
+	}
+
+	if (header.StreamCodec == Codec::Type::None)
+	{
+		return this->m_underlyingFS->ReadFileRange(name, sizeof(FileHeader) + offset, size, destination);
+	}
+
+	// Any stream with data is longer than its largest header.
+	uint8_t streamHeader[Codec::kMaxStreamHeaderSize];
+	if (!this->m_underlyingFS->ReadFileRange(name, sizeof(FileHeader), sizeof(streamHeader), streamHeader))
+	{
+		return false;
+	}
+
+	const size_t tableSize = Codec::GetTileTableSize(header.StreamCodec, streamHeader, sizeof(streamHeader), header.UncompressedSize);
+	std::vector<uint8_t> tableData(tableSize);
+	Codec::TileTable table;
+	if (tableSize == 0 ||
+		!this->m_underlyingFS->ReadFileRange(name, sizeof(FileHeader), tableData.size(), tableData.data()) ||
+		!Codec::ReadTileTable(header.StreamCodec, tableData.data(), tableData.size(), header.UncompressedSize, table))
+	{
+		return false;
+	}
+
+	// Read only the touched tiles, in one request.
+	const uint32_t firstTile = static_cast<uint32_t>(offset / table.TileSize);
+	const uint32_t lastTile = static_cast<uint32_t>((offset + size - 1) / table.TileSize);
+	const uint64_t compressedStart = table.Offsets[firstTile];
+	std::vector<uint8_t> compressed(static_cast<size_t>(table.Offsets[lastTile + 1] - compressedStart));
+	if (!this->m_underlyingFS->ReadFileRange(name, sizeof(FileHeader) + compressedStart, compressed.size(), compressed.data()))
+	{
+		return false;
+	}
+
+	std::atomic<bool> failed = false;
+	ParallelFor(lastTile - firstTile + 1, [&](uint32_t i)
+		{
+			const uint32_t tile = firstTile + i;
+			const uint64_t tileStart = static_cast<uint64_t>(tile) * table.TileSize;
+			const uint64_t tileSize = table.GetTileSize(tile);
+			const uint64_t copyStart = std::max(offset, tileStart);
+			const uint64_t copyEnd = std::min(offset + size, tileStart + tileSize);
+			const uint8_t* tileData = compressed.data() + (table.Offsets[tile] - compressedStart);
+			uint8_t* out = static_cast<uint8_t*>(destination) + (copyStart - offset);
+
+			// Whole tiles decode straight into the destination, partial ones go through a copy.
+			bool decoded;
+			if (copyStart == tileStart && copyEnd == tileStart + tileSize)
+			{
+				decoded = Codec::DecompressTile(header.StreamCodec, table, tile, tileData, out);
+			}
+			else
+			{
+				std::vector<uint8_t> partial(static_cast<size_t>(tileSize));
+				decoded = Codec::DecompressTile(header.StreamCodec, table, tile, tileData, partial.data());
+				if (decoded)
+				{
+					std::memcpy(out, partial.data() + (copyStart - tileStart), static_cast<size_t>(copyEnd - copyStart));
+				}
+			}
+
+			if (!decoded)
+			{
+				failed.store(true, std::memory_order_relaxed);
+			}
+		});
+
+	return !failed.load();
+}
+
+bool phx::CompressedFileSystem::GetLastWriteTime(std::filesystem::path const& name, std::filesystem::file_time_type& outTime)
+{
+	return this->m_underlyingFS->GetLastWriteTime(name, outTime);
+}
+
+bool phx::CompressedFileSystem::RemoveFile(std::filesystem::path const& name)
+{
+	return this->m_underlyingFS->RemoveFile(name);
+}
+
+FileWatchHandle phx::CompressedFileSystem::WatchDirectory(std::filesystem::path const& directory, FileChangeCallback&& onChange)
+{
+	return this->m_underlyingFS->WatchDirectory(directory, std::move(onChange));
+}
+
+void phx::CompressedFileSystem::Unwatch(FileWatchHandle handle)
+{
+	this->m_underlyingFS->Unwatch(handle);
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "phxCodec.h"
+#include "phxVFS.h"
+
+namespace phx
+{
+	// Files are stored as a header followed by a phx::Codec stream of their contents. The stream's
+	// tiles decompress in parallel and ranged reads only read and decode the tiles they touch.
+	namespace CompressedFormat
+	{
+		constexpr uint32_t kMagic = 0x5A584850; // 'PHXZ'
+		constexpr uint16_t kVersion = 2;
+
+		struct FileHeader
+		{
+			uint32_t Magic;
+			uint16_t Version;
+			Codec::Type StreamCodec;
+			uint8_t Reserved;
+			uint64_t UncompressedSize;
+		};
+
+		static_assert(sizeof(FileHeader) == 16);
+	}
+
+	// Compresses files on write and decompresses them on read, wrapping any file system. Files
+	// without the header are passed through, so it can be mounted over existing uncompressed data.
+	// Files are read back with the codec and tile size they were written with.
+	class CompressedFileSystem final : public IFileSystem
+	{
+	public:
+		// Falls back to LZ4 when codec isn't available in this build, and to the codec's default
+		// tile size when tileSize isn't valid for it (see Codec::IsValidTileSize).
+		CompressedFileSystem(
+			std::shared_ptr<IFileSystem> fs,
+			Codec::Type codec = Codec::Type::Lz4,
+			int level = 0,
+			uint32_t tileSize = Codec::kDefaultTileSize);
+
+		bool FileExists(std::filesystem::path const& name) override;
+		bool FolderExists(std::filesystem::path const& name) override;
+		std::unique_ptr<IBlob> ReadFile(std::filesystem::path const& name) override;
+		bool WriteFile(std::filesystem::path const& name, Span<char> Data) override;
+		bool ReadFileRange(std::filesystem::path const& name, uint64_t offset, size_t size, void* destination) override;
+		bool GetLastWriteTime(std::filesystem::path const& name, std::filesystem::file_time_type& outTime) override;
+		bool RemoveFile(std::filesystem::path const& name) override;
+		FileWatchHandle WatchDirectory(std::filesystem::path const& directory, FileChangeCallback&& onChange) override;
+		void Unwatch(FileWatchHandle handle) override;
+
+	private:
+		std::shared_ptr<IFileSystem> m_underlyingFS;
+		Codec::Type m_codec;
+		int m_level;
+		uint32_t m_tileSize;
+	};
+}
@@ -1,35 +1,30 @@
 #include "pch.h"
 #include "phxDeferredReleaseQueue.h"
 
-#include <deque>
-
 using namespace phx;
 namespace
 {
-	std::deque<DeleteItem> m_deleteQueue;
+	RetirementQueue m_retirementQueue;
 }
 
 namespace phx::DeferredDeleteQueue
 {
 	void Enqueue(DeleteItem&& deleteItem)
 	{
-		m_deleteQueue.emplace_back(std::forward<DeleteItem>(deleteItem));
+		m_retirementQueue.Retire(deleteItem.Frame, deleteItem.DeleteFn);
 	}
 
 	void ReleaseItems(uint64_t completedFrame)
 	{
-		while (!m_deleteQueue.empty())
+		// Items queued on completedFrame are still in flight.
+		if (completedFrame > 0)
 		{
-			DeleteItem& deleteItem = m_deleteQueue.front();
-			if (deleteItem.Frame < completedFrame)
-			{
-				deleteItem.DeleteFn();
-				m_deleteQueue.pop_front();
-			}
-			else
-			{
-				break;
-			}
+			m_retirementQueue.Collect(completedFrame - 1);
 		}
 	}
-}
\ No newline at end of file
+
+	RetirementStats GetStats()
+	{
+		return m_retirementQueue.GetStats();
+	}
+}
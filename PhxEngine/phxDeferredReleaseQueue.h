@@ -1,17 +1,16 @@
 #pragma once
 
-#include <functional>
+#include <limits>
 
 #include "phxDisplay.h"
+#include "phxRetirementQueue.h"
 
 namespace phx
 {
-
-
 	struct DeleteItem
 	{
 		uint64_t Frame;
-		std::function<void()> DeleteFn;
+		ReleaseCallback DeleteFn;
 	};
 
 	//////////////////////////////////////////////////////////////////////////
@@ -20,10 +19,13 @@ namespace phx
 	//////////////////////////////////////////////////////////////////////////
 
 
+	// Thin wrapper over a RetirementQueue keyed by frame. Safe to enqueue from any thread,
+	// ReleaseItems must only be called from one thread at a time.
 	namespace DeferredDeleteQueue
 	{
 		void Enqueue(DeleteItem&& deleteItem);
 		void ReleaseItems(uint64_t completedFrame = std::numeric_limits<uint64_t>::max());
+		RetirementStats GetStats();
 	}
 
 	template <typename T>
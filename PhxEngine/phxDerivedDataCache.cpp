@@ -0,0 +1,285 @@
+#include "pch.h"
+#include "phxDerivedDataCache.h"
+
+#include "phxStringHash.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+using namespace phx;
+
+namespace
+{
+	// Second basis for the upper half of the key, so the two halves don't collide together.
+	constexpr uint64_t kSecondBasis = 0x6C62272E07BB0142ull;
+
+	constexpr uint32_t kIndexMagic = 0x49444450; // 'PDDI'
+	constexpr uint32_t kIndexVersion = 1;
+	constexpr const char* kIndexName = "index.ddi";
+
+	struct IndexHeader
+	{
+		uint32_t Magic;
+		uint32_t Version;
+		uint64_t NumEntries;
+		uint64_t UseCounter;
+	};
+
+	struct IndexEntry
+	{
+		DerivedDataKey Key;
+		uint64_t Size;
+		uint64_t LastUse;
+	};
+}
+
+std::string phx::DerivedDataKey::ToString() const
+{
+	char text[33];
+	std::snprintf(text, sizeof(text), "%016llx%016llx", static_cast<unsigned long long>(this->Hash[0]), static_cast<unsigned long long>(this->Hash[1]));
+	return text;
+}
+
+phx::DerivedDataKeyBuilder::DerivedDataKeyBuilder(std::string_view converterName, uint32_t converterVersion)
+	: m_key({ kFnv1a64Basis, kSecondBasis })
+{
+	this->Append(converterName);
+	this->AppendValue(converterVersion);
+}
+
+DerivedDataKeyBuilder& phx::DerivedDataKeyBuilder::Append(const void* data, size_t size)
+{
+	// Length first, so appending "ab" + "c" differs from "a" + "bc".
+	const uint64_t length = size;
+	const char* lengthBytes = reinterpret_cast<const char*>(&length);
+	const char* bytes = static_cast<const char*>(data);
+	for (uint64_t& hash : this->m_key.Hash)
+	{
+		hash = fnv1a_64(lengthBytes, sizeof(length), hash);
+		hash = fnv1a_64(bytes, size, hash);
+	}
+
+	return *this;
+}
+
+DerivedDataKeyBuilder& phx::DerivedDataKeyBuilder::Append(std::string_view text)
+{
+	return this->Append(text.data(), text.size());
+}
+
+phx::DerivedDataCache::DerivedDataCache(std::shared_ptr<IFileSystem> fs, std::filesystem::path const& directory, uint64_t budgetBytes)
+	: m_fs(std::move(fs))
+	, m_directory(directory)
+{
+	this->m_stats.BudgetBytes = budgetBytes;
+	this->LoadIndex();
+}
+
+phx::DerivedDataCache::~DerivedDataCache()
+{
+	this->Flush();
+}
+
+std::unique_ptr<IBlob> phx::DerivedDataCache::Get(DerivedDataKey const& key)
+{
+	std::unique_ptr<IBlob> blob = this->m_fs->MapFile(this->GetEntryPath(key));
+
+	std::scoped_lock _(this->m_mutex);
+	if (!blob)
+	{
+		this->m_stats.Misses++;
+		return nullptr;
+	}
+
+	// Entries written by a run that never saved its index are adopted here.
+	auto [it, inserted] = this->m_entries.try_emplace(key, Entry{ .Size = blob->Size(), .LastUse = 0 });
+	if (inserted)
+	{
+		this->m_stats.TotalBytes += blob->Size();
+	}
+
+	it->second.LastUse = ++this->m_useCounter;
+	this->m_indexDirty = true;
+	this->m_stats.Hits++;
+	return blob;
+}
+
+bool phx::DerivedDataCache::Put(DerivedDataKey const& key, Span<char> data)
+{
+	if (!this->m_fs->WriteFile(this->GetEntryPath(key), data))
+	{
+		return false;
+	}
+
+	std::vector<DerivedDataKey> evicted;
+	{
+		std::scoped_lock _(this->m_mutex);
+		auto [it, inserted] = this->m_entries.try_emplace(key, Entry{ .Size = 0, .LastUse = 0 });
+		this->m_stats.TotalBytes += data.Size() - it->second.Size;
+		it->second = { .Size = data.Size(), .LastUse = ++this->m_useCounter };
+		this->m_indexDirty = true;
+		this->m_stats.Inserts++;
+
+		evicted = this->TrimLocked();
+	}
+
+	// Removed without the lock so other lookups don't wait on the disk. An evicted key put again
+	// meanwhile may lose its file, which only costs a miss.
+	for (DerivedDataKey const& evictedKey : evicted)
+	{
+		this->m_fs->RemoveFile(this->GetEntryPath(evictedKey));
+	}
+
+	return true;
+}
+
+std::unique_ptr<IBlob> phx::DerivedDataCache::GetOrBuild(DerivedDataKey const& key, std::function<std::vector<char>()> const& build)
+{
+	std::unique_ptr<IBlob> blob = this->Get(key);
+	if (blob)
+	{
+		return blob;
+	}
+
+	std::vector<char> data = build();
+	if (this->Put(key, Span<char>(data.data(), data.size())))
+	{
+		blob = this->m_fs->MapFile(this->GetEntryPath(key));
+		if (blob)
+		{
+			return blob;
+		}
+	}
+	else
+	{
+		PHX_CORE_WARN("Failed to store derived data {}", key.ToString());
+	}
+
+	// Not in the cache, possibly trimmed straight away, so hand back what was built.
+	void* copy = malloc(std::max<size_t>(data.size(), 1));
+	if (!copy)
+	{
+		return nullptr;
+	}
+
+	if (!data.empty())
+	{
+		std::memcpy(copy, data.data(), data.size());
+	}
+
+	return FileSystemFactory::CreateBlob(copy, data.size());
+}
+
+void phx::DerivedDataCache::Flush()
+{
+	std::vector<char> index;
+	{
+		std::scoped_lock _(this->m_mutex);
+		if (!this->m_indexDirty)
+		{
+			return;
+		}
+
+		const IndexHeader header = {
+			.Magic = kIndexMagic,
+			.Version = kIndexVersion,
+			.NumEntries = this->m_entries.size(),
+			.UseCounter = this->m_useCounter };
+
+		index.resize(sizeof(IndexHeader) + this->m_entries.size() * sizeof(IndexEntry));
+		std::memcpy(index.data(), &header, sizeof(IndexHeader));
+
+		char* out = index.data() + sizeof(IndexHeader);
+		for (auto const& [key, entry] : this->m_entries)
+		{
+			const IndexEntry indexEntry = { .Key = key, .Size = entry.Size, .LastUse = entry.LastUse };
+			std::memcpy(out, &indexEntry, sizeof(IndexEntry));
+			out += sizeof(IndexEntry);
+		}
+
+		this->m_indexDirty = false;
+	}
+
+	if (!this->m_fs->WriteFile(this->m_directory / kIndexName, Span<char>(index.data(), index.size())))
+	{
+		PHX_CORE_WARN("Failed to write the derived data index");
+	}
+}
+
+DerivedDataStats phx::DerivedDataCache::GetStats()
+{
+	std::scoped_lock _(this->m_mutex);
+	DerivedDataStats stats = this->m_stats;
+	stats.NumEntries = this->m_entries.size();
+	return stats;
+}
+
+std::filesystem::path phx::DerivedDataCache::GetEntryPath(DerivedDataKey const& key) const
+{
+	return this->m_directory / (key.ToString() + ".ddc");
+}
+
+void phx::DerivedDataCache::LoadIndex()
+{
+	std::unique_ptr<IBlob> index = this->m_fs->ReadFile(this->m_directory / kIndexName);
+	if (IBlob::IsEmpty(index.get()) || index->Size() < sizeof(IndexHeader))
+	{
+		return;
+	}
+
+	IndexHeader header;
+	std::memcpy(&header, index->Data(), sizeof(IndexHeader));
+	if (header.Magic != kIndexMagic || header.Version != kIndexVersion ||
+		header.NumEntries > (index->Size() - sizeof(IndexHeader)) / sizeof(IndexEntry))
+	{
+		PHX_CORE_WARN("Ignoring invalid derived data index");
+		return;
+	}
+
+	const char* in = static_cast<const char*>(index->Data()) + sizeof(IndexHeader);
+	for (uint64_t i = 0; i < header.NumEntries; i++)
+	{
+		IndexEntry entry;
+		std::memcpy(&entry, in + i * sizeof(IndexEntry), sizeof(IndexEntry));
+		this->m_entries[entry.Key] = { .Size = entry.Size, .LastUse = entry.LastUse };
+		this->m_stats.TotalBytes += entry.Size;
+	}
+
+	this->m_useCounter = header.UseCounter;
+}
+
+std::vector<DerivedDataKey> phx::DerivedDataCache::TrimLocked()
+{
+	std::vector<DerivedDataKey> evicted;
+	if (this->m_stats.TotalBytes <= this->m_stats.BudgetBytes)
+	{
+		return evicted;
+	}
+
+	std::vector<std::pair<uint64_t, DerivedDataKey>> byAge;
+	byAge.reserve(this->m_entries.size());
+	for (auto const& [key, entry] : this->m_entries)
+	{
+		byAge.emplace_back(entry.LastUse, key);
+	}
+	std::sort(byAge.begin(), byAge.end(), [](auto const& a, auto const& b) { return a.first < b.first; });
+
+	// Trim to below the budget so the next few inserts don't each pay for a sort.
+	const uint64_t target = this->m_stats.BudgetBytes - this->m_stats.BudgetBytes / 8;
+	for (auto const& [lastUse, key] : byAge)
+	{
+		if (this->m_stats.TotalBytes <= target)
+		{
+			break;
+		}
+
+		auto it = this->m_entries.find(key);
+		this->m_stats.TotalBytes -= it->second.Size;
+		this->m_stats.Evictions++;
+		this->m_entries.erase(it);
+		evicted.push_back(key);
+	}
+
+	return evicted;
+}
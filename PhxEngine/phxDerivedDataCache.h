@@ -0,0 +1,108 @@
+#pragma once
+
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "phxVFS.h"
+
+namespace phx
+{
+	struct DerivedDataKey
+	{
+		uint64_t Hash[2];
+
+		bool operator==(DerivedDataKey const&) const = default;
+		std::string ToString() const;
+	};
+
+	// Hashes everything a conversion depends on. Any change in the source bytes, the conversion
+	// flags or the converter version gives a different key.
+	class DerivedDataKeyBuilder
+	{
+	public:
+		DerivedDataKeyBuilder(std::string_view converterName, uint32_t converterVersion);
+
+		DerivedDataKeyBuilder& Append(const void* data, size_t size);
+		DerivedDataKeyBuilder& Append(std::string_view text);
+
+		template<typename T> requires std::is_trivially_copyable_v<T>
+		DerivedDataKeyBuilder& AppendValue(T const& value)
+		{
+			return this->Append(&value, sizeof(T));
+		}
+
+		DerivedDataKey Finish() const { return this->m_key; }
+
+	private:
+		DerivedDataKey m_key;
+	};
+
+	struct DerivedDataStats
+	{
+		uint64_t Hits = 0;
+		uint64_t Misses = 0;
+		uint64_t Inserts = 0;
+		uint64_t Evictions = 0;
+		size_t NumEntries = 0;
+		uint64_t TotalBytes = 0;
+		uint64_t BudgetBytes = 0;
+	};
+
+	// Converted artifacts stored by key under a directory of fs, usually /assets_cache. Entries are
+	// written atomically, so a crashed conversion never leaves a partial artifact behind, and the
+	// least recently used are removed once the cache grows past its budget. Recency and sizes are
+	// kept in an index file that's rewritten on Flush and on destruction.
+	class DerivedDataCache
+	{
+	public:
+		static constexpr uint64_t kDefaultBudgetBytes = 8ull << 30;
+
+		DerivedDataCache(std::shared_ptr<IFileSystem> fs, std::filesystem::path const& directory, uint64_t budgetBytes = kDefaultBudgetBytes);
+		~DerivedDataCache();
+
+		DerivedDataCache(DerivedDataCache const&) = delete;
+		DerivedDataCache& operator=(DerivedDataCache const&) = delete;
+
+		// Null on a miss. The artifact is mapped rather than copied.
+		std::unique_ptr<IBlob> Get(DerivedDataKey const& key);
+		bool Put(DerivedDataKey const& key, Span<char> data);
+
+		// Returns the cached artifact, or runs build, stores its result and returns that.
+		std::unique_ptr<IBlob> GetOrBuild(DerivedDataKey const& key, std::function<std::vector<char>()> const& build);
+
+		void Flush();
+		DerivedDataStats GetStats();
+
+	private:
+		struct KeyHasher
+		{
+			size_t operator()(DerivedDataKey const& key) const { return static_cast<size_t>(key.Hash[0]); }
+		};
+
+		struct Entry
+		{
+			uint64_t Size;
+			uint64_t LastUse;
+		};
+
+		std::filesystem::path GetEntryPath(DerivedDataKey const& key) const;
+		void LoadIndex();
+		// Drops the least recently used entries from the index, returning them so their files can
+		// be removed once the lock is released.
+		std::vector<DerivedDataKey> TrimLocked();
+
+	private:
+		std::shared_ptr<IFileSystem> m_fs;
+		std::filesystem::path m_directory;
+
+		std::mutex m_mutex;
+		std::unordered_map<DerivedDataKey, Entry, KeyHasher> m_entries;
+		uint64_t m_useCounter = 0;
+		bool m_indexDirty = false;
+		DerivedDataStats m_stats;
+	};
+}
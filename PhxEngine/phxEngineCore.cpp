@@ -6,6 +6,7 @@
 #include <shellapi.h>  // For CommandLineToArgW
 
 #include "phxDeferredReleaseQueue.h"
+#include "phxMemory.h"
 #include "phxSystemTime.h"
 #include "EmberGfx/phxEmber.h"
 #include <EmberGfx/phxGfxDeviceResources.h>
@@ -41,6 +42,12 @@ namespace
 		CommandLineArgs::Initialize(argc, argv);
 
 		phx::Log::Initialize();
+
+		// One frame ring region per frame the GPU can have in flight, plus the one being recorded.
+		Memory::MemoryConfiguration memoryConfig = {};
+		memoryConfig.NumFramesInFlight = static_cast<uint32_t>(gfx::kBufferCount + 1);
+		Memory::Initialize(memoryConfig);
+
 		Display::Initialize();
 
 		SystemTime::Initialize();
@@ -52,6 +59,7 @@ namespace
 	void UpdateApplication(IEngineApp& app)
 	{
 		phx::EngineProfile::Update();
+		Memory::BeginFrame();
 		app.Update();
 		app.Render();
 		Display::Preset();
@@ -153,6 +161,7 @@ namespace phx::EngineCore
 
 		XGameRuntimeUninitialize();
 		Display::Finalize();
+		Memory::Finalize();
 
 		return static_cast<int>(msg.wParam);
 	}
@@ -0,0 +1,558 @@
+#include "pch.h"
+#include "phxFileWatcher.h"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#ifdef PHX_PLATFORM_LINUX
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+using namespace phx;
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+
+	// Folds repeated changes to the same file into the net change since the last Take.
+	class ChangeCoalescer
+	{
+	public:
+		void Add(std::filesystem::path&& path, FileChangeType type, Clock::time_point now)
+		{
+			this->m_lastChange = now;
+			if (this->m_rescan)
+			{
+				// A rescan covers every change to come before it's delivered.
+				return;
+			}
+
+			std::string key = path.generic_string();
+			auto it = this->m_index.find(key);
+			if (it == this->m_index.end())
+			{
+				this->m_index.emplace(std::move(key), this->m_pending.size());
+				this->m_pending.push_back({ .Event = { .Path = std::move(path), .Type = type }, .Cancelled = false });
+				return;
+			}
+
+			Pending& pending = this->m_pending[it->second];
+			if (pending.Cancelled)
+			{
+				pending = { .Event = { .Path = std::move(path), .Type = type }, .Cancelled = false };
+			}
+			else if (type == FileChangeType::Rescan || pending.Event.Type == FileChangeType::Rescan)
+			{
+				// A directory that went away, nothing narrower describes what happened to it.
+				pending.Event.Type = FileChangeType::Rescan;
+			}
+			else if (pending.Event.Type == FileChangeType::Added)
+			{
+				// Created and deleted within the window, nobody needs to hear about it.
+				pending.Cancelled = type == FileChangeType::Removed;
+			}
+			else
+			{
+				// Removed then added is a replace, typically an editor saving through a temporary file.
+				pending.Event.Type = type == FileChangeType::Removed ? FileChangeType::Removed : FileChangeType::Modified;
+			}
+		}
+
+		// Replaces everything pending with a single rescan of root.
+		void AddRescan(std::filesystem::path const& root, Clock::time_point now)
+		{
+			this->m_lastChange = now;
+			this->m_rescan = true;
+			this->m_pending.clear();
+			this->m_index.clear();
+			this->m_pending.push_back({ .Event = { .Path = root, .Type = FileChangeType::Rescan }, .Cancelled = false });
+		}
+
+		bool IsEmpty() const { return this->m_pending.empty(); }
+		Clock::time_point GetReadyTime() const { return this->m_lastChange + FileWatch::kCoalesceWindow; }
+
+		std::vector<FileChangeEvent> Take()
+		{
+			std::vector<FileChangeEvent> events;
+			events.reserve(this->m_pending.size());
+			for (Pending& pending : this->m_pending)
+			{
+				if (!pending.Cancelled)
+				{
+					events.push_back(std::move(pending.Event));
+				}
+			}
+
+			this->m_pending.clear();
+			this->m_index.clear();
+			this->m_rescan = false;
+			return events;
+		}
+
+	private:
+		struct Pending
+		{
+			FileChangeEvent Event;
+			bool Cancelled;
+		};
+
+		std::vector<Pending> m_pending;
+		std::unordered_map<std::string, size_t> m_index;
+		Clock::time_point m_lastChange;
+		bool m_rescan = false;
+	};
+
+#ifdef PHX_PLATFORM_LINUX
+	class InotifyWatcher
+	{
+	public:
+		static InotifyWatcher& Get()
+		{
+			static InotifyWatcher watcher;
+			return watcher;
+		}
+
+		InotifyWatcher()
+		{
+			this->m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+			this->m_wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+			if (this->IsAvailable())
+			{
+				this->m_thread = std::thread([this]() { this->WatchLoop(); });
+			}
+		}
+
+		~InotifyWatcher()
+		{
+			if (this->m_thread.joinable())
+			{
+				{
+					std::scoped_lock _(this->m_mutex);
+					this->m_stop = true;
+				}
+
+				const uint64_t wake = 1;
+				(void)::write(this->m_wakeFd, &wake, sizeof(wake));
+				this->m_thread.join();
+			}
+
+			if (this->m_fd >= 0)
+			{
+				::close(this->m_fd);
+			}
+
+			if (this->m_wakeFd >= 0)
+			{
+				::close(this->m_wakeFd);
+			}
+		}
+
+		bool IsAvailable() const { return this->m_fd >= 0 && this->m_wakeFd >= 0; }
+
+		FileWatchHandle Watch(std::filesystem::path const& directory, FileChangeCallback&& onChange)
+		{
+			std::error_code ec;
+			std::filesystem::path root = std::filesystem::canonical(directory, ec);
+			if (!this->IsAvailable() || ec || !std::filesystem::is_directory(root, ec))
+			{
+				return kInvalidFileWatch;
+			}
+
+			std::scoped_lock _(this->m_mutex);
+			if (!this->AddWatchesLocked(root, false, Clock::now()))
+			{
+				return kInvalidFileWatch;
+			}
+
+			auto subscriber = std::make_shared<Subscriber>();
+			subscriber->Handle = ++this->m_nextHandle;
+			subscriber->Root = std::move(root);
+			subscriber->RootPrefix = subscriber->Root.generic_string();
+			if (subscriber->RootPrefix.back() != '/')
+			{
+				subscriber->RootPrefix.push_back('/');
+			}
+			subscriber->UserRoot = directory;
+			subscriber->OnChange = std::move(onChange);
+			this->m_subscribers.push_back(subscriber);
+
+			return subscriber->Handle;
+		}
+
+		void Unwatch(FileWatchHandle handle)
+		{
+			{
+				std::scoped_lock _(this->m_mutex);
+				auto it = std::find_if(
+					this->m_subscribers.begin(),
+					this->m_subscribers.end(),
+					[handle](auto const& s) { return s->Handle == handle; });
+
+				if (it == this->m_subscribers.end())
+				{
+					return;
+				}
+
+				(*it)->Active.store(false);
+				this->m_subscribers.erase(it);
+				this->RemoveUnusedWatchesLocked();
+			}
+
+			// Wait out a callback that's running, unless this is that callback.
+			if (std::this_thread::get_id() != this->m_thread.get_id())
+			{
+				std::scoped_lock dispatch(this->m_dispatchMutex);
+			}
+		}
+
+	private:
+		struct Subscriber
+		{
+			FileWatchHandle Handle;
+			std::filesystem::path Root;
+			std::string RootPrefix;
+			std::filesystem::path UserRoot;
+			FileChangeCallback OnChange;
+			ChangeCoalescer Pending;
+			std::atomic<bool> Active = true;
+		};
+
+		static constexpr uint32_t kWatchMask =
+			IN_CREATE | IN_DELETE | IN_MODIFY | IN_CLOSE_WRITE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+
+		bool AddWatchesLocked(std::filesystem::path const& directory, bool reportFiles, Clock::time_point now)
+		{
+			if (!this->AddWatchLocked(directory))
+			{
+				return false;
+			}
+
+			// Watch before listing, anything created in between is then reported twice rather than lost.
+			std::error_code ec;
+			for (auto it = std::filesystem::recursive_directory_iterator(directory, std::filesystem::directory_options::skip_permission_denied, ec);
+				!ec && it != std::filesystem::recursive_directory_iterator();
+				it.increment(ec))
+			{
+				if (it->is_directory(ec))
+				{
+					this->AddWatchLocked(it->path());
+				}
+				else if (reportFiles && it->is_regular_file(ec))
+				{
+					this->OnChangeLocked(it->path(), FileChangeType::Added, now);
+				}
+			}
+
+			return true;
+		}
+
+		bool AddWatchLocked(std::filesystem::path const& directory)
+		{
+			const int wd = inotify_add_watch(this->m_fd, directory.c_str(), kWatchMask);
+			if (wd < 0)
+			{
+				PHX_CORE_WARN("Unable to watch '{}': {}", directory.generic_string(), std::strerror(errno));
+				return false;
+			}
+
+			this->m_watchDirs[wd] = directory;
+			return true;
+		}
+
+		void RemoveUnusedWatchesLocked()
+		{
+			for (auto it = this->m_watchDirs.begin(); it != this->m_watchDirs.end();)
+			{
+				const std::string dir = it->second.generic_string() + "/";
+				const bool used = std::any_of(
+					this->m_subscribers.begin(),
+					this->m_subscribers.end(),
+					[&dir](auto const& s) { return dir.starts_with(s->RootPrefix); });
+
+				if (used)
+				{
+					++it;
+					continue;
+				}
+
+				inotify_rm_watch(this->m_fd, it->first);
+				it = this->m_watchDirs.erase(it);
+			}
+		}
+
+		void OnChangeLocked(std::filesystem::path const& path, FileChangeType type, Clock::time_point now)
+		{
+			const std::string spath = path.generic_string();
+			for (auto const& subscriber : this->m_subscribers)
+			{
+				if (spath.starts_with(subscriber->RootPrefix))
+				{
+					subscriber->Pending.Add(subscriber->UserRoot / path.lexically_relative(subscriber->Root), type, now);
+				}
+			}
+		}
+
+		// A watched directory was moved or deleted along with everything below it. Its files can't be
+		// listed any more, so subscribers rescan it, and its watches are dropped since the paths they
+		// map to are gone. A directory moved within the tree is picked up again by IN_MOVED_TO.
+		void OnDirectoryGoneLocked(std::filesystem::path const& directory, Clock::time_point now)
+		{
+			const std::string prefix = directory.generic_string() + "/";
+			for (auto const& subscriber : this->m_subscribers)
+			{
+				if (subscriber->RootPrefix.starts_with(prefix))
+				{
+					// The root itself, or a directory above it, went away.
+					subscriber->Pending.Add(std::filesystem::path(subscriber->UserRoot), FileChangeType::Rescan, now);
+				}
+				else if (prefix.starts_with(subscriber->RootPrefix))
+				{
+					subscriber->Pending.Add(subscriber->UserRoot / directory.lexically_relative(subscriber->Root), FileChangeType::Rescan, now);
+				}
+			}
+
+			for (auto it = this->m_watchDirs.begin(); it != this->m_watchDirs.end();)
+			{
+				if ((it->second.generic_string() + "/").starts_with(prefix))
+				{
+					inotify_rm_watch(this->m_fd, it->first);
+					it = this->m_watchDirs.erase(it);
+				}
+				else
+				{
+					++it;
+				}
+			}
+		}
+
+		void OnOverflowLocked(Clock::time_point now)
+		{
+			for (auto const& subscriber : this->m_subscribers)
+			{
+				// Directories created during the overflow were never watched.
+				this->AddWatchesLocked(subscriber->Root, false, now);
+				subscriber->Pending.AddRescan(subscriber->UserRoot, now);
+			}
+		}
+
+		void WatchLoop()
+		{
+			while (true)
+			{
+				int timeoutMs = -1;
+				{
+					std::scoped_lock _(this->m_mutex);
+					if (this->m_stop)
+					{
+						return;
+					}
+
+					const Clock::time_point now = Clock::now();
+					for (auto const& subscriber : this->m_subscribers)
+					{
+						if (!subscriber->Pending.IsEmpty())
+						{
+							const auto wait = std::chrono::ceil<std::chrono::milliseconds>(subscriber->Pending.GetReadyTime() - now);
+							const int waitMs = static_cast<int>(std::max<int64_t>(wait.count(), 0));
+							timeoutMs = timeoutMs < 0 ? waitMs : std::min(timeoutMs, waitMs);
+						}
+					}
+				}
+
+				pollfd fds[2] = {
+					{ .fd = this->m_fd, .events = POLLIN, .revents = 0 },
+					{ .fd = this->m_wakeFd, .events = POLLIN, .revents = 0 } };
+
+				if (::poll(fds, 2, timeoutMs) < 0 && errno != EINTR)
+				{
+					PHX_CORE_ERROR("File watcher poll failed: {}", std::strerror(errno));
+					return;
+				}
+
+				if (fds[1].revents & POLLIN)
+				{
+					uint64_t value;
+					(void)::read(this->m_wakeFd, &value, sizeof(value));
+				}
+
+				if (fds[0].revents & POLLIN)
+				{
+					this->ReadEvents();
+				}
+
+				this->DispatchReady();
+			}
+		}
+
+		void ReadEvents()
+		{
+			alignas(inotify_event) char buffer[16 << 10];
+			while (true)
+			{
+				const ssize_t bytesRead = ::read(this->m_fd, buffer, sizeof(buffer));
+				if (bytesRead <= 0)
+				{
+					return;
+				}
+
+				std::scoped_lock _(this->m_mutex);
+				const Clock::time_point now = Clock::now();
+				for (char* p = buffer; p < buffer + bytesRead;)
+				{
+					const inotify_event* event = reinterpret_cast<const inotify_event*>(p);
+					p += sizeof(inotify_event) + event->len;
+
+					if (event->mask & IN_Q_OVERFLOW)
+					{
+						PHX_CORE_WARN("File watch queue overflowed, rescanning watched directories");
+						this->OnOverflowLocked(now);
+						continue;
+					}
+
+					auto dir = this->m_watchDirs.find(event->wd);
+					if (dir == this->m_watchDirs.end())
+					{
+						continue;
+					}
+
+					if (event->mask & IN_IGNORED)
+					{
+						this->m_watchDirs.erase(dir);
+						continue;
+					}
+
+					if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF))
+					{
+						// Usually a watched root, subdirectories are also reported by their parent.
+						const std::filesystem::path directory = dir->second;
+						this->OnDirectoryGoneLocked(directory, now);
+						continue;
+					}
+
+					if (event->len == 0)
+					{
+						continue;
+					}
+
+					const std::filesystem::path path = dir->second / event->name;
+					if (event->mask & IN_ISDIR)
+					{
+						// Files can land in a new directory before its watch exists, those are
+						// reported by the scan.
+						if (event->mask & (IN_CREATE | IN_MOVED_TO))
+						{
+							this->AddWatchesLocked(path, true, now);
+						}
+						else if (event->mask & (IN_DELETE | IN_MOVED_FROM))
+						{
+							this->OnDirectoryGoneLocked(path, now);
+						}
+						continue;
+					}
+
+					FileChangeType type = FileChangeType::Modified;
+					if (event->mask & (IN_CREATE | IN_MOVED_TO))
+					{
+						type = FileChangeType::Added;
+					}
+					else if (event->mask & (IN_DELETE | IN_MOVED_FROM))
+					{
+						type = FileChangeType::Removed;
+					}
+
+					this->OnChangeLocked(path, type, now);
+				}
+			}
+		}
+
+		void DispatchReady()
+		{
+			std::vector<std::pair<std::shared_ptr<Subscriber>, std::vector<FileChangeEvent>>> ready;
+			{
+				std::scoped_lock _(this->m_mutex);
+				const Clock::time_point now = Clock::now();
+				for (auto const& subscriber : this->m_subscribers)
+				{
+					if (!subscriber->Pending.IsEmpty() && subscriber->Pending.GetReadyTime() <= now)
+					{
+						std::vector<FileChangeEvent> events = subscriber->Pending.Take();
+						if (!events.empty())
+						{
+							ready.emplace_back(subscriber, std::move(events));
+						}
+					}
+				}
+			}
+
+			if (ready.empty())
+			{
+				return;
+			}
+
+			// Callbacks run without m_mutex so they can watch and unwatch.
+			std::scoped_lock dispatch(this->m_dispatchMutex);
+			for (auto& [subscriber, events] : ready)
+			{
+				if (subscriber->Active.load())
+				{
+					subscriber->OnChange(Span<FileChangeEvent>(events.data(), events.size()));
+				}
+			}
+		}
+
+	private:
+		int m_fd = -1;
+		int m_wakeFd = -1;
+		std::thread m_thread;
+
+		std::mutex m_mutex;
+		std::mutex m_dispatchMutex;
+		bool m_stop = false;
+		FileWatchHandle m_nextHandle = kInvalidFileWatch;
+		std::unordered_map<int, std::filesystem::path> m_watchDirs;
+		std::vector<std::shared_ptr<Subscriber>> m_subscribers;
+	};
+#endif
+}
+
+bool phx::FileWatch::IsAvailable()
+{
+#ifdef PHX_PLATFORM_LINUX
+	return InotifyWatcher::Get().IsAvailable();
+#else
+	return false;
+#endif
+}
+
+FileWatchHandle phx::FileWatch::WatchNativeDirectory(std::filesystem::path const& directory, FileChangeCallback&& onChange)
+{
+#ifdef PHX_PLATFORM_LINUX
+	return InotifyWatcher::Get().Watch(directory, std::move(onChange));
+#else
+	(void)directory;
+	(void)onChange;
+	return kInvalidFileWatch;
+#endif
+}
+
+void phx::FileWatch::Unwatch(FileWatchHandle handle)
+{
+#ifdef PHX_PLATFORM_LINUX
+	if (handle != kInvalidFileWatch)
+	{
+		InotifyWatcher::Get().Unwatch(handle);
+	}
+#else
+	(void)handle;
+#endif
+}
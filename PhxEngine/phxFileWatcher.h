@@ -0,0 +1,23 @@
+#pragma once
+
+#include <chrono>
+
+#include "phxVFS.h"
+
+namespace phx::FileWatch
+{
+	// Changes are held until a directory has been quiet for this long, so a save that touches a
+	// file several times arrives as one event.
+	constexpr std::chrono::milliseconds kCoalesceWindow{ 50 };
+
+	// True when native directories can be watched, which needs inotify on Linux.
+	bool IsAvailable();
+
+	// Watches directory and everything below it, including directories created later. Reported
+	// paths start with directory as given. Returns kInvalidFileWatch if it can't be watched.
+	// If the OS drops changes, e.g. when its queue overflows, the burst holds a single Rescan of
+	// directory instead. A directory below it that's moved away or deleted is reported as a Rescan
+	// of that directory, and nothing more is heard from it unless it comes back.
+	FileWatchHandle WatchNativeDirectory(std::filesystem::path const& directory, FileChangeCallback&& onChange);
+	void Unwatch(FileWatchHandle handle);
+}
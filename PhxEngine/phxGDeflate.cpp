@@ -0,0 +1,939 @@
+#include "pch.h"
+#include "phxGDeflate.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <vector>
+
+using namespace phx;
+using namespace phx::GDeflate;
+
+namespace
+{
+	constexpr uint32_t kMinMatch = 3;
+	constexpr uint32_t kMaxMatch = 258;
+	constexpr uint32_t kWindowSize = 32u << 10;
+	constexpr uint32_t kHashLog = 15;
+
+	constexpr uint32_t kMaxCodeLength = 15;
+	constexpr uint32_t kMaxPrecodeLength = 7;
+	constexpr uint32_t kNumLitLenSymbols = 288;	// 286 in use, the last two only pad the fixed code.
+	constexpr uint32_t kNumDistanceSymbols = 32;	// 30 in use.
+	constexpr uint32_t kNumPrecodeSymbols = 19;
+	constexpr uint32_t kEndOfBlock = 256;
+
+	constexpr uint32_t kBlockFixed = 1;
+	constexpr uint32_t kBlockDynamic = 2;
+
+	constexpr int kDefaultLevel = 6;
+	constexpr int kMaxLevel = 12;
+	constexpr uint32_t kMaxChainByLevel[kMaxLevel + 1] = { 0, 4, 8, 12, 16, 32, 64, 128, 256, 512, 1024, 2048, 4096 };
+	constexpr uint32_t kNiceLengthByLevel[kMaxLevel + 1] = { 0, 8, 16, 32, 32, 64, 128, 128, 258, 258, 258, 258, 258 };
+	constexpr int kMinLazyLevel = 4;
+
+	constexpr uint16_t kLengthBase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+	constexpr uint8_t kLengthExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+	constexpr uint16_t kDistanceBase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+	constexpr uint8_t kDistanceExtra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+	constexpr uint8_t kPrecodeOrder[kNumPrecodeSymbols] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+	constexpr uint8_t kPrecodeExtra[3] = { 2, 3, 7 };
+
+	// Literals and the end of block have a Distance of 0, Length holds the symbol.
+	struct Symbol
+	{
+		uint16_t Length;
+		uint16_t Distance;
+	};
+
+	struct PrecodeItem
+	{
+		uint8_t Symbol;
+		uint8_t Extra;
+	};
+
+	uint32_t GetLengthCode(uint32_t length)
+	{
+		uint32_t code = 28;
+		while (kLengthBase[code] > length)
+		{
+			code--;
+		}
+		return code;
+	}
+
+	uint32_t GetDistanceCode(uint32_t distance)
+	{
+		uint32_t code = 29;
+		while (kDistanceBase[code] > distance)
+		{
+			code--;
+		}
+		return code;
+	}
+
+	uint32_t ReverseBits(uint32_t code, uint32_t length)
+	{
+		uint32_t result = 0;
+		for (uint32_t i = 0; i < length; i++)
+		{
+			result = (result << 1) | ((code >> i) & 1);
+		}
+		return result;
+	}
+
+	void GetFixedLengths(uint8_t* litLenLengths, uint8_t* distanceLengths)
+	{
+		std::fill(litLenLengths, litLenLengths + 144, 8);
+		std::fill(litLenLengths + 144, litLenLengths + 256, 9);
+		std::fill(litLenLengths + 256, litLenLengths + 280, 7);
+		std::fill(litLenLengths + 280, litLenLengths + kNumLitLenSymbols, 8);
+		std::fill(distanceLengths, distanceLengths + kNumDistanceSymbols, 5);
+	}
+
+	// Length limited Huffman code. Frequencies are flattened until the code fits, which costs very
+	// little ratio at these alphabet sizes.
+	void BuildCodeLengths(const uint32_t* frequencies, uint32_t numSymbols, uint32_t maxLength, uint8_t* outLengths)
+	{
+		std::memset(outLengths, 0, numSymbols);
+
+		std::array<uint32_t, kNumLitLenSymbols> leaves;
+		std::array<uint32_t, kNumLitLenSymbols> weights;
+		uint32_t numLeaves = 0;
+		for (uint32_t symbol = 0; symbol < numSymbols; symbol++)
+		{
+			if (frequencies[symbol] > 0)
+			{
+				weights[symbol] = frequencies[symbol];
+				leaves[numLeaves++] = symbol;
+			}
+		}
+
+		if (numLeaves == 1)
+		{
+			outLengths[leaves[0]] = 1;
+		}
+		if (numLeaves <= 1)
+		{
+			return;
+		}
+
+		// Two queue construction: leaves sorted by weight, and internal nodes, which are created in
+		// weight order. Parents always come after their children.
+		std::array<uint32_t, 2 * kNumLitLenSymbols> nodeWeights;
+		std::array<uint32_t, 2 * kNumLitLenSymbols> parents;
+		std::array<uint32_t, 2 * kNumLitLenSymbols> depths;
+		for (;;)
+		{
+			std::sort(leaves.begin(), leaves.begin() + numLeaves, [&](uint32_t a, uint32_t b)
+				{
+					return weights[a] != weights[b] ? weights[a] < weights[b] : a < b;
+				});
+
+			for (uint32_t i = 0; i < numLeaves; i++)
+			{
+				nodeWeights[i] = weights[leaves[i]];
+			}
+
+			const uint32_t numNodes = 2 * numLeaves - 1;
+			uint32_t nextLeaf = 0;
+			uint32_t nextInternal = numLeaves;
+			for (uint32_t node = numLeaves; node < numNodes; node++)
+			{
+				uint32_t children[2];
+				for (uint32_t& child : children)
+				{
+					const bool takeLeaf = nextLeaf < numLeaves && (nextInternal == node || nodeWeights[nextLeaf] <= nodeWeights[nextInternal]);
+					child = takeLeaf ? nextLeaf++ : nextInternal++;
+				}
+
+				nodeWeights[node] = nodeWeights[children[0]] + nodeWeights[children[1]];
+				parents[children[0]] = node;
+				parents[children[1]] = node;
+			}
+
+			uint32_t longest = 0;
+			depths[numNodes - 1] = 0;
+			for (uint32_t node = numNodes - 1; node-- > 0;)
+			{
+				depths[node] = depths[parents[node]] + 1;
+				longest = std::max(longest, depths[node]);
+			}
+
+			if (longest <= maxLength)
+			{
+				for (uint32_t i = 0; i < numLeaves; i++)
+				{
+					outLengths[leaves[i]] = static_cast<uint8_t>(depths[i]);
+				}
+				return;
+			}
+
+			for (uint32_t i = 0; i < numLeaves; i++)
+			{
+				weights[leaves[i]] = std::max(weights[leaves[i]] / 2, 1u);
+			}
+		}
+	}
+
+	// Canonical codes, bit reversed since the stream is read LSB first.
+	void BuildCodes(const uint8_t* lengths, uint32_t numSymbols, uint16_t* outCodes)
+	{
+		uint32_t counts[kMaxCodeLength + 1] = {};
+		for (uint32_t symbol = 0; symbol < numSymbols; symbol++)
+		{
+			counts[lengths[symbol]]++;
+		}
+		counts[0] = 0;
+
+		uint32_t nextCode[kMaxCodeLength + 1] = {};
+		uint32_t code = 0;
+		for (uint32_t length = 1; length <= kMaxCodeLength; length++)
+		{
+			code = (code + counts[length - 1]) << 1;
+			nextCode[length] = code;
+		}
+
+		for (uint32_t symbol = 0; symbol < numSymbols; symbol++)
+		{
+			const uint32_t length = lengths[symbol];
+			outCodes[symbol] = length > 0 ? static_cast<uint16_t>(ReverseBits(nextCode[length]++, length)) : 0;
+		}
+	}
+
+	void RunLengthEncode(const uint8_t* lengths, uint32_t count, std::vector<PrecodeItem>& outItems)
+	{
+		uint32_t i = 0;
+		while (i < count)
+		{
+			const uint8_t value = lengths[i];
+			uint32_t run = 1;
+			while (i + run < count && lengths[i + run] == value)
+			{
+				run++;
+			}
+			i += run;
+
+			if (value == 0)
+			{
+				while (run >= 11)
+				{
+					const uint32_t repeat = std::min(run, 138u);
+					outItems.push_back({ 18, static_cast<uint8_t>(repeat - 11) });
+					run -= repeat;
+				}
+				if (run >= 3)
+				{
+					outItems.push_back({ 17, static_cast<uint8_t>(run - 3) });
+					run = 0;
+				}
+			}
+			else
+			{
+				outItems.push_back({ value, 0 });
+				run--;
+				while (run >= 3)
+				{
+					const uint32_t repeat = std::min(run, 6u);
+					outItems.push_back({ 16, static_cast<uint8_t>(repeat - 3) });
+					run -= repeat;
+				}
+			}
+
+			for (; run > 0; run--)
+			{
+				outItems.push_back({ value, 0 });
+			}
+		}
+	}
+
+	class MatchFinder
+	{
+	public:
+		MatchFinder(const uint8_t* src, size_t srcSize, int level)
+			: m_src(src)
+			, m_srcSize(srcSize)
+			, m_maxChain(kMaxChainByLevel[level])
+			, m_niceLength(kNiceLengthByLevel[level])
+			, m_prev(srcSize)
+		{
+			this->m_head.fill(-1);
+		}
+
+		uint32_t GetNiceLength() const { return this->m_niceLength; }
+
+		// Finds the longest match at pos, then adds pos to the chains.
+		Symbol FindAndInsert(size_t pos)
+		{
+			Symbol best = { 0, 0 };
+			if (pos + kMinMatch > this->m_srcSize)
+			{
+				return best;
+			}
+
+			const uint32_t maxLength = static_cast<uint32_t>(std::min<size_t>(kMaxMatch, this->m_srcSize - pos));
+			const uint8_t* current = this->m_src + pos;
+			int32_t& head = this->m_head[this->Hash(pos)];
+			int32_t candidate = head;
+			for (uint32_t chain = this->m_maxChain; candidate >= 0 && pos - candidate <= kWindowSize && chain > 0; chain--)
+			{
+				const uint8_t* match = this->m_src + candidate;
+				if (match[best.Length] == current[best.Length] && match[0] == current[0])
+				{
+					uint32_t length = 1;
+					while (length < maxLength && match[length] == current[length])
+					{
+						length++;
+					}
+
+					if (length > best.Length && length >= kMinMatch)
+					{
+						best = { static_cast<uint16_t>(length), static_cast<uint16_t>(pos - candidate) };
+						if (length >= this->m_niceLength || length == maxLength)
+						{
+							break;
+						}
+					}
+				}
+				candidate = this->m_prev[candidate];
+			}
+
+			this->m_prev[pos] = head;
+			head = static_cast<int32_t>(pos);
+			return best;
+		}
+
+		void Insert(size_t pos)
+		{
+			if (pos + kMinMatch <= this->m_srcSize)
+			{
+				int32_t& head = this->m_head[this->Hash(pos)];
+				this->m_prev[pos] = head;
+				head = static_cast<int32_t>(pos);
+			}
+		}
+
+	private:
+		uint32_t Hash(size_t pos) const
+		{
+			const uint8_t* p = this->m_src + pos;
+			const uint32_t sequence = p[0] | (static_cast<uint32_t>(p[1]) << 8) | (static_cast<uint32_t>(p[2]) << 16);
+			return (sequence * 2654435761u) >> (32 - kHashLog);
+		}
+
+		const uint8_t* m_src;
+		size_t m_srcSize;
+		uint32_t m_maxChain;
+		uint32_t m_niceLength;
+		std::array<int32_t, 1u << kHashLog> m_head;
+		std::vector<int32_t> m_prev;
+	};
+
+	// Greedy parsing, with one step of lazy matching from kMinLazyLevel.
+	void FindSymbols(const uint8_t* src, size_t srcSize, int level, std::vector<Symbol>& outSymbols)
+	{
+		MatchFinder finder(src, srcSize, level);
+		size_t pos = 0;
+		Symbol match = finder.FindAndInsert(pos);
+		while (pos < srcSize)
+		{
+			if (match.Length >= kMinMatch && level >= kMinLazyLevel && match.Length < finder.GetNiceLength() && pos + 1 < srcSize)
+			{
+				const Symbol next = finder.FindAndInsert(pos + 1);
+				if (next.Length > match.Length)
+				{
+					outSymbols.push_back({ src[pos], 0 });
+					pos++;
+					match = next;
+					continue;
+				}
+
+				for (size_t i = pos + 2; i < pos + match.Length; i++)
+				{
+					finder.Insert(i);
+				}
+			}
+			else if (match.Length >= kMinMatch)
+			{
+				for (size_t i = pos + 1; i < pos + match.Length; i++)
+				{
+					finder.Insert(i);
+				}
+			}
+
+			if (match.Length >= kMinMatch)
+			{
+				outSymbols.push_back(match);
+				pos += match.Length;
+			}
+			else
+			{
+				outSymbols.push_back({ src[pos], 0 });
+				pos++;
+			}
+
+			match = pos < srcSize ? finder.FindAndInsert(pos) : Symbol{ 0, 0 };
+		}
+
+		outSymbols.push_back({ static_cast<uint16_t>(kEndOfBlock), 0 });
+	}
+
+	// Records the decoder's refills so the lanes' words can be written in the order it reads them.
+	class LaneWriter
+	{
+	public:
+		void Refill(uint32_t lane)
+		{
+			if (this->m_lanes[lane].Available < 32)
+			{
+				this->m_refills.push_back(static_cast<uint8_t>(lane));
+				this->m_lanes[lane].Available += 32;
+			}
+		}
+
+		// Writes never cross a refill, the decoder has at least 32 bits after one.
+		void Write(uint32_t lane, uint32_t bits, uint32_t count)
+		{
+			Lane& l = this->m_lanes[lane];
+			l.Buffer |= static_cast<uint64_t>(bits) << l.Count;
+			l.Count += count;
+			l.Available -= count;
+			if (l.Count >= 32)
+			{
+				l.Words.push_back(static_cast<uint32_t>(l.Buffer));
+				l.Buffer >>= 32;
+				l.Count -= 32;
+			}
+		}
+
+		size_t Finish(uint8_t* dst, size_t dstCapacity)
+		{
+			const size_t size = this->m_refills.size() * sizeof(uint32_t);
+			if (size > dstCapacity)
+			{
+				return 0;
+			}
+
+			for (Lane& l : this->m_lanes)
+			{
+				if (l.Count > 0)
+				{
+					l.Words.push_back(static_cast<uint32_t>(l.Buffer));
+				}
+			}
+
+			// Refills past the end of a lane's bits are padding.
+			std::array<size_t, kNumLanes> cursors = {};
+			for (size_t i = 0; i < this->m_refills.size(); i++)
+			{
+				const uint8_t lane = this->m_refills[i];
+				std::vector<uint32_t> const& words = this->m_lanes[lane].Words;
+				const uint32_t word = cursors[lane] < words.size() ? words[cursors[lane]] : 0;
+				cursors[lane]++;
+				std::memcpy(dst + i * sizeof(uint32_t), &word, sizeof(uint32_t));
+			}
+
+			return size;
+		}
+
+	private:
+		struct Lane
+		{
+			std::vector<uint32_t> Words;
+			uint64_t Buffer = 0;
+			uint32_t Count = 0;
+			int32_t Available = 0;	// Bits the decoder holds for this lane.
+		};
+
+		std::array<Lane, kNumLanes> m_lanes;
+		std::vector<uint8_t> m_refills;
+	};
+
+	class LaneReader
+	{
+	public:
+		LaneReader(const uint8_t* src, size_t srcSize)
+			: m_next(src)
+			, m_end(src + srcSize)
+		{
+		}
+
+		bool Refill(uint32_t lane)
+		{
+			if (this->m_count[lane] < 32)
+			{
+				if (this->m_end - this->m_next < static_cast<ptrdiff_t>(sizeof(uint32_t)))
+				{
+					return false;
+				}
+
+				uint32_t word;
+				std::memcpy(&word, this->m_next, sizeof(uint32_t));
+				this->m_next += sizeof(uint32_t);
+				this->m_buffer[lane] |= static_cast<uint64_t>(word) << this->m_count[lane];
+				this->m_count[lane] += 32;
+			}
+			return true;
+		}
+
+		// Reads within a refill, at most 32 bits, so the lane always holds them.
+		uint32_t Peek(uint32_t lane, uint32_t count) const
+		{
+			return static_cast<uint32_t>(this->m_buffer[lane] & ((1ull << count) - 1));
+		}
+
+		void Consume(uint32_t lane, uint32_t count)
+		{
+			this->m_buffer[lane] >>= count;
+			this->m_count[lane] -= count;
+		}
+
+		uint32_t Read(uint32_t lane, uint32_t count)
+		{
+			const uint32_t bits = this->Peek(lane, count);
+			this->Consume(lane, count);
+			return bits;
+		}
+
+	private:
+		const uint8_t* m_next;
+		const uint8_t* m_end;
+		std::array<uint64_t, kNumLanes> m_buffer = {};
+		std::array<uint32_t, kNumLanes> m_count = {};
+	};
+
+	// Entries are (symbol << 4) | length, 0 for bit patterns no code maps to.
+	struct DecodeTable
+	{
+		std::array<uint16_t, 1u << kMaxCodeLength> Entries;
+		uint32_t Bits;
+	};
+
+	// Incomplete codes are allowed, as DEFLATE uses them for single distance codes.
+	bool BuildDecodeTable(const uint8_t* lengths, uint32_t numSymbols, DecodeTable& outTable)
+	{
+		uint32_t counts[kMaxCodeLength + 1] = {};
+		uint32_t maxLength = 1;
+		for (uint32_t symbol = 0; symbol < numSymbols; symbol++)
+		{
+			counts[lengths[symbol]]++;
+			maxLength = std::max<uint32_t>(maxLength, lengths[symbol]);
+		}
+
+		int32_t left = 1;
+		for (uint32_t length = 1; length <= kMaxCodeLength; length++)
+		{
+			left = (left << 1) - static_cast<int32_t>(counts[length]);
+			if (left < 0)
+			{
+				return false;
+			}
+		}
+
+		uint16_t codes[kNumLitLenSymbols];
+		BuildCodes(lengths, numSymbols, codes);
+
+		outTable.Bits = maxLength;
+		const uint32_t tableSize = 1u << maxLength;
+		std::fill(outTable.Entries.begin(), outTable.Entries.begin() + tableSize, 0);
+		for (uint32_t symbol = 0; symbol < numSymbols; symbol++)
+		{
+			const uint32_t length = lengths[symbol];
+			if (length == 0)
+			{
+				continue;
+			}
+
+			for (uint32_t i = codes[symbol]; i < tableSize; i += 1u << length)
+			{
+				outTable.Entries[i] = static_cast<uint16_t>((symbol << 4) | length);
+			}
+		}
+
+		return true;
+	}
+
+	bool DecodeSymbol(LaneReader& reader, uint32_t lane, DecodeTable const& table, uint32_t& outSymbol)
+	{
+		const uint16_t entry = table.Entries[reader.Peek(lane, table.Bits)];
+		if (entry == 0)
+		{
+			return false;
+		}
+
+		reader.Consume(lane, entry & 15);
+		outSymbol = entry >> 4;
+		return true;
+	}
+
+	bool ReadDynamicLengths(LaneReader& reader, uint8_t* litLenLengths, uint8_t* distanceLengths)
+	{
+		if (!reader.Refill(0))
+		{
+			return false;
+		}
+
+		const uint32_t numLitLen = reader.Read(0, 5) + 257;
+		const uint32_t numDistance = reader.Read(0, 5) + 1;
+		const uint32_t numPrecode = reader.Read(0, 4) + 4;
+		if (numLitLen > 286)
+		{
+			return false;
+		}
+
+		uint8_t precodeLengths[kNumPrecodeSymbols] = {};
+		for (uint32_t i = 0; i < numPrecode; i++)
+		{
+			if (!reader.Refill(0))
+			{
+				return false;
+			}
+			precodeLengths[kPrecodeOrder[i]] = static_cast<uint8_t>(reader.Read(0, 3));
+		}
+
+		thread_local DecodeTable precodeTable;
+		if (!BuildDecodeTable(precodeLengths, kNumPrecodeSymbols, precodeTable))
+		{
+			return false;
+		}
+
+		// Runs may cross from the literal/length lengths into the distance lengths.
+		uint8_t lengths[kNumLitLenSymbols + kNumDistanceSymbols];
+		const uint32_t numLengths = numLitLen + numDistance;
+		uint32_t i = 0;
+		while (i < numLengths)
+		{
+			uint32_t symbol;
+			if (!reader.Refill(0) || !DecodeSymbol(reader, 0, precodeTable, symbol))
+			{
+				return false;
+			}
+
+			if (symbol < 16)
+			{
+				lengths[i++] = static_cast<uint8_t>(symbol);
+				continue;
+			}
+
+			if (symbol == 16 && i == 0)
+			{
+				return false;
+			}
+
+			const uint8_t value = symbol == 16 ? lengths[i - 1] : 0;
+			const uint32_t repeat = reader.Read(0, kPrecodeExtra[symbol - 16]) + (symbol == 18 ? 11 : 3);
+			if (repeat > numLengths - i)
+			{
+				return false;
+			}
+
+			std::fill(lengths + i, lengths + i + repeat, value);
+			i += repeat;
+		}
+
+		std::memset(litLenLengths, 0, kNumLitLenSymbols);
+		std::memset(distanceLengths, 0, kNumDistanceSymbols);
+		std::memcpy(litLenLengths, lengths, numLitLen);
+		std::memcpy(distanceLengths, lengths + numLitLen, numDistance);
+		return litLenLengths[kEndOfBlock] != 0;
+	}
+}
+
+size_t phx::GDeflate::Compress(const void* src, size_t srcSize, void* dst, size_t dstCapacity, int level)
+{
+	if (srcSize > kTileSize || dstCapacity < CompressBound(srcSize))
+	{
+		return 0;
+	}
+
+	level = level > 0 ? std::min(level, kMaxLevel) : kDefaultLevel;
+	const uint8_t* source = static_cast<const uint8_t*>(src);
+
+	std::vector<Symbol> symbols;
+	symbols.reserve(srcSize / 2 + 1);
+	FindSymbols(source, srcSize, level, symbols);
+
+	uint32_t litLenFrequencies[kNumLitLenSymbols] = {};
+	uint32_t distanceFrequencies[kNumDistanceSymbols] = {};
+	for (Symbol const& symbol : symbols)
+	{
+		if (symbol.Distance == 0)
+		{
+			litLenFrequencies[symbol.Length]++;
+		}
+		else
+		{
+			litLenFrequencies[257 + GetLengthCode(symbol.Length)]++;
+			distanceFrequencies[GetDistanceCode(symbol.Distance)]++;
+		}
+	}
+
+	// Dynamic code, with a distance code even when there are no matches as the header needs one.
+	uint8_t litLenLengths[kNumLitLenSymbols];
+	uint8_t distanceLengths[kNumDistanceSymbols];
+	BuildCodeLengths(litLenFrequencies, kNumLitLenSymbols, kMaxCodeLength, litLenLengths);
+	BuildCodeLengths(distanceFrequencies, kNumDistanceSymbols, kMaxCodeLength, distanceLengths);
+
+	uint32_t numLitLen = 286;
+	while (numLitLen > 257 && litLenLengths[numLitLen - 1] == 0)
+	{
+		numLitLen--;
+	}
+
+	uint32_t numDistance = 30;
+	while (numDistance > 1 && distanceLengths[numDistance - 1] == 0)
+	{
+		numDistance--;
+	}
+	if (distanceLengths[0] == 0 && numDistance == 1)
+	{
+		distanceLengths[0] = 1;
+	}
+
+	uint8_t lengths[kNumLitLenSymbols + kNumDistanceSymbols];
+	std::memcpy(lengths, litLenLengths, numLitLen);
+	std::memcpy(lengths + numLitLen, distanceLengths, numDistance);
+
+	std::vector<PrecodeItem> precodeItems;
+	RunLengthEncode(lengths, numLitLen + numDistance, precodeItems);
+
+	uint32_t precodeFrequencies[kNumPrecodeSymbols] = {};
+	for (PrecodeItem const& item : precodeItems)
+	{
+		precodeFrequencies[item.Symbol]++;
+	}
+
+	uint8_t precodeLengths[kNumPrecodeSymbols];
+	BuildCodeLengths(precodeFrequencies, kNumPrecodeSymbols, kMaxPrecodeLength, precodeLengths);
+
+	uint32_t numPrecode = kNumPrecodeSymbols;
+	while (numPrecode > 4 && precodeLengths[kPrecodeOrder[numPrecode - 1]] == 0)
+	{
+		numPrecode--;
+	}
+
+	// Pick whichever of the dynamic and fixed codes is smaller.
+	uint8_t fixedLitLenLengths[kNumLitLenSymbols];
+	uint8_t fixedDistanceLengths[kNumDistanceSymbols];
+	GetFixedLengths(fixedLitLenLengths, fixedDistanceLengths);
+
+	uint64_t dynamicBits = 3 + 14 + 3 * numPrecode;
+	uint64_t fixedBits = 3;
+	for (PrecodeItem const& item : precodeItems)
+	{
+		dynamicBits += precodeLengths[item.Symbol] + (item.Symbol >= 16 ? kPrecodeExtra[item.Symbol - 16] : 0);
+	}
+	for (uint32_t symbol = 0; symbol < kNumLitLenSymbols; symbol++)
+	{
+		const uint32_t extra = symbol > 256 && symbol < 286 ? kLengthExtra[symbol - 257] : 0;
+		dynamicBits += static_cast<uint64_t>(litLenFrequencies[symbol]) * (litLenLengths[symbol] + extra);
+		fixedBits += static_cast<uint64_t>(litLenFrequencies[symbol]) * (fixedLitLenLengths[symbol] + extra);
+	}
+	for (uint32_t symbol = 0; symbol < 30; symbol++)
+	{
+		dynamicBits += static_cast<uint64_t>(distanceFrequencies[symbol]) * (distanceLengths[symbol] + kDistanceExtra[symbol]);
+		fixedBits += static_cast<uint64_t>(distanceFrequencies[symbol]) * (fixedDistanceLengths[symbol] + kDistanceExtra[symbol]);
+	}
+
+	const bool useFixed = fixedBits <= dynamicBits;
+	if (useFixed)
+	{
+		std::memcpy(litLenLengths, fixedLitLenLengths, kNumLitLenSymbols);
+		std::memcpy(distanceLengths, fixedDistanceLengths, kNumDistanceSymbols);
+	}
+
+	uint16_t litLenCodes[kNumLitLenSymbols];
+	uint16_t distanceCodes[kNumDistanceSymbols];
+	BuildCodes(litLenLengths, kNumLitLenSymbols, litLenCodes);
+	BuildCodes(distanceLengths, kNumDistanceSymbols, distanceCodes);
+
+	// Each tile is a single final block.
+	LaneWriter writer;
+	writer.Refill(0);
+	writer.Write(0, 1 | ((useFixed ? kBlockFixed : kBlockDynamic) << 1), 3);
+	if (!useFixed)
+	{
+		uint16_t precodeCodes[kNumPrecodeSymbols];
+		BuildCodes(precodeLengths, kNumPrecodeSymbols, precodeCodes);
+
+		writer.Refill(0);
+		writer.Write(0, (numLitLen - 257) | ((numDistance - 1) << 5) | ((numPrecode - 4) << 10), 14);
+		for (uint32_t i = 0; i < numPrecode; i++)
+		{
+			writer.Refill(0);
+			writer.Write(0, precodeLengths[kPrecodeOrder[i]], 3);
+		}
+
+		for (PrecodeItem const& item : precodeItems)
+		{
+			writer.Refill(0);
+			writer.Write(0, precodeCodes[item.Symbol], precodeLengths[item.Symbol]);
+			if (item.Symbol >= 16)
+			{
+				writer.Write(0, item.Extra, kPrecodeExtra[item.Symbol - 16]);
+			}
+		}
+	}
+
+	for (size_t round = 0; round < symbols.size(); round += kNumLanes)
+	{
+		const uint32_t numInRound = static_cast<uint32_t>(std::min<size_t>(kNumLanes, symbols.size() - round));
+		for (uint32_t lane = 0; lane < numInRound; lane++)
+		{
+			Symbol const& symbol = symbols[round + lane];
+			writer.Refill(lane);
+			if (symbol.Distance == 0)
+			{
+				writer.Write(lane, litLenCodes[symbol.Length], litLenLengths[symbol.Length]);
+			}
+			else
+			{
+				const uint32_t code = GetLengthCode(symbol.Length);
+				writer.Write(lane, litLenCodes[257 + code], litLenLengths[257 + code]);
+				writer.Write(lane, symbol.Length - kLengthBase[code], kLengthExtra[code]);
+			}
+		}
+
+		for (uint32_t lane = 0; lane < numInRound; lane++)
+		{
+			Symbol const& symbol = symbols[round + lane];
+			if (symbol.Distance != 0)
+			{
+				const uint32_t code = GetDistanceCode(symbol.Distance);
+				writer.Refill(lane);
+				writer.Write(lane, distanceCodes[code], distanceLengths[code]);
+				writer.Write(lane, symbol.Distance - kDistanceBase[code], kDistanceExtra[code]);
+			}
+		}
+	}
+
+	return writer.Finish(static_cast<uint8_t*>(dst), dstCapacity);
+}
+
+bool phx::GDeflate::Decompress(const void* src, size_t srcSize, void* dst, size_t dstSize)
+{
+	LaneReader reader(static_cast<const uint8_t*>(src), srcSize);
+	uint8_t* const opBase = static_cast<uint8_t*>(dst);
+	uint8_t* op = opBase;
+	uint8_t* const opEnd = op + dstSize;
+
+	thread_local DecodeTable litLenTable;
+	thread_local DecodeTable distanceTable;
+
+	bool finalBlock = false;
+	while (!finalBlock)
+	{
+		if (!reader.Refill(0))
+		{
+			return false;
+		}
+
+		finalBlock = reader.Read(0, 1) != 0;
+		const uint32_t blockType = reader.Read(0, 2);
+
+		uint8_t litLenLengths[kNumLitLenSymbols];
+		uint8_t distanceLengths[kNumDistanceSymbols];
+		if (blockType == kBlockFixed)
+		{
+			GetFixedLengths(litLenLengths, distanceLengths);
+		}
+		else if (blockType != kBlockDynamic || !ReadDynamicLengths(reader, litLenLengths, distanceLengths))
+		{
+			return false;
+		}
+
+		if (!BuildDecodeTable(litLenLengths, kNumLitLenSymbols, litLenTable) ||
+			!BuildDecodeTable(distanceLengths, kNumDistanceSymbols, distanceTable))
+		{
+			return false;
+		}
+
+		bool endOfBlock = false;
+		while (!endOfBlock)
+		{
+			// A round decodes all its lengths before any distance, as the lanes would in parallel.
+			Symbol round[kNumLanes];
+			uint32_t numInRound = 0;
+			for (uint32_t lane = 0; lane < kNumLanes; lane++)
+			{
+				uint32_t symbol;
+				if (!reader.Refill(lane) || !DecodeSymbol(reader, lane, litLenTable, symbol))
+				{
+					return false;
+				}
+
+				if (symbol == kEndOfBlock)
+				{
+					endOfBlock = true;
+					break;
+				}
+
+				if (symbol < kEndOfBlock)
+				{
+					round[lane] = { static_cast<uint16_t>(symbol), 0 };
+				}
+				else if (symbol < 286)
+				{
+					const uint32_t code = symbol - 257;
+					round[lane] = { static_cast<uint16_t>(kLengthBase[code] + reader.Read(lane, kLengthExtra[code])), 1 };
+				}
+				else
+				{
+					return false;
+				}
+				numInRound++;
+			}
+
+			for (uint32_t lane = 0; lane < numInRound; lane++)
+			{
+				if (round[lane].Distance == 0)
+				{
+					continue;
+				}
+
+				uint32_t code;
+				if (!reader.Refill(lane) || !DecodeSymbol(reader, lane, distanceTable, code) || code >= 30)
+				{
+					return false;
+				}
+				round[lane].Distance = static_cast<uint16_t>(kDistanceBase[code] + reader.Read(lane, kDistanceExtra[code]));
+			}
+
+			for (uint32_t lane = 0; lane < numInRound; lane++)
+			{
+				Symbol const& symbol = round[lane];
+				if (symbol.Distance == 0)
+				{
+					if (op == opEnd)
+					{
+						return false;
+					}
+					*op++ = static_cast<uint8_t>(symbol.Length);
+					continue;
+				}
+
+				if (symbol.Distance > op - opBase || symbol.Length > opEnd - op)
+				{
+					return false;
+				}
+
+				// Overlapping copy repeats the last Distance bytes.
+				const uint8_t* match = op - symbol.Distance;
+				if (symbol.Distance >= symbol.Length)
+				{
+					std::memcpy(op, match, symbol.Length);
+					op += symbol.Length;
+				}
+				else
+				{
+					for (uint32_t i = 0; i < symbol.Length; i++)
+					{
+						*op++ = *match++;
+					}
+				}
+			}
+		}
+	}
+
+	return op == opEnd;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace phx::GDeflate
+{
+	// GDeflate is DEFLATE (RFC 1951) with the bits spread over 32 lanes, so a GPU can decode 32
+	// symbols at once. Streams are split into 64KiB tiles that decode on their own:
+	//   StreamHeader
+	//   uint32_t TileOffsets[NumTiles], from the end of the table. The first tile always starts at 0,
+	//            so the first entry holds the size of the last tile instead.
+	//   Tile data
+	// phx::Codec handles the stream and threading, the functions here encode and decode one tile.
+	//
+	// A tile is a sequence of little-endian 32-bit words. Each lane is an LSB-first bit stream that
+	// takes the next unread word when it's refilled holding fewer than 32 bits, so the lanes' words
+	// are interleaved in the order the decoder asks for them. Block headers are read from lane 0,
+	// refilling before each field group. A block's symbols are dealt to the lanes in rounds of 32,
+	// starting at lane 0: every lane refills and reads its literal/length code and extra bits in lane
+	// order, then every lane holding a length refills and reads its distance in lane order. Only
+	// Huffman blocks are used, stored blocks aren't supported.
+	constexpr uint32_t kTileSize = 64u << 10;
+	constexpr uint32_t kNumLanes = 32;
+	constexpr uint8_t kStreamId = 4;
+
+	struct StreamHeader
+	{
+		uint8_t Id;					// kStreamId
+		uint8_t Magic;				// Id ^ 0xff
+		uint16_t NumTiles;
+		uint32_t TileSizeIndex : 2;	// 1 for kTileSize
+		uint32_t LastTileSize : 18;	// 0 when the last tile is full
+		uint32_t Reserved : 12;
+	};
+
+	static_assert(sizeof(StreamHeader) == 8);
+
+	// Bound for one tile of at most kTileSize bytes.
+	constexpr size_t CompressBound(size_t srcSize)
+	{
+		return srcSize + srcSize / 8 + 1024;
+	}
+
+	// Returns the compressed size, or 0 if srcSize is above kTileSize or dstCapacity is below
+	// CompressBound(srcSize). level goes from 1 (fastest) to 12 (smallest), 0 picks the default.
+	size_t Compress(const void* src, size_t srcSize, void* dst, size_t dstCapacity, int level = 0);
+
+	// Fails on malformed input or if the tile doesn't decode to exactly dstSize bytes. Never reads
+	// or writes out of bounds.
+	bool Decompress(const void* src, size_t srcSize, void* dst, size_t dstSize);
+}
@@ -0,0 +1,236 @@
+#include "pch.h"
+#include "phxLz4.h"
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+using namespace phx;
+
+namespace
+{
+	constexpr size_t kMinMatch = 4;
+	constexpr size_t kLastLiterals = 5;	// The format requires the block to end in literals.
+	constexpr size_t kMatchStartLimit = 12;	// No match may start within this many bytes of the end.
+	constexpr size_t kMaxOffset = 65535;
+	constexpr uint32_t kHashLog = 14;
+
+	uint32_t Read32(const uint8_t* p)
+	{
+		uint32_t v;
+		std::memcpy(&v, p, sizeof(v));
+		return v;
+	}
+
+	uint32_t Hash(uint32_t sequence)
+	{
+		return (sequence * 2654435761u) >> (32 - kHashLog);
+	}
+
+	uint8_t* WriteLength(uint8_t* op, size_t length)
+	{
+		while (length >= 255)
+		{
+			*op++ = 255;
+			length -= 255;
+		}
+		*op++ = static_cast<uint8_t>(length);
+		return op;
+	}
+
+	uint8_t* WriteLiterals(uint8_t* op, uint8_t* token, const uint8_t* literals, size_t length)
+	{
+		if (length >= 15)
+		{
+			*token = 15 << 4;
+			op = WriteLength(op, length - 15);
+		}
+		else
+		{
+			*token = static_cast<uint8_t>(length << 4);
+		}
+
+		if (length > 0)
+		{
+			std::memcpy(op, literals, length);
+		}
+		return op + length;
+	}
+
+	bool ReadLength(const uint8_t*& ip, const uint8_t* end, size_t& length)
+	{
+		uint8_t b;
+		do
+		{
+			if (ip == end)
+			{
+				return false;
+			}
+			b = *ip++;
+			length += b;
+		} while (b == 255);
+
+		return true;
+	}
+}
+
+size_t phx::Lz4::Compress(const void* src, size_t srcSize, void* dst, size_t dstCapacity)
+{
+	if (dstCapacity < CompressBound(srcSize))
+	{
+		return 0;
+	}
+
+	const uint8_t* const base = static_cast<const uint8_t*>(src);
+	uint8_t* op = static_cast<uint8_t*>(dst);
+	size_t anchor = 0;
+
+	if (srcSize > kMatchStartLimit)
+	{
+		// Candidates are verified against the data, so stale entries from a previous block only cost
+		// a compare.
+		thread_local std::array<uint32_t, 1u << kHashLog> table;
+		table.fill(0);
+
+		const size_t matchStartLimit = srcSize - kMatchStartLimit;
+		const size_t matchEndLimit = srcSize - kLastLiterals;
+		size_t ip = 1;
+		uint32_t misses = 0;
+		while (ip <= matchStartLimit)
+		{
+			const uint32_t sequence = Read32(base + ip);
+			uint32_t& slot = table[Hash(sequence)];
+			size_t ref = slot;
+			slot = static_cast<uint32_t>(ip);
+
+			if (ref >= ip || ip - ref > kMaxOffset || Read32(base + ref) != sequence)
+			{
+				// Step faster through data that isn't matching.
+				ip += 1 + (misses++ >> 6);
+				continue;
+			}
+			misses = 0;
+
+			while (ip > anchor && ref > 0 && base[ip - 1] == base[ref - 1])
+			{
+				ip--;
+				ref--;
+			}
+
+			size_t matchLength = kMinMatch;
+			while (ip + matchLength < matchEndLimit && base[ip + matchLength] == base[ref + matchLength])
+			{
+				matchLength++;
+			}
+
+			uint8_t* token = op++;
+			op = WriteLiterals(op, token, base + anchor, ip - anchor);
+
+			const size_t offset = ip - ref;
+			*op++ = static_cast<uint8_t>(offset);
+			*op++ = static_cast<uint8_t>(offset >> 8);
+
+			const size_t extraLength = matchLength - kMinMatch;
+			if (extraLength >= 15)
+			{
+				*token |= 15;
+				op = WriteLength(op, extraLength - 15);
+			}
+			else
+			{
+				*token |= static_cast<uint8_t>(extraLength);
+			}
+
+			ip += matchLength;
+			anchor = ip;
+
+			if (ip - 2 <= matchStartLimit)
+			{
+				table[Hash(Read32(base + ip - 2))] = static_cast<uint32_t>(ip - 2);
+			}
+		}
+	}
+
+	uint8_t* token = op++;
+	op = WriteLiterals(op, token, base + anchor, srcSize - anchor);
+	return static_cast<size_t>(op - static_cast<uint8_t*>(dst));
+}
+
+bool phx::Lz4::Decompress(const void* src, size_t srcSize, void* dst, size_t dstSize)
+{
+	const uint8_t* ip = static_cast<const uint8_t*>(src);
+	const uint8_t* const ipEnd = ip + srcSize;
+	uint8_t* const opBase = static_cast<uint8_t*>(dst);
+	uint8_t* op = opBase;
+	uint8_t* const opEnd = op + dstSize;
+
+	while (ip < ipEnd)
+	{
+		const uint8_t token = *ip++;
+
+		size_t literalLength = token >> 4;
+		if (literalLength == 15 && !ReadLength(ip, ipEnd, literalLength))
+		{
+			return false;
+		}
+
+		if (literalLength > static_cast<size_t>(ipEnd - ip) || literalLength > static_cast<size_t>(opEnd - op))
+		{
+			return false;
+		}
+
+		if (literalLength > 0)
+		{
+			std::memcpy(op, ip, literalLength);
+		}
+		ip += literalLength;
+		op += literalLength;
+
+		// The last sequence is literals only.
+		if (ip == ipEnd)
+		{
+			break;
+		}
+
+		if (ipEnd - ip < 2)
+		{
+			return false;
+		}
+
+		const size_t offset = ip[0] | (static_cast<size_t>(ip[1]) << 8);
+		ip += 2;
+		if (offset == 0 || offset > static_cast<size_t>(op - opBase))
+		{
+			return false;
+		}
+
+		size_t matchLength = token & 15;
+		if (matchLength == 15 && !ReadLength(ip, ipEnd, matchLength))
+		{
+			return false;
+		}
+		matchLength += kMinMatch;
+
+		if (matchLength > static_cast<size_t>(opEnd - op))
+		{
+			return false;
+		}
+
+		const uint8_t* match = op - offset;
+		if (offset >= matchLength)
+		{
+			std::memcpy(op, match, matchLength);
+			op += matchLength;
+		}
+		else
+		{
+			// Overlapping copy repeats the last offset bytes.
+			for (size_t i = 0; i < matchLength; i++)
+			{
+				*op++ = *match++;
+			}
+		}
+	}
+
+	return op == opEnd;
+}
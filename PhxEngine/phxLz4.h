@@ -0,0 +1,21 @@
+#pragma once
+
+#include <stddef.h>
+
+namespace phx::Lz4
+{
+	// Raw LZ4 block format, readable by LZ4_decompress_safe. Blocks are independent, there is no
+	// frame header or checksum.
+
+	constexpr size_t CompressBound(size_t srcSize)
+	{
+		return srcSize + srcSize / 255 + 16;
+	}
+
+	// Returns the compressed size, or 0 if dstCapacity is below CompressBound(srcSize).
+	size_t Compress(const void* src, size_t srcSize, void* dst, size_t dstCapacity);
+
+	// Fails on malformed input or if the block doesn't decode to exactly dstSize bytes. Never reads
+	// or writes out of bounds.
+	bool Decompress(const void* src, size_t srcSize, void* dst, size_t dstSize);
+}
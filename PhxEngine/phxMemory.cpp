@@ -1,20 +1,74 @@
 #include "pch.h"
 
 #include "phxMemory.h"
+#include "phxMemoryResource.h"
 
+#include <assert.h>
+#include <atomic>
+#include <bit>
 #include <iostream>
 #include <mutex>
 #include <vector>
 
+#if !defined(PHX_PLATFORM_WINDOWS)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
 using namespace phx;
 namespace
 {
 	uint8_t* VirtualPtr;
+	size_t VirtualMemorySize = 0;
 	size_t TotalMemoryCommited = 0;
-	size_t PtrOffset = 0;
+	std::atomic<size_t> PtrOffset = 0;
 	std::mutex Mutex;
-	VirtualStackAllocator gFrameAllocator;
-	VirtualStackAllocator gScratchAllocator;;
+
+	// Thread indices are handed out lowest first, so with threads coming and going the live
+	// ones still fit in the per thread slots of the allocators and pools.
+	std::mutex ThreadIndexMutex;
+	uint32_t NextThreadIndex = 0;
+	std::vector<uint32_t> FreeThreadIndices;
+
+	struct ThreadIndexSlot
+	{
+		const uint32_t Index;
+
+		ThreadIndexSlot()
+			: Index(Acquire())
+		{
+		}
+
+		~ThreadIndexSlot()
+		{
+			std::scoped_lock _(ThreadIndexMutex);
+			FreeThreadIndices.push_back(this->Index);
+		}
+
+		static uint32_t Acquire()
+		{
+			std::scoped_lock _(ThreadIndexMutex);
+			if (FreeThreadIndices.empty())
+			{
+				return NextThreadIndex++;
+			}
+
+			auto lowest = std::min_element(FreeThreadIndices.begin(), FreeThreadIndices.end());
+			const uint32_t index = *lowest;
+			*lowest = FreeThreadIndices.back();
+			FreeThreadIndices.pop_back();
+			return index;
+		}
+	};
+	thread_local const ThreadIndexSlot tThreadSlot;
+
+	VirtualStackAllocator gFrameAllocator(4_MiB, VirtualStackAllocator::ThreadingMode::PerThread);
+	VirtualStackAllocator gScratchAllocator(4_MiB, VirtualStackAllocator::ThreadingMode::PerThread);
+	FrameRingAllocator gFrameRingAllocator;
+
+	StackMemoryResource gFrameResource(gFrameAllocator);
+	StackMemoryResource gScratchResource(gScratchAllocator);
+	TlsfAllocator gHeap;
 
 	template<typename T, typename U>
 	constexpr T AlignUp(T Size, U Alignment)
@@ -22,39 +76,82 @@ namespace
 		return (T)(((size_t)Size + (size_t)Alignment - 1) & ~((size_t)Alignment - 1));
 	}
 
+	// Hands out address space from the shared reservation. Memory is not committed. Sizes are
+	// rounded to whole pages, so every range handed out starts on a page boundary.
+	uint8_t* Reserve(size_t reserveSize)
+	{
+		reserveSize = AlignUp(reserveSize, VirtualMemPageSize());
+		const size_t offset = PtrOffset.fetch_add(reserveSize, std::memory_order_relaxed);
+		if (offset + reserveSize > VirtualMemorySize)
+		{
+			PHX_CORE_ERROR("Ran out of reserved virtual memory");
+			return nullptr;
+		}
+
+		return VirtualPtr + offset;
+	}
+
 	uint8_t* Commit(size_t commitSize)
 	{
-		std::scoped_lock _(Mutex);
+		uint8_t* ptr = Reserve(commitSize);
+		if (!ptr)
+		{
+			return nullptr;
+		}
 
-		PtrOffset += commitSize;
-		if (PtrOffset < TotalMemoryCommited)
+		if (!VirtualMemCommit(ptr, commitSize))
 		{
-			// no need to commit more memory, return address offset
-			return VirtualPtr + PtrOffset;
+			return nullptr;
 		}
 
-		// Commit data
-		VirtualAlloc(VirtualPtr + TotalMemoryCommited, commitSize, MEM_COMMIT, PAGE_READWRITE);
+		std::scoped_lock _(Mutex);
 		TotalMemoryCommited += commitSize;
-		PtrOffset += commitSize;
-		return VirtualPtr + PtrOffset;
+
+		return ptr;
 	}
 
 }
 
 void Memory::Initialize(MemoryConfiguration const& config)
 {
-	VirtualPtr = static_cast<uint8_t*>(VirtualAlloc(NULL, config.VirtualMemorySize, MEM_RESERVE, PAGE_READWRITE));
+	gFrameAllocator.SetDecommitIdleFrames(config.DecommitIdleFrames);
+	gScratchAllocator.SetDecommitIdleFrames(config.DecommitIdleFrames);
+
+	gFrameRingAllocator.Initialize(config.NumFramesInFlight, config.StackPageSize);
+
+	// Without a reservation every allocator and the heap fail their allocations.
+	VirtualPtr = static_cast<uint8_t*>(VirtualMemReserve(config.VirtualMemorySize, config.UseHugePages));
+	if (!VirtualPtr)
+	{
+		PHX_CORE_ERROR("Failed to reserve {} bytes of virtual memory", config.VirtualMemorySize);
+		VirtualMemorySize = 0;
+		return;
+	}
+	VirtualMemorySize = config.VirtualMemorySize;
+
+	uint8_t* heapMemory = Reserve(config.HeapReserveSize);
+	if (!heapMemory || !gHeap.Initialize(heapMemory, config.HeapReserveSize, config.HeapCommitGranularity))
+	{
+		PHX_CORE_ERROR("Failed to initialize the heap");
+	}
 }
 
 void Memory::Finalize()
 {
+	gFrameRingAllocator.Finalize();
+	gHeap.Finalize();
+
+	// Their pages point into the reservation, drop them so a later Initialize starts clean.
+	gFrameAllocator.Release();
+	gScratchAllocator.Release();
+
 	// Free the committed memory
-	if (!VirtualFree(reinterpret_cast<void*>(VirtualPtr), 0, MEM_RELEASE))
+	if (VirtualPtr && !VirtualMemFree(reinterpret_cast<void*>(VirtualPtr), VirtualMemorySize))
 	{
 		std::cerr << "Memory deallocation failed." << std::endl;
 	}
 	VirtualPtr = nullptr;
+	VirtualMemorySize = 0;
 	TotalMemoryCommited = 0;
 	PtrOffset = 0;
 }
@@ -62,8 +159,7 @@ void Memory::Finalize()
 
 void Memory::BeginFrame()
 {
-	std::scoped_lock _(Mutex);
-	PtrOffset = 0;
+	// Allocators keep the pages they've been given, so only their cursors are reset.
 	gFrameAllocator.Reset();
 	gScratchAllocator.Reset();
 }
@@ -78,74 +174,908 @@ VirtualStackAllocator& Memory::GetScratchAllocator()
 	return gScratchAllocator;
 
 }
-VirtualStackAllocator::VirtualStackAllocator(size_t pageSize)
+
+FrameRingAllocator& Memory::GetFrameRingAllocator()
+{
+	return gFrameRingAllocator;
+}
+
+TlsfAllocator& Memory::GetHeap()
+{
+	return gHeap;
+}
+
+TlsfAllocator* Memory::GetHeapIfInitialized()
+{
+	return gHeap.IsInitialized() ? &gHeap : nullptr;
+}
+
+uint32_t Memory::GetThreadIndex()
+{
+	return tThreadSlot.Index;
+}
+
+std::pmr::memory_resource* Memory::GetFrameResource()
+{
+	return &gFrameResource;
+}
+
+std::pmr::memory_resource* Memory::GetScratchResource()
+{
+	return &gScratchResource;
+}
+
+void FrameRingAllocator::Initialize(uint32_t numFramesInFlight, size_t pageSize, size_t maxRegionPages)
+{
+	assert(numFramesInFlight > 0 && numFramesInFlight <= kMaxFramesInFlight);
+	this->m_numFramesInFlight = std::clamp<uint32_t>(numFramesInFlight, 1, kMaxFramesInFlight);
+	this->m_currentRegion = 0;
+
+	for (uint32_t i = 0; i < this->m_numFramesInFlight; i++)
+	{
+		this->m_regions[i] = std::make_unique<VirtualStackAllocator>(pageSize, VirtualStackAllocator::ThreadingMode::PerThread, maxRegionPages);
+		this->m_regionFrames[i] = kUnusedRegion;
+	}
+
+	this->m_regionFrames[0] = 0;
+}
+
+void FrameRingAllocator::Finalize()
+{
+	for (auto& region : this->m_regions)
+	{
+		region.reset();
+	}
+
+	this->m_numFramesInFlight = 0;
+	this->m_currentRegion = 0;
+}
+
+bool FrameRingAllocator::BeginFrame(uint64_t frameIndex, uint64_t completedFrame)
+{
+	const uint32_t regionIndex = static_cast<uint32_t>(frameIndex % this->m_numFramesInFlight);
+	if (regionIndex == this->m_currentRegion && this->m_regionFrames[regionIndex] == frameIndex)
+	{
+		return true;
+	}
+
+	if (!this->IsRegionRetired(regionIndex, completedFrame))
+	{
+		return false;
+	}
+
+	this->m_regions[regionIndex]->Reset();
+	this->m_regionFrames[regionIndex] = frameIndex;
+	this->m_currentRegion = regionIndex;
+
+	return true;
+}
+
+bool FrameRingAllocator::IsRegionRetired(uint32_t regionIndex, uint64_t completedFrame) const
+{
+	const uint64_t regionFrame = this->m_regionFrames[regionIndex];
+	return regionFrame == kUnusedRegion || regionFrame < completedFrame;
+}
+VirtualStackAllocator::VirtualStackAllocator(size_t pageSize, ThreadingMode mode, size_t maxArenaPages)
 	: m_pageSize(pageSize)
+	, m_mode(mode)
 	, m_currentPage(0)
 	, m_ptrOffset(0)
+	, m_maxArenaPages(maxArenaPages)
 {
 }
 
 void* VirtualStackAllocator::Allocate(size_t size, size_t alignment)
+{
+	// Threads past the arena limit fall back to the locked path.
+	if (this->m_mode == ThreadingMode::PerThread && tThreadSlot.Index < kMaxThreadArenas)
+	{
+		return this->AllocateThreadArena(size, alignment);
+	}
+
+	return this->AllocateLocked(size, alignment);
+}
+
+void VirtualStackAllocator::Reset()
+{
+	std::scoped_lock _(this->m_mutex);
+	const size_t usedPages = this->m_framePages;
+	this->m_currentPage = 0;
+	this->m_ptrOffset = 0;
+	this->m_framePages = 0;
+
+	for (LargeBlock& block : this->m_largeBlocks)
+	{
+		block.InUse = false;
+	}
+
+	size_t usedArenaPages = 0;
+	if (this->m_mode == ThreadingMode::PerThread)
+	{
+		// Arenas notice the generation change on their next allocation and drop their cursor.
+		usedArenaPages = this->m_nextArenaPage.exchange(0, std::memory_order_relaxed);
+		this->m_generation.fetch_add(1, std::memory_order_release);
+	}
+
+	this->DecommitIdlePages(usedPages, usedArenaPages);
+}
+
+void VirtualStackAllocator::Release()
+{
+	std::scoped_lock _(this->m_mutex);
+	this->m_pages.clear();
+	this->m_largeBlocks.clear();
+	this->m_currentPage = 0;
+	this->m_ptrOffset = 0;
+	this->m_numCommittedPages = 0;
+	this->m_framePages = 0;
+	this->m_idleFrames = 0;
+	this->m_peakPages = 0;
+	this->m_peakArenaPages = 0;
+
+	this->m_arenaBase = nullptr;
+	this->m_arenaReserved.store(false, std::memory_order_relaxed);
+	this->m_nextArenaPage.store(0, std::memory_order_relaxed);
+	this->m_committedArenaPages.store(0, std::memory_order_relaxed);
+	this->m_generation.fetch_add(1, std::memory_order_release);
+}
+
+VirtualStackAllocator::Marker VirtualStackAllocator::GetMarker()
+{
+	if (this->m_mode == ThreadingMode::PerThread && tThreadSlot.Index < kMaxThreadArenas)
+	{
+		// Per thread markers store the arena's page end and cursor. The marker has to point into a
+		// page, otherwise freeing it would drop the page the scope allocated into until the next Reset.
+		ThreadArena& arena = this->m_threadArenas[tThreadSlot.Index];
+		const uint64_t generation = this->m_generation.load(std::memory_order_acquire);
+		if (arena.Generation != generation || arena.End == 0)
+		{
+			arena.Cursor = 0;
+			arena.End = 0;
+			arena.Generation = generation;
+
+			const size_t firstPage = this->AcquireArenaPages(1);
+			if (firstPage == kInvalidPage)
+			{
+				return { .PageIndex = 0, .ByteOffset = 0 };
+			}
+
+			arena.Cursor = firstPage * this->m_pageSize;
+			arena.End = arena.Cursor + this->m_pageSize;
+		}
+
+		return { .PageIndex = arena.End / this->m_pageSize, .ByteOffset = arena.Cursor };
+	}
+
+	std::scoped_lock _(this->m_mutex);
+	return { .PageIndex = this->m_currentPage, .ByteOffset = this->m_ptrOffset };
+}
+
+void VirtualStackAllocator::FreeMarker(VirtualStackAllocator::Marker marker)
+{
+	if (this->m_mode == ThreadingMode::PerThread && tThreadSlot.Index < kMaxThreadArenas)
+	{
+		// Pages acquired after the marker was taken are not returned until the next Reset.
+		ThreadArena& arena = this->m_threadArenas[tThreadSlot.Index];
+		arena.Cursor = marker.ByteOffset;
+		arena.End = marker.PageIndex * this->m_pageSize;
+		return;
+	}
+
+	std::scoped_lock _(this->m_mutex);
+	this->m_currentPage = marker.PageIndex;
+	this->m_ptrOffset = marker.ByteOffset;
+}
+
+void* VirtualStackAllocator::AllocateLocked(size_t size, size_t alignment)
 {
 	std::scoped_lock _(this->m_mutex);
 
 	size_t alignedSize = AlignUp(size, alignment);
-	// If too big of an allocation then just allocate directly in the virtual allocator.
 	if (alignedSize > m_pageSize)
 	{
-		// TODO: Warn
-		return Commit(alignedSize);
+		return this->AllocateLargeBlockLocked(alignedSize);
 	}
 
-	// if there isn't enough space on the current page, request a new one
+	// if there isn't enough space on the current page, move to the next one, requesting a new page if needed
 	if (this->m_pages.empty() || this->m_ptrOffset + alignedSize > this->m_pageSize)
 	{
-		// request a new page
-		this->m_currentPage = this->m_pages.size();
+		if (!this->m_pages.empty() && this->m_currentPage + 1 < this->m_pages.size())
+		{
+			this->m_currentPage++;
+		}
+		else
+		{
+			uint8_t* page = Commit(this->m_pageSize);
+			if (!page)
+			{
+				return nullptr;
+			}
+
+			this->m_currentPage = this->m_pages.size();
+			this->m_pages.push_back(page);
+			this->m_numCommittedPages = this->m_pages.size();
+		}
+
 		this->m_ptrOffset = 0;
-		this->m_pages.push_back(Commit(this->m_pageSize));
 	}
 
+	// Owned pages are committed in order, so anything past m_numCommittedPages was decommitted while idle.
+	if (this->m_currentPage >= this->m_numCommittedPages)
+	{
+		if (!VirtualMemCommit(this->m_pages[this->m_currentPage], this->m_pageSize))
+		{
+			return nullptr;
+		}
+		this->m_numCommittedPages = this->m_currentPage + 1;
+	}
+
+	this->m_framePages = std::max(this->m_framePages, this->m_currentPage + 1);
+
 	void* ptr = this->m_pages[this->m_currentPage] + this->m_ptrOffset;
 	this->m_ptrOffset += alignedSize;
 
 	return ptr;
 }
 
-void VirtualStackAllocator::Reset()
+void* VirtualStackAllocator::AllocateLargeBlockLocked(size_t size)
+{
+	// Best fit from the blocks not used since the last reset, blocks are only released by Reset,
+	// FreeMarker leaves them in use.
+	LargeBlock* found = nullptr;
+	for (LargeBlock& block : this->m_largeBlocks)
+	{
+		if (!block.InUse && block.Size >= size && (!found || block.Size < found->Size))
+		{
+			found = &block;
+		}
+	}
+
+	if (!found)
+	{
+		// Rounded to whole pages so blocks can be reused by allocations of a similar size.
+		const size_t blockSize = AlignUp(size, this->m_pageSize);
+		uint8_t* ptr = Commit(blockSize);
+		if (!ptr)
+		{
+			return nullptr;
+		}
+
+		found = &this->m_largeBlocks.emplace_back();
+		found->Ptr = ptr;
+		found->Size = blockSize;
+		found->Committed = true;
+	}
+
+	if (!found->Committed)
+	{
+		if (!VirtualMemCommit(found->Ptr, found->Size))
+		{
+			return nullptr;
+		}
+		found->Committed = true;
+	}
+
+	found->InUse = true;
+	found->UsedInWindow = true;
+	return found->Ptr;
+}
+
+void* VirtualStackAllocator::AllocateThreadArena(size_t size, size_t alignment)
+{
+	ThreadArena& arena = this->m_threadArenas[tThreadSlot.Index];
+
+	const uint64_t generation = this->m_generation.load(std::memory_order_acquire);
+	if (arena.Generation != generation)
+	{
+		arena.Cursor = 0;
+		arena.End = 0;
+		arena.Generation = generation;
+	}
+
+	size_t offset = AlignUp(arena.Cursor, alignment);
+	if (arena.End == 0 || offset + size > arena.End)
+	{
+		// Allocations larger then a page take a contiguous run of pages.
+		const size_t numPages = std::max<size_t>(1, AlignUp(size, this->m_pageSize) / this->m_pageSize);
+		const size_t firstPage = this->AcquireArenaPages(numPages);
+		if (firstPage == kInvalidPage)
+		{
+			return nullptr;
+		}
+
+		offset = firstPage * this->m_pageSize;
+		arena.End = (firstPage + numPages) * this->m_pageSize;
+	}
+
+	arena.Cursor = offset + size;
+	return this->m_arenaBase + offset;
+}
+
+size_t VirtualStackAllocator::AcquireArenaPages(size_t numPages)
+{
+	// Reserved once, a failed reservation isn't retried until Release.
+	if (!this->m_arenaReserved.load(std::memory_order_acquire))
+	{
+		std::scoped_lock _(this->m_mutex);
+		if (!this->m_arenaReserved.load(std::memory_order_relaxed))
+		{
+			this->m_arenaBase = Reserve(this->m_maxArenaPages * this->m_pageSize);
+			this->m_arenaReserved.store(true, std::memory_order_release);
+		}
+	}
+
+	if (!this->m_arenaBase)
+	{
+		return kInvalidPage;
+	}
+
+	const size_t firstPage = this->m_nextArenaPage.fetch_add(numPages, std::memory_order_relaxed);
+	const size_t lastPage = firstPage + numPages;
+	if (lastPage > this->m_maxArenaPages)
+	{
+		PHX_CORE_ERROR("Thread arena allocator ran out of pages");
+		return kInvalidPage;
+	}
+
+	// Pages are reused between frames, so committing only happens while the high water mark grows.
+	if (lastPage > this->m_committedArenaPages.load(std::memory_order_acquire))
+	{
+		std::scoped_lock _(this->m_mutex);
+		const size_t committedPages = this->m_committedArenaPages.load(std::memory_order_relaxed);
+		if (lastPage > committedPages)
+		{
+			if (!VirtualMemCommit(this->m_arenaBase + committedPages * this->m_pageSize, (lastPage - committedPages) * this->m_pageSize))
+			{
+				return kInvalidPage;
+			}
+			this->m_committedArenaPages.store(lastPage, std::memory_order_release);
+		}
+	}
+
+	return firstPage;
+}
+
+void VirtualStackAllocator::DecommitIdlePages(size_t usedPages, size_t usedArenaPages)
+{
+	if (this->m_decommitIdleFrames == 0)
+	{
+		return;
+	}
+
+	// Track the high water mark over a window of frames, anything committed above it at the end
+	// of the window has been idle for the whole window and is given back to the OS.
+	this->m_peakPages = std::max(this->m_peakPages, usedPages);
+	this->m_peakArenaPages = std::max(this->m_peakArenaPages, usedArenaPages);
+	if (++this->m_idleFrames < this->m_decommitIdleFrames)
+	{
+		return;
+	}
+
+	for (size_t i = this->m_peakPages; i < this->m_numCommittedPages; i++)
+	{
+		VirtualMemDecommit(this->m_pages[i], this->m_pageSize);
+	}
+	this->m_numCommittedPages = std::min(this->m_numCommittedPages, this->m_peakPages);
+
+	for (LargeBlock& block : this->m_largeBlocks)
+	{
+		if (block.Committed && !block.UsedInWindow)
+		{
+			VirtualMemDecommit(block.Ptr, block.Size);
+			block.Committed = false;
+		}
+		block.UsedInWindow = false;
+	}
+
+	const size_t committedArenaPages = this->m_committedArenaPages.load(std::memory_order_relaxed);
+	if (committedArenaPages > this->m_peakArenaPages)
+	{
+		VirtualMemDecommit(
+			this->m_arenaBase + this->m_peakArenaPages * this->m_pageSize,
+			(committedArenaPages - this->m_peakArenaPages) * this->m_pageSize);
+		this->m_committedArenaPages.store(this->m_peakArenaPages, std::memory_order_release);
+	}
+
+	this->m_idleFrames = 0;
+	this->m_peakPages = 0;
+	this->m_peakArenaPages = 0;
+}
+
+namespace
+{
+	// Maps a size to its first and second level free list indices.
+	void TlsfMappingInsert(size_t size, uint32_t kSLIndexCountLog2, size_t kSmallBlockSize, uint32_t kFLIndexShift, uint32_t& fl, uint32_t& sl)
+	{
+		if (size < kSmallBlockSize)
+		{
+			fl = 0;
+			sl = static_cast<uint32_t>(size / (kSmallBlockSize >> kSLIndexCountLog2));
+		}
+		else
+		{
+			const uint32_t topBit = static_cast<uint32_t>(std::bit_width(size)) - 1;
+			sl = static_cast<uint32_t>(size >> (topBit - kSLIndexCountLog2)) ^ (1u << kSLIndexCountLog2);
+			fl = topBit - (kFLIndexShift - 1);
+		}
+	}
+}
+
+bool TlsfAllocator::Initialize(void* reservedMemory, size_t reserveSize, size_t commitGranularity)
 {
 	std::scoped_lock _(this->m_mutex);
-	this->m_currentPage = 0;
-	this->m_ptrOffset = 0;
+	assert(!this->m_base);
+	assert((reinterpret_cast<uintptr_t>(reservedMemory) & (kAlignment - 1)) == 0);
+
+	this->m_base = static_cast<uint8_t*>(reservedMemory);
+	this->m_reserveSize = reserveSize;
+	this->m_commitGranularity = commitGranularity;
+	this->m_committedSize = 0;
+	this->m_flBitmap = 0;
+	this->m_slBitmap = {};
+	this->m_freeLists = {};
+	this->m_usedBytes = 0;
+	this->m_peakUsedBytes = 0;
+	this->m_numAllocations = 0;
+
+	if (!VirtualMemCommit(this->m_base, this->m_commitGranularity))
+	{
+		this->m_base = nullptr;
+		return false;
+	}
+	this->m_committedSize = this->m_commitGranularity;
+
+	// One free block spanning the first commit, followed by the sentinel.
+	BlockHeader* block = reinterpret_cast<BlockHeader*>(this->m_base);
+	block->PrevPhysical = nullptr;
+	block->Size = this->m_committedSize - 2 * kBlockHeaderSize;
+
+	this->m_sentinel = reinterpret_cast<BlockHeader*>(this->m_base + this->m_committedSize - kBlockHeaderSize);
+	this->m_sentinel->PrevPhysical = block;
+	this->m_sentinel->Size = 0;
+
+	this->InsertFreeBlock(block);
+	return true;
 }
 
-VirtualStackAllocator::Marker VirtualStackAllocator::GetMarker()
+void TlsfAllocator::Finalize()
 {
 	std::scoped_lock _(this->m_mutex);
-	return { .PageIndex = this->m_currentPage, .ByteOffset = this->m_ptrOffset };
+	if (this->m_base && this->m_committedSize > 0)
+	{
+		VirtualMemDecommit(this->m_base, this->m_committedSize);
+	}
+
+	this->m_base = nullptr;
+	this->m_reserveSize = 0;
+	this->m_committedSize = 0;
+	this->m_sentinel = nullptr;
 }
 
-void VirtualStackAllocator::FreeMarker(VirtualStackAllocator::Marker marker)
+void* TlsfAllocator::Allocate(size_t size, size_t alignment)
 {
 	std::scoped_lock _(this->m_mutex);
-	this->m_currentPage = marker.PageIndex;
-	this->m_ptrOffset = marker.ByteOffset;
+	if (!this->m_base)
+	{
+		return nullptr;
+	}
+
+	void* ptr = this->AllocateLocked(size, alignment);
+	if (!ptr && this->Grow(size + alignment + kBlockHeaderSize + kMinBlockSize))
+	{
+		ptr = this->AllocateLocked(size, alignment);
+	}
+
+	return ptr;
+}
+
+void TlsfAllocator::Free(void* ptr)
+{
+	if (!ptr)
+	{
+		return;
+	}
+
+	std::scoped_lock _(this->m_mutex);
+	assert(this->Owns(ptr));
+
+	BlockHeader* block = reinterpret_cast<BlockHeader*>(static_cast<uint8_t*>(ptr) - kBlockHeaderSize);
+	assert((block->Size & kFreeBit) == 0);
+
+	this->m_usedBytes -= block->Size;
+	this->m_numAllocations--;
+
+	block->Size |= kFreeBit;
+	block = this->MergeFreeNeighbours(block);
+	this->InsertFreeBlock(block);
+}
+
+TlsfAllocator::Stats TlsfAllocator::GetStats()
+{
+	std::scoped_lock _(this->m_mutex);
+
+	Stats stats = {};
+	stats.CommittedBytes = this->m_committedSize;
+	stats.UsedBytes = this->m_usedBytes;
+	stats.PeakUsedBytes = this->m_peakUsedBytes;
+	stats.NumAllocations = this->m_numAllocations;
+
+	for (auto& flList : this->m_freeLists)
+	{
+		for (BlockHeader* block : flList)
+		{
+			for (; block; block = block->NextFree)
+			{
+				const size_t blockSize = block->Size & ~kFreeBit;
+				stats.FreeBytes += blockSize;
+				stats.LargestFreeBlock = std::max(stats.LargestFreeBlock, blockSize);
+			}
+		}
+	}
+
+	return stats;
+}
+
+void* TlsfAllocator::AllocateLocked(size_t size, size_t alignment)
+{
+	alignment = std::max(alignment, kAlignment);
+	size_t alignedSize = std::max(AlignUp(size, kAlignment), kMinBlockSize);
+
+	// Over allocate when the alignment is larger then what blocks naturally have, so a leading
+	// free block can be split off.
+	const size_t searchSize = alignment > kAlignment
+		? alignedSize + alignment + kBlockHeaderSize + kMinBlockSize
+		: alignedSize;
+
+	BlockHeader* block = this->FindFreeBlock(searchSize);
+	if (!block)
+	{
+		return nullptr;
+	}
+
+	this->RemoveFreeBlock(block);
+
+	if (alignment > kAlignment)
+	{
+		uint8_t* payload = reinterpret_cast<uint8_t*>(block) + kBlockHeaderSize;
+		uint8_t* alignedPayload = AlignUp(payload, alignment);
+		size_t gap = alignedPayload - payload;
+		if (gap > 0 && gap < kBlockHeaderSize + kMinBlockSize)
+		{
+			alignedPayload = AlignUp(payload + kBlockHeaderSize + kMinBlockSize, alignment);
+			gap = alignedPayload - payload;
+		}
+
+		if (gap > 0)
+		{
+			// Leading space becomes its own free block.
+			BlockHeader* alignedBlock = this->SplitBlock(block, gap - kBlockHeaderSize);
+			this->InsertFreeBlock(block);
+			block = alignedBlock;
+		}
+	}
+
+	BlockHeader* remainder = this->SplitBlock(block, alignedSize);
+	if (remainder)
+	{
+		this->InsertFreeBlock(remainder);
+	}
+
+	block->Size &= ~kFreeBit;
+	this->m_usedBytes += block->Size;
+	this->m_peakUsedBytes = std::max(this->m_peakUsedBytes, this->m_usedBytes);
+	this->m_numAllocations++;
+
+	return reinterpret_cast<uint8_t*>(block) + kBlockHeaderSize;
+}
+
+bool TlsfAllocator::Grow(size_t minSize)
+{
+	// FindFreeBlock rounds requests up to the next list, so the new block has to cover that as well.
+	if (minSize >= kSmallBlockSize)
+	{
+		const uint32_t topBit = static_cast<uint32_t>(std::bit_width(minSize)) - 1;
+		minSize += size_t(1) << (topBit - kSLIndexCountLog2);
+	}
+
+	const size_t growSize = AlignUp(minSize + kBlockHeaderSize, this->m_commitGranularity);
+	if (this->m_committedSize + growSize > this->m_reserveSize)
+	{
+		PHX_CORE_ERROR("TLSF heap ran out of reserved memory");
+		return false;
+	}
+
+	if (!VirtualMemCommit(this->m_base + this->m_committedSize, growSize))
+	{
+		return false;
+	}
+	this->m_committedSize += growSize;
+
+	// The old sentinel becomes the header of the new free block.
+	BlockHeader* block = this->m_sentinel;
+	block->Size = (growSize - kBlockHeaderSize) | kFreeBit;
+
+	this->m_sentinel = reinterpret_cast<BlockHeader*>(this->m_base + this->m_committedSize - kBlockHeaderSize);
+	this->m_sentinel->PrevPhysical = block;
+	this->m_sentinel->Size = 0;
+
+	block = this->MergeFreeNeighbours(block);
+	this->InsertFreeBlock(block);
+
+	return true;
+}
+
+void TlsfAllocator::InsertFreeBlock(BlockHeader* block)
+{
+	block->Size |= kFreeBit;
+
+	uint32_t fl, sl;
+	TlsfMappingInsert(block->Size & ~kFreeBit, kSLIndexCountLog2, kSmallBlockSize, kFLIndexShift, fl, sl);
+
+	BlockHeader*& head = this->m_freeLists[fl][sl];
+	block->NextFree = head;
+	block->PrevFree = nullptr;
+	if (head)
+	{
+		head->PrevFree = block;
+	}
+	head = block;
+
+	this->m_flBitmap |= 1u << fl;
+	this->m_slBitmap[fl] |= 1u << sl;
+}
+
+void TlsfAllocator::RemoveFreeBlock(BlockHeader* block)
+{
+	uint32_t fl, sl;
+	TlsfMappingInsert(block->Size & ~kFreeBit, kSLIndexCountLog2, kSmallBlockSize, kFLIndexShift, fl, sl);
+
+	if (block->PrevFree)
+	{
+		block->PrevFree->NextFree = block->NextFree;
+	}
+	if (block->NextFree)
+	{
+		block->NextFree->PrevFree = block->PrevFree;
+	}
+
+	BlockHeader*& head = this->m_freeLists[fl][sl];
+	if (head == block)
+	{
+		head = block->NextFree;
+		if (!head)
+		{
+			this->m_slBitmap[fl] &= ~(1u << sl);
+			if (this->m_slBitmap[fl] == 0)
+			{
+				this->m_flBitmap &= ~(1u << fl);
+			}
+		}
+	}
+
+	block->NextFree = nullptr;
+	block->PrevFree = nullptr;
+}
+
+TlsfAllocator::BlockHeader* TlsfAllocator::FindFreeBlock(size_t size)
+{
+	// Round up to the next list so any block found is large enough.
+	if (size >= kSmallBlockSize)
+	{
+		const uint32_t topBit = static_cast<uint32_t>(std::bit_width(size)) - 1;
+		size += (size_t(1) << (topBit - kSLIndexCountLog2)) - 1;
+	}
+
+	uint32_t fl, sl;
+	TlsfMappingInsert(size, kSLIndexCountLog2, kSmallBlockSize, kFLIndexShift, fl, sl);
+	if (fl >= kFLIndexCount)
+	{
+		return nullptr;
+	}
+
+	uint32_t slMap = this->m_slBitmap[fl] & (~0u << sl);
+	if (!slMap)
+	{
+		const uint32_t flMap = fl + 1 < 32 ? this->m_flBitmap & (~0u << (fl + 1)) : 0;
+		if (!flMap)
+		{
+			return nullptr;
+		}
+
+		fl = static_cast<uint32_t>(std::countr_zero(flMap));
+		slMap = this->m_slBitmap[fl];
+	}
+
+	sl = static_cast<uint32_t>(std::countr_zero(slMap));
+	return this->m_freeLists[fl][sl];
+}
+
+TlsfAllocator::BlockHeader* TlsfAllocator::SplitBlock(BlockHeader* block, size_t size)
+{
+	const size_t blockSize = block->Size & ~kFreeBit;
+	if (blockSize < size + kBlockHeaderSize + kMinBlockSize)
+	{
+		return nullptr;
+	}
+
+	BlockHeader* next = reinterpret_cast<BlockHeader*>(reinterpret_cast<uint8_t*>(block) + kBlockHeaderSize + blockSize);
+
+	BlockHeader* remainder = reinterpret_cast<BlockHeader*>(reinterpret_cast<uint8_t*>(block) + kBlockHeaderSize + size);
+	remainder->PrevPhysical = block;
+	remainder->Size = (blockSize - size - kBlockHeaderSize) | kFreeBit;
+	next->PrevPhysical = remainder;
+
+	block->Size = size | (block->Size & kFreeBit);
+
+	return remainder;
+}
+
+TlsfAllocator::BlockHeader* TlsfAllocator::MergeFreeNeighbours(BlockHeader* block)
+{
+	BlockHeader* prev = block->PrevPhysical;
+	if (prev && (prev->Size & kFreeBit))
+	{
+		this->RemoveFreeBlock(prev);
+		prev->Size += kBlockHeaderSize + (block->Size & ~kFreeBit);
+		block = prev;
+	}
+
+	BlockHeader* next = reinterpret_cast<BlockHeader*>(reinterpret_cast<uint8_t*>(block) + kBlockHeaderSize + (block->Size & ~kFreeBit));
+	if (next->Size & kFreeBit)
+	{
+		this->RemoveFreeBlock(next);
+		block->Size += kBlockHeaderSize + (next->Size & ~kFreeBit);
+		next = reinterpret_cast<BlockHeader*>(reinterpret_cast<uint8_t*>(block) + kBlockHeaderSize + (block->Size & ~kFreeBit));
+	}
+
+	next->PrevPhysical = block;
+	return block;
+}
+
+namespace
+{
+	// Decommit only touches pages entirely inside the range.
+	void PageRangeInward(void*& ptr, size_t& size)
+	{
+		const uintptr_t pageMask = VirtualMemPageSize() - 1;
+		const uintptr_t start = (reinterpret_cast<uintptr_t>(ptr) + pageMask) & ~pageMask;
+		const uintptr_t end = (reinterpret_cast<uintptr_t>(ptr) + size) & ~pageMask;
+		ptr = reinterpret_cast<void*>(start);
+		size = end > start ? end - start : 0;
+	}
 }
 
 #if defined(PHX_PLATFORM_WINDOWS)
-void* phx::VirtualMemReserve(size_t reserveSize)
+size_t phx::VirtualMemPageSize()
 {
+	static const size_t pageSize = []()
+		{
+			SYSTEM_INFO info = {};
+			GetSystemInfo(&info);
+			return static_cast<size_t>(info.dwPageSize);
+		}();
+	return pageSize;
+}
+
+void* phx::VirtualMemReserve(size_t reserveSize, bool useHugePages)
+{
+	// Large pages on windows require SeLockMemoryPrivilege and must be committed up front, so the hint is ignored.
+	(void)useHugePages;
 	return VirtualAlloc(NULL, reserveSize, MEM_RESERVE, PAGE_READWRITE);
 }
 
-void phx::VirtualMemCommit(void* ptr, size_t commitSize)
+bool phx::VirtualMemCommit(void* ptr, size_t commitSize)
 {
-	VirtualAlloc(ptr, commitSize, MEM_COMMIT, PAGE_READWRITE);
+	if (!VirtualAlloc(ptr, commitSize, MEM_COMMIT, PAGE_READWRITE))
+	{
+		PHX_CORE_ERROR("Failed to commit virtual memory");
+		return false;
+	}
+
+	return true;
+}
+
+bool phx::VirtualMemDecommit(void* ptr, size_t decommitSize)
+{
+	// VirtualFree decommits every page the range touches, so round inward first.
+	PageRangeInward(ptr, decommitSize);
+	return decommitSize == 0 || VirtualFree(ptr, decommitSize, MEM_DECOMMIT);
 }
 
-bool phx::VirtualMemFree(void* ptr)
+bool phx::VirtualMemFree(void* ptr, size_t reserveSize)
 {
+	(void)reserveSize;
 	return VirtualFree(ptr, 0, MEM_RELEASE);
 }
 
+#else
+namespace
+{
+	// Commit covers every page the range touches.
+	void PageRangeOutward(void*& ptr, size_t& size)
+	{
+		const uintptr_t pageMask = VirtualMemPageSize() - 1;
+		const uintptr_t start = reinterpret_cast<uintptr_t>(ptr) & ~pageMask;
+		const uintptr_t end = (reinterpret_cast<uintptr_t>(ptr) + size + pageMask) & ~pageMask;
+		ptr = reinterpret_cast<void*>(start);
+		size = end - start;
+	}
+}
+
+size_t phx::VirtualMemPageSize()
+{
+	static const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+	return pageSize;
+}
+
+void* phx::VirtualMemReserve(size_t reserveSize, bool useHugePages)
+{
+	// Over reserve so the usable range can be aligned to a huge page boundary.
+	constexpr size_t kHugePageSize = 2_MiB;
+	const size_t mapSize = useHugePages ? reserveSize + kHugePageSize : reserveSize;
+
+	void* mapping = mmap(nullptr, mapSize, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	if (mapping == MAP_FAILED)
+	{
+		PHX_CORE_ERROR("Failed to reserve virtual memory");
+		return nullptr;
+	}
+
+	if (!useHugePages)
+	{
+		return mapping;
+	}
+
+	uint8_t* mappingStart = static_cast<uint8_t*>(mapping);
+	uint8_t* alignedStart = AlignUp(mappingStart, kHugePageSize);
+	const size_t headSize = alignedStart - mappingStart;
+	const size_t tailSize = mapSize - headSize - reserveSize;
+	if (headSize > 0)
+	{
+		munmap(mappingStart, headSize);
+	}
+	if (tailSize > 0)
+	{
+		munmap(alignedStart + reserveSize, tailSize);
+	}
+
+#if defined(MADV_HUGEPAGE)
+	madvise(alignedStart, reserveSize, MADV_HUGEPAGE);
+#endif
+
+	return alignedStart;
+}
+
+bool phx::VirtualMemCommit(void* ptr, size_t commitSize)
+{
+	// mprotect needs a page aligned start.
+	PageRangeOutward(ptr, commitSize);
+	if (mprotect(ptr, commitSize, PROT_READ | PROT_WRITE) != 0)
+	{
+		PHX_CORE_ERROR("Failed to commit virtual memory");
+		return false;
+	}
+
+	return true;
+}
+
+bool phx::VirtualMemDecommit(void* ptr, size_t decommitSize)
+{
+	PageRangeInward(ptr, decommitSize);
+	if (decommitSize == 0)
+	{
+		return true;
+	}
+
+	// Drop the physical pages first so RSS actually shrinks, then fault on any stale access.
+	return
+		madvise(ptr, decommitSize, MADV_DONTNEED) == 0 &&
+		mprotect(ptr, decommitSize, PROT_NONE) == 0;
+}
+
+bool phx::VirtualMemFree(void* ptr, size_t reserveSize)
+{
+	return munmap(ptr, reserveSize) == 0;
+}
+
 #endif
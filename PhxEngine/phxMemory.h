@@ -1,6 +1,10 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <cstdint>
+#include <memory>
 #include <mutex>
 #include <vector>
 constexpr inline unsigned long long operator "" _KiB(unsigned long long value)
@@ -19,9 +23,16 @@ constexpr inline unsigned long long operator "" _GiB(unsigned long long value)
 }
 namespace phx
 {
-	void* VirtualMemReserve(size_t reserveSize);
-	void VirtualMemCommit(void* ptr, size_t commitSize);
-	bool VirtualMemFree(void* ptr);
+	// Granularity of commit and decommit, the OS page size.
+	size_t VirtualMemPageSize();
+	// Huge pages are a hint, only honoured by the POSIX backend (transparent huge pages).
+	void* VirtualMemReserve(size_t reserveSize, bool useHugePages = false);
+	// Commits every page touched by the range, so sub page ranges are fine.
+	[[nodiscard]] bool VirtualMemCommit(void* ptr, size_t commitSize);
+	// Returns the physical pages to the OS, the address range stays reserved. Only pages entirely
+	// inside the range are decommitted, so neighbouring data sharing a page is left alone.
+	bool VirtualMemDecommit(void* ptr, size_t decommitSize);
+	bool VirtualMemFree(void* ptr, size_t reserveSize);
 
 
 	class VirtualStackAllocator
@@ -33,8 +44,20 @@ namespace phx
 			size_t ByteOffset;
 		};
 
+		enum class ThreadingMode
+		{
+			// Every allocation goes through a mutex protecting a single cursor.
+			Locked,
+			// Each thread bumps its own cursor inside pages that are handed out
+			// with a single atomic op. Reset must happen at a point where no other
+			// thread is allocating (i.e. Memory::BeginFrame()).
+			PerThread,
+		};
+
+		static constexpr size_t kMaxThreadArenas = 64;
+
 	public:
-		VirtualStackAllocator(size_t pageSize = 4_MiB);
+		VirtualStackAllocator(size_t pageSize = 4_MiB, ThreadingMode mode = ThreadingMode::Locked, size_t maxArenaPages = 512);
 
 		template<typename T, typename... TArgs>
 		[[nodiscard]] T* Alloc(TArgs&&... Args)
@@ -56,16 +79,219 @@ namespace phx
 		void* Allocate(size_t size, size_t alignment);
 
 		void Reset();
+		// Forgets every page and block without touching them, for when the memory they point into
+		// has been freed. Like Reset, no other thread may be allocating.
+		void Release();
 		Marker GetMarker();
 		void FreeMarker(Marker marker);
 
+		ThreadingMode GetThreadingMode() const { return this->m_mode; }
+
+		// Committed pages above the high water mark are decommitted once they have gone unused
+		// for this many consecutive resets. Zero disables decommitting.
+		void SetDecommitIdleFrames(uint32_t numFrames) { this->m_decommitIdleFrames = numFrames; }
+
 	private:
+		void* AllocateLocked(size_t size, size_t alignment);
+		void* AllocateLargeBlockLocked(size_t size);
+		void* AllocateThreadArena(size_t size, size_t alignment);
+		size_t AcquireArenaPages(size_t numPages);
+		void DecommitIdlePages(size_t usedPages, size_t usedArenaPages);
+
+	private:
+		static constexpr size_t kInvalidPage = ~0ull;
+
+		// Cursor is stored as byte offsets from m_arenaBase. An arena is only ever
+		// touched by the thread that owns its slot, the generation lets Reset()
+		// invalidate every arena without touching them.
+		struct alignas(64) ThreadArena
+		{
+			size_t Cursor = 0;
+			size_t End = 0;
+			uint64_t Generation = 0;
+		};
+
 		const size_t m_pageSize;
+		const ThreadingMode m_mode;
+
+		// -- Locked Mode ---
 		std::vector<uint8_t*> m_pages;
 		size_t m_currentPage;
 		size_t m_ptrOffset;
+		size_t m_numCommittedPages = 0;
+		size_t m_framePages = 0;
+
+		// Allocations larger then a page get a block of their own. Blocks are kept across resets
+		// and handed to later large allocations, so they don't keep taking new address space.
+		struct LargeBlock
+		{
+			uint8_t* Ptr = nullptr;
+			size_t Size = 0;
+			bool InUse = false;
+			bool Committed = false;
+			bool UsedInWindow = false;
+		};
+		std::vector<LargeBlock> m_largeBlocks;
 
 		std::mutex m_mutex;
+
+		// -- Decommit Policy ---
+		uint32_t m_decommitIdleFrames = 0;
+		uint32_t m_idleFrames = 0;
+		size_t m_peakPages = 0;
+		size_t m_peakArenaPages = 0;
+
+		// -- Per Thread Mode ---
+		const size_t m_maxArenaPages;
+		uint8_t* m_arenaBase = nullptr;
+		std::atomic<bool> m_arenaReserved = false;
+		std::atomic<size_t> m_nextArenaPage = 0;
+		std::atomic<size_t> m_committedArenaPages = 0;
+		std::atomic<uint64_t> m_generation = 1;
+		std::array<ThreadArena, kMaxThreadArenas> m_threadArenas;
+	};
+
+	// Multi-buffered frame allocator, one region per frame in flight. A region is only
+	// reset once the frame that last allocated from it has been retired, so data allocated
+	// in a frame stays valid until the GPU (or any other consumer) is done with that frame.
+	// Frames are plain counters, a frame is retired once completedFrame > frame.
+	class FrameRingAllocator
+	{
+	public:
+		static constexpr uint32_t kMaxFramesInFlight = 4;
+
+	public:
+		void Initialize(uint32_t numFramesInFlight, size_t pageSize = 4_MiB, size_t maxRegionPages = 128);
+		void Finalize();
+
+		// Switches to the region for frameIndex. Returns false, leaving the current region active,
+		// if the frame that last used that region has not yet been retired.
+		[[nodiscard]] bool BeginFrame(uint64_t frameIndex, uint64_t completedFrame);
+
+		template<typename T, typename... TArgs>
+		[[nodiscard]] T* Alloc(TArgs&&... Args)
+		{
+			return this->GetCurrentRegion().Alloc<T>(std::forward<TArgs>(Args)...);
+		}
+
+		template<typename T>
+		[[nodiscard]] T* AllocArray(size_t count)
+		{
+			return this->GetCurrentRegion().AllocArray<T>(count);
+		}
+
+		void* Allocate(size_t size, size_t alignment)
+		{
+			return this->GetCurrentRegion().Allocate(size, alignment);
+		}
+
+		bool IsRegionRetired(uint32_t regionIndex, uint64_t completedFrame) const;
+		uint32_t GetNumFramesInFlight() const { return this->m_numFramesInFlight; }
+		uint64_t GetCurrentFrame() const { return this->m_regionFrames[this->m_currentRegion]; }
+
+	private:
+		VirtualStackAllocator& GetCurrentRegion() { return *this->m_regions[this->m_currentRegion]; }
+
+	private:
+		static constexpr uint64_t kUnusedRegion = ~0ull;
+
+		uint32_t m_numFramesInFlight = 0;
+		uint32_t m_currentRegion = 0;
+		std::array<std::unique_ptr<VirtualStackAllocator>, kMaxFramesInFlight> m_regions;
+		std::array<uint64_t, kMaxFramesInFlight> m_regionFrames;
+	};
+
+	// Two-level segregated fit heap for mid-lifetime allocations (loaded assets, file blobs).
+	// Allocation and free are O(1) with bounded fragmentation. Memory is committed on demand
+	// inside a range that has been reserved, but not committed, by the caller.
+	class TlsfAllocator
+	{
+	public:
+		struct Stats
+		{
+			size_t CommittedBytes = 0;
+			size_t UsedBytes = 0;
+			size_t PeakUsedBytes = 0;
+			size_t FreeBytes = 0;
+			size_t LargestFreeBlock = 0;
+			size_t NumAllocations = 0;
+
+			// 0 when all free memory is one block, approaches 1 as it's split into small blocks.
+			float Fragmentation() const { return this->FreeBytes == 0 ? 0.0f : 1.0f - static_cast<float>(this->LargestFreeBlock) / static_cast<float>(this->FreeBytes); }
+		};
+
+	public:
+		TlsfAllocator() = default;
+		~TlsfAllocator() = default;
+
+		// Returns false, leaving the heap uninitialized, if the first commit fails.
+		bool Initialize(void* reservedMemory, size_t reserveSize, size_t commitGranularity = 64_MiB);
+		void Finalize();
+
+		[[nodiscard]] void* Allocate(size_t size, size_t alignment = kAlignment);
+		void Free(void* ptr);
+
+		template<typename T>
+		[[nodiscard]] T* AllocArray(size_t count)
+		{
+			return static_cast<T*>(this->Allocate(sizeof(T) * count, std::max(alignof(T), kAlignment)));
+		}
+
+		bool IsInitialized() const { return this->m_base != nullptr; }
+		bool Owns(const void* ptr) const { return ptr >= this->m_base && ptr < this->m_base + this->m_reserveSize; }
+		Stats GetStats();
+
+	public:
+		static constexpr size_t kAlignment = 16;
+
+	private:
+		static constexpr uint32_t kSLIndexCountLog2 = 5;
+		static constexpr uint32_t kSLIndexCount = 1u << kSLIndexCountLog2;
+		static constexpr uint32_t kFLIndexShift = kSLIndexCountLog2 + 4;
+		static constexpr uint32_t kFLIndexMax = 40;
+		static constexpr uint32_t kFLIndexCount = kFLIndexMax - kFLIndexShift + 1;
+		static constexpr size_t kSmallBlockSize = size_t(1) << kFLIndexShift;
+
+		struct BlockHeader
+		{
+			BlockHeader* PrevPhysical;
+			size_t Size;
+
+			// Only valid while the block is free, overlaps the payload.
+			BlockHeader* NextFree;
+			BlockHeader* PrevFree;
+		};
+
+		static constexpr size_t kBlockHeaderSize = sizeof(BlockHeader*) + sizeof(size_t);
+		static constexpr size_t kMinBlockSize = sizeof(BlockHeader) - kBlockHeaderSize;
+		static constexpr size_t kFreeBit = 1;
+
+		void* AllocateLocked(size_t size, size_t alignment);
+		bool Grow(size_t minSize);
+
+		void InsertFreeBlock(BlockHeader* block);
+		void RemoveFreeBlock(BlockHeader* block);
+		BlockHeader* FindFreeBlock(size_t size);
+		BlockHeader* SplitBlock(BlockHeader* block, size_t size);
+		BlockHeader* MergeFreeNeighbours(BlockHeader* block);
+
+	private:
+		std::mutex m_mutex;
+		uint8_t* m_base = nullptr;
+		size_t m_reserveSize = 0;
+		size_t m_commitGranularity = 0;
+		size_t m_committedSize = 0;
+
+		// Zero sized, allocated block at the end of committed memory, stops merging.
+		BlockHeader* m_sentinel = nullptr;
+
+		uint32_t m_flBitmap = 0;
+		std::array<uint32_t, kFLIndexCount> m_slBitmap = {};
+		std::array<std::array<BlockHeader*, kSLIndexCount>, kFLIndexCount> m_freeLists = {};
+
+		size_t m_usedBytes = 0;
+		size_t m_peakUsedBytes = 0;
+		size_t m_numAllocations = 0;
 	};
 
 	namespace Memory
@@ -74,6 +300,11 @@ namespace phx
 		{
 			size_t VirtualMemorySize = 16_GiB;
 			size_t StackPageSize = 4_MiB;
+			bool UseHugePages = false;
+			uint32_t DecommitIdleFrames = 120;
+			uint32_t NumFramesInFlight = 2;
+			size_t HeapReserveSize = 4_GiB;
+			size_t HeapCommitGranularity = 64_MiB;
 		};
 
 		void Initialize(MemoryConfiguration const& config);
@@ -83,6 +314,19 @@ namespace phx
 		VirtualStackAllocator& GetFrameAllocator();
 		VirtualStackAllocator& GetScratchAllocator();
 
+		// Data allocated here stays valid until the frame it was allocated in is retired.
+		FrameRingAllocator& GetFrameRingAllocator();
+
+		// General purpose heap for engine owned long lived allocations.
+		TlsfAllocator& GetHeap();
+		// The heap, or nullptr if Memory wasn't initialized or the heap failed to initialize. For
+		// callers that fall back to malloc, such as file blobs.
+		TlsfAllocator* GetHeapIfInitialized();
+
+		// Small dense index for the calling thread, assigned on first use. Used to pick per thread state.
+		// Indices are recycled when a thread exits, the next thread to start inherits its state.
+		uint32_t GetThreadIndex();
+
 	}
 
 	struct ScopedScratchMarker
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <deque>
+#include <memory_resource>
+#include <new>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "phxMemory.h"
+
+namespace phx
+{
+	// std::pmr adapter over a VirtualStackAllocator. Deallocation is a no-op, memory is
+	// reclaimed when the allocator is reset or a marker taken before the allocation is freed.
+	class StackMemoryResource final : public std::pmr::memory_resource
+	{
+	public:
+		explicit StackMemoryResource(VirtualStackAllocator& allocator)
+			: m_allocator(allocator)
+		{}
+
+		VirtualStackAllocator& GetAllocator() const { return this->m_allocator; }
+
+	private:
+		void* do_allocate(size_t bytes, size_t alignment) override
+		{
+			void* ptr = this->m_allocator.Allocate(bytes, alignment);
+			if (!ptr)
+			{
+				throw std::bad_alloc();
+			}
+
+			return ptr;
+		}
+
+		void do_deallocate(void*, size_t, size_t) override {}
+
+		bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+		{
+			const auto* otherStack = dynamic_cast<const StackMemoryResource*>(&other);
+			return otherStack && &otherStack->m_allocator == &this->m_allocator;
+		}
+
+	private:
+		VirtualStackAllocator& m_allocator;
+	};
+
+	// Scratch memory resource that takes a scratch marker on construction and frees it on
+	// destruction. Containers using it must not outlive it, and since scratch markers are per
+	// thread it should only be used from the thread that created it.
+	class ScopedScratchMemoryResource final : public std::pmr::memory_resource
+	{
+	public:
+		ScopedScratchMemoryResource()
+			: m_resource(Memory::GetScratchAllocator())
+		{}
+
+		ScopedScratchMemoryResource(ScopedScratchMemoryResource const&) = delete;
+		ScopedScratchMemoryResource& operator=(ScopedScratchMemoryResource const&) = delete;
+
+	private:
+		void* do_allocate(size_t bytes, size_t alignment) override
+		{
+			return this->m_resource.allocate(bytes, alignment);
+		}
+
+		void do_deallocate(void*, size_t, size_t) override {}
+
+		bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+		{
+			return this == &other;
+		}
+
+	private:
+		ScopedScratchMarker m_marker;
+		StackMemoryResource m_resource;
+	};
+
+	namespace Memory
+	{
+		std::pmr::memory_resource* GetFrameResource();
+		std::pmr::memory_resource* GetScratchResource();
+	}
+
+	namespace pmr
+	{
+		template<typename T>
+		using Vector = std::pmr::vector<T>;
+
+		template<typename T>
+		using Deque = std::pmr::deque<T>;
+
+		template<typename K, typename V, typename H = std::hash<K>, typename E = std::equal_to<K>>
+		using UnorderedMap = std::pmr::unordered_map<K, V, H, E>;
+
+		using String = std::pmr::string;
+		using WString = std::pmr::wstring;
+	}
+}
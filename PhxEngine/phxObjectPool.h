@@ -0,0 +1,230 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <assert.h>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+
+#include "phxMemory.h"
+
+namespace phx
+{
+	// Slab allocator for small fixed size objects. Slots live contiguously in a reserved range
+	// that is committed a page at a time. Each thread keeps a magazine of free slots, so the common
+	// allocate / free path touches no locks or atomics, the shared free list is only hit to refill
+	// or flush a magazine.
+	template<typename T, size_t MagazineSize = 64>
+	class ObjectPool
+	{
+	public:
+		static constexpr size_t kMaxThreadMagazines = 64;
+
+		explicit ObjectPool(size_t maxObjects = 1 << 20, size_t pageSize = 64_KiB)
+			: m_maxSlots(maxObjects)
+			, m_pageSize(pageSize)
+		{
+			this->m_base = static_cast<uint8_t*>(VirtualMemReserve(this->GetReserveSize()));
+			if (!this->m_base)
+			{
+				throw std::runtime_error("Failed to reserve object pool memory");
+			}
+		}
+
+		~ObjectPool()
+		{
+			// Objects still alive are leaked, their memory goes away with the reservation.
+			VirtualMemFree(this->m_base, this->GetReserveSize());
+			this->m_base = nullptr;
+		}
+
+		ObjectPool(ObjectPool const&) = delete;
+		ObjectPool& operator=(ObjectPool const&) = delete;
+
+		template<typename... TArgs>
+		[[nodiscard]] T* New(TArgs&&... args)
+		{
+			void* memory = this->Allocate();
+			if (!memory)
+			{
+				return nullptr;
+			}
+
+			return new (memory) T(std::forward<TArgs>(args)...);
+		}
+
+		void Delete(T* object)
+		{
+			if (object)
+			{
+				object->~T();
+				this->Free(object);
+			}
+		}
+
+		[[nodiscard]] void* Allocate()
+		{
+			const uint32_t threadIndex = Memory::GetThreadIndex();
+			if (threadIndex >= kMaxThreadMagazines)
+			{
+				std::scoped_lock _(this->m_mutex);
+				return this->PopSharedLocked();
+			}
+
+			Magazine& magazine = this->m_magazines[threadIndex];
+			if (magazine.Count == 0)
+			{
+				this->RefillMagazine(magazine);
+				if (magazine.Count == 0)
+				{
+					return nullptr;
+				}
+			}
+
+			return magazine.Slots[--magazine.Count];
+		}
+
+		void Free(void* ptr)
+		{
+			assert(this->Owns(ptr));
+			const uint32_t threadIndex = Memory::GetThreadIndex();
+			if (threadIndex >= kMaxThreadMagazines)
+			{
+				std::scoped_lock _(this->m_mutex);
+				this->PushSharedLocked(ptr);
+				return;
+			}
+
+			Magazine& magazine = this->m_magazines[threadIndex];
+			if (magazine.Count == MagazineSize)
+			{
+				this->FlushMagazine(magazine);
+			}
+
+			magazine.Slots[magazine.Count++] = ptr;
+		}
+
+		bool Owns(const void* ptr) const
+		{
+			return ptr >= this->m_base && ptr < this->m_base + this->m_maxSlots * kSlotSize;
+		}
+
+		// Returns the calling thread's cached slots to the shared list, call before a thread exits.
+		void FlushThreadCache()
+		{
+			const uint32_t threadIndex = Memory::GetThreadIndex();
+			if (threadIndex < kMaxThreadMagazines)
+			{
+				Magazine& magazine = this->m_magazines[threadIndex];
+				std::scoped_lock _(this->m_mutex);
+				while (magazine.Count > 0)
+				{
+					this->PushSharedLocked(magazine.Slots[--magazine.Count]);
+				}
+			}
+		}
+
+		size_t GetNumSlotsCommitted() const { return this->m_committedSlots; }
+
+	private:
+		struct FreeSlot
+		{
+			FreeSlot* Next;
+		};
+
+		struct alignas(64) Magazine
+		{
+			size_t Count = 0;
+			std::array<void*, MagazineSize> Slots;
+		};
+
+		static constexpr size_t kSlotAlignment = std::max(alignof(T), alignof(FreeSlot));
+		static constexpr size_t kSlotSize = (std::max(sizeof(T), sizeof(FreeSlot)) + kSlotAlignment - 1) & ~(kSlotAlignment - 1);
+
+		// Kept local so the header doesn't depend on the engine pch.
+		static size_t AlignUp(size_t size, size_t alignment)
+		{
+			return (size + alignment - 1) & ~(alignment - 1);
+		}
+
+		size_t GetReserveSize() const
+		{
+			return AlignUp(this->m_maxSlots * kSlotSize, this->m_pageSize);
+		}
+
+		void RefillMagazine(Magazine& magazine)
+		{
+			std::scoped_lock _(this->m_mutex);
+			while (magazine.Count < MagazineSize / 2)
+			{
+				void* slot = this->PopSharedLocked();
+				if (!slot)
+				{
+					break;
+				}
+
+				magazine.Slots[magazine.Count++] = slot;
+			}
+		}
+
+		void FlushMagazine(Magazine& magazine)
+		{
+			std::scoped_lock _(this->m_mutex);
+			while (magazine.Count > MagazineSize / 2)
+			{
+				this->PushSharedLocked(magazine.Slots[--magazine.Count]);
+			}
+		}
+
+		void* PopSharedLocked()
+		{
+			if (this->m_freeList)
+			{
+				FreeSlot* slot = this->m_freeList;
+				this->m_freeList = slot->Next;
+				return slot;
+			}
+
+			// Bump into untouched slots, committing another page when needed.
+			if (this->m_nextSlot == this->m_maxSlots)
+			{
+				return nullptr;
+			}
+
+			if (this->m_nextSlot == this->m_committedSlots)
+			{
+				const size_t committedBytes = this->m_committedSlots * kSlotSize;
+				const size_t commitStart = AlignUp(committedBytes, this->m_pageSize);
+				const size_t commitEnd = std::min(AlignUp(committedBytes + kSlotSize, this->m_pageSize), this->GetReserveSize());
+				if (commitEnd > commitStart && !VirtualMemCommit(this->m_base + commitStart, commitEnd - commitStart))
+				{
+					return nullptr;
+				}
+
+				this->m_committedSlots = std::min(commitEnd / kSlotSize, this->m_maxSlots);
+			}
+
+			return this->m_base + kSlotSize * this->m_nextSlot++;
+		}
+
+		void PushSharedLocked(void* ptr)
+		{
+			FreeSlot* slot = static_cast<FreeSlot*>(ptr);
+			slot->Next = this->m_freeList;
+			this->m_freeList = slot;
+		}
+
+	private:
+		const size_t m_maxSlots;
+		const size_t m_pageSize;
+		uint8_t* m_base = nullptr;
+
+		std::mutex m_mutex;
+		FreeSlot* m_freeList = nullptr;
+		size_t m_nextSlot = 0;
+		size_t m_committedSlots = 0;
+
+		std::array<Magazine, kMaxThreadMagazines> m_magazines;
+	};
+}
@@ -0,0 +1,399 @@
+#include "pch.h"
+#include "phxPackageFile.h"
+#include "phxMemory.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+using namespace phx;
+using namespace phx::PackageFormat;
+
+namespace
+{
+	// View of an entry inside the mapped package, keeps the package mapping alive.
+	class PackageEntryBlob : public IBlob
+	{
+	public:
+		PackageEntryBlob(std::shared_ptr<IBlob> package, const void* data, size_t size)
+			: m_package(std::move(package))
+			, m_data(data)
+			, m_size(size)
+		{}
+
+		[[nodiscard]] const void* Data() const override { return this->m_data; }
+		[[nodiscard]] size_t Size() const override { return this->m_size; }
+
+	private:
+		std::shared_ptr<IBlob> m_package;
+		const void* m_data;
+		size_t m_size;
+	};
+
+	class PackageFileSystem final : public IFileSystem
+	{
+	public:
+		bool Open(std::unique_ptr<IBlob>&& package);
+
+		bool FileExists(std::filesystem::path const& name) override;
+		bool FolderExists(std::filesystem::path const& name) override;
+		std::unique_ptr<IBlob> ReadFile(std::filesystem::path const& name) override;
+		bool WriteFile(std::filesystem::path const& name, Span<char> Data) override;
+		std::unique_ptr<IBlob> MapFile(std::filesystem::path const& name, MapAdvice advice) override;
+		bool ReadFileRange(std::filesystem::path const& name, uint64_t offset, size_t size, void* destination) override;
+
+	private:
+		const PackageEntry* FindEntry(std::filesystem::path const& name) const;
+		std::string_view GetEntryName(PackageEntry const& entry) const;
+
+	private:
+		std::shared_ptr<IBlob> m_package;
+		const uint8_t* m_base = nullptr;
+		const PackageEntry* m_entries = nullptr;
+		uint32_t m_numEntries = 0;
+		const char* m_names = nullptr;
+	};
+
+	uint64_t AlignOffset(uint64_t offset, uint64_t alignment)
+	{
+		return (offset + alignment - 1) & ~(alignment - 1);
+	}
+}
+
+bool PackageFileSystem::Open(std::unique_ptr<IBlob>&& package)
+{
+	if (IBlob::IsEmpty(package.get()) || package->Size() < sizeof(PackageHeader))
+	{
+		return false;
+	}
+
+	const uint8_t* base = static_cast<const uint8_t*>(package->Data());
+	const size_t packageSize = package->Size();
+
+	PackageHeader header;
+	std::memcpy(&header, base, sizeof(PackageHeader));
+	if (header.Magic != kMagic || header.Version != kVersion)
+	{
+		PHX_CORE_ERROR("Invalid package header");
+		return false;
+	}
+
+	const uint64_t tocSize = static_cast<uint64_t>(header.NumEntries) * sizeof(PackageEntry);
+	if (header.TocOffset > packageSize || tocSize > packageSize - header.TocOffset ||
+		header.NamesOffset > packageSize || header.NamesSize > packageSize - header.NamesOffset ||
+		header.TocOffset % alignof(PackageEntry) != 0)
+	{
+		PHX_CORE_ERROR("Package table of contents is out of range");
+		return false;
+	}
+
+	this->m_entries = reinterpret_cast<const PackageEntry*>(base + header.TocOffset);
+	this->m_numEntries = header.NumEntries;
+	this->m_names = reinterpret_cast<const char*>(base + header.NamesOffset);
+
+	for (uint32_t i = 0; i < this->m_numEntries; i++)
+	{
+		const PackageEntry& entry = this->m_entries[i];
+		if (entry.Offset > packageSize || entry.Size > packageSize - entry.Offset ||
+			static_cast<uint64_t>(entry.NameOffset) + entry.NameLength > header.NamesSize)
+		{
+			PHX_CORE_ERROR("Package entry is out of range");
+			return false;
+		}
+	}
+
+	this->m_base = base;
+	this->m_package = std::move(package);
+	return true;
+}
+
+bool PackageFileSystem::FileExists(std::filesystem::path const& name)
+{
+	return this->FindEntry(name) != nullptr;
+}
+
+bool PackageFileSystem::FolderExists(std::filesystem::path const& name)
+{
+	// Folders aren't stored, one exists if any entry lives under it.
+	std::string folder = NormalizePath(name);
+	if (folder.empty())
+	{
+		return true;
+	}
+
+	folder.push_back('/');
+	for (uint32_t i = 0; i < this->m_numEntries; i++)
+	{
+		if (this->GetEntryName(this->m_entries[i]).starts_with(folder))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+std::unique_ptr<IBlob> PackageFileSystem::ReadFile(std::filesystem::path const& name)
+{
+	const PackageEntry* entry = this->FindEntry(name);
+	if (!entry)
+	{
+		return nullptr;
+	}
+
+	if (entry->CompressionType != Compression::None)
+	{
+		PHX_CORE_ERROR("Unsupported package compression");
+		return nullptr;
+	}
+
+	return std::make_unique<PackageEntryBlob>(this->m_package, this->m_base + entry->Offset, static_cast<size_t>(entry->Size));
+}
+
+bool PackageFileSystem::WriteFile(std::filesystem::path const& name, Span<char> Data)
+{
+	(void)name;
+	(void)Data;
+	PHX_CORE_ERROR("Packages are read only");
+	return false;
+}
+
+std::unique_ptr<IBlob> PackageFileSystem::MapFile(std::filesystem::path const& name, MapAdvice advice)
+{
+	// Entries are already views into the mapped package.
+	(void)advice;
+	return this->ReadFile(name);
+}
+
+bool PackageFileSystem::ReadFileRange(std::filesystem::path const& name, uint64_t offset, size_t size, void* destination)
+{
+	const PackageEntry* entry = this->FindEntry(name);
+	if (!entry || entry->CompressionType != Compression::None || offset > entry->Size || size > entry->Size - offset)
+	{
+		return false;
+	}
+
+	if (size > 0)
+	{
+		std::memcpy(destination, this->m_base + entry->Offset + offset, size);
+	}
+
+	return true;
+}
+
+const PackageEntry* PackageFileSystem::FindEntry(std::filesystem::path const& name) const
+{
+	const std::string normalized = NormalizePath(name);
+	const uint64_t hash = HashPath(normalized);
+
+	const PackageEntry* end = this->m_entries + this->m_numEntries;
+	const PackageEntry* entry = std::lower_bound(
+		this->m_entries,
+		end,
+		hash,
+		[](PackageEntry const& e, uint64_t h) { return e.PathHash < h; });
+
+	// The builder rejects colliding paths, the name check guards against lookups of paths that
+	// aren't in the package but share a hash with one that is.
+	if (entry != end && entry->PathHash == hash && this->GetEntryName(*entry) == normalized)
+	{
+		return entry;
+	}
+
+	return nullptr;
+}
+
+std::string_view PackageFileSystem::GetEntryName(PackageEntry const& entry) const
+{
+	return std::string_view(this->m_names + entry.NameOffset, entry.NameLength);
+}
+
+std::string phx::PackageFormat::NormalizePath(std::filesystem::path const& path)
+{
+	std::string normalized = path.lexically_normal().generic_string();
+	const size_t first = normalized.find_first_not_of('/');
+	if (first == std::string::npos || normalized == ".")
+	{
+		return {};
+	}
+
+	return normalized.substr(first);
+}
+
+phx::PackageBuilder::PackageBuilder(uint32_t dataAlignment)
+	: m_dataAlignment(std::max<uint32_t>(dataAlignment, alignof(PackageEntry)))
+{
+	assert((this->m_dataAlignment & (this->m_dataAlignment - 1)) == 0);
+}
+
+bool phx::PackageBuilder::AddDirectory(std::filesystem::path const& rootPath)
+{
+	std::error_code ec;
+	std::vector<std::filesystem::path> files;
+	for (auto const& item : std::filesystem::recursive_directory_iterator(rootPath, ec))
+	{
+		if (item.is_regular_file())
+		{
+			files.push_back(item.path());
+		}
+	}
+
+	if (ec)
+	{
+		PHX_CORE_ERROR("Failed to enumerate '{}'", rootPath.generic_string());
+		return false;
+	}
+
+	// Directory order differs between platforms, sorting keeps builds reproducible.
+	std::sort(files.begin(), files.end());
+	for (std::filesystem::path const& file : files)
+	{
+		if (!this->AddFile(file.lexically_relative(rootPath), file))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool phx::PackageBuilder::AddFile(std::filesystem::path const& packagePath, std::filesystem::path const& nativePath)
+{
+	std::error_code ec;
+	const uint64_t size = std::filesystem::file_size(nativePath, ec);
+	if (ec)
+	{
+		PHX_CORE_ERROR("Unable to read '{}'", nativePath.generic_string());
+		return false;
+	}
+
+	std::string name = NormalizePath(packagePath);
+	if (name.empty() || name.size() > std::numeric_limits<uint16_t>::max())
+	{
+		PHX_CORE_ERROR("Invalid package path '{}'", packagePath.generic_string());
+		return false;
+	}
+
+	const uint64_t hash = HashPath(name);
+	this->m_files.push_back({
+		.Name = std::move(name),
+		.PathHash = hash,
+		.NativePath = nativePath,
+		.Size = size });
+
+	return true;
+}
+
+bool phx::PackageBuilder::Write(std::filesystem::path const& outputPath)
+{
+	std::sort(this->m_files.begin(), this->m_files.end(), [](SourceFile const& a, SourceFile const& b) { return a.PathHash < b.PathHash; });
+	for (size_t i = 1; i < this->m_files.size(); i++)
+	{
+		if (this->m_files[i].PathHash == this->m_files[i - 1].PathHash)
+		{
+			PHX_CORE_ERROR("'{}' and '{}' have the same path hash", this->m_files[i - 1].Name, this->m_files[i].Name);
+			return false;
+		}
+	}
+
+	PackageHeader header = {};
+	header.Magic = kMagic;
+	header.Version = kVersion;
+	header.NumEntries = static_cast<uint32_t>(this->m_files.size());
+	header.DataAlignment = this->m_dataAlignment;
+	header.TocOffset = sizeof(PackageHeader);
+	header.NamesOffset = header.TocOffset + this->m_files.size() * sizeof(PackageEntry);
+
+	std::string names;
+	std::vector<PackageEntry> entries;
+	entries.reserve(this->m_files.size());
+	for (const SourceFile& file : this->m_files)
+	{
+		entries.push_back({
+			.PathHash = file.PathHash,
+			.Offset = 0,
+			.Size = file.Size,
+			.UncompressedSize = file.Size,
+			.NameOffset = static_cast<uint32_t>(names.size()),
+			.NameLength = static_cast<uint16_t>(file.Name.size()),
+			.CompressionType = Compression::None,
+			.Reserved = 0 });
+		names.append(file.Name);
+	}
+	header.NamesSize = names.size();
+
+	uint64_t dataOffset = header.NamesOffset + header.NamesSize;
+	for (PackageEntry& entry : entries)
+	{
+		dataOffset = AlignOffset(dataOffset, this->m_dataAlignment);
+		entry.Offset = dataOffset;
+		dataOffset += entry.Size;
+	}
+
+	std::ofstream out(outputPath, std::ios::binary | std::ios::trunc);
+	if (!out.is_open())
+	{
+		PHX_CORE_ERROR("Unable to open '{}' for writing", outputPath.generic_string());
+		return false;
+	}
+
+	out.write(reinterpret_cast<const char*>(&header), sizeof(PackageHeader));
+	out.write(reinterpret_cast<const char*>(entries.data()), static_cast<std::streamsize>(entries.size() * sizeof(PackageEntry)));
+	out.write(names.data(), static_cast<std::streamsize>(names.size()));
+
+	std::vector<char> buffer(1 << 20);
+	uint64_t written = header.NamesOffset + header.NamesSize;
+	for (size_t i = 0; i < entries.size(); i++)
+	{
+		const std::vector<char> padding(static_cast<size_t>(entries[i].Offset - written), 0);
+		out.write(padding.data(), static_cast<std::streamsize>(padding.size()));
+
+		std::ifstream in(this->m_files[i].NativePath, std::ios::binary);
+		uint64_t remaining = entries[i].Size;
+		while (remaining > 0 && in)
+		{
+			const size_t chunk = static_cast<size_t>(std::min<uint64_t>(remaining, buffer.size()));
+			in.read(buffer.data(), static_cast<std::streamsize>(chunk));
+			out.write(buffer.data(), in.gcount());
+			remaining -= static_cast<uint64_t>(in.gcount());
+		}
+
+		if (remaining > 0)
+		{
+			PHX_CORE_ERROR("Failed to read '{}'", this->m_files[i].NativePath.generic_string());
+			return false;
+		}
+
+		written = entries[i].Offset + entries[i].Size;
+	}
+
+	if (!out.good())
+	{
+		PHX_CORE_ERROR("Failed to write package '{}'", outputPath.generic_string());
+		return false;
+	}
+
+	return true;
+}
+
+namespace phx::FileSystemFactory
+{
+	std::unique_ptr<IFileSystem> CreatePackageFileSystem(std::filesystem::path const& packagePath)
+	{
+		// Mapping the package makes every entry a view, nothing is copied on read.
+		std::unique_ptr<IBlob> package = CreateNativeFileSystem(Memory::GetHeapIfInitialized())->MapFile(packagePath, MapAdvice::Normal);
+		if (!package)
+		{
+			PHX_CORE_ERROR("Unable to open package '{}'", packagePath.generic_string());
+			return nullptr;
+		}
+
+		auto fs = std::make_unique<PackageFileSystem>();
+		if (!fs->Open(std::move(package)))
+		{
+			return nullptr;
+		}
+
+		return fs;
+	}
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "phxStringHash.h"
+#include "phxVFS.h"
+
+namespace phx
+{
+	// Read only package of many files in one. Layout:
+	//   PackageHeader
+	//   PackageEntry[NumEntries], sorted by PathHash
+	//   Entry names, NameOffset / NameLength into this block
+	//   Entry data, each entry starting on DataAlignment so it can be mapped in place
+	namespace PackageFormat
+	{
+		constexpr uint32_t kMagic = 0x504B5850; // 'PXKP'
+		constexpr uint32_t kVersion = 1;
+		constexpr uint32_t kDefaultAlignment = 4096;
+
+		enum class Compression : uint8_t
+		{
+			None = 0,
+		};
+
+		struct PackageHeader
+		{
+			uint32_t Magic;
+			uint32_t Version;
+			uint32_t NumEntries;
+			uint32_t DataAlignment;
+			uint64_t TocOffset;
+			uint64_t NamesOffset;
+			uint64_t NamesSize;
+		};
+
+		struct PackageEntry
+		{
+			uint64_t PathHash;
+			uint64_t Offset;
+			uint64_t Size;
+			uint64_t UncompressedSize;
+			uint32_t NameOffset;
+			uint16_t NameLength;
+			Compression CompressionType;
+			uint8_t Reserved;
+		};
+
+		static_assert(sizeof(PackageHeader) == 40);
+		static_assert(sizeof(PackageEntry) == 40);
+
+		// Entries are keyed by their path relative to the package root, with '/' separators and
+		// no leading slash.
+		std::string NormalizePath(std::filesystem::path const& path);
+
+		inline uint64_t HashPath(std::string_view normalizedPath)
+		{
+			return fnv1a_64(normalizedPath.data(), normalizedPath.size());
+		}
+	}
+
+	class PackageBuilder
+	{
+	public:
+		explicit PackageBuilder(uint32_t dataAlignment = PackageFormat::kDefaultAlignment);
+
+		// Adds every regular file under rootPath, named by its path relative to rootPath.
+		bool AddDirectory(std::filesystem::path const& rootPath);
+		bool AddFile(std::filesystem::path const& packagePath, std::filesystem::path const& nativePath);
+
+		bool Write(std::filesystem::path const& outputPath);
+
+		size_t GetNumEntries() const { return this->m_files.size(); }
+
+	private:
+		struct SourceFile
+		{
+			std::string Name;
+			uint64_t PathHash;
+			std::filesystem::path NativePath;
+			uint64_t Size;
+		};
+
+		uint32_t m_dataAlignment;
+		std::vector<SourceFile> m_files;
+	};
+}
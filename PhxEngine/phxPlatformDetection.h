@@ -35,7 +35,6 @@
 #error "Android is not supported!"
 #elif defined(__linux__)
 #define PHX_PLATFORM_LINUX
-#error "Linux is not supported!"
 #else
 	/* Unknown compiler/platform */
 #error "Unknown platform!"
@@ -0,0 +1,245 @@
+#include "pch.h"
+#include "phxRetirementQueue.h"
+
+#include "phxMemory.h"
+
+#include <algorithm>
+#include <assert.h>
+#include <chrono>
+
+using namespace phx;
+
+namespace
+{
+	int64_t GetTicks()
+	{
+		return std::chrono::steady_clock::now().time_since_epoch().count();
+	}
+
+	double TicksToMs(int64_t ticks)
+	{
+		using Ticks = std::chrono::steady_clock::duration;
+		return std::chrono::duration<double, std::milli>(Ticks(ticks)).count();
+	}
+}
+
+phx::RetirementQueue::~RetirementQueue()
+{
+	// Anything still pending is dropped without running, callers Collect everything on shutdown.
+	for (ProducerSlot& slot : this->m_producers)
+	{
+		DeleteList(slot.Current.exchange(nullptr));
+		DeleteList(slot.FreeBuckets);
+		slot.FreeBuckets = nullptr;
+	}
+
+	DeleteList(this->m_publishedBuckets.exchange(nullptr));
+	DeleteList(this->m_freeBuckets.exchange(nullptr));
+	DeleteList(this->m_pendingBuckets);
+	this->m_pendingBuckets = nullptr;
+}
+
+RetireTypeId phx::RetirementQueue::RegisterBatchType(BatchFn&& batchFn)
+{
+	assert(this->m_batchFns.size() < kMaxBatchTypes);
+	this->m_batchFns.emplace_back(std::move(batchFn));
+	return static_cast<RetireTypeId>(this->m_batchFns.size() - 1);
+}
+
+void phx::RetirementQueue::Retire(uint64_t retireValue, ReleaseCallback const& callback)
+{
+	this->Push({ .Callback = callback, .Payload = 0, .Type = kCallbackType }, retireValue);
+}
+
+void phx::RetirementQueue::Retire(RetireTypeId type, uint64_t retireValue, uint64_t payload)
+{
+	assert(type < this->m_batchFns.size());
+	this->Push({ .Callback = {}, .Payload = payload, .Type = type }, retireValue);
+}
+
+void phx::RetirementQueue::Collect(uint64_t completedValue)
+{
+	std::scoped_lock _(this->m_consumerMutex);
+
+	// Gather buckets that are still being filled, a producer holding its bucket right now will
+	// have it picked up on the next call.
+	for (ProducerSlot& slot : this->m_producers)
+	{
+		Bucket* bucket = slot.Current.exchange(nullptr, std::memory_order_acquire);
+		if (bucket)
+		{
+			bucket->Next = this->m_pendingBuckets;
+			this->m_pendingBuckets = bucket;
+		}
+	}
+
+	Bucket* published = this->m_publishedBuckets.exchange(nullptr, std::memory_order_acquire);
+	while (published)
+	{
+		Bucket* next = published->Next;
+		published->Next = this->m_pendingBuckets;
+		this->m_pendingBuckets = published;
+		published = next;
+	}
+
+	RetirementStats stats = {};
+	stats.NumRetiredTotal = this->m_stats.NumRetiredTotal;
+
+	const int64_t nowTicks = GetTicks();
+	Bucket* stillPending = nullptr;
+	Bucket* freeFirst = nullptr;
+	Bucket* freeLast = nullptr;
+	while (this->m_pendingBuckets)
+	{
+		Bucket* bucket = this->m_pendingBuckets;
+		this->m_pendingBuckets = bucket->Next;
+
+		if (bucket->RetireValue > completedValue)
+		{
+			stats.NumPending += bucket->Count;
+			stats.OldestPendingValue = std::min(stats.OldestPendingValue, bucket->RetireValue);
+			for (uint32_t i = 0; i < bucket->Count; i++)
+			{
+				const Entry& entry = bucket->Entries[i];
+				if (entry.Type == kCallbackType)
+				{
+					stats.NumPendingCallbacks++;
+				}
+				else
+				{
+					stats.NumPendingByType[entry.Type]++;
+				}
+			}
+
+			bucket->Next = stillPending;
+			stillPending = bucket;
+			continue;
+		}
+
+		for (uint32_t i = 0; i < bucket->Count; i++)
+		{
+			Entry& entry = bucket->Entries[i];
+			if (entry.Type == kCallbackType)
+			{
+				entry.Callback();
+			}
+			else
+			{
+				this->m_batches[entry.Type].push_back(entry.Payload);
+			}
+		}
+
+		stats.NumRetiredLastCollect += bucket->Count;
+		stats.MaxLatencyValues = std::max(stats.MaxLatencyValues, completedValue - bucket->RetireValue);
+		stats.MaxLatencyMs = std::max(stats.MaxLatencyMs, TicksToMs(nowTicks - bucket->OpenedTicks));
+
+		bucket->Count = 0;
+		bucket->Next = freeFirst;
+		freeFirst = bucket;
+		if (!freeLast)
+		{
+			freeLast = bucket;
+		}
+	}
+
+	this->m_pendingBuckets = stillPending;
+	if (freeFirst)
+	{
+		PushList(this->m_freeBuckets, freeFirst, freeLast);
+	}
+
+	// One call per type for everything that retired this time.
+	for (size_t type = 0; type < this->m_batchFns.size(); type++)
+	{
+		std::vector<uint64_t>& batch = this->m_batches[type];
+		if (!batch.empty())
+		{
+			this->m_batchFns[type](Span<uint64_t>(batch.data(), batch.size()));
+			batch.clear();
+		}
+	}
+
+	stats.NumRetiredTotal += stats.NumRetiredLastCollect;
+	this->m_stats = stats;
+}
+
+RetirementStats phx::RetirementQueue::GetStats()
+{
+	std::scoped_lock _(this->m_consumerMutex);
+	return this->m_stats;
+}
+
+void phx::RetirementQueue::Push(Entry const& entry, uint64_t retireValue)
+{
+	const uint32_t threadIndex = Memory::GetThreadIndex();
+	if (threadIndex < kMaxProducers)
+	{
+		this->PushToSlot(this->m_producers[threadIndex], entry, retireValue);
+		return;
+	}
+
+	std::scoped_lock _(this->m_overflowMutex);
+	this->PushToSlot(this->m_producers[kMaxProducers], entry, retireValue);
+}
+
+void phx::RetirementQueue::PushToSlot(ProducerSlot& slot, Entry const& entry, uint64_t retireValue)
+{
+	Bucket* bucket = slot.Current.exchange(nullptr, std::memory_order_acquire);
+	if (bucket && (bucket->RetireValue != retireValue || bucket->Count == Bucket::kCapacity))
+	{
+		PushList(this->m_publishedBuckets, bucket, bucket);
+		bucket = nullptr;
+	}
+
+	if (!bucket)
+	{
+		bucket = this->AcquireBucket(slot, retireValue);
+	}
+
+	bucket->Entries[bucket->Count++] = entry;
+	slot.Current.store(bucket, std::memory_order_release);
+}
+
+phx::RetirementQueue::Bucket* phx::RetirementQueue::AcquireBucket(ProducerSlot& slot, uint64_t retireValue)
+{
+	if (!slot.FreeBuckets)
+	{
+		// Take every recycled bucket at once, keeping the pop side free of ABA.
+		slot.FreeBuckets = this->m_freeBuckets.exchange(nullptr, std::memory_order_acquire);
+	}
+
+	Bucket* bucket = slot.FreeBuckets;
+	if (bucket)
+	{
+		slot.FreeBuckets = bucket->Next;
+	}
+	else
+	{
+		bucket = new Bucket();
+	}
+
+	bucket->RetireValue = retireValue;
+	bucket->OpenedTicks = GetTicks();
+	bucket->Count = 0;
+	bucket->Next = nullptr;
+	return bucket;
+}
+
+void phx::RetirementQueue::PushList(std::atomic<Bucket*>& list, Bucket* first, Bucket* last)
+{
+	Bucket* head = list.load(std::memory_order_relaxed);
+	do
+	{
+		last->Next = head;
+	} while (!list.compare_exchange_weak(head, first, std::memory_order_release, std::memory_order_relaxed));
+}
+
+void phx::RetirementQueue::DeleteList(Bucket* bucket)
+{
+	while (bucket)
+	{
+		Bucket* next = bucket->Next;
+		delete bucket;
+		bucket = next;
+	}
+}
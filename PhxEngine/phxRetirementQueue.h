@@ -0,0 +1,176 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "phxSpan.h"
+
+namespace phx
+{
+	// Type erased callback stored inline, so queueing a release never allocates. The callable has to
+	// fit in kStorageSize and be trivially copyable (i.e. a lambda capturing pointers or handles).
+	class ReleaseCallback
+	{
+	public:
+		static constexpr size_t kStorageSize = 3 * sizeof(void*);
+
+		ReleaseCallback() = default;
+
+		template<typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, ReleaseCallback>>>
+		ReleaseCallback(F&& fn)
+		{
+			using FnT = std::decay_t<F>;
+			static_assert(sizeof(FnT) <= kStorageSize, "Release callback captures too much state");
+			static_assert(alignof(FnT) <= alignof(void*), "Release callback is over aligned");
+			static_assert(std::is_trivially_copyable_v<FnT>, "Release callback must be trivially copyable");
+
+			new (this->m_storage) FnT(std::forward<F>(fn));
+			this->m_invoke = [](void* storage) { (*static_cast<FnT*>(storage))(); };
+		}
+
+		void operator()() { this->m_invoke(this->m_storage); }
+		explicit operator bool() const { return this->m_invoke != nullptr; }
+
+	private:
+		alignas(void*) unsigned char m_storage[kStorageSize] = {};
+		void (*m_invoke)(void*) = nullptr;
+	};
+
+	// Source of the completed value a RetirementQueue is collected against, e.g. a GPU fence or the
+	// completed frame count.
+	class IRetirementFence
+	{
+	public:
+		virtual ~IRetirementFence() = default;
+		virtual uint64_t GetCompletedValue() const = 0;
+	};
+
+	// Fence signalled from the CPU, used where there is no GPU timeline and for testing.
+	class CpuRetirementFence final : public IRetirementFence
+	{
+	public:
+		void Signal(uint64_t value)
+		{
+			uint64_t current = this->m_completedValue.load(std::memory_order_relaxed);
+			while (current < value && !this->m_completedValue.compare_exchange_weak(current, value, std::memory_order_release))
+			{
+			}
+		}
+
+		uint64_t GetCompletedValue() const override { return this->m_completedValue.load(std::memory_order_acquire); }
+
+	private:
+		std::atomic<uint64_t> m_completedValue = 0;
+	};
+
+	using RetireTypeId = uint32_t;
+
+	struct RetirementStats
+	{
+		static constexpr size_t kMaxBatchTypes = 16;
+
+		uint64_t NumPending = 0;
+		uint64_t NumPendingCallbacks = 0;
+		std::array<uint64_t, kMaxBatchTypes> NumPendingByType = {};
+		uint64_t OldestPendingValue = ~0ull;
+
+		uint64_t NumRetiredLastCollect = 0;
+		uint64_t NumRetiredTotal = 0;
+
+		// How far the fence had moved past an entry's value when it was retired, and the wall time
+		// between the first entry of a bucket being queued and the bucket being retired.
+		uint64_t MaxLatencyValues = 0;
+		double MaxLatencyMs = 0.0;
+	};
+
+	// Deferred destruction keyed by a fence value. An entry retired with value V is destroyed once
+	// Collect is called with a completed value >= V.
+	//
+	// Retire is lock free and safe from any thread, entries go into per thread buckets that are only
+	// handed to the consumer when they fill or the value changes. Collect must only be called from one
+	// thread at a time. Callbacks run as their bucket is retired, typed payloads are gathered and
+	// handed to their batch function once per Collect.
+	class RetirementQueue
+	{
+	public:
+		static constexpr size_t kMaxBatchTypes = RetirementStats::kMaxBatchTypes;
+		using BatchFn = std::function<void(Span<uint64_t> payloads)>;
+
+		RetirementQueue() = default;
+		~RetirementQueue();
+
+		RetirementQueue(RetirementQueue const&) = delete;
+		RetirementQueue& operator=(RetirementQueue const&) = delete;
+
+		// Not thread safe, register every type before anything is retired.
+		RetireTypeId RegisterBatchType(BatchFn&& batchFn);
+
+		void Retire(uint64_t retireValue, ReleaseCallback const& callback);
+		void Retire(RetireTypeId type, uint64_t retireValue, uint64_t payload);
+
+		void Collect(uint64_t completedValue);
+		void Collect(IRetirementFence const& fence) { this->Collect(fence.GetCompletedValue()); }
+
+		// Snapshot taken at the end of the last Collect.
+		RetirementStats GetStats();
+
+	private:
+		static constexpr RetireTypeId kCallbackType = ~0u;
+		static constexpr uint32_t kMaxProducers = 64;
+
+		struct Entry
+		{
+			ReleaseCallback Callback;
+			uint64_t Payload;
+			RetireTypeId Type;
+		};
+
+		// Entries queued by one thread for one retire value.
+		struct Bucket
+		{
+			static constexpr uint32_t kCapacity = 256;
+
+			uint64_t RetireValue = 0;
+			int64_t OpenedTicks = 0;
+			uint32_t Count = 0;
+			Bucket* Next = nullptr;
+			std::array<Entry, kCapacity> Entries;
+		};
+
+		// A producer owns its current bucket while the pointer is swapped out of Current, the
+		// consumer steals it the same way, so whoever holds the pointer has exclusive access.
+		struct alignas(64) ProducerSlot
+		{
+			std::atomic<Bucket*> Current = nullptr;
+			Bucket* FreeBuckets = nullptr;
+		};
+
+		void Push(Entry const& entry, uint64_t retireValue);
+		void PushToSlot(ProducerSlot& slot, Entry const& entry, uint64_t retireValue);
+		Bucket* AcquireBucket(ProducerSlot& slot, uint64_t retireValue);
+		static void PushList(std::atomic<Bucket*>& list, Bucket* first, Bucket* last);
+		static void DeleteList(Bucket* bucket);
+
+	private:
+		std::array<ProducerSlot, kMaxProducers + 1> m_producers;
+		// Threads beyond kMaxProducers share the last slot.
+		std::mutex m_overflowMutex;
+
+		// Producers push, the consumer takes the whole list at once, so neither list suffers ABA.
+		std::atomic<Bucket*> m_publishedBuckets = nullptr;
+		std::atomic<Bucket*> m_freeBuckets = nullptr;
+
+		// -- Consumer side ---
+		std::mutex m_consumerMutex;
+		Bucket* m_pendingBuckets = nullptr;
+		std::vector<BatchFn> m_batchFns;
+		std::array<std::vector<uint64_t>, kMaxBatchTypes> m_batches;
+		RetirementStats m_stats;
+	};
+}
@@ -11,6 +11,19 @@ namespace phx
 		return ((count ? fnv1a_32(s, count - 1) : 2166136261u) ^ s[count]) * 16777619u;
 	}
 
+	constexpr uint64_t kFnv1a64Basis = 14695981039346656037ull;
+
+	// FNV-1a 64bit, for large key sets where 32bit collisions become likely. Pass a previous
+	// result as hash to continue hashing where it left off.
+	constexpr uint64_t fnv1a_64(char const* s, size_t count, uint64_t hash = kFnv1a64Basis)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			hash = (hash ^ static_cast<uint8_t>(s[i])) * 1099511628211ull;
+		}
+		return hash;
+	}
+
 	constexpr size_t const_strlen(const char* s)
 	{
 		size_t size = 0;
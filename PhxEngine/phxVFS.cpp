@@ -1,12 +1,25 @@
 #include "pch.h"
 #include "phxVFS.h"
-
+#include "phxAsyncIo.h"
+#include "phxFileWatcher.h"
+#include "phxMemory.h"
+#include "phxStringHash.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
 #include <fstream>
+#include <string_view>
+#include <unordered_map>
 
 #ifndef PHX_PLATFORM_WINDOWS
 #include <unistd.h>
 #include <cstdio>
 #include <climits>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #else
 #define PATH_MAX MAX_PATH
 #endif // _WIN32
@@ -18,16 +31,55 @@ namespace
     class Blob : public IBlob
     {
     public:
-        Blob(void* Data, size_t size)
+        Blob(void* Data, size_t size, TlsfAllocator* heap = nullptr)
             : m_data(Data)
             , m_size(size)
+            , m_heap(heap)
         {}
 
         ~Blob() override
         {
             if (this->m_data)
             {
-                free(this->m_data);
+                if (this->m_heap)
+                {
+                    this->m_heap->Free(this->m_data);
+                }
+                else
+                {
+                    free(this->m_data);
+                }
+                this->m_data = nullptr;
+            }
+
+            this->m_size = 0;
+        }
+
+        [[nodiscard]] const void* Data() const override { return this->m_data; }
+        [[nodiscard]] size_t Size() const override { return this->m_size; }
+
+    private:
+        void* m_data;
+        size_t m_size;
+        TlsfAllocator* m_heap;
+    };
+
+    // Read only view of a whole file. The mapping is private, so a consumer writing through Data()
+    // gets its own copy of the touched pages and never modifies the file.
+    class MappedBlob : public IBlob
+    {
+    public:
+        static std::unique_ptr<MappedBlob> Create(std::filesystem::path const& name, MapAdvice advice);
+
+        ~MappedBlob() override
+        {
+            if (this->m_data)
+            {
+#ifdef PHX_PLATFORM_WINDOWS
+                UnmapViewOfFile(this->m_data);
+#else
+                munmap(this->m_data, this->m_size);
+#endif
                 this->m_data = nullptr;
             }
 
@@ -37,6 +89,12 @@ namespace
         [[nodiscard]] const void* Data() const override { return this->m_data; }
         [[nodiscard]] size_t Size() const override { return this->m_size; }
 
+    private:
+        MappedBlob(void* data, size_t size)
+            : m_data(data)
+            , m_size(size)
+        {}
+
     private:
         void* m_data;
         size_t m_size;
@@ -45,10 +103,29 @@ namespace
     class NativeFileSystem final : public IFileSystem
     {
     public:
+        NativeFileSystem(TlsfAllocator* blobHeap = nullptr, size_t memoryMapThreshold = FileSystemFactory::kDefaultMemoryMapThreshold)
+            : m_blobHeap(blobHeap)
+            , m_memoryMapThreshold(memoryMapThreshold)
+        {}
+
         bool FileExists(std::filesystem::path const& name) override;
         bool FolderExists(std::filesystem::path const& name) override;
         std::unique_ptr<IBlob> ReadFile(std::filesystem::path const& name) override;
         bool WriteFile(std::filesystem::path const& name, Span<char> Data) override;
+        std::unique_ptr<IBlob> MapFile(std::filesystem::path const& name, MapAdvice advice) override;
+        bool ReadFileRange(std::filesystem::path const& name, uint64_t offset, size_t size, void* destination) override;
+        void ReadFilesAsync(Span<ReadFileRequest> requests) override;
+        bool GetLastWriteTime(std::filesystem::path const& name, std::filesystem::file_time_type& outTime) override;
+        bool RemoveFile(std::filesystem::path const& name) override;
+        FileWatchHandle WatchDirectory(std::filesystem::path const& directory, FileChangeCallback&& onChange) override;
+        void Unwatch(FileWatchHandle handle) override;
+
+    private:
+        std::unique_ptr<IBlob> ReadFileCopy(std::filesystem::path const& name);
+
+    private:
+        TlsfAllocator* m_blobHeap;
+        size_t m_memoryMapThreshold;
     };
 
     class RelativeFileSystem final : public IFileSystem
@@ -62,6 +139,13 @@ namespace
         bool FolderExists(std::filesystem::path const& name) override;
         std::unique_ptr<IBlob> ReadFile(std::filesystem::path const& name) override;
         bool WriteFile(std::filesystem::path const& name, Span<char> Data) override;
+        std::unique_ptr<IBlob> MapFile(std::filesystem::path const& name, MapAdvice advice) override;
+        bool ReadFileRange(std::filesystem::path const& name, uint64_t offset, size_t size, void* destination) override;
+        void ReadFilesAsync(Span<ReadFileRequest> requests) override;
+        bool GetLastWriteTime(std::filesystem::path const& name, std::filesystem::file_time_type& outTime) override;
+        bool RemoveFile(std::filesystem::path const& name) override;
+        FileWatchHandle WatchDirectory(std::filesystem::path const& directory, FileChangeCallback&& onChange) override;
+        void Unwatch(FileWatchHandle handle) override;
 
     private:
         std::shared_ptr<IFileSystem> m_underlyingFS;
@@ -79,15 +163,164 @@ namespace
         bool FolderExists(std::filesystem::path const& name) override;
         std::unique_ptr<IBlob> ReadFile(std::filesystem::path const& name) override;
         bool WriteFile(std::filesystem::path const& name, Span<char> Data) override;
+        std::unique_ptr<IBlob> MapFile(std::filesystem::path const& name, MapAdvice advice) override;
+        bool ReadFileRange(std::filesystem::path const& name, uint64_t offset, size_t size, void* destination) override;
+        void ReadFilesAsync(Span<ReadFileRequest> requests) override;
+        bool GetLastWriteTime(std::filesystem::path const& name, std::filesystem::file_time_type& outTime) override;
+        bool RemoveFile(std::filesystem::path const& name) override;
+        FileWatchHandle WatchDirectory(std::filesystem::path const& directory, FileChangeCallback&& onChange) override;
+        void Unwatch(FileWatchHandle handle) override;
 
     private:
-        bool FindMountPoint(const std::filesystem::path& path, std::filesystem::path* pRelativePath, IFileSystem** ppFS);
+        struct MountPoint
+        {
+            std::string Prefix;
+            uint64_t PrefixHash;
+            std::shared_ptr<IFileSystem> FS;
+        };
+
+        bool FindMountPoint(const std::filesystem::path& path, std::filesystem::path* pRelativePath, IFileSystem** ppFS, const MountPoint** ppMount = nullptr);
+        void RebuildMountLookup();
 
     private:
-        std::vector<std::pair<std::string, std::shared_ptr<IFileSystem>>> m_mountPoints;
+        std::vector<MountPoint> m_mountPoints;
+        // Prefix hash to index into m_mountPoints, so resolving a path costs one probe per segment
+        // rather than a string compare per mount.
+        std::unordered_map<uint64_t, uint32_t> m_mountLookup;
+        // Keeps a watched file system alive, and reachable to unwatch, after it's unmounted.
+        std::unordered_map<FileWatchHandle, std::shared_ptr<IFileSystem>> m_watches;
     };
+
+    // Already normal generic paths need no rewriting, which is the common case for engine paths.
+    bool IsNormalGenericPath(std::string_view path)
+    {
+        size_t segmentStart = 0;
+        for (size_t i = 0; i <= path.size(); i++)
+        {
+            if (i < path.size() && path[i] != '/')
+            {
+                continue;
+            }
+
+            const std::string_view segment = path.substr(segmentStart, i - segmentStart);
+            if (segment == "." || segment == ".." || (segment.empty() && i > 0 && i < path.size()))
+            {
+                return false;
+            }
+
+            segmentStart = i + 1;
+        }
+
+        return !path.empty();
+    }
+
+    // Generic form of path as a view, either of the path itself or of scratch. Only paths that
+    // need normalizing allocate, scratch keeps its capacity between calls.
+    std::string_view GetNormalGenericView(const std::filesystem::path& path, std::string& scratch)
+    {
+        if constexpr (std::is_same_v<std::filesystem::path::value_type, char>)
+        {
+            const std::string_view native = path.native();
+            if (IsNormalGenericPath(native))
+            {
+                return native;
+            }
+        }
+        else
+        {
+            scratch.clear();
+            bool isAscii = true;
+            for (auto c : path.native())
+            {
+                if (static_cast<uint32_t>(c) > 0x7F)
+                {
+                    isAscii = false;
+                    break;
+                }
+                scratch.push_back(c == '\\' ? '/' : static_cast<char>(c));
+            }
+
+            if (isAscii && IsNormalGenericPath(scratch))
+            {
+                return scratch;
+            }
+        }
+
+        scratch = path.lexically_normal().generic_string();
+        return scratch;
+    }
+}
+
+
+bool IFileSystem::ReadFileRange(std::filesystem::path const& name, uint64_t offset, size_t size, void* destination)
+{
+    std::unique_ptr<IBlob> blob = this->ReadFile(name);
+    if (!blob || offset > blob->Size() || size > blob->Size() - offset)
+    {
+        return false;
+    }
+
+    if (size > 0)
+    {
+        std::memcpy(destination, static_cast<const uint8_t*>(blob->Data()) + offset, size);
+    }
+
+    return true;
+}
+
+void IFileSystem::ReadFilesAsync(Span<ReadFileRequest> requests)
+{
+    for (const ReadFileRequest& request : requests)
+    {
+        IoThreadPool::Get().Submit(
+            request.Priority,
+            [this, path = request.Path, onComplete = request.OnComplete]()
+            {
+                std::unique_ptr<IBlob> blob = this->ReadFile(path);
+                if (onComplete)
+                {
+                    onComplete(std::move(blob));
+                }
+            });
+    }
+}
+
+void IFileSystem::WriteFileAsync(std::filesystem::path const& name, std::vector<char>&& data, WriteFileCallback&& onComplete)
+{
+    WriteBehindQueue::Get().Enqueue(this, name, std::move(data), std::move(onComplete));
+}
+
+void IFileSystem::FlushWrites()
+{
+    WriteBehindQueue::Get().Flush(this);
+}
+
+std::future<std::unique_ptr<IBlob>> IFileSystem::ReadFileAsync(std::filesystem::path const& name, IoPriority priority)
+{
+    // std::function needs a copyable callable, so the promise is shared.
+    auto promise = std::make_shared<std::promise<std::unique_ptr<IBlob>>>();
+    std::future<std::unique_ptr<IBlob>> future = promise->get_future();
+
+    this->ReadFileAsync(
+        name,
+        [promise](std::unique_ptr<IBlob> blob)
+        {
+            promise->set_value(std::move(blob));
+        },
+        priority);
+
+    return future;
 }
 
+void IFileSystem::ReadFileAsync(std::filesystem::path const& name, ReadFileCallback&& onComplete, IoPriority priority)
+{
+    ReadFileRequest request = {
+        .Path = name,
+        .OnComplete = std::move(onComplete),
+        .Priority = priority };
+
+    this->ReadFilesAsync(Span<ReadFileRequest>(&request, 1));
+}
 
 bool NativeFileSystem::FileExists(std::filesystem::path const& name)
 {
@@ -99,7 +332,225 @@ bool NativeFileSystem::FolderExists(std::filesystem::path const& name)
     return std::filesystem::exists(name) && std::filesystem::is_directory(name);
 }
 
+bool NativeFileSystem::GetLastWriteTime(std::filesystem::path const& name, std::filesystem::file_time_type& outTime)
+{
+    std::error_code ec;
+    outTime = std::filesystem::last_write_time(name, ec);
+    return !ec;
+}
+
+bool NativeFileSystem::RemoveFile(std::filesystem::path const& name)
+{
+    std::error_code ec;
+    return std::filesystem::remove(name, ec) && !ec;
+}
+
+FileWatchHandle NativeFileSystem::WatchDirectory(std::filesystem::path const& directory, FileChangeCallback&& onChange)
+{
+    return FileWatch::WatchNativeDirectory(directory, std::move(onChange));
+}
+
+void NativeFileSystem::Unwatch(FileWatchHandle handle)
+{
+    FileWatch::Unwatch(handle);
+}
+
+#ifdef PHX_PLATFORM_WINDOWS
+std::unique_ptr<MappedBlob> MappedBlob::Create(std::filesystem::path const& name, MapAdvice advice)
+{
+    HANDLE file = CreateFileW(
+        name.c_str(),
+        GENERIC_READ,
+        FILE_SHARE_READ,
+        nullptr,
+        OPEN_EXISTING,
+        advice == MapAdvice::Sequential ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_ATTRIBUTE_NORMAL,
+        nullptr);
+
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return nullptr;
+    }
+
+    LARGE_INTEGER fileSize = {};
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+    {
+        CloseHandle(file);
+        return nullptr;
+    }
+
+    // The view keeps the file alive, both handles can be closed once it is mapped.
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (!mapping)
+    {
+        return nullptr;
+    }
+
+    void* data = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+    CloseHandle(mapping);
+    if (!data)
+    {
+        return nullptr;
+    }
+
+    const size_t size = static_cast<size_t>(fileSize.QuadPart);
+    if (advice == MapAdvice::WillNeed)
+    {
+        WIN32_MEMORY_RANGE_ENTRY range = { data, size };
+        PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+    }
+
+    return std::unique_ptr<MappedBlob>(new MappedBlob(data, size));
+}
+#else
+std::unique_ptr<MappedBlob> MappedBlob::Create(std::filesystem::path const& name, MapAdvice advice)
+{
+    const int fd = open(name.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        return nullptr;
+    }
+
+    struct stat fileStat = {};
+    if (fstat(fd, &fileStat) != 0 || fileStat.st_size <= 0)
+    {
+        close(fd);
+        return nullptr;
+    }
+
+    // The mapping keeps the file alive, the descriptor can be closed straight away.
+    const size_t size = static_cast<size_t>(fileStat.st_size);
+    void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+    {
+        return nullptr;
+    }
+
+    switch (advice)
+    {
+    case MapAdvice::Sequential:
+        madvise(data, size, MADV_SEQUENTIAL);
+        break;
+    case MapAdvice::WillNeed:
+        madvise(data, size, MADV_WILLNEED);
+        break;
+    case MapAdvice::Normal:
+    default:
+        break;
+    }
+
+    return std::unique_ptr<MappedBlob>(new MappedBlob(data, size));
+}
+#endif
+
 std::unique_ptr<IBlob> NativeFileSystem::ReadFile(std::filesystem::path const& name)
+{
+    std::error_code ec;
+    const uintmax_t fileSize = std::filesystem::file_size(name, ec);
+    if (!ec && fileSize > 0 && fileSize >= this->m_memoryMapThreshold)
+    {
+        // Callers of ReadFile want the whole file, so start paging it in now.
+        std::unique_ptr<IBlob> mapped = MappedBlob::Create(name, MapAdvice::WillNeed);
+        if (mapped)
+        {
+            return mapped;
+        }
+    }
+
+    return this->ReadFileCopy(name);
+}
+
+std::unique_ptr<IBlob> NativeFileSystem::MapFile(std::filesystem::path const& name, MapAdvice advice)
+{
+    std::unique_ptr<IBlob> mapped = MappedBlob::Create(name, advice);
+    if (mapped)
+    {
+        return mapped;
+    }
+
+    // Empty files can't be mapped, anything else that failed to map gets one more try as a copy.
+    return this->ReadFileCopy(name);
+}
+
+#ifdef PHX_PLATFORM_WINDOWS
+bool NativeFileSystem::ReadFileRange(std::filesystem::path const& name, uint64_t offset, size_t size, void* destination)
+{
+    HANDLE file = CreateFileW(name.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    // ReadFile takes a DWORD count, so large ranges go in chunks.
+    uint8_t* cursor = static_cast<uint8_t*>(destination);
+    size_t remaining = size;
+    while (remaining > 0)
+    {
+        OVERLAPPED overlapped = {};
+        overlapped.Offset = static_cast<DWORD>(offset);
+        overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+
+        const DWORD toRead = static_cast<DWORD>(std::min<size_t>(remaining, 1u << 30));
+        DWORD bytesRead = 0;
+        if (!::ReadFile(file, cursor, toRead, &bytesRead, &overlapped) || bytesRead == 0)
+        {
+            break;
+        }
+
+        cursor += bytesRead;
+        offset += bytesRead;
+        remaining -= bytesRead;
+    }
+
+    CloseHandle(file);
+    return remaining == 0;
+}
+#else
+bool NativeFileSystem::ReadFileRange(std::filesystem::path const& name, uint64_t offset, size_t size, void* destination)
+{
+    const int fd = open(name.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    uint8_t* cursor = static_cast<uint8_t*>(destination);
+    size_t remaining = size;
+    while (remaining > 0)
+    {
+        const ssize_t bytesRead = pread(fd, cursor, remaining, static_cast<off_t>(offset));
+        if (bytesRead < 0 && errno == EINTR)
+        {
+            continue;
+        }
+
+        // Error or end of file before the range was filled.
+        if (bytesRead <= 0)
+        {
+            break;
+        }
+
+        cursor += bytesRead;
+        offset += static_cast<uint64_t>(bytesRead);
+        remaining -= static_cast<size_t>(bytesRead);
+    }
+
+    close(fd);
+    return remaining == 0;
+}
+#endif
+
+void NativeFileSystem::ReadFilesAsync(Span<ReadFileRequest> requests)
+{
+    if (!AsyncIo::SubmitUringReads(requests, this, this->m_blobHeap, this->m_memoryMapThreshold))
+    {
+        IFileSystem::ReadFilesAsync(requests);
+    }
+}
+
+std::unique_ptr<IBlob> NativeFileSystem::ReadFileCopy(std::filesystem::path const& name)
 {
     std::ifstream file(name, std::ios::binary);
 
@@ -120,7 +571,9 @@ std::unique_ptr<IBlob> NativeFileSystem::ReadFile(std::filesystem::path const& n
         return nullptr;
     }
 
-    char* Data = static_cast<char*>(malloc(size));
+    char* Data = this->m_blobHeap
+        ? static_cast<char*>(this->m_blobHeap->Allocate(size))
+        : static_cast<char*>(malloc(size));
 
     if (Data == nullptr)
     {
@@ -128,36 +581,61 @@ std::unique_ptr<IBlob> NativeFileSystem::ReadFile(std::filesystem::path const& n
         return nullptr;
     }
 
+    std::unique_ptr<Blob> blob = std::make_unique<Blob>(Data, size, this->m_blobHeap);
     file.read(Data, size);
 
     if (!file.good())
     {
         PHX_CORE_ERROR("Reading error");
-        free(Data);
         return nullptr;
     }
 
-    return std::make_unique<Blob>(Data, size);
+    return blob;
 }
 
 bool NativeFileSystem::WriteFile(std::filesystem::path const& name, Span<char> Data)
 {
-    std::ofstream file(name, std::ios::binary);
+    // Write beside the target and rename over it, so a crash mid write leaves the old file intact
+    // and readers never see a partial one.
+    static std::atomic<uint64_t> tempCounter = 0;
+#ifdef PHX_PLATFORM_WINDOWS
+    const uint64_t processId = GetCurrentProcessId();
+#else
+    const uint64_t processId = static_cast<uint64_t>(getpid());
+#endif
+    std::filesystem::path tempPath = name;
+    tempPath += "." + std::to_string(processId) + "." + std::to_string(tempCounter.fetch_add(1)) + ".tmp";
 
-    if (!file.is_open())
     {
-        PHX_CORE_ERROR("File does not exist or is locked");
-        return false;
-    }
+        std::ofstream file(tempPath, std::ios::binary);
 
-    if (Data.Size() > 0)
-    {
-        file.write(Data.begin(), static_cast<std::streamsize>(Data.Size()));
+        if (!file.is_open())
+        {
+            PHX_CORE_ERROR("File does not exist or is locked");
+            return false;
+        }
+
+        if (Data.Size() > 0)
+        {
+            file.write(Data.begin(), static_cast<std::streamsize>(Data.Size()));
+        }
+
+        file.close();
+        if (!file.good())
+        {
+            PHX_CORE_ERROR("Failed to write file.");
+            std::error_code ec;
+            std::filesystem::remove(tempPath, ec);
+            return false;
+        }
     }
 
-    if (!file.good())
+    std::error_code ec;
+    std::filesystem::rename(tempPath, name, ec);
+    if (ec)
     {
-        PHX_CORE_ERROR("Failed to write file.");
+        PHX_CORE_ERROR("Failed to replace {}: {}", name.generic_string(), ec.message());
+        std::filesystem::remove(tempPath, ec);
         return false;
     }
 
@@ -190,32 +668,105 @@ bool RelativeFileSystem::WriteFile(std::filesystem::path const& name, Span<char>
     return this->m_underlyingFS->WriteFile(this->m_basePath / name.relative_path(), Data);
 }
 
+std::unique_ptr<IBlob> RelativeFileSystem::MapFile(std::filesystem::path const& name, MapAdvice advice)
+{
+    return this->m_underlyingFS->MapFile(this->m_basePath / name.relative_path(), advice);
+}
+
+bool RelativeFileSystem::ReadFileRange(std::filesystem::path const& name, uint64_t offset, size_t size, void* destination)
+{
+    return this->m_underlyingFS->ReadFileRange(this->m_basePath / name.relative_path(), offset, size, destination);
+}
+
+bool RelativeFileSystem::GetLastWriteTime(std::filesystem::path const& name, std::filesystem::file_time_type& outTime)
+{
+    return this->m_underlyingFS->GetLastWriteTime(this->m_basePath / name.relative_path(), outTime);
+}
+
+bool RelativeFileSystem::RemoveFile(std::filesystem::path const& name)
+{
+    return this->m_underlyingFS->RemoveFile(this->m_basePath / name.relative_path());
+}
+
+FileWatchHandle RelativeFileSystem::WatchDirectory(std::filesystem::path const& directory, FileChangeCallback&& onChange)
+{
+    return this->m_underlyingFS->WatchDirectory(
+        this->m_basePath / directory.relative_path(),
+        [basePath = this->m_basePath, onChange = std::move(onChange)](Span<FileChangeEvent> changes)
+        {
+            std::vector<FileChangeEvent> relative(changes.begin(), changes.end());
+            for (FileChangeEvent& change : relative)
+            {
+                change.Path = change.Path.lexically_relative(basePath);
+            }
+
+            onChange(Span<FileChangeEvent>(relative.data(), relative.size()));
+        });
+}
+
+void RelativeFileSystem::Unwatch(FileWatchHandle handle)
+{
+    this->m_underlyingFS->Unwatch(handle);
+}
+
+void RelativeFileSystem::ReadFilesAsync(Span<ReadFileRequest> requests)
+{
+    std::vector<ReadFileRequest> forwarded(requests.begin(), requests.end());
+    for (ReadFileRequest& request : forwarded)
+    {
+        request.Path = this->m_basePath / request.Path.relative_path();
+    }
+
+    this->m_underlyingFS->ReadFilesAsync(forwarded);
+}
+
 void RootFileSystem::Mount(const std::filesystem::path& path, std::shared_ptr<IFileSystem> fs)
 {
     if (this->FindMountPoint(path, nullptr, nullptr))
     {
-        PHX_CORE_ERROR("Cannot mount a filesystem at %s: there is another FS that includes this path", path.generic_string().c_str());
+        PHX_CORE_ERROR("Cannot mount a filesystem at {}: there is another FS that includes this path", path.generic_string().c_str());
 
         return;
     }
 
-    this->m_mountPoints.push_back(std::make_pair(path.lexically_normal().generic_string(), fs));
+    std::string prefix = path.lexically_normal().generic_string();
+    if (prefix.size() > 1 && prefix.back() == '/')
+    {
+        prefix.pop_back();
+    }
+
+    const uint64_t prefixHash = fnv1a_64(prefix.data(), prefix.size());
+    if (this->m_mountLookup.contains(prefixHash))
+    {
+        PHX_CORE_ERROR("Cannot mount a filesystem at {}: mount point hash collides with another", prefix);
+
+        return;
+    }
+
+    this->m_mountLookup.emplace(prefixHash, static_cast<uint32_t>(this->m_mountPoints.size()));
+    this->m_mountPoints.push_back({ .Prefix = std::move(prefix), .PrefixHash = prefixHash, .FS = std::move(fs) });
 }
 
 void RootFileSystem::Mount(const std::filesystem::path& path, const std::filesystem::path& nativePath)
 {
-    this->Mount(path, std::make_shared<RelativeFileSystem>(std::make_shared<NativeFileSystem>(), nativePath));
+    // Files read through native mounts are loaded assets, keep them on the engine heap once it's up.
+    this->Mount(path, std::make_shared<RelativeFileSystem>(std::make_shared<NativeFileSystem>(Memory::GetHeapIfInitialized()), nativePath));
 }
 
 bool RootFileSystem::Unmount(const std::filesystem::path& path)
 {
     std::string spath = path.lexically_normal().generic_string();
+    if (spath.size() > 1 && spath.back() == '/')
+    {
+        spath.pop_back();
+    }
 
     for (size_t index = 0; index < this->m_mountPoints.size(); index++)
     {
-        if (this->m_mountPoints[index].first == spath)
+        if (this->m_mountPoints[index].Prefix == spath)
         {
             this->m_mountPoints.erase(this->m_mountPoints.begin() + index);
+            this->RebuildMountLookup();
             return true;
         }
     }
@@ -275,37 +826,210 @@ bool RootFileSystem::WriteFile(std::filesystem::path const& name, Span<char> Dat
     return false;
 }
 
-bool RootFileSystem::FindMountPoint(const std::filesystem::path& path, std::filesystem::path* pRelativePath, IFileSystem** ppFS)
+std::unique_ptr<IBlob> RootFileSystem::MapFile(std::filesystem::path const& name, MapAdvice advice)
 {
-    std::string spath = path.lexically_normal().generic_string();
+    std::filesystem::path relativePath;
+    IFileSystem* fs = nullptr;
+
+    if (this->FindMountPoint(name, &relativePath, &fs))
+    {
+        return fs->MapFile(relativePath, advice);
+    }
+
+    return nullptr;
+}
+
+bool RootFileSystem::ReadFileRange(std::filesystem::path const& name, uint64_t offset, size_t size, void* destination)
+{
+    std::filesystem::path relativePath;
+    IFileSystem* fs = nullptr;
+
+    if (this->FindMountPoint(name, &relativePath, &fs))
+    {
+        return fs->ReadFileRange(relativePath, offset, size, destination);
+    }
+
+    return false;
+}
+
+bool RootFileSystem::GetLastWriteTime(std::filesystem::path const& name, std::filesystem::file_time_type& outTime)
+{
+    std::filesystem::path relativePath;
+    IFileSystem* fs = nullptr;
+
+    if (this->FindMountPoint(name, &relativePath, &fs))
+    {
+        return fs->GetLastWriteTime(relativePath, outTime);
+    }
+
+    return false;
+}
+
+bool RootFileSystem::RemoveFile(std::filesystem::path const& name)
+{
+    std::filesystem::path relativePath;
+    IFileSystem* fs = nullptr;
+
+    if (this->FindMountPoint(name, &relativePath, &fs))
+    {
+        return fs->RemoveFile(relativePath);
+    }
+
+    return false;
+}
+
+FileWatchHandle RootFileSystem::WatchDirectory(std::filesystem::path const& directory, FileChangeCallback&& onChange)
+{
+    std::filesystem::path relativePath;
+    IFileSystem* fs = nullptr;
+    const MountPoint* mount = nullptr;
 
-    for (auto it : this->m_mountPoints)
+    if (!this->FindMountPoint(directory, &relativePath, &fs, &mount))
     {
-        if (spath.find(it.first, 0) == 0 && ((spath.length() == it.first.length()) || (spath[it.first.length()] == '/')))
+        return kInvalidFileWatch;
+    }
+
+    const FileWatchHandle handle = fs->WatchDirectory(
+        relativePath,
+        [mountPath = std::filesystem::path(mount->Prefix), onChange = std::move(onChange)](Span<FileChangeEvent> changes)
         {
-            if (pRelativePath)
+            std::vector<FileChangeEvent> mounted(changes.begin(), changes.end());
+            for (FileChangeEvent& change : mounted)
             {
-                std::string relative = spath.substr(it.first.size() + 1);
-                *pRelativePath = relative;
+                change.Path = mountPath / change.Path;
             }
 
-            if (ppFS)
+            onChange(Span<FileChangeEvent>(mounted.data(), mounted.size()));
+        });
+
+    if (handle != kInvalidFileWatch)
+    {
+        this->m_watches.emplace(handle, mount->FS);
+    }
+
+    return handle;
+}
+
+void RootFileSystem::Unwatch(FileWatchHandle handle)
+{
+    auto it = this->m_watches.find(handle);
+    if (it != this->m_watches.end())
+    {
+        it->second->Unwatch(handle);
+        this->m_watches.erase(it);
+    }
+}
+
+void RootFileSystem::ReadFilesAsync(Span<ReadFileRequest> requests)
+{
+    // Keep each mount's requests together so they reach its backend as one batch.
+    std::vector<std::pair<IFileSystem*, std::vector<ReadFileRequest>>> batches;
+    for (const ReadFileRequest& request : requests)
+    {
+        std::filesystem::path relativePath;
+        IFileSystem* fs = nullptr;
+
+        if (!this->FindMountPoint(request.Path, &relativePath, &fs))
+        {
+            if (request.OnComplete)
             {
-                *ppFS = it.second.get();
+                request.OnComplete(nullptr);
             }
+            continue;
+        }
 
-            return true;
+        auto batch = std::find_if(batches.begin(), batches.end(), [fs](auto const& b) { return b.first == fs; });
+        if (batch == batches.end())
+        {
+            batch = batches.emplace(batches.end(), fs, std::vector<ReadFileRequest>());
         }
+
+        batch->second.push_back({
+            .Path = std::move(relativePath),
+            .OnComplete = request.OnComplete,
+            .Priority = request.Priority });
     }
 
-    return false;
+    for (auto& [fs, batch] : batches)
+    {
+        fs->ReadFilesAsync(batch);
+    }
+}
+
+bool RootFileSystem::FindMountPoint(const std::filesystem::path& path, std::filesystem::path* pRelativePath, IFileSystem** ppFS, const MountPoint** ppMount)
+{
+    if (this->m_mountPoints.empty())
+    {
+        return false;
+    }
+
+    thread_local std::string scratch;
+    const std::string_view spath = GetNormalGenericView(path, scratch);
+
+    // Hash the path one segment at a time, probing at each separator. A mount added above an
+    // existing one is allowed, the deepest match wins so the existing one stays reachable.
+    const MountPoint* match = nullptr;
+    uint64_t hash = kFnv1a64Basis;
+    size_t hashed = 0;
+    for (size_t i = 1; i <= spath.size(); i++)
+    {
+        if (i < spath.size() && spath[i] != '/')
+        {
+            continue;
+        }
+
+        hash = fnv1a_64(spath.data() + hashed, i - hashed, hash);
+        hashed = i;
+
+        auto it = this->m_mountLookup.find(hash);
+        if (it != this->m_mountLookup.end())
+        {
+            const MountPoint& mount = this->m_mountPoints[it->second];
+            if (spath.substr(0, i) == mount.Prefix)
+            {
+                match = &mount;
+            }
+        }
+    }
+
+    if (!match)
+    {
+        return false;
+    }
+
+    if (pRelativePath)
+    {
+        const size_t relativeStart = std::min(match->Prefix.size() + 1, spath.size());
+        *pRelativePath = spath.substr(relativeStart);
+    }
+
+    if (ppFS)
+    {
+        *ppFS = match->FS.get();
+    }
+
+    if (ppMount)
+    {
+        *ppMount = match;
+    }
+
+    return true;
+}
+
+void RootFileSystem::RebuildMountLookup()
+{
+    this->m_mountLookup.clear();
+    for (size_t index = 0; index < this->m_mountPoints.size(); index++)
+    {
+        this->m_mountLookup.emplace(this->m_mountPoints[index].PrefixHash, static_cast<uint32_t>(index));
+    }
 }
 
 namespace phx::FileSystemFactory
 {
-    std::unique_ptr<IFileSystem> CreateNativeFileSystem()
+    std::unique_ptr<IFileSystem> CreateNativeFileSystem(TlsfAllocator* blobHeap, size_t memoryMapThreshold)
     {
-        return std::make_unique<NativeFileSystem>();
+        return std::make_unique<NativeFileSystem>(blobHeap, memoryMapThreshold);
     }
 
     std::unique_ptr<IFileSystem> CreateRelativeFileSystem(std::shared_ptr<IFileSystem> fs, const std::filesystem::path& basePath)
@@ -322,6 +1046,11 @@ namespace phx::FileSystemFactory
     {
         return std::make_unique<Blob>(Data, size);
     }
+
+    std::unique_ptr<IBlob> CreateBlob(void* Data, size_t size, TlsfAllocator* heap)
+    {
+        return std::make_unique<Blob>(Data, size, heap);
+    }
 }
 
 namespace phx::FS
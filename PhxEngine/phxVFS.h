@@ -2,16 +2,20 @@
 
 #pragma once
 
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <filesystem>
 #include <functional>
+#include <future>
 #include <vector>
 
 #include "phxSpan.h"
 
 namespace phx
 {
+	class TlsfAllocator;
+
 	class IBlob
 	{
 	public:
@@ -26,6 +30,57 @@ namespace phx
 		}
 	};
 
+	// Access pattern hint for memory mapped files.
+	enum class MapAdvice : uint8_t
+	{
+		Normal,
+		Sequential,	// Read front to back, lets the OS read ahead aggressively.
+		WillNeed,	// Start paging the whole file in straight away.
+	};
+
+	enum class IoPriority : uint8_t
+	{
+		High = 0,
+		Normal,
+		Low,
+		Count
+	};
+
+	// Runs on an I/O thread, keep it short and hand heavy work off. Blob is null if the read failed.
+	using ReadFileCallback = std::function<void(std::unique_ptr<IBlob> blob)>;
+
+	struct ReadFileRequest
+	{
+		std::filesystem::path Path;
+		ReadFileCallback OnComplete;
+		IoPriority Priority = IoPriority::Normal;
+	};
+
+	// Runs on the writer thread, success is false if the file couldn't be written.
+	using WriteFileCallback = std::function<void(bool success)>;
+
+	enum class FileChangeType : uint8_t
+	{
+		Added,
+		Modified,
+		Removed,
+		// Changes were dropped, anything under Path may have changed. Path is the watched directory, or a
+		// directory below it that was moved or deleted.
+		Rescan,
+	};
+
+	struct FileChangeEvent
+	{
+		std::filesystem::path Path;
+		FileChangeType Type;
+	};
+
+	// Runs on the watcher thread with every change from one burst, each file listed once.
+	using FileChangeCallback = std::function<void(Span<FileChangeEvent> changes)>;
+
+	using FileWatchHandle = uint64_t;
+	constexpr FileWatchHandle kInvalidFileWatch = 0;
+
 	class IFileSystem
 	{
 	public:
@@ -35,6 +90,63 @@ namespace phx
 		virtual bool FolderExists(std::filesystem::path const& name) = 0;
 		virtual std::unique_ptr<IBlob> ReadFile(std::filesystem::path const& name) = 0;
 		virtual bool WriteFile(std::filesystem::path const& name, Span<char> Data) = 0;
+
+		// Maps the file rather than copying it. File systems that can't map fall back to ReadFile.
+		virtual std::unique_ptr<IBlob> MapFile(std::filesystem::path const& name, MapAdvice advice = MapAdvice::Normal)
+		{
+			(void)advice;
+			return this->ReadFile(name);
+		}
+
+		// Reads size bytes starting at offset into destination. Fails if the file is shorter than
+		// offset + size. The default reads the whole file and copies the range out.
+		virtual bool ReadFileRange(std::filesystem::path const& name, uint64_t offset, size_t size, void* destination);
+
+		// Queues reads on the I/O threads, the file system must outlive them. The default runs
+		// ReadFile on the shared I/O thread pool.
+		virtual void ReadFilesAsync(Span<ReadFileRequest> requests);
+
+		// False if the file couldn't be removed or the file system is read only.
+		virtual bool RemoveFile(std::filesystem::path const& name)
+		{
+			(void)name;
+			return false;
+		}
+
+		// Reports changes to files anywhere under directory, with paths as this file system names
+		// them. Returns kInvalidFileWatch if the file system can't watch for changes.
+		virtual FileWatchHandle WatchDirectory(std::filesystem::path const& directory, FileChangeCallback&& onChange)
+		{
+			(void)directory;
+			(void)onChange;
+			return kInvalidFileWatch;
+		}
+
+		// Once this returns the callback is no longer running and won't be called again.
+		virtual void Unwatch(FileWatchHandle handle)
+		{
+			(void)handle;
+		}
+
+		// False when the file doesn't exist or the file system doesn't track modification times.
+		virtual bool GetLastWriteTime(std::filesystem::path const& name, std::filesystem::file_time_type& outTime)
+		{
+			(void)name;
+			(void)outTime;
+			return false;
+		}
+
+		std::future<std::unique_ptr<IBlob>> ReadFileAsync(std::filesystem::path const& name, IoPriority priority = IoPriority::Normal);
+		void ReadFileAsync(std::filesystem::path const& name, ReadFileCallback&& onComplete, IoPriority priority = IoPriority::Normal);
+
+		// Queues the write on the background writer and returns straight away. Writes to a file that
+		// are still queued are merged, only the latest data is written and every callback is told the
+		// result. The file system must outlive its queued writes, FlushWrites before destroying it.
+		void WriteFileAsync(std::filesystem::path const& name, std::vector<char>&& data, WriteFileCallback&& onComplete = {});
+
+		// Blocks until every write queued through this file system so far has finished. Don't call
+		// it from a write callback.
+		void FlushWrites();
 	};
 
 	class IRootFileSystem : public IFileSystem
@@ -49,10 +161,19 @@ namespace phx
 
 	namespace FileSystemFactory
 	{
-		std::unique_ptr<IFileSystem> CreateNativeFileSystem();
+		// Files at or above this size are memory mapped by ReadFile instead of copied.
+		constexpr size_t kDefaultMemoryMapThreshold = 4ull << 20;
+
+		// When a heap is provided, file data is allocated from it rather than malloc.
+		// Pass SIZE_MAX as the threshold to only map files through MapFile.
+		std::unique_ptr<IFileSystem> CreateNativeFileSystem(TlsfAllocator* blobHeap = nullptr, size_t memoryMapThreshold = kDefaultMemoryMapThreshold);
 		std::unique_ptr<IFileSystem> CreateRelativeFileSystem(std::shared_ptr<IFileSystem> fs, const std::filesystem::path& baseBath);
 		std::unique_ptr<IRootFileSystem> CreateRootFileSystem();
+		// Read only view of a package written by PackageBuilder, mount it through IRootFileSystem.
+		std::unique_ptr<IFileSystem> CreatePackageFileSystem(const std::filesystem::path& packagePath);
 		std::unique_ptr<IBlob> CreateBlob(void* Data, size_t size);
+		// Takes ownership of Data, which must have been allocated from heap.
+		std::unique_ptr<IBlob> CreateBlob(void* Data, size_t size, TlsfAllocator* heap);
 	}
 
 	namespace FS
@@ -0,0 +1,163 @@
+#include "phxTest.h"
+
+#include <phxAssetFile.h>
+#include <phxLog.h>
+#include <phxMemory.h>
+#include <phxVFS.h>
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <vector>
+
+using namespace phx;
+using namespace phx::assets;
+
+namespace
+{
+	std::filesystem::path GetTestDirectory()
+	{
+		return std::filesystem::temp_directory_path() / "PhxAssetFileTests";
+	}
+
+	std::string GetTestPath(const char* name)
+	{
+		return (GetTestDirectory() / name).string();
+	}
+
+	AssetFile MakeAssetFile()
+	{
+		AssetFile assetFile;
+		assetFile.ID = MAKE_ID('T', 'E', 'S', 'T');
+		assetFile.Version = 3;
+		assetFile.Json = R"({ "name": "crate", "lods": 2 })";
+		assetFile.Sections.push_back(std::vector<char>(1000, 'a'));
+		assetFile.Sections.push_back({});
+		assetFile.Sections.push_back(std::vector<char>(4097, 'c'));
+		return assetFile;
+	}
+
+	std::vector<char> ReadBytes(std::string const& path)
+	{
+		std::ifstream file(path, std::ios::binary);
+		return std::vector<char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	}
+
+	void WriteBytes(std::string const& path, std::vector<char> const& bytes)
+	{
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		file.write(bytes.data(), bytes.size());
+	}
+
+	void TestRoundTrip()
+	{
+		std::unique_ptr<IFileSystem> fs = FileSystemFactory::CreateNativeFileSystem();
+		const AssetFile original = MakeAssetFile();
+		const std::string path = GetTestPath("roundtrip.phxasset");
+		PHX_CHECK(SaveBinaryFile(fs.get(), path.c_str(), original));
+
+		AssetFileView view;
+		PHX_CHECK(LoadBinaryFile(fs.get(), path.c_str(), view));
+		PHX_CHECK(view.IsValid());
+		PHX_CHECK(view.GetID() == original.ID && view.GetVersion() == original.Version);
+		PHX_CHECK(view.GetJson() == original.Json);
+		PHX_CHECK(view.GetJson().data()[view.GetJson().size()] == '\0');
+
+		PHX_CHECK(view.GetNumSections() == original.Sections.size());
+		for (size_t i = 0; i < original.Sections.size(); i++)
+		{
+			Span<char> section = view.GetSection(i);
+			PHX_CHECK(section.Size() == original.Sections[i].size());
+			PHX_CHECK(std::equal(section.begin(), section.end(), original.Sections[i].begin()));
+			PHX_CHECK(reinterpret_cast<uintptr_t>(section.begin()) % FileFormat::kSectionAlignment == 0);
+		}
+
+		// The view keeps the mapping alive after being moved.
+		AssetFileView moved = std::move(view);
+		PHX_CHECK(!view.IsValid() && moved.IsValid() && moved.GetJson() == original.Json);
+	}
+
+	// Saves a valid file, lets corrupt edit its header and checks the load is rejected.
+	bool LoadsCorrupted(const char* name, std::function<void(FileFormat::FileHeader& header, std::vector<char>& bytes)> const& corrupt)
+	{
+		std::unique_ptr<IFileSystem> fs = FileSystemFactory::CreateNativeFileSystem();
+		const std::string path = GetTestPath(name);
+		PHX_CHECK(SaveBinaryFile(fs.get(), path.c_str(), MakeAssetFile()));
+
+		std::vector<char> bytes = ReadBytes(path);
+		FileFormat::FileHeader header;
+		std::memcpy(&header, bytes.data(), sizeof(header));
+		corrupt(header, bytes);
+		std::memcpy(bytes.data(), &header, sizeof(header));
+		WriteBytes(path, bytes);
+
+		AssetFileView view;
+		const bool loaded = LoadBinaryFile(fs.get(), path.c_str(), view);
+		PHX_CHECK(loaded == view.IsValid());
+		return loaded;
+	}
+
+	void TestRejectsCorruptLayouts()
+	{
+		using FileFormat::FileHeader;
+
+		// Unmodified files load, so the rejections below come from the corruption.
+		PHX_CHECK(LoadsCorrupted("valid.phxasset", [](FileHeader&, std::vector<char>&) {}));
+
+		// JsonSize + 1 wraps to zero, which passed the old range check.
+		PHX_CHECK(!LoadsCorrupted("jsonsizemax.phxasset", [](FileHeader& h, std::vector<char>&) { h.JsonSize = UINT64_MAX; }));
+		PHX_CHECK(!LoadsCorrupted("jsonsizewrap.phxasset", [](FileHeader& h, std::vector<char>&) { h.JsonSize = UINT64_MAX - h.JsonOffset; }));
+		PHX_CHECK(!LoadsCorrupted("jsonoffset.phxasset", [](FileHeader& h, std::vector<char>&) { h.JsonOffset = h.FileSize + 1; }));
+		PHX_CHECK(!LoadsCorrupted("jsonoffsetmax.phxasset", [](FileHeader& h, std::vector<char>&) { h.JsonOffset = UINT64_MAX; h.JsonSize = 1; }));
+
+		// Json running exactly to the end of the file leaves no room for the terminator.
+		PHX_CHECK(!LoadsCorrupted("jsonatend.phxasset", [](FileHeader& h, std::vector<char>&) { h.JsonSize = h.FileSize - h.JsonOffset; }));
+		PHX_CHECK(!LoadsCorrupted("unterminated.phxasset", [](FileHeader& h, std::vector<char>& bytes) { bytes[h.JsonOffset + h.JsonSize] = 'x'; }));
+
+		PHX_CHECK(!LoadsCorrupted("magic.phxasset", [](FileHeader& h, std::vector<char>&) { h.Magic = 0; }));
+		PHX_CHECK(!LoadsCorrupted("filesize.phxasset", [](FileHeader& h, std::vector<char>&) { h.FileSize++; }));
+		PHX_CHECK(!LoadsCorrupted("numsections.phxasset", [](FileHeader& h, std::vector<char>&) { h.NumSections = UINT32_MAX; }));
+		PHX_CHECK(!LoadsCorrupted("section.phxasset", [](FileHeader& h, std::vector<char>& bytes)
+			{
+				FileFormat::SectionEntry entry = { .Offset = h.FileSize - 8, .Size = 16 };
+				std::memcpy(bytes.data() + h.SectionTableOffset, &entry, sizeof(entry));
+			}));
+	}
+
+	void TestRejectsTruncatedFiles()
+	{
+		std::unique_ptr<IFileSystem> fs = FileSystemFactory::CreateNativeFileSystem();
+		const std::string path = GetTestPath("truncated.phxasset");
+		WriteBytes(path, std::vector<char>(sizeof(FileFormat::FileHeader) - 1, 0));
+
+		AssetFileView view;
+		PHX_CHECK(!LoadBinaryFile(fs.get(), path.c_str(), view));
+		PHX_CHECK(!LoadBinaryFile(fs.get(), GetTestPath("missing.phxasset").c_str(), view));
+	}
+}
+
+int main()
+{
+	Log::Initialize();
+
+	Memory::MemoryConfiguration config = {};
+	config.VirtualMemorySize = 8_GiB;
+	config.HeapReserveSize = 64_MiB;
+	config.HeapCommitGranularity = 1_MiB;
+	Memory::Initialize(config);
+
+	std::filesystem::create_directories(GetTestDirectory());
+
+	Test::Run("RoundTrip", TestRoundTrip);
+	Test::Run("RejectsCorruptLayouts", TestRejectsCorruptLayouts);
+	Test::Run("RejectsTruncatedFiles", TestRejectsTruncatedFiles);
+
+	std::error_code ec;
+	std::filesystem::remove_all(GetTestDirectory(), ec);
+
+	Memory::Finalize();
+	return Test::Result();
+}
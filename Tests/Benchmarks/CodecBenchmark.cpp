@@ -0,0 +1,284 @@
+// Measures compression ratio and throughput of each codec on archive style regions.
+//
+//   CodecBenchmark [regionMiB] [maxThreads]
+//
+// Builds three regions of regionMiB each: a BC1 and a BC7 texture of smooth colour with noise, and
+// a mesh of interleaved vertices followed by its index buffer. Each codec compresses and then
+// decompresses every region with ParallelFor capped at 1, 2, 4, ... up to maxThreads, the way
+// PhxArchive writes regions and the engine reads them back. Codecs that aren't in the build are
+// skipped. Every round trip is checked against the source.
+
+#include <phxAsyncIo.h>
+#include <phxCodec.h>
+#include <phxLog.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace phx;
+
+namespace
+{
+	constexpr size_t kMiB = size_t(1) << 20;
+	constexpr double kMinSeconds = 0.25;
+
+	struct Dataset
+	{
+		const char* Name;
+		std::vector<char> Data;
+	};
+
+	float Noise(std::mt19937& rng, float scale)
+	{
+		return (static_cast<float>(rng() & 0xffff) / 65535.0f - 0.5f) * scale;
+	}
+
+	// Smooth colour over the texture, in 0..1.
+	float Channel(uint32_t x, uint32_t y, uint32_t channel)
+	{
+		return 0.5f + 0.5f * std::sin(x * (0.011f + channel * 0.004f) + y * (0.007f + channel * 0.003f) + channel);
+	}
+
+	uint16_t ToRgb565(float r, float g, float b)
+	{
+		auto quantize = [](float v, uint32_t max) { return static_cast<uint16_t>(std::clamp(v, 0.0f, 1.0f) * max + 0.5f); };
+		return static_cast<uint16_t>((quantize(r, 31) << 11) | (quantize(g, 63) << 5) | quantize(b, 31));
+	}
+
+	// Endpoints follow the colour of each 4x4 block, indices follow its gradient with some noise.
+	Dataset MakeBc1(size_t size, std::mt19937& rng)
+	{
+		const uint32_t blocksPerRow = 1024;
+		const size_t numBlocks = size / 8;
+
+		Dataset dataset{ .Name = "BC1 texture", .Data = std::vector<char>(numBlocks * 8) };
+		for (size_t i = 0; i < numBlocks; i++)
+		{
+			const uint32_t bx = static_cast<uint32_t>(i % blocksPerRow);
+			const uint32_t by = static_cast<uint32_t>(i / blocksPerRow);
+			const float spread = 0.03f + Noise(rng, 0.04f);
+
+			uint16_t color0 = ToRgb565(Channel(bx, by, 0) + spread, Channel(bx, by, 1) + spread, Channel(bx, by, 2) + spread);
+			uint16_t color1 = ToRgb565(Channel(bx, by, 0) - spread, Channel(bx, by, 1) - spread, Channel(bx, by, 2) - spread);
+			if (color0 < color1)
+			{
+				std::swap(color0, color1);
+			}
+
+			uint32_t indices = 0;
+			for (uint32_t texel = 0; texel < 16; texel++)
+			{
+				// 0 and 1 are the endpoints, 2 and 3 the colours between them.
+				constexpr uint32_t kRamp[] = { 0, 2, 3, 1 };
+				const float t = std::clamp((texel % 4 + texel / 4) / 6.0f + Noise(rng, 0.4f), 0.0f, 0.999f);
+				indices |= kRamp[static_cast<uint32_t>(t * 4)] << (texel * 2);
+			}
+
+			char* block = dataset.Data.data() + i * 8;
+			std::memcpy(block, &color0, 2);
+			std::memcpy(block + 2, &color1, 2);
+			std::memcpy(block + 4, &indices, 4);
+		}
+
+		return dataset;
+	}
+
+	// Mode 6 blocks, RGBA endpoints with 7 bits per channel and a 4 bit index per texel.
+	Dataset MakeBc7(size_t size, std::mt19937& rng)
+	{
+		const uint32_t blocksPerRow = 512;
+		const size_t numBlocks = size / 16;
+
+		Dataset dataset{ .Name = "BC7 texture", .Data = std::vector<char>(numBlocks * 16) };
+		for (size_t i = 0; i < numBlocks; i++)
+		{
+			const uint32_t bx = static_cast<uint32_t>(i % blocksPerRow);
+			const uint32_t by = static_cast<uint32_t>(i / blocksPerRow);
+			const float spread = 0.02f + Noise(rng, 0.03f);
+
+			uint64_t bits[2] = {};
+			uint32_t position = 0;
+			auto write = [&](uint64_t value, uint32_t numBits)
+				{
+					for (uint32_t b = 0; b < numBits; b++, position++)
+					{
+						bits[position / 64] |= ((value >> b) & 1) << (position % 64);
+					}
+				};
+
+			auto quantize = [](float v) { return static_cast<uint64_t>(std::clamp(v, 0.0f, 1.0f) * 127 + 0.5f); };
+
+			write(1 << 6, 7);
+			for (uint32_t channel = 0; channel < 4; channel++)
+			{
+				const float value = channel == 3 ? 1.0f : Channel(bx, by, channel);
+				write(quantize(value - spread), 7);
+				write(quantize(value + spread), 7);
+			}
+			write(rng() & 3, 2);
+
+			for (uint32_t texel = 0; texel < 16; texel++)
+			{
+				const float t = std::clamp((texel % 4 + texel / 4) / 6.0f + Noise(rng, 0.3f), 0.0f, 0.999f);
+				// The anchor texel drops its top bit, which is always 0.
+				write(texel == 0 ? std::min<uint64_t>(static_cast<uint64_t>(t * 16), 7) : static_cast<uint64_t>(t * 16), texel == 0 ? 3 : 4);
+			}
+
+			std::memcpy(dataset.Data.data() + i * 16, bits, 16);
+		}
+
+		return dataset;
+	}
+
+	struct Vertex
+	{
+		float Position[3];
+		float Normal[3];
+		float Tangent[4];
+		float TexCoord[2];
+	};
+
+	// A heightfield grid, the vertices followed by two triangles per quad.
+	Dataset MakeMesh(size_t size)
+	{
+		// Each vertex comes with about six indices.
+		const uint32_t gridSize = static_cast<uint32_t>(std::sqrt(size / (sizeof(Vertex) + 6 * sizeof(uint32_t))));
+		const float step = 1.0f / gridSize;
+
+		std::vector<Vertex> vertices;
+		vertices.reserve(size_t(gridSize) * gridSize);
+		for (uint32_t z = 0; z < gridSize; z++)
+		{
+			for (uint32_t x = 0; x < gridSize; x++)
+			{
+				const float fx = x * step;
+				const float fz = z * step;
+				const float height = 0.1f * std::sin(fx * 17.0f) * std::cos(fz * 13.0f);
+				const float dx = 1.7f * std::cos(fx * 17.0f) * std::cos(fz * 13.0f);
+				const float dz = -1.3f * std::sin(fx * 17.0f) * std::sin(fz * 13.0f);
+				const float length = std::sqrt(dx * dx + 1.0f + dz * dz);
+				const float tangentLength = std::sqrt(1.0f + dx * dx);
+
+				vertices.push_back(Vertex{
+					.Position = { fx * 100.0f, height * 100.0f, fz * 100.0f },
+					.Normal = { -dx / length, 1.0f / length, -dz / length },
+					.Tangent = { 1.0f / tangentLength, dx / tangentLength, 0.0f, 1.0f },
+					.TexCoord = { fx * 8.0f, fz * 8.0f } });
+			}
+		}
+
+		std::vector<uint32_t> indices;
+		indices.reserve(size_t(gridSize - 1) * (gridSize - 1) * 6);
+		for (uint32_t z = 0; z + 1 < gridSize; z++)
+		{
+			for (uint32_t x = 0; x + 1 < gridSize; x++)
+			{
+				const uint32_t i = z * gridSize + x;
+				for (uint32_t index : { i, i + gridSize, i + 1, i + 1, i + gridSize, i + gridSize + 1 })
+				{
+					indices.push_back(index);
+				}
+			}
+		}
+
+		const size_t vertexBytes = vertices.size() * sizeof(Vertex);
+		const size_t indexBytes = indices.size() * sizeof(uint32_t);
+		Dataset dataset{ .Name = "Mesh", .Data = std::vector<char>(vertexBytes + indexBytes) };
+		std::memcpy(dataset.Data.data(), vertices.data(), vertexBytes);
+		std::memcpy(dataset.Data.data() + vertexBytes, indices.data(), indexBytes);
+
+		return dataset;
+	}
+
+	// Runs fn until kMinSeconds have passed, returns MiB/s of size bytes per run.
+	template<typename Fn>
+	double Measure(size_t size, Fn&& fn)
+	{
+		size_t numRuns = 0;
+		double seconds = 0.0;
+		const auto start = std::chrono::steady_clock::now();
+		do
+		{
+			fn();
+			numRuns++;
+			seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		} while (seconds < kMinSeconds);
+
+		return static_cast<double>(size * numRuns) / kMiB / seconds;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	Log::Initialize();
+
+	const size_t regionMiB = argc > 1 ? static_cast<size_t>(std::atoll(argv[1])) : 32;
+	const uint32_t maxThreads = argc > 2
+		? static_cast<uint32_t>(std::atoi(argv[2]))
+		: std::max(std::thread::hardware_concurrency(), 1u);
+
+	std::mt19937 rng(24);
+	std::vector<Dataset> datasets;
+	datasets.push_back(MakeBc1(regionMiB * kMiB, rng));
+	datasets.push_back(MakeBc7(regionMiB * kMiB, rng));
+	datasets.push_back(MakeMesh(regionMiB * kMiB));
+
+	bool roundTripsMatch = true;
+	std::printf("region        codec      ratio   threads   compress MiB/s   decompress MiB/s\n");
+	for (Dataset const& dataset : datasets)
+	{
+		const size_t size = dataset.Data.size();
+		for (Codec::Type codec : { Codec::Type::Lz4, Codec::Type::Zstd, Codec::Type::GDeflate })
+		{
+			if (!Codec::IsAvailable(codec))
+			{
+				std::printf("%-12s  %-8s   not available\n", dataset.Name, Codec::ToString(codec));
+				continue;
+			}
+
+			std::vector<char> compressed(Codec::CompressBound(codec, size));
+			std::vector<char> decompressed(size);
+			size_t compressedSize = 0;
+			for (uint32_t numThreads = 1; numThreads <= maxThreads; numThreads *= 2)
+			{
+				SetMaxParallelForThreads(numThreads);
+				const double compressSpeed = Measure(size, [&]()
+					{
+						compressedSize = Codec::Compress(codec, dataset.Data.data(), size, compressed.data(), compressed.size());
+					});
+
+				bool decompressedOk = compressedSize != 0;
+				const double decompressSpeed = Measure(size, [&]()
+					{
+						decompressedOk &= Codec::Decompress(codec, compressed.data(), compressedSize, decompressed.data(), size);
+					});
+
+				roundTripsMatch &= decompressedOk && decompressed == dataset.Data;
+				std::printf("%-12s  %-8s   %5.2f   %7u   %14.1f   %16.1f\n",
+					dataset.Name,
+					Codec::ToString(codec),
+					compressedSize ? static_cast<double>(size) / compressedSize : 0.0,
+					numThreads,
+					compressSpeed,
+					decompressSpeed);
+			}
+		}
+	}
+	SetMaxParallelForThreads(0);
+
+	if (!roundTripsMatch)
+	{
+		std::printf("A codec failed to round trip a region\n");
+		return 1;
+	}
+
+	return 0;
+}
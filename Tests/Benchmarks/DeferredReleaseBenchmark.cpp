@@ -0,0 +1,195 @@
+// Measures deferred releases from many threads, 100k per frame by default.
+//
+//   DeferredReleaseBenchmark [maxThreads] [releasesPerFrame]
+//
+// Every thread queues its share of a frame's releases, as DeferredReleasePtr does when a resource
+// goes out of scope, then all threads meet at a barrier where the frame that is kFramesInFlight
+// old is collected, as the engine does once its fence has completed. The locked queue is the
+// std::deque of std::function that DeferredDeleteQueue was before, with a mutex added so it can
+// take releases from more than one thread. Heap allocations are counted through global new.
+
+#include <phxLog.h>
+#include <phxDeferredReleaseQueue.h>
+
+#include <atomic>
+#include <barrier>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	std::atomic<size_t> gNumNews = 0;
+}
+
+void* operator new(size_t size)
+{
+	gNumNews.fetch_add(1, std::memory_order_relaxed);
+	if (void* ptr = std::malloc(size ? size : 1))
+	{
+		return ptr;
+	}
+	throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+	std::free(ptr);
+}
+
+using namespace phx;
+
+namespace
+{
+	constexpr uint64_t kFrames = 32;
+	constexpr uint64_t kFramesInFlight = 2;
+
+	struct LockedQueue
+	{
+		struct Item
+		{
+			uint64_t Frame;
+			std::function<void()> DeleteFn;
+		};
+
+		std::mutex Mutex;
+		std::deque<Item> Items;
+
+		void Enqueue(uint64_t frame, uint64_t* numReleased)
+		{
+			std::scoped_lock _(this->Mutex);
+			this->Items.push_back({ frame, [numReleased]() { (*numReleased)++; } });
+		}
+
+		void ReleaseItems(uint64_t completedFrame)
+		{
+			std::scoped_lock _(this->Mutex);
+			while (!this->Items.empty() && this->Items.front().Frame < completedFrame)
+			{
+				this->Items.front().DeleteFn();
+				this->Items.pop_front();
+			}
+		}
+	};
+
+	struct RetirementQueueWrapper
+	{
+		void Enqueue(uint64_t frame, uint64_t* numReleased)
+		{
+			DeferredDeleteQueue::Enqueue({ .Frame = frame, .DeleteFn = [numReleased]() { (*numReleased)++; } });
+		}
+
+		void ReleaseItems(uint64_t completedFrame)
+		{
+			DeferredDeleteQueue::ReleaseItems(completedFrame);
+		}
+	};
+
+	struct Result
+	{
+		double EnqueueMopsPerSec;
+		double CollectMsPerFrame;
+		double NewsPerRelease;
+	};
+
+	template<typename TQueue>
+	Result Measure(uint32_t numThreads, uint64_t releasesPerFrame)
+	{
+		TQueue queue;
+		const uint64_t releasesPerThread = releasesPerFrame / numThreads;
+
+		// Only touched by whoever runs the barrier completion, callbacks run there too.
+		uint64_t numReleased = 0;
+		uint64_t frame = 1;
+		double enqueueSeconds = 0.0;
+		double collectSeconds = 0.0;
+		auto frameStart = std::chrono::steady_clock::now();
+
+		std::barrier frameEnd(numThreads, [&]() noexcept
+			{
+				const auto enqueued = std::chrono::steady_clock::now();
+				enqueueSeconds += std::chrono::duration<double>(enqueued - frameStart).count();
+
+				if (frame > kFramesInFlight)
+				{
+					queue.ReleaseItems(frame - kFramesInFlight);
+				}
+
+				frameStart = std::chrono::steady_clock::now();
+				collectSeconds += std::chrono::duration<double>(frameStart - enqueued).count();
+				frame++;
+			});
+
+		const size_t newsBefore = gNumNews.load();
+		std::vector<std::thread> threads;
+		for (uint32_t t = 0; t < numThreads; t++)
+		{
+			threads.emplace_back([&]()
+				{
+					for (uint64_t f = 0; f < kFrames; f++)
+					{
+						for (uint64_t i = 0; i < releasesPerThread; i++)
+						{
+							queue.Enqueue(frame, &numReleased);
+						}
+						frameEnd.arrive_and_wait();
+					}
+				});
+		}
+
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+		const size_t numNews = gNumNews.load() - newsBefore;
+
+		// Drain the frames still in flight.
+		queue.ReleaseItems(std::numeric_limits<uint64_t>::max());
+		const uint64_t numReleases = kFrames * releasesPerThread * numThreads;
+		if (numReleased != numReleases)
+		{
+			std::printf("Released %llu of %llu items\n", static_cast<unsigned long long>(numReleased), static_cast<unsigned long long>(numReleases));
+			std::exit(1);
+		}
+
+		return Result{
+			.EnqueueMopsPerSec = static_cast<double>(numReleases) / enqueueSeconds / 1e6,
+			.CollectMsPerFrame = collectSeconds * 1e3 / (kFrames - kFramesInFlight),
+			.NewsPerRelease = static_cast<double>(numNews) / numReleases };
+	}
+}
+
+int main(int argc, char** argv)
+{
+	Log::Initialize();
+
+	const uint32_t maxThreads = argc > 1 ? static_cast<uint32_t>(std::atoi(argv[1])) : 8;
+	const uint64_t releasesPerFrame = argc > 2 ? static_cast<uint64_t>(std::atoll(argv[2])) : 100000;
+
+	std::printf("%llu releases per frame\n", static_cast<unsigned long long>(releasesPerFrame));
+	std::printf("                locked deque                     retirement queue\n");
+	std::printf("threads   Mrel/s   collect ms   news/rel   Mrel/s   collect ms   news/rel\n");
+	for (uint32_t numThreads = 1; numThreads <= maxThreads; numThreads *= 2)
+	{
+		const Result locked = Measure<LockedQueue>(numThreads, releasesPerFrame);
+		const Result retirement = Measure<RetirementQueueWrapper>(numThreads, releasesPerFrame);
+		std::printf("%7u   %6.1f   %10.2f   %8.3f   %6.1f   %10.2f   %8.3f\n",
+			numThreads,
+			locked.EnqueueMopsPerSec, locked.CollectMsPerFrame, locked.NewsPerRelease,
+			retirement.EnqueueMopsPerSec, retirement.CollectMsPerFrame, retirement.NewsPerRelease);
+	}
+
+	return 0;
+}
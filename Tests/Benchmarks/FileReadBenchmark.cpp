@@ -0,0 +1,112 @@
+// Compares NativeFileSystem::ReadFile copying a file through ifstream against mapping it.
+//
+//   FileReadBenchmark [maxFileSizeMiB] [MiBPerSize]
+//
+// Writes one file per size from 4 MiB up to maxFileSizeMiB and reads each one repeatedly until
+// MiBPerSize has been read. The copy file system is created with a memoryMapThreshold of SIZE_MAX,
+// so ReadFile always copies, the mapped one uses the default threshold. Every page of the blob is
+// touched so mapped reads pay for their page faults. Files are freshly written and read from the
+// OS cache, this measures the cost of the copy rather than disk throughput.
+
+#include <phxLog.h>
+#include <phxVFS.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace phx;
+
+namespace
+{
+	constexpr size_t kMiB = size_t(1) << 20;
+
+	struct ReadResult
+	{
+		double MiBPerSec = 0.0;
+		uint64_t Checksum = 0;
+	};
+
+	template<typename TRead>
+	ReadResult Measure(size_t fileSize, size_t numReads, TRead&& read)
+	{
+		ReadResult result;
+		const auto start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < numReads; i++)
+		{
+			std::unique_ptr<IBlob> blob = read();
+			if (IBlob::IsEmpty(blob.get()) || blob->Size() != fileSize)
+			{
+				std::printf("Failed to read a %zu byte file\n", fileSize);
+				std::exit(1);
+			}
+
+			const uint8_t* data = static_cast<const uint8_t*>(blob->Data());
+			for (size_t offset = 0; offset < blob->Size(); offset += 4096)
+			{
+				result.Checksum += data[offset];
+			}
+		}
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		result.MiBPerSec = static_cast<double>(fileSize * numReads) / kMiB / seconds;
+
+		return result;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	Log::Initialize();
+
+	const size_t maxFileSizeMiB = argc > 1 ? static_cast<size_t>(std::atoll(argv[1])) : 256;
+	const size_t mibPerSize = argc > 2 ? static_cast<size_t>(std::atoll(argv[2])) : 1024;
+
+	const std::filesystem::path directory = std::filesystem::temp_directory_path() / "PhxFileReadBenchmark";
+	std::error_code ec;
+	std::filesystem::remove_all(directory, ec);
+	std::filesystem::create_directories(directory);
+
+	std::unique_ptr<IFileSystem> copyFs = FileSystemFactory::CreateNativeFileSystem(nullptr, SIZE_MAX);
+	std::unique_ptr<IFileSystem> mapFs = FileSystemFactory::CreateNativeFileSystem();
+
+	std::printf("size MiB   ifstream MiB/s   mmap MiB/s   mmap sequential MiB/s\n");
+	bool checksumsMatch = true;
+	for (size_t fileSizeMiB = 4; fileSizeMiB <= maxFileSizeMiB; fileSizeMiB *= 4)
+	{
+		const size_t fileSize = fileSizeMiB * kMiB;
+		const std::filesystem::path path = directory / (std::to_string(fileSizeMiB) + ".bin");
+		{
+			std::vector<char> contents(fileSize);
+			for (size_t i = 0; i < fileSize; i++)
+			{
+				contents[i] = static_cast<char>(i * 31 + fileSizeMiB);
+			}
+
+			std::ofstream file(path, std::ios::binary | std::ios::trunc);
+			file.write(contents.data(), contents.size());
+		}
+
+		const size_t numReads = std::max<size_t>(1, mibPerSize / fileSizeMiB);
+		const ReadResult copied = Measure(fileSize, numReads, [&]() { return copyFs->ReadFile(path); });
+		const ReadResult mapped = Measure(fileSize, numReads, [&]() { return mapFs->ReadFile(path); });
+		const ReadResult sequential = Measure(fileSize, numReads, [&]() { return mapFs->MapFile(path, MapAdvice::Sequential); });
+		std::printf("%8zu   %14.1f   %10.1f   %21.1f\n", fileSizeMiB, copied.MiBPerSec, mapped.MiBPerSec, sequential.MiBPerSec);
+
+		checksumsMatch &= copied.Checksum == mapped.Checksum && copied.Checksum == sequential.Checksum;
+		std::filesystem::remove(path, ec);
+	}
+
+	if (!checksumsMatch)
+	{
+		std::printf("Checksum mismatch, mapped reads differ from copied ones\n");
+	}
+
+	std::filesystem::remove_all(directory, ec);
+	return checksumsMatch ? 0 : 1;
+}
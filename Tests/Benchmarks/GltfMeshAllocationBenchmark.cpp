@@ -0,0 +1,187 @@
+// Counts the heap allocations phxModelImporterGltf::CompileMesh makes for its transient containers,
+// with std containers on global new and with the pmr containers on scratch memory it uses now.
+//
+//   GltfMeshAllocationBenchmark [numMeshes]
+//
+// PhxArchive still builds against headers that are not in this tree, so the importer can't be
+// linked here. The loop below does the same container work as CompileMesh for a generated scene
+// shaped like Sponza: the primitive list sized from the glTF mesh, and the map from primitive hash
+// to the primitives that share a draw. Vertex and index buffers are allocated the same way either
+// way and are left out.
+
+#include <phxLog.h>
+#include <phxMemory.h>
+#include <phxMemoryResource.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+	std::atomic<size_t> gNumNews = 0;
+}
+
+void* operator new(size_t size)
+{
+	gNumNews.fetch_add(1, std::memory_order_relaxed);
+	if (void* ptr = std::malloc(size ? size : 1))
+	{
+		return ptr;
+	}
+	throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+	std::free(ptr);
+}
+
+using namespace phx;
+
+namespace
+{
+	// Same size and hash as MeshConverter::Primitive.
+	struct Primitive
+	{
+		float Bounds[20];
+		void* VertexBuffer[2];
+		uint32_t VertexBufferSize;
+		void* IndexBuffer[2];
+		uint32_t IndexBufferSize;
+		uint32_t NumVertices;
+		uint32_t NumIndices;
+		uint32_t Hash;
+	};
+
+	struct SourceMesh
+	{
+		std::vector<uint32_t> PrimitiveHashes;
+	};
+
+	std::vector<SourceMesh> BuildScene(size_t numMeshes)
+	{
+		std::mt19937 rng(17);
+		std::vector<SourceMesh> scene(numMeshes);
+		for (SourceMesh& mesh : scene)
+		{
+			// Most meshes have a handful of primitives, a few have dozens.
+			const size_t numPrimitives = rng() % 8 == 0 ? 16 + rng() % 48 : 1 + rng() % 6;
+			for (size_t i = 0; i < numPrimitives; i++)
+			{
+				const uint32_t materialIdx = rng() % 32;
+				const uint32_t psoFlags = rng() % 4;
+				mesh.PrimitiveHashes.push_back(psoFlags | (materialIdx << 17));
+			}
+		}
+		return scene;
+	}
+
+	// The transient half of CompileMesh, on whatever the containers allocate from.
+	template<typename TPrimitives, typename TRenderMeshes>
+	size_t GroupPrimitives(SourceMesh const& srcMesh, TPrimitives& primitives, TRenderMeshes& renderMeshes)
+	{
+		for (size_t i = 0; i < srcMesh.PrimitiveHashes.size(); i++)
+		{
+			primitives[i].Hash = srcMesh.PrimitiveHashes[i];
+			primitives[i].VertexBufferSize = static_cast<uint32_t>(i * 64);
+			primitives[i].IndexBufferSize = static_cast<uint32_t>(i * 12);
+		}
+
+		size_t totalSize = 0;
+		for (auto& prim : primitives)
+		{
+			renderMeshes[prim.Hash].push_back(&prim);
+			totalSize += prim.VertexBufferSize + prim.IndexBufferSize;
+		}
+
+		for (auto& [hash, drawables] : renderMeshes)
+		{
+			totalSize += drawables.size();
+		}
+		return totalSize;
+	}
+
+	size_t CompileWithStd(SourceMesh const& srcMesh)
+	{
+		std::vector<Primitive> primitives(srcMesh.PrimitiveHashes.size());
+		std::unordered_map<uint32_t, std::vector<Primitive*>> renderMeshes;
+		return GroupPrimitives(srcMesh, primitives, renderMeshes);
+	}
+
+	size_t CompileWithScratch(SourceMesh const& srcMesh)
+	{
+		ScopedScratchMemoryResource scratch;
+		pmr::Vector<Primitive> primitives(srcMesh.PrimitiveHashes.size(), &scratch);
+		pmr::UnorderedMap<uint32_t, pmr::Vector<Primitive*>> renderMeshes(&scratch);
+		return GroupPrimitives(srcMesh, primitives, renderMeshes);
+	}
+
+	struct Result
+	{
+		size_t NumNews;
+		double Milliseconds;
+		size_t Checksum;
+	};
+
+	template<typename TFunc>
+	Result Run(std::vector<SourceMesh> const& scene, TFunc&& compileMesh)
+	{
+		Result result = {};
+		const size_t newsBefore = gNumNews.load();
+		const auto start = std::chrono::steady_clock::now();
+		for (SourceMesh const& mesh : scene)
+		{
+			result.Checksum += compileMesh(mesh);
+		}
+		result.Milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		result.NumNews = gNumNews.load() - newsBefore;
+		return result;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	Log::Initialize();
+
+	Memory::MemoryConfiguration config = {};
+	config.VirtualMemorySize = 8_GiB;
+	config.HeapReserveSize = 64_MiB;
+	config.HeapCommitGranularity = 1_MiB;
+	Memory::Initialize(config);
+
+	const size_t numMeshes = argc > 1 ? static_cast<size_t>(std::atoll(argv[1])) : 10000;
+	const std::vector<SourceMesh> scene = BuildScene(numMeshes);
+
+	size_t numPrimitives = 0;
+	for (SourceMesh const& mesh : scene)
+	{
+		numPrimitives += mesh.PrimitiveHashes.size();
+	}
+
+	const Result withStd = Run(scene, CompileWithStd);
+	const Result withScratch = Run(scene, CompileWithScratch);
+	if (withStd.Checksum != withScratch.Checksum)
+	{
+		std::printf("Checksum mismatch\n");
+		return 1;
+	}
+
+	std::printf("%zu meshes, %zu primitives\n", numMeshes, numPrimitives);
+	std::printf("containers   allocations   per mesh        ms\n");
+	std::printf("std          %11zu   %8.2f   %7.2f\n", withStd.NumNews, static_cast<double>(withStd.NumNews) / numMeshes, withStd.Milliseconds);
+	std::printf("scratch      %11zu   %8.2f   %7.2f\n", withScratch.NumNews, static_cast<double>(withScratch.NumNews) / numMeshes, withScratch.Milliseconds);
+
+	Memory::Finalize();
+	return 0;
+}
@@ -0,0 +1,140 @@
+// Measures how resource registration scales with the number of threads registering at once.
+//
+//   HandlePoolBenchmark [maxThreads]
+//
+// Every thread runs the create / lookup / delete pattern of a streaming loader: it keeps a small
+// window of live handles, emplacing a new entry, looking up a few live ones and releasing the
+// oldest. HandlePool behind a mutex is what callers needed before ConcurrentHandlePool.
+
+#include <phxLog.h>
+#include <EmberGfx/phxHandlePool.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace phx;
+using namespace phx::gfx;
+
+namespace
+{
+	struct Entry
+	{
+		uint64_t NativePtr = 0;
+		uint32_t BindlessIndex = 0;
+	};
+
+	constexpr size_t kOpsPerThread = 1 << 20;
+	constexpr size_t kWindowSize = 64;
+
+	struct LockedPool
+	{
+		HandlePool<Entry, Entry> Pool;
+		std::mutex Mutex;
+
+		Handle<Entry> Emplace(uint64_t value)
+		{
+			std::scoped_lock _(this->Mutex);
+			return this->Pool.Emplace(Entry{ .NativePtr = value });
+		}
+
+		Entry* Get(Handle<Entry> handle)
+		{
+			std::scoped_lock _(this->Mutex);
+			return this->Pool.Get(handle);
+		}
+
+		void Release(Handle<Entry> handle)
+		{
+			std::scoped_lock _(this->Mutex);
+			this->Pool.Release(handle);
+		}
+	};
+
+	struct LockFreePool
+	{
+		ConcurrentHandlePool<Entry, Entry> Pool;
+
+		Handle<Entry> Emplace(uint64_t value) { return this->Pool.Emplace(Entry{ .NativePtr = value }); }
+		Entry* Get(Handle<Entry> handle) { return this->Pool.Get(handle); }
+		void Release(Handle<Entry> handle) { this->Pool.Release(handle); }
+	};
+
+	template<typename TPool>
+	void Churn(TPool& pool, uint64_t& checksum)
+	{
+		std::vector<Handle<Entry>> window(kWindowSize);
+		for (size_t i = 0; i < kWindowSize; i++)
+		{
+			window[i] = pool.Emplace(i);
+		}
+
+		uint64_t sum = 0;
+		for (size_t i = 0; i < kOpsPerThread; i++)
+		{
+			const size_t oldest = i % kWindowSize;
+			pool.Release(window[oldest]);
+			window[oldest] = pool.Emplace(i);
+
+			// A few lookups per registration, as binding a resource would.
+			for (size_t j = 1; j <= 4; j++)
+			{
+				Entry* entry = pool.Get(window[(oldest + j * 7) % kWindowSize]);
+				sum += entry ? entry->NativePtr : 0;
+			}
+		}
+
+		for (Handle<Entry> handle : window)
+		{
+			pool.Release(handle);
+		}
+
+		checksum = sum;
+	}
+
+	template<typename TPool>
+	double MeasureMopsPerSec(uint32_t numThreads)
+	{
+		TPool pool;
+		std::vector<uint64_t> checksums(numThreads);
+		std::vector<std::thread> threads;
+
+		const auto start = std::chrono::steady_clock::now();
+		for (uint32_t t = 0; t < numThreads; t++)
+		{
+			threads.emplace_back([&, t]() { Churn(pool, checksums[t]); });
+		}
+
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		// Emplace, Release and four Gets per iteration.
+		return (6.0 * kOpsPerThread * numThreads) / seconds / 1e6;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	Log::Initialize();
+
+	const uint32_t maxThreads = argc > 1
+		? static_cast<uint32_t>(std::atoi(argv[1]))
+		: std::max(1u, std::thread::hardware_concurrency());
+
+	std::printf("threads   mutex Mops/s   lock free Mops/s\n");
+	for (uint32_t numThreads = 1; numThreads <= maxThreads; numThreads *= 2)
+	{
+		const double locked = MeasureMopsPerSec<LockedPool>(numThreads);
+		const double lockFree = MeasureMopsPerSec<LockFreePool>(numThreads);
+		std::printf("%7u   %12.1f   %16.1f\n", numThreads, locked, lockFree);
+	}
+
+	return 0;
+}
@@ -0,0 +1,205 @@
+// Replays the allocation trace of an asset load against the TLSF heap and malloc.
+//
+//   HeapTraceBenchmark [assetDirectory]
+//
+// With a directory every file becomes a blob allocation in path order, like the native file system
+// loading it. Without one a glTF scene shaped trace is generated (geometry buffers, texture mips,
+// small material blobs). Loads interleave with decode scratch that is freed straight away and with
+// unloads of older assets, the way a streaming level load behaves.
+
+#include <phxLog.h>
+#include <phxMemory.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <random>
+#include <vector>
+
+using namespace phx;
+
+namespace
+{
+	struct TraceEvent
+	{
+		// Alloc when Size != 0, otherwise frees the allocation made by event Slot.
+		size_t Size;
+		uint32_t Slot;
+	};
+
+	void AddLoad(std::vector<TraceEvent>& trace, std::vector<uint32_t>& live, std::mt19937& rng, size_t size)
+	{
+		// Decode scratch lives only while the asset is loaded.
+		const uint32_t scratch = static_cast<uint32_t>(trace.size());
+		trace.push_back({ .Size = std::max<size_t>(size / 4, 64), .Slot = scratch });
+
+		const uint32_t asset = static_cast<uint32_t>(trace.size());
+		trace.push_back({ .Size = std::max<size_t>(size, 16), .Slot = asset });
+		trace.push_back({ .Size = 0, .Slot = scratch });
+		live.push_back(asset);
+
+		// Roughly one in four loads evicts an older asset.
+		if (live.size() > 8 && rng() % 4 == 0)
+		{
+			const size_t victim = rng() % live.size();
+			trace.push_back({ .Size = 0, .Slot = live[victim] });
+			live[victim] = live.back();
+			live.pop_back();
+		}
+	}
+
+	std::vector<TraceEvent> BuildTrace(std::vector<size_t> const& assetSizes)
+	{
+		std::mt19937 rng(1234);
+		std::vector<TraceEvent> trace;
+		std::vector<uint32_t> live;
+		for (size_t size : assetSizes)
+		{
+			AddLoad(trace, live, rng, size);
+		}
+
+		for (uint32_t slot : live)
+		{
+			trace.push_back({ .Size = 0, .Slot = slot });
+		}
+
+		return trace;
+	}
+
+	std::vector<size_t> SceneAssetSizes()
+	{
+		std::mt19937 rng(42);
+		std::vector<size_t> sizes;
+		for (int mesh = 0; mesh < 400; mesh++)
+		{
+			sizes.push_back(64_KiB + rng() % (4_MiB));					// vertex and index data
+			sizes.push_back(256 + rng() % 4_KiB);						// material
+
+			// Texture with its mip chain as separate regions.
+			size_t mip = size_t(64_KiB) << (rng() % 7);
+			for (; mip >= 4_KiB; mip /= 4)
+			{
+				sizes.push_back(mip);
+			}
+		}
+
+		return sizes;
+	}
+
+	std::vector<size_t> DirectoryAssetSizes(std::filesystem::path const& directory)
+	{
+		std::vector<std::filesystem::path> files;
+		for (auto const& entry : std::filesystem::recursive_directory_iterator(directory))
+		{
+			if (entry.is_regular_file())
+			{
+				files.push_back(entry.path());
+			}
+		}
+		std::sort(files.begin(), files.end());
+
+		std::vector<size_t> sizes;
+		for (auto const& file : files)
+		{
+			sizes.push_back(static_cast<size_t>(std::filesystem::file_size(file)));
+		}
+
+		return sizes;
+	}
+
+	template<typename TAlloc, typename TFree>
+	double Replay(std::vector<TraceEvent> const& trace, std::vector<void*>& slots, TAlloc&& alloc, TFree&& free)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		for (TraceEvent const& e : trace)
+		{
+			if (e.Size != 0)
+			{
+				void* ptr = alloc(e.Size);
+				// Touch the first byte like a loader would, so both heaps pay for faulting pages in.
+				*static_cast<volatile uint8_t*>(ptr) = 1;
+				slots[e.Slot] = ptr;
+			}
+			else
+			{
+				free(slots[e.Slot]);
+			}
+		}
+
+		return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / trace.size();
+	}
+}
+
+int main(int argc, char** argv)
+{
+	Log::Initialize();
+
+	const std::vector<size_t> assetSizes = argc > 1 ? DirectoryAssetSizes(argv[1]) : SceneAssetSizes();
+	const std::vector<TraceEvent> trace = BuildTrace(assetSizes);
+
+	size_t totalBytes = 0;
+	for (size_t size : assetSizes)
+	{
+		totalBytes += size;
+	}
+	std::printf("%zu assets, %.1f MiB, %zu events\n", assetSizes.size(), totalBytes / double(1_MiB), trace.size());
+
+	constexpr int kNumRuns = 5;
+	constexpr size_t kReserveSize = 16_GiB;
+	void* reservation = VirtualMemReserve(kReserveSize);
+	std::vector<void*> slots(trace.size());
+
+	// Untimed pass sampling the heap stats whenever the number of live allocations peaks.
+	TlsfAllocator::Stats peakStats = {};
+	{
+		TlsfAllocator heap;
+		heap.Initialize(reservation, kReserveSize);
+
+		size_t live = 0;
+		size_t peakLive = 0;
+		Replay(trace, slots,
+			[&](size_t size)
+			{
+				peakLive = std::max(peakLive, ++live);
+				return heap.Allocate(size);
+			},
+			[&](void* ptr)
+			{
+				if (live-- == peakLive)
+				{
+					peakStats = heap.GetStats();
+				}
+				heap.Free(ptr);
+			});
+
+		heap.Finalize();
+	}
+
+	// Both heaps keep their pages between runs, so the best run compares warm heaps.
+	double bestTlsf = 1e30;
+	double bestMalloc = 1e30;
+	TlsfAllocator heap;
+	heap.Initialize(reservation, kReserveSize);
+	for (int run = 0; run < kNumRuns; run++)
+	{
+		bestTlsf = std::min(bestTlsf, Replay(trace, slots,
+			[&](size_t size) { return heap.Allocate(size); },
+			[&](void* ptr) { heap.Free(ptr); }));
+
+		bestMalloc = std::min(bestMalloc, Replay(trace, slots,
+			[](size_t size) { return std::malloc(size); },
+			[](void* ptr) { std::free(ptr); }));
+	}
+
+	heap.Finalize();
+	VirtualMemFree(reservation, kReserveSize);
+
+	std::printf("tlsf:   %8.1f ns/op\n", bestTlsf);
+	std::printf("malloc: %8.1f ns/op\n", bestMalloc);
+	std::printf("tlsf at peak: used %.1f MiB, committed %.1f MiB, fragmentation %.3f\n",
+		peakStats.UsedBytes / double(1_MiB), peakStats.CommittedBytes / double(1_MiB), peakStats.Fragmentation());
+
+	return 0;
+}
@@ -0,0 +1,204 @@
+// Measures how long RootFileSystem takes to resolve a path to its mount.
+//
+//   MountLookupBenchmark [numLookups]
+//
+// Mounts 16 file systems and calls FileExists on 1M paths spread across them. The file systems
+// only count the calls, so the time is spent resolving the path. The prefix compare resolver is
+// the one RootFileSystem had before the hash table. It normalizes every path into a new string,
+// copies each mount entry while looping over them and builds the relative path with substr. Heap
+// allocations are counted through global new. Resolving through the hash table doesn't allocate,
+// what it still allocates is the relative std::filesystem::path passed to the mounted file system.
+
+#include <phxLog.h>
+#include <phxVFS.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <memory>
+#include <new>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace
+{
+	std::atomic<size_t> gNumNews = 0;
+}
+
+void* operator new(size_t size)
+{
+	gNumNews.fetch_add(1, std::memory_order_relaxed);
+	if (void* ptr = std::malloc(size ? size : 1))
+	{
+		return ptr;
+	}
+	throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+	std::free(ptr);
+}
+
+using namespace phx;
+
+namespace
+{
+	constexpr const char* kMounts[] = {
+		"/native",
+		"/cache",
+		"/shaders",
+		"/scripts",
+		"/assets/textures",
+		"/assets/meshes",
+		"/assets/materials",
+		"/assets/animations",
+		"/assets/audio",
+		"/assets/fonts",
+		"/assets/levels",
+		"/assets/ui",
+		"/packages/base",
+		"/packages/dlc",
+		"/user/config",
+		"/user/saves",
+	};
+
+	class CountingFileSystem final : public IFileSystem
+	{
+	public:
+		bool FileExists(std::filesystem::path const&) override { return ++this->NumCalls > 0; }
+		bool FolderExists(std::filesystem::path const&) override { return ++this->NumCalls > 0; }
+		std::unique_ptr<IBlob> ReadFile(std::filesystem::path const&) override { return nullptr; }
+		bool WriteFile(std::filesystem::path const&, Span<char>) override { return false; }
+
+		uint64_t NumCalls = 0;
+	};
+
+	class PrefixCompareResolver
+	{
+	public:
+		void Mount(std::filesystem::path const& path, std::shared_ptr<IFileSystem> fs)
+		{
+			this->m_mountPoints.push_back(std::make_pair(path.lexically_normal().generic_string(), fs));
+		}
+
+		bool FileExists(std::filesystem::path const& name)
+		{
+			std::filesystem::path relativePath;
+			IFileSystem* fs = nullptr;
+
+			if (this->FindMountPoint(name, &relativePath, &fs))
+			{
+				return fs->FileExists(relativePath);
+			}
+
+			return false;
+		}
+
+	private:
+		bool FindMountPoint(std::filesystem::path const& path, std::filesystem::path* pRelativePath, IFileSystem** ppFS)
+		{
+			std::string spath = path.lexically_normal().generic_string();
+
+			for (auto it : this->m_mountPoints)
+			{
+				if (spath.find(it.first, 0) == 0 && ((spath.length() == it.first.length()) || (spath[it.first.length()] == '/')))
+				{
+					if (pRelativePath)
+					{
+						std::string relative = spath.substr(it.first.size() + 1);
+						*pRelativePath = relative;
+					}
+
+					if (ppFS)
+					{
+						*ppFS = it.second.get();
+					}
+
+					return true;
+				}
+			}
+
+			return false;
+		}
+
+	private:
+		std::vector<std::pair<std::string, std::shared_ptr<IFileSystem>>> m_mountPoints;
+	};
+
+	struct Result
+	{
+		double NsPerLookup;
+		double NewsPerLookup;
+		size_t NumFound;
+	};
+
+	template<typename TResolver>
+	Result Measure(TResolver& resolver, std::vector<std::filesystem::path> const& paths)
+	{
+		Result result = {};
+		const size_t newsBefore = gNumNews.load();
+		const auto start = std::chrono::steady_clock::now();
+		for (std::filesystem::path const& path : paths)
+		{
+			result.NumFound += resolver.FileExists(path) ? 1 : 0;
+		}
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		result.NsPerLookup = seconds * 1e9 / paths.size();
+		result.NewsPerLookup = static_cast<double>(gNumNews.load() - newsBefore) / paths.size();
+
+		return result;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	Log::Initialize();
+
+	const size_t numLookups = argc > 1 ? static_cast<size_t>(std::atoll(argv[1])) : 1000000;
+
+	std::unique_ptr<IRootFileSystem> rootFs = FileSystemFactory::CreateRootFileSystem();
+	PrefixCompareResolver prefixCompare;
+	for (const char* mount : kMounts)
+	{
+		auto fs = std::make_shared<CountingFileSystem>();
+		rootFs->Mount(mount, fs);
+		prefixCompare.Mount(mount, fs);
+	}
+
+	// Asset style paths a few folders below a random mount, built up front so both resolvers get
+	// the same std::filesystem::path objects.
+	std::mt19937 rng(16);
+	std::vector<std::filesystem::path> paths;
+	paths.reserve(numLookups);
+	for (size_t i = 0; i < numLookups; i++)
+	{
+		const char* mount = kMounts[rng() % std::size(kMounts)];
+		paths.emplace_back(std::string(mount) + "/group_" + std::to_string(rng() % 64) + "/item_" + std::to_string(rng() % 4096) + ".bin");
+	}
+
+	const Result prefix = Measure(prefixCompare, paths);
+	const Result hashed = Measure(*rootFs, paths);
+
+	std::printf("%zu lookups across %zu mounts\n", numLookups, std::size(kMounts));
+	std::printf("resolver         ns / lookup   allocations / lookup\n");
+	std::printf("prefix compare   %11.1f   %20.2f\n", prefix.NsPerLookup, prefix.NewsPerLookup);
+	std::printf("hash table       %11.1f   %20.2f\n", hashed.NsPerLookup, hashed.NewsPerLookup);
+
+	if (prefix.NumFound != numLookups || hashed.NumFound != numLookups)
+	{
+		std::printf("Resolved %zu and %zu of %zu paths\n", prefix.NumFound, hashed.NumFound, numLookups);
+		return 1;
+	}
+
+	return 0;
+}
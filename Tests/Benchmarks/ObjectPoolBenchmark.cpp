@@ -0,0 +1,188 @@
+// Compares ObjectPool<T> with new/delete for small engine objects.
+//
+//   ObjectPoolBenchmark [maxPairs]
+//
+// Single thread: keeps a window of live objects, freeing the oldest and allocating a new one, the
+// pattern of per frame nodes such as ring regions. Cross thread: each producer allocates batches
+// and hands them to a consumer that frees them, as when a render thread releases what a worker
+// created. Both allocators go through the same hand off, so only the allocation cost differs.
+
+#include <phxLog.h>
+#include <phxObjectPool.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace phx;
+
+namespace
+{
+	struct Node
+	{
+		uint64_t Payload[6];
+		Node* Next;
+		uint32_t Owner;
+	};
+
+	constexpr size_t kOpsPerThread = 1 << 21;
+	constexpr size_t kWindowSize = 256;
+	constexpr size_t kBatchSize = 64;
+	constexpr uint32_t kMaxPairs = 16;
+
+	struct HeapAllocator
+	{
+		Node* New(uint32_t owner) { return new Node{ .Payload = {}, .Next = nullptr, .Owner = owner }; }
+		void Delete(Node* node) { delete node; }
+	};
+
+	struct PoolAllocator
+	{
+		// Room for every object of every producer, in case the consumers fall behind.
+		ObjectPool<Node> Pool{ kMaxPairs * kOpsPerThread };
+
+		Node* New(uint32_t owner) { return this->Pool.New(Node{ .Payload = {}, .Next = nullptr, .Owner = owner }); }
+		void Delete(Node* node) { this->Pool.Delete(node); }
+	};
+
+	template<typename TAllocator>
+	double MeasureSingleThread()
+	{
+		TAllocator allocator;
+		std::vector<Node*> window(kWindowSize);
+		for (size_t i = 0; i < kWindowSize; i++)
+		{
+			window[i] = allocator.New(0);
+		}
+
+		const auto start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < kOpsPerThread; i++)
+		{
+			const size_t oldest = i % kWindowSize;
+			allocator.Delete(window[oldest]);
+			window[oldest] = allocator.New(static_cast<uint32_t>(i));
+		}
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		for (Node* node : window)
+		{
+			allocator.Delete(node);
+		}
+
+		// A New and a Delete per iteration.
+		return 2.0 * kOpsPerThread / seconds / 1e6;
+	}
+
+	// Batches of objects passed from a producer to its consumer.
+	struct HandOff
+	{
+		std::mutex Mutex;
+		std::condition_variable Ready;
+		std::vector<Node*> Batches;
+		bool Done = false;
+
+		void Push(Node* batch)
+		{
+			{
+				std::scoped_lock _(this->Mutex);
+				this->Batches.push_back(batch);
+			}
+			this->Ready.notify_one();
+		}
+
+		// Returns false once the producer is done and everything has been taken.
+		bool Take(std::vector<Node*>& outBatches)
+		{
+			std::unique_lock lock(this->Mutex);
+			this->Ready.wait(lock, [this]() { return !this->Batches.empty() || this->Done; });
+			outBatches.swap(this->Batches);
+			return !outBatches.empty();
+		}
+	};
+
+	template<typename TAllocator>
+	double MeasureCrossThread(uint32_t numPairs)
+	{
+		TAllocator allocator;
+		std::vector<HandOff> handOffs(numPairs);
+		std::vector<std::thread> threads;
+
+		const auto start = std::chrono::steady_clock::now();
+		for (uint32_t p = 0; p < numPairs; p++)
+		{
+			threads.emplace_back([&, p]()
+				{
+					for (size_t i = 0; i < kOpsPerThread; i += kBatchSize)
+					{
+						Node* batch = nullptr;
+						for (size_t j = 0; j < kBatchSize; j++)
+						{
+							Node* node = allocator.New(p);
+							node->Next = batch;
+							batch = node;
+						}
+						handOffs[p].Push(batch);
+					}
+
+					{
+						std::scoped_lock _(handOffs[p].Mutex);
+						handOffs[p].Done = true;
+					}
+					handOffs[p].Ready.notify_one();
+				});
+
+			threads.emplace_back([&, p]()
+				{
+					std::vector<Node*> batches;
+					while (handOffs[p].Take(batches))
+					{
+						for (Node* batch : batches)
+						{
+							while (batch)
+							{
+								Node* next = batch->Next;
+								allocator.Delete(batch);
+								batch = next;
+							}
+						}
+						batches.clear();
+					}
+				});
+		}
+
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		return 2.0 * kOpsPerThread * numPairs / seconds / 1e6;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	Log::Initialize();
+
+	const uint32_t maxPairs = std::min(kMaxPairs, argc > 1
+		? static_cast<uint32_t>(std::atoi(argv[1]))
+		: std::max(1u, std::thread::hardware_concurrency() / 2));
+
+	std::printf("single thread   new/delete Mops/s   pool Mops/s\n");
+	std::printf("%13s   %17.1f   %11.1f\n", "", MeasureSingleThread<HeapAllocator>(), MeasureSingleThread<PoolAllocator>());
+
+	std::printf("\ncross thread pairs   new/delete Mops/s   pool Mops/s\n");
+	for (uint32_t numPairs = 1; numPairs <= maxPairs; numPairs *= 2)
+	{
+		const double heap = MeasureCrossThread<HeapAllocator>(numPairs);
+		const double pool = MeasureCrossThread<PoolAllocator>(numPairs);
+		std::printf("%18u   %17.1f   %11.1f\n", numPairs, heap, pool);
+	}
+
+	return 0;
+}
@@ -0,0 +1,131 @@
+// Compares reading many small assets as loose files against reading them out of one package.
+//
+//   PackageBenchmark [numEntries] [entrySize]
+//
+// Generates numEntries files of entrySize bytes, packages them with PackageBuilder and reads every
+// entry back through both file systems. Loose reads pay an open, a size query and a close per file,
+// package reads are a table lookup into one mapping. Files are freshly written so both runs read from
+// the OS cache, this measures per file overhead rather than disk throughput.
+
+#include <phxLog.h>
+#include <phxMemory.h>
+#include <phxPackageFile.h>
+#include <phxVFS.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace phx;
+
+namespace
+{
+	std::filesystem::path GetEntryPath(size_t index)
+	{
+		// A few hundred entries per folder, like a cooked asset tree.
+		return std::filesystem::path(std::to_string(index / 256)) / (std::to_string(index) + ".bin");
+	}
+
+	struct ReadResult
+	{
+		double Milliseconds = 0.0;
+		size_t NumRead = 0;
+		uint64_t Checksum = 0;
+	};
+
+	ReadResult ReadAll(IFileSystem& fs, std::filesystem::path const& root, size_t numEntries)
+	{
+		ReadResult result;
+		const auto start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < numEntries; i++)
+		{
+			std::unique_ptr<IBlob> blob = fs.ReadFile(root / GetEntryPath(i));
+			if (IBlob::IsEmpty(blob.get()))
+			{
+				continue;
+			}
+
+			// Touch the data so mapped reads fault their pages in as well.
+			result.NumRead++;
+			const uint8_t* data = static_cast<const uint8_t*>(blob->Data());
+			for (size_t offset = 0; offset < blob->Size(); offset += 64)
+			{
+				result.Checksum += data[offset];
+			}
+		}
+		result.Milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		return result;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	Log::Initialize();
+
+	Memory::MemoryConfiguration config = {};
+	config.VirtualMemorySize = 8_GiB;
+	config.HeapReserveSize = 64_MiB;
+	config.HeapCommitGranularity = 1_MiB;
+	Memory::Initialize(config);
+
+	const size_t numEntries = argc > 1 ? static_cast<size_t>(std::atoll(argv[1])) : 10000;
+	const size_t entrySize = argc > 2 ? static_cast<size_t>(std::atoll(argv[2])) : 4_KiB;
+
+	const std::filesystem::path directory = std::filesystem::temp_directory_path() / "PhxPackageBenchmark";
+	const std::filesystem::path looseRoot = directory / "loose";
+	const std::filesystem::path packagePath = directory / "assets.phxpkg";
+
+	std::error_code ec;
+	std::filesystem::remove_all(directory, ec);
+
+	std::vector<char> contents(entrySize);
+	for (size_t i = 0; i < numEntries; i++)
+	{
+		const std::filesystem::path path = looseRoot / GetEntryPath(i);
+		std::filesystem::create_directories(path.parent_path());
+		for (size_t j = 0; j < entrySize; j++)
+		{
+			contents[j] = static_cast<char>(i + j);
+		}
+
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		file.write(contents.data(), contents.size());
+	}
+
+	PackageBuilder builder;
+	if (!builder.AddDirectory(looseRoot) || !builder.Write(packagePath))
+	{
+		std::printf("Failed to build the package\n");
+		Memory::Finalize();
+		return 1;
+	}
+
+	std::unique_ptr<IFileSystem> looseFs = FileSystemFactory::CreateNativeFileSystem(&Memory::GetHeap());
+	const ReadResult loose = ReadAll(*looseFs, looseRoot, numEntries);
+
+	const auto openStart = std::chrono::steady_clock::now();
+	std::unique_ptr<IFileSystem> packageFs = FileSystemFactory::CreatePackageFileSystem(packagePath);
+	const double openMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - openStart).count();
+	const ReadResult package = packageFs ? ReadAll(*packageFs, {}, numEntries) : ReadResult{};
+
+	std::printf("%zu entries of %zu bytes\n", numEntries, entrySize);
+	std::printf("source    entries read   total ms   us / entry\n");
+	std::printf("loose     %12zu   %8.2f   %10.2f\n", loose.NumRead, loose.Milliseconds, 1000.0 * loose.Milliseconds / numEntries);
+	std::printf("package   %12zu   %8.2f   %10.2f   (+%.2f ms to open)\n", package.NumRead, package.Milliseconds, 1000.0 * package.Milliseconds / numEntries, openMs);
+	if (loose.Checksum != package.Checksum)
+	{
+		std::printf("Checksum mismatch, package contents differ from the loose files\n");
+	}
+
+	packageFs.reset();
+	looseFs.reset();
+	std::filesystem::remove_all(directory, ec);
+
+	Memory::Finalize();
+	return loose.Checksum == package.Checksum ? 0 : 1;
+}
@@ -0,0 +1,90 @@
+// Measures how frame allocations scale with the number of threads allocating at once.
+//
+//   StackAllocatorContentionBenchmark [maxThreads]
+//
+// Every thread makes a frame's worth of small allocations (command packets, transient arrays),
+// then all threads meet at a barrier where the allocator is reset, as Memory::BeginFrame does.
+// Locked mode is the single cursor behind a mutex the allocator had before PerThread mode.
+
+#include <phxLog.h>
+#include <phxMemory.h>
+
+#include <barrier>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+using namespace phx;
+
+namespace
+{
+	constexpr size_t kFrames = 64;
+	constexpr size_t kAllocsPerFrame = 16 * 1024;
+
+	double MeasureMallocsPerSec(VirtualStackAllocator::ThreadingMode mode, uint32_t numThreads)
+	{
+		VirtualStackAllocator allocator(4_MiB, mode);
+		std::barrier frameEnd(numThreads, [&]() noexcept { allocator.Reset(); });
+		std::vector<uint64_t> checksums(numThreads);
+		std::vector<std::thread> threads;
+
+		const auto start = std::chrono::steady_clock::now();
+		for (uint32_t t = 0; t < numThreads; t++)
+		{
+			threads.emplace_back([&, t]()
+				{
+					uint64_t sum = 0;
+					for (size_t frame = 0; frame < kFrames; frame++)
+					{
+						for (size_t i = 0; i < kAllocsPerFrame; i++)
+						{
+							// 16 to 256 bytes, mostly at the small end.
+							const size_t size = 16u << ((i * 7 + t) % 5);
+							uint8_t* ptr = static_cast<uint8_t*>(allocator.Allocate(size, 16));
+							if (ptr)
+							{
+								ptr[0] = static_cast<uint8_t>(i);
+								sum += ptr[0];
+							}
+						}
+						frameEnd.arrive_and_wait();
+					}
+					checksums[t] = sum;
+				});
+		}
+
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		return static_cast<double>(kFrames * kAllocsPerFrame * numThreads) / seconds / 1e6;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	Log::Initialize();
+
+	Memory::MemoryConfiguration config = {};
+	config.VirtualMemorySize = 64_GiB;
+	config.HeapReserveSize = 64_MiB;
+	config.HeapCommitGranularity = 1_MiB;
+	Memory::Initialize(config);
+
+	const uint32_t maxThreads = argc > 1 ? static_cast<uint32_t>(std::atoi(argv[1])) : 32;
+
+	std::printf("threads   locked Mallocs/s   per thread Mallocs/s\n");
+	for (uint32_t numThreads = 1; numThreads <= maxThreads; numThreads *= 2)
+	{
+		const double locked = MeasureMallocsPerSec(VirtualStackAllocator::ThreadingMode::Locked, numThreads);
+		const double perThread = MeasureMallocsPerSec(VirtualStackAllocator::ThreadingMode::PerThread, numThreads);
+		std::printf("%7u   %17.1f   %20.1f\n", numThreads, locked, perThread);
+	}
+
+	Memory::Finalize();
+	return 0;
+}
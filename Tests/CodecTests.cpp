@@ -0,0 +1,255 @@
+#include "phxTest.h"
+
+#include <phxCodec.h>
+#include <phxGDeflate.h>
+#include <phxLog.h>
+#include <phxMemory.h>
+
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace phx;
+
+namespace
+{
+	constexpr Codec::Type kTiledCodecs[] = { Codec::Type::Lz4, Codec::Type::Zstd, Codec::Type::GDeflate };
+
+	// Sizes around tile boundaries, in data that compresses, doesn't, and only in places.
+	std::vector<std::vector<uint8_t>> MakeInputs()
+	{
+		std::mt19937 rng(7);
+		std::vector<std::vector<uint8_t>> inputs;
+		for (size_t size : { size_t(0), size_t(1), size_t(100), size_t(64_KiB - 1), size_t(64_KiB), size_t(64_KiB + 1), size_t(200_KiB + 5) })
+		{
+			std::vector<uint8_t> text(size);
+			const char* words[] = { "vertex ", "index ", "texture ", "mip ", "region " };
+			for (size_t i = 0; i < size;)
+			{
+				for (const char* c = words[rng() % 5]; *c && i < size; c++)
+				{
+					text[i++] = static_cast<uint8_t>(*c);
+				}
+			}
+			inputs.push_back(std::move(text));
+
+			std::vector<uint8_t> noise(size);
+			for (uint8_t& b : noise)
+			{
+				b = static_cast<uint8_t>(rng());
+			}
+			inputs.push_back(std::move(noise));
+
+			std::vector<uint8_t> mixed(size);
+			for (size_t i = 0; i < size; i++)
+			{
+				mixed[i] = (i / 4096) % 2 ? static_cast<uint8_t>(rng()) : static_cast<uint8_t>(i % 7);
+			}
+			inputs.push_back(std::move(mixed));
+		}
+		return inputs;
+	}
+
+	bool RoundTrips(Codec::Type codec, std::vector<uint8_t> const& input, int level, size_t* outCompressedSize = nullptr)
+	{
+		std::vector<uint8_t> compressed(Codec::CompressBound(codec, input.size()));
+		const size_t compressedSize = Codec::Compress(codec, input.data(), input.size(), compressed.data(), compressed.size(), level);
+		if ((compressedSize == 0 && !input.empty()) || compressedSize > compressed.size())
+		{
+			return false;
+		}
+
+		std::vector<uint8_t> output(input.size());
+		if (outCompressedSize)
+		{
+			*outCompressedSize = compressedSize;
+		}
+		return Codec::Decompress(codec, compressed.data(), compressedSize, output.data(), output.size()) && output == input;
+	}
+
+	void TestRoundTrip()
+	{
+		const std::vector<std::vector<uint8_t>> inputs = MakeInputs();
+		for (Codec::Type codec : kTiledCodecs)
+		{
+			if (!Codec::IsAvailable(codec))
+			{
+				continue;
+			}
+
+			for (std::vector<uint8_t> const& input : inputs)
+			{
+				PHX_CHECK(RoundTrips(codec, input, 0));
+			}
+		}
+
+		for (std::vector<uint8_t> const& input : inputs)
+		{
+			PHX_CHECK(RoundTrips(Codec::Type::None, input, 0));
+		}
+	}
+
+	void TestGDeflateLevels()
+	{
+		const std::vector<uint8_t> input = MakeInputs()[18];
+		size_t fastest = 0;
+		size_t smallest = 0;
+		PHX_CHECK(RoundTrips(Codec::Type::GDeflate, input, 1, &fastest));
+		PHX_CHECK(RoundTrips(Codec::Type::GDeflate, input, 12, &smallest));
+		PHX_CHECK(smallest <= fastest && fastest < input.size() / 2);
+	}
+
+	void TestGDeflateStreamLayout()
+	{
+		const std::vector<uint8_t> input = MakeInputs()[18];
+		std::vector<uint8_t> compressed(Codec::CompressBound(Codec::Type::GDeflate, input.size()));
+		const size_t compressedSize = Codec::Compress(Codec::Type::GDeflate, input.data(), input.size(), compressed.data(), compressed.size());
+		PHX_CHECK(compressedSize > 0);
+
+		GDeflate::StreamHeader header;
+		std::memcpy(&header, compressed.data(), sizeof(header));
+		PHX_CHECK(header.Id == GDeflate::kStreamId && header.Magic == (GDeflate::kStreamId ^ 0xff));
+		PHX_CHECK(header.NumTiles == 4 && header.TileSizeIndex == 1 && header.LastTileSize == input.size() % GDeflate::kTileSize);
+
+		// The first entry is the last tile's size, the rest are offsets from the end of the table.
+		uint32_t entries[4];
+		std::memcpy(entries, compressed.data() + sizeof(header), sizeof(entries));
+		const size_t dataStart = sizeof(header) + sizeof(entries);
+		PHX_CHECK(entries[1] > 0 && entries[1] < entries[2] && entries[2] < entries[3]);
+		PHX_CHECK(dataStart + entries[3] + entries[0] == compressedSize);
+		PHX_CHECK(compressedSize % sizeof(uint32_t) == 0);
+	}
+
+	void TestTilesDecodeOnTheirOwn()
+	{
+		const std::vector<uint8_t> input = MakeInputs()[20];
+		for (Codec::Type codec : kTiledCodecs)
+		{
+			if (!Codec::IsAvailable(codec))
+			{
+				continue;
+			}
+
+			std::vector<uint8_t> compressed(Codec::CompressBound(codec, input.size()));
+			const size_t compressedSize = Codec::Compress(codec, input.data(), input.size(), compressed.data(), compressed.size());
+
+			const size_t tableSize = Codec::GetTileTableSize(codec, compressed.data(), Codec::kMaxStreamHeaderSize, input.size());
+			Codec::TileTable table;
+			PHX_CHECK(tableSize > 0 && Codec::ReadTileTable(codec, compressed.data(), tableSize, input.size(), table));
+			PHX_CHECK(table.GetNumTiles() == 4 && table.Offsets.front() == tableSize && table.Offsets.back() == compressedSize);
+
+			// Last tile first, so nothing depends on earlier tiles having been decoded.
+			for (uint32_t tile = table.GetNumTiles(); tile-- > 0;)
+			{
+				std::vector<uint8_t> output(table.GetTileSize(tile));
+				PHX_CHECK(Codec::DecompressTile(codec, table, tile, compressed.data() + table.Offsets[tile], output.data()));
+				PHX_CHECK(std::memcmp(output.data(), input.data() + tile * table.TileSize, output.size()) == 0);
+			}
+
+			// The header has to describe the size being asked for.
+			PHX_CHECK(Codec::GetTileTableSize(codec, compressed.data(), Codec::kMaxStreamHeaderSize, input.size() + 64_KiB) == 0);
+		}
+	}
+
+	void TestTileSizes()
+	{
+		const std::vector<uint8_t> input = MakeInputs()[20];
+		for (Codec::Type codec : { Codec::Type::Lz4, Codec::Type::Zstd })
+		{
+			if (!Codec::IsAvailable(codec))
+			{
+				continue;
+			}
+
+			for (uint32_t tileSize : { 4_KiB, 16_KiB, 1_MiB })
+			{
+				std::vector<uint8_t> compressed(Codec::CompressBound(codec, input.size(), tileSize));
+				const size_t compressedSize = Codec::Compress(codec, input.data(), input.size(), compressed.data(), compressed.size(), 0, tileSize);
+				PHX_CHECK(compressedSize > 0);
+
+				// The reader takes the tile size from the header.
+				const size_t tableSize = Codec::GetTileTableSize(codec, compressed.data(), Codec::kMaxStreamHeaderSize, input.size());
+				Codec::TileTable table;
+				PHX_CHECK(tableSize > 0 && Codec::ReadTileTable(codec, compressed.data(), tableSize, input.size(), table));
+				PHX_CHECK(table.TileSize == tileSize && table.GetNumTiles() == (input.size() + tileSize - 1) / tileSize);
+
+				std::vector<uint8_t> output(input.size());
+				PHX_CHECK(Codec::Decompress(codec, compressed.data(), compressedSize, output.data(), output.size()));
+				PHX_CHECK(output == input);
+			}
+
+			// Not a power of two, or out of range.
+			for (uint32_t tileSize : { 0u, 3000u, Codec::kMinTileSize / 2, Codec::kMaxTileSize * 2 })
+			{
+				std::vector<uint8_t> compressed(Codec::CompressBound(codec, input.size()));
+				PHX_CHECK(!Codec::IsValidTileSize(codec, tileSize) && Codec::CompressBound(codec, input.size(), tileSize) == 0);
+				PHX_CHECK(Codec::Compress(codec, input.data(), input.size(), compressed.data(), compressed.size(), 0, tileSize) == 0);
+			}
+		}
+
+		PHX_CHECK(Codec::IsValidTileSize(Codec::Type::GDeflate, GDeflate::kTileSize));
+		PHX_CHECK(!Codec::IsValidTileSize(Codec::Type::GDeflate, 128_KiB));
+	}
+
+	void TestRejectsCorruptInput()
+	{
+		const std::vector<uint8_t> input = MakeInputs()[18];
+		std::vector<uint8_t> output(input.size());
+		std::mt19937 rng(11);
+		for (Codec::Type codec : kTiledCodecs)
+		{
+			if (!Codec::IsAvailable(codec))
+			{
+				continue;
+			}
+
+			std::vector<uint8_t> compressed(Codec::CompressBound(codec, input.size()));
+			const size_t compressedSize = Codec::Compress(codec, input.data(), input.size(), compressed.data(), compressed.size());
+			compressed.resize(compressedSize);
+
+			PHX_CHECK(!Codec::Decompress(codec, compressed.data(), compressedSize - 4, output.data(), output.size()));
+			PHX_CHECK(!Codec::Decompress(codec, compressed.data(), compressedSize, output.data(), output.size() - 1));
+			PHX_CHECK(!Codec::Decompress(codec, compressed.data(), 3, output.data(), output.size()));
+
+			// Flipped bits may still decode to something, they just can't read or write out of bounds.
+			for (int i = 0; i < 200; i++)
+			{
+				std::vector<uint8_t> corrupt = compressed;
+				corrupt[rng() % corrupt.size()] ^= static_cast<uint8_t>(1u << (rng() % 8));
+				Codec::Decompress(codec, corrupt.data(), corrupt.size(), output.data(), output.size());
+			}
+		}
+
+		// A single GDeflate tile cut short.
+		std::vector<uint8_t> tile(GDeflate::CompressBound(GDeflate::kTileSize));
+		const size_t tileSize = GDeflate::Compress(input.data(), GDeflate::kTileSize, tile.data(), tile.size());
+		PHX_CHECK(tileSize > 0);
+		for (size_t size = 0; size < tileSize; size += 4)
+		{
+			PHX_CHECK(!GDeflate::Decompress(tile.data(), size, output.data(), GDeflate::kTileSize));
+		}
+		PHX_CHECK(GDeflate::Decompress(tile.data(), tileSize, output.data(), GDeflate::kTileSize));
+	}
+}
+
+int main()
+{
+	Log::Initialize();
+
+	Memory::MemoryConfiguration config = {};
+	config.VirtualMemorySize = 8_GiB;
+	config.HeapReserveSize = 64_MiB;
+	config.HeapCommitGranularity = 1_MiB;
+	Memory::Initialize(config);
+
+	Test::Run("RoundTrip", TestRoundTrip);
+	Test::Run("GDeflateLevels", TestGDeflateLevels);
+	Test::Run("GDeflateStreamLayout", TestGDeflateStreamLayout);
+	Test::Run("TilesDecodeOnTheirOwn", TestTilesDecodeOnTheirOwn);
+	Test::Run("TileSizes", TestTileSizes);
+	Test::Run("RejectsCorruptInput", TestRejectsCorruptInput);
+
+	Memory::Finalize();
+	return Test::Result();
+}
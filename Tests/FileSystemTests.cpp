@@ -0,0 +1,343 @@
+#include "phxTest.h"
+
+#include <phxCachedFileSystem.h>
+#include <phxCompressedFileSystem.h>
+#include <phxFileWatcher.h>
+#include <phxLog.h>
+#include <phxMemory.h>
+#include <phxVFS.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace phx;
+
+namespace
+{
+	std::filesystem::path GetTestDirectory()
+	{
+		return std::filesystem::temp_directory_path() / "PhxFileSystemTests";
+	}
+
+	std::vector<char> WriteTestFile(std::filesystem::path const& path, size_t size)
+	{
+		std::vector<char> contents(size);
+		for (size_t i = 0; i < size; i++)
+		{
+			contents[i] = static_cast<char>((i * 31) ^ (i >> 8));
+		}
+
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		file.write(contents.data(), contents.size());
+		return contents;
+	}
+
+	bool Matches(IBlob const* blob, std::vector<char> const& expected)
+	{
+		return blob && blob->Size() == expected.size() && std::memcmp(blob->Data(), expected.data(), expected.size()) == 0;
+	}
+
+	void TestCopyAndMappedReadsMatch()
+	{
+		const std::filesystem::path directory = GetTestDirectory();
+		const std::vector<char> small = WriteTestFile(directory / "small.bin", 4_KiB + 3);
+		const std::vector<char> large = WriteTestFile(directory / "large.bin", 3_MiB + 5);
+
+		// Files at or above the threshold are mapped, smaller ones are copied into the heap.
+		void* reservation = VirtualMemReserve(256_MiB);
+		TlsfAllocator heap;
+		PHX_CHECK(heap.Initialize(reservation, 256_MiB));
+		std::unique_ptr<IFileSystem> fs = FileSystemFactory::CreateNativeFileSystem(&heap, 1_MiB);
+
+		std::unique_ptr<IBlob> smallBlob = fs->ReadFile(directory / "small.bin");
+		PHX_CHECK(Matches(smallBlob.get(), small));
+		PHX_CHECK(heap.Owns(smallBlob->Data()));
+
+		std::unique_ptr<IBlob> largeBlob = fs->ReadFile(directory / "large.bin");
+		PHX_CHECK(Matches(largeBlob.get(), large));
+		PHX_CHECK(!heap.Owns(largeBlob->Data()));
+
+		// Explicit mapping ignores the threshold, every hint reads the same bytes.
+		for (MapAdvice advice : { MapAdvice::Normal, MapAdvice::Sequential, MapAdvice::WillNeed })
+		{
+			std::unique_ptr<IBlob> mapped = fs->MapFile(directory / "small.bin", advice);
+			PHX_CHECK(Matches(mapped.get(), small));
+			PHX_CHECK(!heap.Owns(mapped->Data()));
+		}
+
+		// Copied blobs go back to the heap when destroyed.
+		smallBlob.reset();
+		largeBlob.reset();
+		PHX_CHECK(heap.GetStats().UsedBytes == 0);
+		heap.Finalize();
+		VirtualMemFree(reservation, 256_MiB);
+	}
+
+	void TestThresholdDisablesMapping()
+	{
+		const std::filesystem::path directory = GetTestDirectory();
+		const std::vector<char> large = WriteTestFile(directory / "large.bin", 3_MiB + 5);
+
+		void* reservation = VirtualMemReserve(256_MiB);
+		TlsfAllocator heap;
+		PHX_CHECK(heap.Initialize(reservation, 256_MiB));
+		std::unique_ptr<IFileSystem> fs = FileSystemFactory::CreateNativeFileSystem(&heap, SIZE_MAX);
+
+		std::unique_ptr<IBlob> blob = fs->ReadFile(directory / "large.bin");
+		PHX_CHECK(Matches(blob.get(), large));
+		PHX_CHECK(heap.Owns(blob->Data()));
+
+		blob.reset();
+		heap.Finalize();
+		VirtualMemFree(reservation, 256_MiB);
+	}
+
+	void TestMappingOutlivesFile()
+	{
+		const std::filesystem::path directory = GetTestDirectory();
+		const std::vector<char> large = WriteTestFile(directory / "removed.bin", 2_MiB);
+
+		std::unique_ptr<IFileSystem> fs = FileSystemFactory::CreateNativeFileSystem(nullptr, 1_MiB);
+		std::unique_ptr<IBlob> blob = fs->MapFile(directory / "removed.bin", MapAdvice::Sequential);
+
+		// The mapping holds the contents until the blob is destroyed.
+		std::error_code ec;
+		std::filesystem::remove(directory / "removed.bin", ec);
+		PHX_CHECK(Matches(blob.get(), large));
+	}
+
+	// Native reads, with changes reported by the test instead of the OS.
+	class ScriptedWatchFileSystem final : public IFileSystem
+	{
+	public:
+		bool FileExists(std::filesystem::path const& name) override { return this->m_native->FileExists(name); }
+		bool FolderExists(std::filesystem::path const& name) override { return this->m_native->FolderExists(name); }
+		std::unique_ptr<IBlob> ReadFile(std::filesystem::path const& name) override { return this->m_native->ReadFile(name); }
+		bool WriteFile(std::filesystem::path const& name, Span<char> Data) override { return this->m_native->WriteFile(name, Data); }
+
+		FileWatchHandle WatchDirectory(std::filesystem::path const& directory, FileChangeCallback&& onChange) override
+		{
+			(void)directory;
+			this->m_onChange = std::move(onChange);
+			return 1;
+		}
+
+		void Report(std::filesystem::path const& path, FileChangeType type)
+		{
+			FileChangeEvent change = { .Path = path, .Type = type };
+			this->m_onChange(Span<FileChangeEvent>(&change, 1));
+		}
+
+	private:
+		std::unique_ptr<IFileSystem> m_native = FileSystemFactory::CreateNativeFileSystem();
+		FileChangeCallback m_onChange;
+	};
+
+	void TestCacheDropsEverythingOnRescan()
+	{
+		const std::filesystem::path directory = GetTestDirectory();
+		WriteTestFile(directory / "a.bin", 1_KiB);
+		WriteTestFile(directory / "b.bin", 1_KiB);
+		WriteTestFile(directory / "c.bin", 1_KiB);
+
+		auto watched = std::make_shared<ScriptedWatchFileSystem>();
+		CachedFileSystem cache(watched, 1_MiB, false);
+
+		std::vector<FileChangeType> delivered;
+		cache.WatchDirectory(directory, [&](Span<FileChangeEvent> changes)
+			{
+				for (FileChangeEvent const& change : changes)
+				{
+					delivered.push_back(change.Type);
+				}
+			});
+
+		for (const char* name : { "a.bin", "b.bin", "c.bin" })
+		{
+			PHX_CHECK(cache.ReadFile(directory / name) != nullptr);
+		}
+		PHX_CHECK(cache.GetStats().NumEntries == 3);
+
+		// A single change only drops that file.
+		watched->Report(directory / "a.bin", FileChangeType::Modified);
+		PHX_CHECK(cache.GetStats().NumEntries == 2);
+
+		// Missed changes could be anywhere, nothing cached can be trusted.
+		watched->Report(directory, FileChangeType::Rescan);
+		PHX_CHECK(cache.GetStats().NumEntries == 0 && cache.GetStats().CachedBytes == 0);
+		PHX_CHECK(delivered.size() == 2 && delivered[1] == FileChangeType::Rescan);
+	}
+
+	void TestWatcherRescansMovedDirectory()
+	{
+		if (!FileWatch::IsAvailable())
+		{
+			return;
+		}
+
+		const std::filesystem::path directory = GetTestDirectory() / "watched";
+		const std::filesystem::path movedTo = GetTestDirectory() / "moved";
+		std::error_code ec;
+		std::filesystem::remove_all(directory, ec);
+		std::filesystem::remove_all(movedTo, ec);
+		std::filesystem::create_directories(directory / "sub" / "nested");
+
+		std::mutex mutex;
+		std::vector<FileChangeEvent> delivered;
+		const FileWatchHandle handle = FileWatch::WatchNativeDirectory(directory, [&](Span<FileChangeEvent> changes)
+			{
+				std::scoped_lock _(mutex);
+				for (FileChangeEvent const& change : changes)
+				{
+					delivered.push_back(change);
+				}
+			});
+		PHX_CHECK(handle != kInvalidFileWatch);
+
+		std::filesystem::rename(directory / "sub", movedTo);
+
+		// The moved directories aren't watched any more, writes to them aren't reported.
+		WriteTestFile(movedTo / "late.bin", 1_KiB);
+		WriteTestFile(movedTo / "nested" / "late.bin", 1_KiB);
+
+		for (int i = 0; i < 100; i++)
+		{
+			std::this_thread::sleep_for(FileWatch::kCoalesceWindow);
+			std::scoped_lock _(mutex);
+			if (!delivered.empty() && i > 4)
+			{
+				break;
+			}
+		}
+		FileWatch::Unwatch(handle);
+
+		PHX_CHECK(delivered.size() == 1);
+		PHX_CHECK(!delivered.empty() && delivered[0].Type == FileChangeType::Rescan && delivered[0].Path == directory / "sub");
+
+		std::filesystem::remove_all(directory, ec);
+		std::filesystem::remove_all(movedTo, ec);
+	}
+
+	void TestCompressedReadsMatch()
+	{
+		const std::filesystem::path directory = GetTestDirectory();
+		std::vector<char> contents(300_KiB + 17);
+		for (size_t i = 0; i < contents.size(); i++)
+		{
+			contents[i] = static_cast<char>((i / 64) % 2 ? i % 11 : (i * 2654435761u) >> 24);
+		}
+
+		std::shared_ptr<IFileSystem> native = FileSystemFactory::CreateNativeFileSystem();
+		for (Codec::Type codec : { Codec::Type::None, Codec::Type::Lz4, Codec::Type::Zstd, Codec::Type::GDeflate })
+		{
+			if (!Codec::IsAvailable(codec))
+			{
+				continue;
+			}
+
+			CompressedFileSystem fs(native, codec);
+			const std::filesystem::path path = directory / "compressed.bin";
+			PHX_CHECK(fs.WriteFile(path, Span<char>(contents.data(), contents.size())));
+			PHX_CHECK(codec == Codec::Type::None || std::filesystem::file_size(path) < contents.size() / 2);
+			PHX_CHECK(Matches(fs.ReadFile(path).get(), contents));
+
+			// Within a tile, across tiles, up to the end, and everything.
+			const std::pair<uint64_t, size_t> ranges[] = { { 5, 100 }, { 64_KiB - 3, 70_KiB }, { contents.size() - 9, 9 }, { 0, contents.size() } };
+			for (auto const& [offset, size] : ranges)
+			{
+				std::vector<char> range(size);
+				PHX_CHECK(fs.ReadFileRange(path, offset, size, range.data()));
+				PHX_CHECK(std::memcmp(range.data(), contents.data() + offset, size) == 0);
+			}
+
+			std::vector<char> past(16);
+			PHX_CHECK(!fs.ReadFileRange(path, contents.size() - 8, past.size(), past.data()));
+
+			// Files are read with the codec they were written with.
+			CompressedFileSystem otherCodec(native, codec == Codec::Type::Lz4 ? Codec::Type::GDeflate : Codec::Type::Lz4);
+			PHX_CHECK(Matches(otherCodec.ReadFile(path).get(), contents));
+		}
+
+		// Files without the header pass through.
+		const std::vector<char> plain = WriteTestFile(directory / "plain.bin", 4_KiB);
+		CompressedFileSystem fs(native);
+		PHX_CHECK(Matches(fs.ReadFile(directory / "plain.bin").get(), plain));
+	}
+
+	void TestCompressedTileSizes()
+	{
+		const std::filesystem::path directory = GetTestDirectory();
+		std::vector<char> contents(300_KiB + 17);
+		for (size_t i = 0; i < contents.size(); i++)
+		{
+			contents[i] = static_cast<char>((i / 64) % 2 ? i % 11 : (i * 2654435761u) >> 24);
+		}
+
+		std::shared_ptr<IFileSystem> native = FileSystemFactory::CreateNativeFileSystem();
+		const std::filesystem::path path = directory / "tiled.bin";
+		for (uint32_t tileSize : { 4_KiB, 256_KiB })
+		{
+			CompressedFileSystem fs(native, Codec::Type::Lz4, 0, tileSize);
+			PHX_CHECK(fs.WriteFile(path, Span<char>(contents.data(), contents.size())));
+
+			// Readers take the tile size from the file, not from their own setting.
+			CompressedFileSystem defaultTiles(native);
+			PHX_CHECK(Matches(defaultTiles.ReadFile(path).get(), contents));
+
+			std::vector<char> range(10_KiB);
+			PHX_CHECK(defaultTiles.ReadFileRange(path, 250_KiB + 3, range.size(), range.data()));
+			PHX_CHECK(std::memcmp(range.data(), contents.data() + 250_KiB + 3, range.size()) == 0);
+		}
+
+		// GDeflate tiles are fixed, another size falls back to them rather than failing writes.
+		CompressedFileSystem gdeflate(native, Codec::Type::GDeflate, 0, 256_KiB);
+		PHX_CHECK(gdeflate.WriteFile(path, Span<char>(contents.data(), contents.size())));
+		PHX_CHECK(std::filesystem::file_size(path) < contents.size() / 2);
+		PHX_CHECK(Matches(gdeflate.ReadFile(path).get(), contents));
+	}
+
+	void TestEmptyAndMissingFiles()
+	{
+		const std::filesystem::path directory = GetTestDirectory();
+		WriteTestFile(directory / "empty.bin", 0);
+
+		std::unique_ptr<IFileSystem> fs = FileSystemFactory::CreateNativeFileSystem(nullptr, 0);
+		PHX_CHECK(IBlob::IsEmpty(fs->ReadFile(directory / "empty.bin").get()));
+		PHX_CHECK(fs->ReadFile(directory / "missing.bin") == nullptr);
+		PHX_CHECK(fs->MapFile(directory / "missing.bin") == nullptr);
+	}
+}
+
+int main()
+{
+	Log::Initialize();
+
+	Memory::MemoryConfiguration config = {};
+	config.VirtualMemorySize = 8_GiB;
+	config.HeapReserveSize = 64_MiB;
+	config.HeapCommitGranularity = 1_MiB;
+	Memory::Initialize(config);
+
+	std::filesystem::create_directories(GetTestDirectory());
+
+	Test::Run("CopyAndMappedReadsMatch", TestCopyAndMappedReadsMatch);
+	Test::Run("ThresholdDisablesMapping", TestThresholdDisablesMapping);
+	Test::Run("MappingOutlivesFile", TestMappingOutlivesFile);
+	Test::Run("EmptyAndMissingFiles", TestEmptyAndMissingFiles);
+	Test::Run("CacheDropsEverythingOnRescan", TestCacheDropsEverythingOnRescan);
+	Test::Run("WatcherRescansMovedDirectory", TestWatcherRescansMovedDirectory);
+	Test::Run("CompressedReadsMatch", TestCompressedReadsMatch);
+	Test::Run("CompressedTileSizes", TestCompressedTileSizes);
+
+	std::error_code ec;
+	std::filesystem::remove_all(GetTestDirectory(), ec);
+
+	Memory::Finalize();
+	return Test::Result();
+}
@@ -0,0 +1,361 @@
+#include "phxTest.h"
+
+#include <phxLog.h>
+#include <EmberGfx/phxHandlePool.h>
+
+#include <atomic>
+#include <memory>
+#include <random>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace phx;
+using namespace phx::gfx;
+
+namespace
+{
+	struct Resource
+	{
+		uint32_t Id = 0;
+		// Non trivial members, copying entries with memcpy would break these.
+		std::string Name;
+		std::shared_ptr<uint32_t> Owner;
+		std::vector<uint32_t> Views;
+	};
+
+	using ResourcePool = HandlePool<Resource, Resource>;
+	using ConcurrentResourcePool = ConcurrentHandlePool<Resource, Resource>;
+
+	struct ResourceCold
+	{
+		std::string DebugName;
+		std::vector<uint32_t> SubresourceViews;
+	};
+
+	Resource MakeResource(uint32_t id)
+	{
+		return Resource{
+			.Id = id,
+			.Name = "resource with a name too long for the small string buffer " + std::to_string(id),
+			.Owner = std::make_shared<uint32_t>(id),
+			.Views = std::vector<uint32_t>(4, id) };
+	}
+
+	bool IsIntact(Resource const& resource, uint32_t id)
+	{
+		return
+			resource.Id == id &&
+			resource.Name == MakeResource(id).Name &&
+			resource.Owner && *resource.Owner == id &&
+			resource.Views.size() == 4 && resource.Views[3] == id;
+	}
+
+	void TestPointersSurviveGrowth()
+	{
+		ResourcePool pool;
+		pool.Initialize(1);
+
+		Handle<Resource> first = pool.Insert(MakeResource(0));
+		Resource* firstPtr = pool.Get(first);
+		PHX_CHECK(firstPtr != nullptr);
+
+		// Grow well past the first page, entries must neither move nor be copied.
+		std::vector<Handle<Resource>> handles;
+		std::vector<Resource*> pointers;
+		for (uint32_t i = 1; i < 10 * ResourcePool::kPageSize; i++)
+		{
+			handles.push_back(pool.Insert(MakeResource(i)));
+			pointers.push_back(pool.Get(handles.back()));
+		}
+
+		PHX_CHECK(pool.GetCapacity() >= 10 * ResourcePool::kPageSize);
+		PHX_CHECK(pool.Get(first) == firstPtr && IsIntact(*firstPtr, 0));
+		for (size_t i = 0; i < handles.size(); i++)
+		{
+			PHX_CHECK(pool.Get(handles[i]) == pointers[i]);
+			PHX_CHECK(IsIntact(*pointers[i], static_cast<uint32_t>(i + 1)));
+		}
+	}
+
+	void TestStaleHandlesAreRejected()
+	{
+		ResourcePool pool;
+		pool.Initialize();
+
+		Handle<Resource> handle = pool.Insert(MakeResource(1));
+		std::weak_ptr<uint32_t> owner = pool.Get(handle)->Owner;
+		pool.Release(handle);
+
+		// The entry was destroyed on release and the old handle no longer resolves.
+		PHX_CHECK(owner.expired());
+		PHX_CHECK(!pool.Contains(handle));
+		PHX_CHECK(pool.Get(handle) == nullptr);
+
+		// The slot is reused with a new generation, releasing the stale handle again is a no-op.
+		Handle<Resource> reused = pool.Insert(MakeResource(2));
+		PHX_CHECK(!(reused == handle));
+		pool.Release(handle);
+		PHX_CHECK(pool.Contains(reused) && IsIntact(*pool.Get(reused), 2));
+		PHX_CHECK(pool.GetNumActiveEntries() == 1);
+	}
+
+	void TestLiveIndicesAreNeverReissued()
+	{
+		ResourcePool pool;
+		pool.Initialize(1);
+
+		// Random churn across growth. Every live entry must keep its value, which fails if a live
+		// index is handed out a second time.
+		std::mt19937 rng(7);
+		std::vector<std::pair<Handle<Resource>, uint32_t>> live;
+		uint32_t nextId = 0;
+		for (int i = 0; i < 20000; i++)
+		{
+			if (live.empty() || rng() % 3 != 0)
+			{
+				const uint32_t id = nextId++;
+				live.emplace_back(pool.Insert(MakeResource(id)), id);
+			}
+			else
+			{
+				const size_t victim = rng() % live.size();
+				pool.Release(live[victim].first);
+				live[victim] = live.back();
+				live.pop_back();
+			}
+		}
+
+		PHX_CHECK(pool.GetNumActiveEntries() == live.size());
+		for (auto const& [handle, id] : live)
+		{
+			Resource* resource = pool.Get(handle);
+			PHX_CHECK(resource && IsIntact(*resource, id));
+		}
+	}
+
+	void TestFinalizeDestroysEntries()
+	{
+		std::weak_ptr<uint32_t> owner;
+		{
+			ResourcePool pool;
+			pool.Initialize();
+			owner = pool.Get(pool.Insert(MakeResource(3)))->Owner;
+			PHX_CHECK(!owner.expired());
+		}
+
+		PHX_CHECK(owner.expired());
+	}
+
+	void TestLiveIteration()
+	{
+		ResourcePool pool;
+		ConcurrentResourcePool concurrentPool;
+
+		std::vector<Handle<Resource>> handles;
+		std::vector<Handle<Resource>> concurrentHandles;
+		for (uint32_t i = 0; i < 3 * ResourcePool::kPageSize; i++)
+		{
+			handles.push_back(pool.Insert(MakeResource(i)));
+			concurrentHandles.push_back(concurrentPool.Insert(MakeResource(i)));
+		}
+
+		// Release every odd entry, only the even ones may be visited.
+		std::set<uint32_t> expected;
+		for (uint32_t i = 0; i < handles.size(); i++)
+		{
+			if (i % 2)
+			{
+				pool.Release(handles[i]);
+				concurrentPool.Release(concurrentHandles[i]);
+			}
+			else
+			{
+				expected.insert(i);
+			}
+		}
+
+		PHX_CHECK(pool.GetLiveHandles().Size() == expected.size());
+		PHX_CHECK(concurrentPool.GetLiveHandles().Size() == expected.size());
+
+		std::set<uint32_t> visited;
+		pool.ForEach([&](Handle<Resource> handle, Resource& resource)
+			{
+				PHX_CHECK(pool.Get(handle) == &resource);
+				visited.insert(resource.Id);
+			});
+		PHX_CHECK(visited == expected);
+
+		std::set<uint32_t> concurrentVisited;
+		concurrentPool.ForEach([&](Handle<Resource> handle, Resource& resource)
+			{
+				PHX_CHECK(concurrentPool.Get(handle) == &resource && IsIntact(resource, resource.Id));
+				concurrentVisited.insert(resource.Id);
+			});
+		PHX_CHECK(concurrentVisited == expected);
+	}
+
+	template<typename TPool>
+	void CheckColdData()
+	{
+		TPool pool;
+		pool.Initialize();
+
+		Handle<Resource> handle = pool.Insert(MakeResource(1));
+		Handle<Resource> other = pool.Insert(MakeResource(2));
+		pool.GetCold(handle)->DebugName = "Texture";
+		pool.GetCold(handle)->SubresourceViews.push_back(7);
+		PHX_CHECK(pool.GetCold(other)->DebugName.empty());
+
+		// Cold data is reset along with the entry and isn't reachable from a stale handle.
+		pool.Release(handle);
+		PHX_CHECK(pool.GetCold(handle) == nullptr);
+
+		// The freed slot is the next one handed out.
+		Handle<Resource> reused = pool.Insert(MakeResource(3));
+		PHX_CHECK(pool.GetCold(reused)->DebugName.empty() && pool.GetCold(reused)->SubresourceViews.empty());
+	}
+
+	void TestColdData()
+	{
+		CheckColdData<HandlePool<Resource, Resource, ResourceCold>>();
+		CheckColdData<ConcurrentHandlePool<Resource, Resource, ResourceCold>>();
+	}
+
+	void TestConcurrentFuzz()
+	{
+		constexpr uint32_t kNumThreads = 8;
+		constexpr uint32_t kNumOps = 20000;
+		ConcurrentResourcePool pool;
+
+		// Each thread churns its own handles. A free list that hands the same index to two threads
+		// shows up as an entry whose value changed underneath its owner.
+		std::atomic<uint32_t> numCorrupt = 0;
+		std::vector<std::vector<std::pair<Handle<Resource>, uint32_t>>> live(kNumThreads);
+		std::vector<std::thread> threads;
+		for (uint32_t t = 0; t < kNumThreads; t++)
+		{
+			threads.emplace_back([&, t]()
+				{
+					std::mt19937 rng(t);
+					auto& handles = live[t];
+					for (uint32_t i = 0; i < kNumOps; i++)
+					{
+						const uint32_t id = t * kNumOps + i;
+						const uint32_t op = rng() % 8;
+						if (handles.empty() || op < 4)
+						{
+							handles.emplace_back(pool.Insert(MakeResource(id)), id);
+						}
+						else if (op < 7)
+						{
+							const size_t victim = rng() % handles.size();
+							pool.Release(handles[victim].first);
+							handles[victim] = handles.back();
+							handles.pop_back();
+						}
+						else
+						{
+							auto const& [handle, value] = handles[rng() % handles.size()];
+							Resource* resource = pool.Get(handle);
+							if (!resource || !IsIntact(*resource, value))
+							{
+								numCorrupt++;
+							}
+						}
+					}
+				});
+		}
+
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+
+		PHX_CHECK(numCorrupt == 0);
+
+		size_t numLive = 0;
+		for (auto const& handles : live)
+		{
+			numLive += handles.size();
+			for (auto const& [handle, id] : handles)
+			{
+				Resource* resource = pool.Get(handle);
+				PHX_CHECK(resource && IsIntact(*resource, id));
+			}
+		}
+		PHX_CHECK(pool.GetNumActiveEntries() == numLive);
+
+		// The dense list holds exactly the live handles.
+		size_t numVisited = 0;
+		pool.ForEach([&](Handle<Resource> handle, Resource& resource)
+			{
+				PHX_CHECK(pool.Get(handle) == &resource);
+				numVisited++;
+			});
+		PHX_CHECK(numVisited == numLive && pool.GetLiveHandles().Size() == numLive);
+	}
+
+	void TestConcurrentRacingReleases()
+	{
+		constexpr uint32_t kNumThreads = 4;
+		constexpr uint32_t kNumHandles = 4096;
+		ConcurrentResourcePool pool;
+
+		std::vector<Handle<Resource>> handles;
+		for (uint32_t i = 0; i < kNumHandles; i++)
+		{
+			handles.push_back(pool.Insert(MakeResource(i)));
+		}
+
+		// Every thread releases every handle, only one release per handle may push its index.
+		std::vector<std::thread> threads;
+		for (uint32_t t = 0; t < kNumThreads; t++)
+		{
+			threads.emplace_back([&]()
+				{
+					for (Handle<Resource> handle : handles)
+					{
+						pool.Release(handle);
+					}
+				});
+		}
+
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+
+		PHX_CHECK(pool.IsEmpty() && pool.GetLiveHandles().Size() == 0);
+
+		// A duplicated free index would give two of these the same slot.
+		std::vector<Handle<Resource>> reused;
+		for (uint32_t i = 0; i < kNumHandles; i++)
+		{
+			reused.push_back(pool.Insert(MakeResource(i)));
+		}
+
+		for (uint32_t i = 0; i < kNumHandles; i++)
+		{
+			PHX_CHECK(!pool.Contains(handles[i]));
+			PHX_CHECK(IsIntact(*pool.Get(reused[i]), i));
+		}
+	}
+}
+
+int main()
+{
+	Log::Initialize();
+
+	Test::Run("PointersSurviveGrowth", TestPointersSurviveGrowth);
+	Test::Run("StaleHandlesAreRejected", TestStaleHandlesAreRejected);
+	Test::Run("LiveIndicesAreNeverReissued", TestLiveIndicesAreNeverReissued);
+	Test::Run("FinalizeDestroysEntries", TestFinalizeDestroysEntries);
+	Test::Run("LiveIteration", TestLiveIteration);
+	Test::Run("ColdData", TestColdData);
+	Test::Run("ConcurrentFuzz", TestConcurrentFuzz);
+	Test::Run("ConcurrentRacingReleases", TestConcurrentRacingReleases);
+
+	return Test::Result();
+}
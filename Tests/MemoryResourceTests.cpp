@@ -0,0 +1,128 @@
+#include "phxTest.h"
+
+#include <phxLog.h>
+#include <phxMemoryResource.h>
+
+#include <array>
+#include <new>
+
+using namespace phx;
+
+namespace
+{
+	void TestStackResourceUsesAllocator()
+	{
+		VirtualStackAllocator allocator(64_KiB, VirtualStackAllocator::ThreadingMode::Locked);
+		StackMemoryResource resource(allocator);
+
+		const VirtualStackAllocator::Marker marker = allocator.GetMarker();
+		{
+			pmr::Vector<uint64_t> values(&resource);
+			for (uint64_t i = 0; i < 1000; i++)
+			{
+				values.push_back(i);
+			}
+
+			uint64_t sum = 0;
+			for (uint64_t v : values)
+			{
+				sum += v;
+			}
+			PHX_CHECK(sum == 999 * 1000 / 2);
+
+			// Growth only ever bumps the cursor, the old buffers are left behind.
+			const VirtualStackAllocator::Marker after = allocator.GetMarker();
+			PHX_CHECK(after.PageIndex != marker.PageIndex || after.ByteOffset >= 1000 * sizeof(uint64_t));
+		}
+
+		// Freeing the marker hands everything back, the next allocation starts at the same place.
+		allocator.FreeMarker(marker);
+		void* first = resource.allocate(16, 16);
+		allocator.FreeMarker(marker);
+		PHX_CHECK(resource.allocate(16, 16) == first);
+	}
+
+	void TestStackResourceEquality()
+	{
+		VirtualStackAllocator a(64_KiB, VirtualStackAllocator::ThreadingMode::Locked);
+		VirtualStackAllocator b(64_KiB, VirtualStackAllocator::ThreadingMode::Locked);
+		StackMemoryResource resourceA(a);
+		StackMemoryResource otherA(a);
+		StackMemoryResource resourceB(b);
+
+		PHX_CHECK(resourceA.is_equal(otherA));
+		PHX_CHECK(!resourceA.is_equal(resourceB));
+		PHX_CHECK(!resourceA.is_equal(*std::pmr::new_delete_resource()));
+	}
+
+	void TestStackResourceThrowsWhenExhausted()
+	{
+		// A single arena page, anything larger can't be satisfied.
+		VirtualStackAllocator allocator(64_KiB, VirtualStackAllocator::ThreadingMode::PerThread, 1);
+		StackMemoryResource resource(allocator);
+
+		bool threw = false;
+		try
+		{
+			(void)resource.allocate(128_KiB, 16);
+		}
+		catch (std::bad_alloc const&)
+		{
+			threw = true;
+		}
+		PHX_CHECK(threw);
+	}
+
+	void TestScopedScratchReleasesMarker()
+	{
+		// Every scope starts where the previous one did since its marker was freed.
+		std::array<const char*, 3> allocations = {};
+		for (const char*& allocation : allocations)
+		{
+			ScopedScratchMemoryResource scratch;
+			pmr::String text("a string long enough to not fit the small string buffer", &scratch);
+			pmr::UnorderedMap<uint32_t, pmr::Vector<uint32_t>> map(&scratch);
+			for (uint32_t i = 0; i < 64; i++)
+			{
+				map[i % 8].push_back(i);
+			}
+
+			PHX_CHECK(map.size() == 8 && map[3].size() == 8);
+			PHX_CHECK(map[3].get_allocator().resource() == &scratch);
+			allocation = text.data();
+		}
+
+		PHX_CHECK(allocations[0] == allocations[1] && allocations[1] == allocations[2]);
+	}
+
+	void TestFrameResource()
+	{
+		{
+			pmr::Vector<int> values(Memory::GetFrameResource());
+			values.assign(100, 7);
+			PHX_CHECK(values.size() == 100 && values[99] == 7);
+		}
+
+		Memory::BeginFrame();
+	}
+}
+
+int main()
+{
+	Log::Initialize();
+
+	Memory::MemoryConfiguration config = {};
+	config.VirtualMemorySize = 8_GiB;
+	config.HeapReserveSize = 64_MiB;
+	config.HeapCommitGranularity = 1_MiB;
+	Memory::Initialize(config);
+
+	Test::Run("StackResourceUsesAllocator", TestStackResourceUsesAllocator);
+	Test::Run("StackResourceEquality", TestStackResourceEquality);
+	Test::Run("StackResourceThrowsWhenExhausted", TestStackResourceThrowsWhenExhausted);
+	Test::Run("ScopedScratchReleasesMarker", TestScopedScratchReleasesMarker);
+	Test::Run("FrameResource", TestFrameResource);
+
+	Memory::Finalize();
+	return Test::Result();
+}
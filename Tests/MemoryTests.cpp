@@ -0,0 +1,249 @@
+#include "phxTest.h"
+
+#include <phxLog.h>
+#include <phxMemory.h>
+
+#include <cstring>
+#include <thread>
+#include <vector>
+
+using namespace phx;
+
+namespace
+{
+	Memory::MemoryConfiguration TestConfig()
+	{
+		Memory::MemoryConfiguration config = {};
+		config.VirtualMemorySize = 8_GiB;
+		config.HeapReserveSize = 64_MiB;
+		config.HeapCommitGranularity = 1_MiB;
+		return config;
+	}
+
+	void TestVirtualMemPageRounding()
+	{
+		const size_t pageSize = VirtualMemPageSize();
+		uint8_t* base = static_cast<uint8_t*>(VirtualMemReserve(4 * pageSize));
+		PHX_CHECK(base != nullptr);
+
+		// An unaligned range straddling a page boundary commits both pages.
+		uint8_t* straddle = base + pageSize - 8;
+		PHX_CHECK(VirtualMemCommit(straddle, 16));
+		std::memset(straddle, 1, 16);
+
+		// Neither page is entirely inside the range, so both stay committed.
+		PHX_CHECK(VirtualMemDecommit(straddle, 16));
+		PHX_CHECK(straddle[0] == 1 && straddle[15] == 1);
+
+		PHX_CHECK(VirtualMemFree(base, 4 * pageSize));
+	}
+
+	void TestSubPageStackPages()
+	{
+		// Page sizes that aren't a multiple of the OS page still get page aligned reservations.
+		VirtualStackAllocator allocator(1000, VirtualStackAllocator::ThreadingMode::Locked);
+		for (size_t size : { 900, 900, 3000, 900 })
+		{
+			uint8_t* ptr = allocator.AllocArray<uint8_t>(size);
+			PHX_CHECK(ptr != nullptr);
+			if (ptr)
+			{
+				std::memset(ptr, 0xEF, size);
+			}
+		}
+	}
+
+	void TestArenaResetReusesPages()
+	{
+		VirtualStackAllocator allocator(64_KiB, VirtualStackAllocator::ThreadingMode::PerThread, 64);
+
+		uint8_t* first = allocator.AllocArray<uint8_t>(1024);
+		PHX_CHECK(first != nullptr);
+		std::memset(first, 0xAB, 1024);
+
+		// The bumped generation drops the arena cursor, so the same page is handed out again.
+		allocator.Reset();
+		uint8_t* second = allocator.AllocArray<uint8_t>(1024);
+		PHX_CHECK(second == first);
+
+		uint8_t* third = allocator.AllocArray<uint8_t>(1024);
+		PHX_CHECK(third == second + 1024);
+	}
+
+	void TestArenaMarker()
+	{
+		VirtualStackAllocator allocator(64_KiB, VirtualStackAllocator::ThreadingMode::PerThread, 64);
+
+		(void)allocator.AllocArray<uint8_t>(128);
+		const VirtualStackAllocator::Marker marker = allocator.GetMarker();
+		uint8_t* scoped = allocator.AllocArray<uint8_t>(256);
+		allocator.FreeMarker(marker);
+		PHX_CHECK(allocator.AllocArray<uint8_t>(256) == scoped);
+	}
+
+	void TestArenaThreadsDontOverlap()
+	{
+		constexpr uint32_t kNumThreads = 4;
+		constexpr size_t kNumAllocations = 2000;
+		VirtualStackAllocator allocator(64_KiB, VirtualStackAllocator::ThreadingMode::PerThread, 512);
+
+		for (int frame = 0; frame < 3; frame++)
+		{
+			std::vector<std::vector<uint32_t*>> allocations(kNumThreads);
+			std::vector<std::thread> threads;
+			for (uint32_t t = 0; t < kNumThreads; t++)
+			{
+				threads.emplace_back([&, t]()
+					{
+						for (size_t i = 0; i < kNumAllocations; i++)
+						{
+							uint32_t* value = allocator.Alloc<uint32_t>(t);
+							allocations[t].push_back(value);
+						}
+					});
+			}
+
+			for (std::thread& thread : threads)
+			{
+				thread.join();
+			}
+
+			// Any overlap between threads would have overwritten another thread's value.
+			for (uint32_t t = 0; t < kNumThreads; t++)
+			{
+				PHX_CHECK(allocations[t].size() == kNumAllocations);
+				for (uint32_t* value : allocations[t])
+				{
+					PHX_CHECK(value && *value == t);
+				}
+			}
+
+			allocator.Reset();
+		}
+	}
+
+	void TestLargeBlocksAreReused()
+	{
+		VirtualStackAllocator allocator(64_KiB, VirtualStackAllocator::ThreadingMode::Locked);
+
+		void* large = allocator.Allocate(200_KiB, 16);
+		void* other = allocator.Allocate(150_KiB, 16);
+		PHX_CHECK(large && other && large != other);
+		std::memset(large, 0, 200_KiB);
+		std::memset(other, 0, 150_KiB);
+
+		allocator.Reset();
+
+		// Both blocks are free again, the smaller request takes the best fitting one.
+		PHX_CHECK(allocator.Allocate(150_KiB, 16) == other);
+		PHX_CHECK(allocator.Allocate(200_KiB, 16) == large);
+		PHX_CHECK(allocator.Allocate(100_KiB, 16) != large);
+	}
+
+	void TestLargeBlocksDecommitWhenIdle()
+	{
+		VirtualStackAllocator allocator(64_KiB, VirtualStackAllocator::ThreadingMode::Locked);
+		allocator.SetDecommitIdleFrames(2);
+
+		uint8_t* large = static_cast<uint8_t*>(allocator.Allocate(200_KiB, 16));
+		PHX_CHECK(large != nullptr);
+
+		// Idle for a whole window, decommitted, then recommitted on reuse.
+		for (int i = 0; i < 4; i++)
+		{
+			allocator.Reset();
+		}
+
+		uint8_t* reused = static_cast<uint8_t*>(allocator.Allocate(200_KiB, 16));
+		PHX_CHECK(reused == large);
+		std::memset(reused, 0xCD, 200_KiB);
+	}
+
+	void TestFrameRingRetirement()
+	{
+		FrameRingAllocator ring;
+		ring.Initialize(2, 64_KiB, 16);
+
+		uint32_t* frame0 = ring.Alloc<uint32_t>(0u);
+		PHX_CHECK(ring.BeginFrame(1, 0));
+		uint32_t* frame1 = ring.Alloc<uint32_t>(1u);
+		PHX_CHECK(frame1 != frame0);
+
+		// Frame 0's region can't be reused until frame 0 has completed.
+		PHX_CHECK(!ring.BeginFrame(2, 0));
+		PHX_CHECK(ring.GetCurrentFrame() == 1);
+		PHX_CHECK(*frame0 == 0 && *frame1 == 1);
+
+		PHX_CHECK(ring.BeginFrame(2, 1));
+		PHX_CHECK(ring.Alloc<uint32_t>(2u) == frame0);
+		PHX_CHECK(*frame1 == 1);
+
+		ring.Finalize();
+	}
+
+	void TestThreadIndexRecycling()
+	{
+		const uint32_t mainIndex = Memory::GetThreadIndex();
+
+		uint32_t firstIndex = 0;
+		std::thread([&]() { firstIndex = Memory::GetThreadIndex(); }).join();
+		PHX_CHECK(firstIndex != mainIndex);
+
+		// Threads coming and going keep reusing the lowest free index.
+		for (size_t i = 0; i < 2 * VirtualStackAllocator::kMaxThreadArenas; i++)
+		{
+			uint32_t index = 0;
+			std::thread([&]() { index = Memory::GetThreadIndex(); }).join();
+			PHX_CHECK(index == firstIndex);
+		}
+	}
+
+	void TestReinitialize()
+	{
+		// Pages the global allocators were given point into the reservation Finalize frees.
+		std::memset(Memory::GetFrameAllocator().AllocArray<uint8_t>(1024), 0xAB, 1024);
+		std::memset(Memory::GetScratchAllocator().AllocArray<uint8_t>(1024), 0xAB, 1024);
+		Memory::Finalize();
+
+		// A reservation that can't be made leaves allocations failing rather than pointing at nothing.
+		Memory::MemoryConfiguration tooLarge = TestConfig();
+		tooLarge.VirtualMemorySize = size_t(1) << 62;
+		Memory::Initialize(tooLarge);
+		PHX_CHECK(Memory::GetFrameAllocator().Allocate(1024, 16) == nullptr);
+		PHX_CHECK(Memory::GetHeapIfInitialized() == nullptr);
+		Memory::Finalize();
+
+		Memory::Initialize(TestConfig());
+		for (VirtualStackAllocator* allocator : { &Memory::GetFrameAllocator(), &Memory::GetScratchAllocator() })
+		{
+			uint8_t* ptr = allocator->AllocArray<uint8_t>(1024);
+			PHX_CHECK(ptr != nullptr);
+			if (ptr)
+			{
+				std::memset(ptr, 0xCD, 1024);
+			}
+		}
+		PHX_CHECK(Memory::GetHeapIfInitialized() == &Memory::GetHeap());
+	}
+}
+
+int main()
+{
+	Log::Initialize();
+
+	Memory::Initialize(TestConfig());
+
+	Test::Run("VirtualMemPageRounding", TestVirtualMemPageRounding);
+	Test::Run("SubPageStackPages", TestSubPageStackPages);
+	Test::Run("ArenaResetReusesPages", TestArenaResetReusesPages);
+	Test::Run("ArenaMarker", TestArenaMarker);
+	Test::Run("ArenaThreadsDontOverlap", TestArenaThreadsDontOverlap);
+	Test::Run("LargeBlocksAreReused", TestLargeBlocksAreReused);
+	Test::Run("LargeBlocksDecommitWhenIdle", TestLargeBlocksDecommitWhenIdle);
+	Test::Run("FrameRingRetirement", TestFrameRingRetirement);
+	Test::Run("ThreadIndexRecycling", TestThreadIndexRecycling);
+	Test::Run("Reinitialize", TestReinitialize);
+
+	Memory::Finalize();
+	return Test::Result();
+}
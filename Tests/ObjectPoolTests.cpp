@@ -0,0 +1,176 @@
+#include "phxTest.h"
+
+#include <phxLog.h>
+#include <phxObjectPool.h>
+
+#include <set>
+#include <thread>
+#include <vector>
+
+using namespace phx;
+
+namespace
+{
+	struct Node
+	{
+		uint64_t Value;
+		uint32_t Owner;
+	};
+
+	void TestNewDeleteReusesSlots()
+	{
+		ObjectPool<Node> pool(1024);
+
+		Node* first = pool.New(Node{ .Value = 1, .Owner = 0 });
+		PHX_CHECK(first && first->Value == 1);
+		pool.Delete(first);
+
+		// The slot sits in this thread's magazine and comes straight back.
+		Node* second = pool.New(Node{ .Value = 2, .Owner = 0 });
+		PHX_CHECK(second == first);
+		pool.Delete(second);
+	}
+
+	void TestExhaustion()
+	{
+		ObjectPool<Node> pool(16, 4_KiB);
+
+		std::vector<Node*> nodes;
+		while (Node* node = pool.New())
+		{
+			nodes.push_back(node);
+		}
+		PHX_CHECK(nodes.size() == 16);
+
+		for (Node* node : nodes)
+		{
+			pool.Delete(node);
+		}
+	}
+
+	void TestCrossThreadFree()
+	{
+		constexpr size_t kNumObjects = 4096;
+		ObjectPool<Node> pool(kNumObjects);
+
+		// Allocated on one thread, freed on another.
+		std::vector<Node*> nodes;
+		std::thread([&]()
+			{
+				for (size_t i = 0; i < kNumObjects; i++)
+				{
+					nodes.push_back(pool.New(Node{ .Value = i, .Owner = 1 }));
+				}
+				pool.FlushThreadCache();
+			}).join();
+
+		PHX_CHECK(nodes.size() == kNumObjects);
+		PHX_CHECK(pool.GetNumSlotsCommitted() >= kNumObjects);
+
+		std::thread([&]()
+			{
+				for (size_t i = 0; i < kNumObjects; i++)
+				{
+					PHX_CHECK(nodes[i] && nodes[i]->Value == i);
+					pool.Delete(nodes[i]);
+				}
+				pool.FlushThreadCache();
+			}).join();
+
+		// Every slot made it back to the shared list, so a full pool can be allocated again
+		// from a third thread without running out.
+		std::set<Node*> reused;
+		for (size_t i = 0; i < kNumObjects; i++)
+		{
+			Node* node = pool.New();
+			PHX_CHECK(node != nullptr);
+			reused.insert(node);
+		}
+		PHX_CHECK(reused.size() == kNumObjects);
+		PHX_CHECK(reused == std::set<Node*>(nodes.begin(), nodes.end()));
+
+		for (Node* node : reused)
+		{
+			pool.Delete(node);
+		}
+		pool.FlushThreadCache();
+	}
+
+	void TestThreadsDontOverlap()
+	{
+		constexpr uint32_t kNumThreads = 4;
+		constexpr size_t kNumObjects = 5000;
+		// Magazines can hold on to slots another thread would need, leave room for them.
+		ObjectPool<Node> pool(kNumThreads * (kNumObjects + 64));
+
+		// Every thread allocates concurrently, then frees its neighbour's objects so slots
+		// move between magazines.
+		std::vector<std::vector<Node*>> live(kNumThreads);
+		std::vector<std::thread> threads;
+		for (uint32_t t = 0; t < kNumThreads; t++)
+		{
+			threads.emplace_back([&, t]()
+				{
+					for (size_t i = 0; i < kNumObjects; i++)
+					{
+						Node* node = pool.New(Node{ .Value = i, .Owner = t });
+						if (node)
+						{
+							live[t].push_back(node);
+						}
+					}
+				});
+		}
+
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+
+		for (uint32_t t = 0; t < kNumThreads; t++)
+		{
+			PHX_CHECK(live[t].size() == kNumObjects);
+			for (size_t i = 0; i < live[t].size(); i++)
+			{
+				PHX_CHECK(live[t][i]->Owner == t && live[t][i]->Value == i);
+			}
+		}
+
+		threads.clear();
+		for (uint32_t t = 0; t < kNumThreads; t++)
+		{
+			threads.emplace_back([&, t]()
+				{
+					for (Node* node : live[(t + 1) % kNumThreads])
+					{
+						pool.Delete(node);
+					}
+					pool.FlushThreadCache();
+				});
+		}
+
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+	}
+}
+
+int main()
+{
+	Log::Initialize();
+
+	Memory::MemoryConfiguration config = {};
+	config.VirtualMemorySize = 8_GiB;
+	config.HeapReserveSize = 64_MiB;
+	config.HeapCommitGranularity = 1_MiB;
+	Memory::Initialize(config);
+
+	Test::Run("NewDeleteReusesSlots", TestNewDeleteReusesSlots);
+	Test::Run("Exhaustion", TestExhaustion);
+	Test::Run("CrossThreadFree", TestCrossThreadFree);
+	Test::Run("ThreadsDontOverlap", TestThreadsDontOverlap);
+
+	Memory::Finalize();
+	return Test::Result();
+}
@@ -0,0 +1,185 @@
+#include "phxTest.h"
+
+#include <phxLog.h>
+#include <phxMemory.h>
+#include <phxRetirementQueue.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace phx;
+
+namespace
+{
+	void TestRetiresOnlyCompletedValues()
+	{
+		RetirementQueue queue;
+
+		// Value each callback was collected at, 0 while it hasn't run.
+		std::vector<uint64_t> collectedAt(30, 0);
+		uint64_t currentCollect = 0;
+		for (uint64_t i = 0; i < collectedAt.size(); i++)
+		{
+			const uint64_t retireValue = 1 + i / 3;
+			uint64_t* slot = &collectedAt[i];
+			uint64_t* current = &currentCollect;
+			queue.Retire(retireValue, [slot, current]() { *slot = *current; });
+		}
+
+		for (currentCollect = 1; currentCollect <= 10; currentCollect++)
+		{
+			queue.Collect(currentCollect);
+
+			// Everything up to and including the completed value ran, nothing after it.
+			for (uint64_t i = 0; i < collectedAt.size(); i++)
+			{
+				const uint64_t retireValue = 1 + i / 3;
+				PHX_CHECK(retireValue > currentCollect ? collectedAt[i] == 0 : collectedAt[i] == retireValue);
+			}
+		}
+
+		PHX_CHECK(queue.GetStats().NumRetiredTotal == collectedAt.size());
+		PHX_CHECK(queue.GetStats().NumPending == 0);
+	}
+
+	void TestFenceSkippingValues()
+	{
+		RetirementQueue queue;
+		CpuRetirementFence fence;
+
+		uint32_t numRun = 0;
+		uint32_t* counter = &numRun;
+		for (uint64_t value = 1; value <= 5; value++)
+		{
+			queue.Retire(value, [counter]() { (*counter)++; });
+		}
+
+		queue.Collect(fence);
+		PHX_CHECK(numRun == 0);
+		PHX_CHECK(queue.GetStats().NumPending == 5 && queue.GetStats().OldestPendingValue == 1);
+
+		// The fence jumping past several values retires all of them at once, and never goes back.
+		fence.Signal(4);
+		fence.Signal(2);
+		queue.Collect(fence);
+		PHX_CHECK(numRun == 4);
+		PHX_CHECK(queue.GetStats().NumRetiredLastCollect == 4 && queue.GetStats().OldestPendingValue == 5);
+
+		queue.Collect(fence);
+		PHX_CHECK(numRun == 4);
+	}
+
+	void TestBatchesOncePerCollect()
+	{
+		RetirementQueue queue;
+
+		std::vector<std::vector<uint64_t>> batches;
+		const RetireTypeId type = queue.RegisterBatchType([&](Span<uint64_t> payloads)
+			{
+				batches.emplace_back(payloads.begin(), payloads.end());
+			});
+
+		// More than a bucket's worth on one value, plus a later value that must wait.
+		for (uint64_t i = 0; i < 600; i++)
+		{
+			queue.Retire(type, 1, i);
+		}
+		queue.Retire(type, 2, 1000);
+
+		queue.Collect(1);
+		PHX_CHECK(batches.size() == 1 && batches[0].size() == 600);
+		PHX_CHECK(queue.GetStats().NumPendingByType[type] == 1);
+
+		queue.Collect(1);
+		PHX_CHECK(batches.size() == 1);
+
+		queue.Collect(2);
+		PHX_CHECK(batches.size() == 2 && batches[1].size() == 1 && batches[1][0] == 1000);
+	}
+
+	void TestConcurrentProducers()
+	{
+		constexpr uint32_t kNumThreads = 4;
+		constexpr uint64_t kNumValues = 200;
+		constexpr uint32_t kPerValue = 50;
+
+		RetirementQueue queue;
+		std::atomic<uint64_t> completed = 0;
+		std::atomic<uint32_t> numEarly = 0;
+		std::vector<std::atomic<uint32_t>> runCounts(kNumThreads * kNumValues * kPerValue);
+
+		struct Context
+		{
+			std::atomic<uint64_t>* Completed;
+			std::atomic<uint32_t>* NumEarly;
+		} context = { &completed, &numEarly };
+
+		// Producers retire against values ahead of the consumer, which collects concurrently.
+		std::vector<std::thread> producers;
+		for (uint32_t t = 0; t < kNumThreads; t++)
+		{
+			producers.emplace_back([&, t]()
+				{
+					for (uint64_t value = 1; value <= kNumValues; value++)
+					{
+						for (uint32_t i = 0; i < kPerValue; i++)
+						{
+							std::atomic<uint32_t>* runCount = &runCounts[(t * kNumValues + value - 1) * kPerValue + i];
+							Context* ctx = &context;
+							queue.Retire(value, [runCount, ctx, value]()
+								{
+									if (value > ctx->Completed->load())
+									{
+										ctx->NumEarly->fetch_add(1);
+									}
+									runCount->fetch_add(1);
+								});
+						}
+					}
+				});
+		}
+
+		for (uint64_t value = 1; value <= kNumValues; value++)
+		{
+			completed.store(value);
+			queue.Collect(value);
+			std::this_thread::yield();
+		}
+
+		for (std::thread& producer : producers)
+		{
+			producer.join();
+		}
+
+		queue.Collect(kNumValues);
+
+		PHX_CHECK(numEarly == 0);
+		uint32_t numWrong = 0;
+		for (auto const& count : runCounts)
+		{
+			numWrong += count.load() != 1;
+		}
+		PHX_CHECK(numWrong == 0);
+		PHX_CHECK(queue.GetStats().NumPending == 0);
+	}
+}
+
+int main()
+{
+	Log::Initialize();
+
+	Memory::MemoryConfiguration config = {};
+	config.VirtualMemorySize = 8_GiB;
+	config.HeapReserveSize = 64_MiB;
+	config.HeapCommitGranularity = 1_MiB;
+	Memory::Initialize(config);
+
+	Test::Run("RetiresOnlyCompletedValues", TestRetiresOnlyCompletedValues);
+	Test::Run("FenceSkippingValues", TestFenceSkippingValues);
+	Test::Run("BatchesOncePerCollect", TestBatchesOncePerCollect);
+	Test::Run("ConcurrentProducers", TestConcurrentProducers);
+
+	Memory::Finalize();
+	return Test::Result();
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdio>
+
+// Minimal checks for the engine tests. Each test executable runs its cases from main and
+// returns phx::Test::Result(), CTest treats a non zero exit code as a failure.
+namespace phx::Test
+{
+	inline int& NumFailures()
+	{
+		static int numFailures = 0;
+		return numFailures;
+	}
+
+	inline void Check(bool condition, const char* expression, const char* file, int line)
+	{
+		if (!condition)
+		{
+			std::fprintf(stderr, "%s(%d): check failed: %s\n", file, line, expression);
+			NumFailures()++;
+		}
+	}
+
+	template<typename TFunc>
+	void Run(const char* name, TFunc&& func)
+	{
+		const int failuresBefore = NumFailures();
+		func();
+		std::printf("[%s] %s\n", NumFailures() == failuresBefore ? "PASS" : "FAIL", name);
+	}
+
+	inline int Result()
+	{
+		return NumFailures() == 0 ? 0 : 1;
+	}
+}
+
+#define PHX_CHECK(expr) ::phx::Test::Check(static_cast<bool>(expr), #expr, __FILE__, __LINE__)
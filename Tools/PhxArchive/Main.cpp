@@ -4,9 +4,18 @@
 #include "pch.h"
 #include <iostream>
 
-#include <dstorage.h>
 #include <fstream>
 #include <assert.h>
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstring>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <semaphore>
+#include <thread>
 
 #include <Core/phxMemory.h>
 #include <Core/phxLog.h>
@@ -16,7 +25,13 @@
 #include <Core/phxBinaryBuilder.h>
 #include <RHI/phxRHI.h>
 #include <RHI/D3D12/d3dx12.h>
+#include <phxAsyncIo.h>
+#include <phxCodec.h>
+#include <phxCompressedFileSystem.h>
+#include <phxDerivedDataCache.h>
+#include <phxStringHash.h>
 
+#include "phxArchiveDependencies.h"
 #include "phxTextureConvert.h"
 #include "3rdParty/nlohmann/json.hpp"
 #include "phxModelImporter.h"
@@ -31,6 +46,9 @@ using namespace nlohmann;
 
 namespace
 {
+	// Bump when BuildDDS output changes, so conversions cached by older builds are ignored.
+	constexpr uint32_t kTextureConverterVersion = 1;
+
 	struct FormatMapping
 	{
 		rhi::Format PhxRHIFormat;
@@ -107,58 +125,46 @@ namespace
 	{ rhi::Format::BC7_UNORM,            DXGI_FORMAT_BC7_UNORM,              8 },
 	{ rhi::Format::BC7_UNORM_SRGB,       DXGI_FORMAT_BC7_UNORM_SRGB,         8 },
 	};
-	ComPtr<IDStorageCompressionCodec> g_bufferCompression;
+
+	Codec::Type ToCodec(arc::Compression compression)
+	{
+		switch (compression)
+		{
+		case arc::Compression::None:
+			return Codec::Type::None;
+		case arc::Compression::GDeflate:
+			return Codec::Type::GDeflate;
+		case arc::Compression::Lz4:
+			return Codec::Type::Lz4;
+		case arc::Compression::Zstd:
+			return Codec::Type::Zstd;
+		default:
+			throw std::runtime_error("Unsupported compression type");
+		}
+	}
 
 	template<typename T>
 	static std::remove_reference_t<T> Compress(arc::Compression compression, T&& source)
 	{
-		if (compression == marc::Compression::None)
+		Codec::Type const codec = ToCodec(compression);
+		if (codec == Codec::Type::None)
 		{
 			return source;
 		}
-		else
-		{
-			size_t maxSize;
-			if (compression == marc::Compression::GDeflate)
-				maxSize = g_bufferCompression->CompressBufferBound(static_cast<uint32_t>(source.size()));
-			else if (compression == marc::Compression::Zlib)
-				maxSize = static_cast<size_t>(compressBound(static_cast<uLong>(source.size())));
-			else
-				throw std::runtime_error("Unknown Compression type");
 
-			std::remove_reference_t<T> dest;
-			dest.resize(maxSize);
-
-			size_t actualCompressedSize = 0;
-
-			HRESULT compressionResult = S_OK;
-
-			if (compression == marc::Compression::GDeflate)
-			{
-				compressionResult = g_bufferCompression->CompressBuffer(
-					reinterpret_cast<const void*>(source.data()),
-					static_cast<uint32_t>(source.size()),
-					DSTORAGE_COMPRESSION_BEST_RATIO,
-					reinterpret_cast<void*>(dest.data()),
-					static_cast<uint32_t>(dest.size()),
-					&actualCompressedSize);
-			}
-			else if (compression == marc::Compression::Zlib)
-			{
-				throw std::runtime_error("Zlib is not supported");
-			}
+		std::remove_reference_t<T> dest;
+		dest.resize(Codec::CompressBound(codec, source.size()));
 
-			if (FAILED(compressionResult))
-			{
-				std::cout << "Failed to compress data using CompressBuffer, hr = 0x" << std::hex << compressionResult
-					<< std::endl;
-				std::abort();
-			}
+		size_t const compressedSize = Codec::Compress(codec, source.data(), source.size(), dest.data(), dest.size());
+		if (compressedSize == 0)
+		{
+			std::cout << "Failed to compress data using " << Codec::ToString(codec) << std::endl;
+			std::abort();
+		}
 
-			dest.resize(actualCompressedSize);
+		dest.resize(compressedSize);
 
-			return dest;
-		}
+		return dest;
 	}
 
 	std::string Compress(arc::Compression compression, std::stringstream sourceStream)
@@ -185,32 +191,54 @@ namespace
 	class Exporter
 	{
 	public:
+		// previousArchive is the archive described by the graph's previous record. Textures whose
+		// inputs are unchanged are spliced from it instead of being converted again. derivedData,
+		// if set, caches converted textures across archives and runs.
 		static void Export(
 			std::ostream& out,
+			std::istream* previousArchive,
+			ArchiveDependencyGraph& graph,
 			Compression compression,
+			bool verify,
 			TexConversionFlags extraTextureFlags,
 			uint32_t stagingBufferSizeBytes,
 			std::filesystem::path rootPath,
-			ModelData const& modelData)
+			ModelData const& modelData,
+			DerivedDataCache* derivedData)
 		{
-			Exporter exporter(out, compression, extraTextureFlags, stagingBufferSizeBytes, rootPath, modelData);
+			Exporter exporter(out, previousArchive, graph, compression, verify, extraTextureFlags, stagingBufferSizeBytes, rootPath, modelData, derivedData);
 			exporter.Export();
 		}
 
 	public:
 		Exporter(
 			std::ostream& out,
+			std::istream* previousArchive,
+			ArchiveDependencyGraph& graph,
 			Compression compression,
+			bool verify,
 			TexConversionFlags extraTextureFlags,
 			uint32_t stagingBufferSizeBytes,
 			std::filesystem::path rootPath,
-			ModelData const& modelData)
+			ModelData const& modelData,
+			DerivedDataCache* derivedData)
 			: m_out(out)
+			, m_previousArchive(previousArchive)
+			, m_graph(graph)
 			, m_compression(compression)
+			, m_verify(verify)
 			, m_extraTextureFlags(extraTextureFlags)
+			, m_stagingBufferSizeBytes(stagingBufferSizeBytes)
 			, m_rootPath(rootPath)
 			, m_modelData(modelData)
+			, m_derivedData(derivedData)
 		{
+			if (this->m_previousArchive)
+			{
+				this->m_previousArchive->seekg(0, std::ios::end);
+				this->m_previousArchiveSize = static_cast<uint64_t>(this->m_previousArchive->tellg());
+			}
+
 			if (auto hr = D3D12CreateDevice(nullptr, D3D_FEATURE_LEVEL_12_0, IID_PPV_ARGS(&m_device)); FAILED(hr))
 			{
 				PHX_ERROR("Failed to create D3D12 device");
@@ -259,24 +287,277 @@ namespace
 
 
 	private:
+		// Time spent in each stage, summed over every thread that ran it.
+		struct StageTimes
+		{
+			std::atomic<int64_t> Hash = 0;
+			std::atomic<int64_t> Convert = 0;
+			std::atomic<int64_t> Compress = 0;
+			std::atomic<int64_t> Write = 0;
+		};
+
+		class ScopedStageTimer
+		{
+		public:
+			explicit ScopedStageTimer(std::atomic<int64_t>& total)
+				: m_total(total)
+				, m_start(std::chrono::steady_clock::now())
+			{}
+
+			~ScopedStageTimer()
+			{
+				m_total += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_start).count();
+			}
+
+		private:
+			std::atomic<int64_t>& m_total;
+			std::chrono::steady_clock::time_point m_start;
+		};
+
+		// A region compressed and waiting for its place in the archive.
+		struct PendingRegion
+		{
+			std::string Name;
+			std::vector<char> Data;
+			Compression RegionCompression = Compression::None;
+			uint32_t UncompressedSize = 0;
+		};
+
+		struct PendingTexture
+		{
+			TextureNode const* Splice = nullptr;	// Copy this node's regions from the previous archive instead
+			TextureNode Node;
+			D3D12_RESOURCE_DESC Desc{};
+			std::vector<PendingRegion> SingleMips;
+			std::optional<PendingRegion> RemainingMips;
+		};
+
+		static double ToSeconds(int64_t nanoseconds)
+		{
+			return static_cast<double>(nanoseconds) / 1e9;
+		}
+
+		// Textures are hashed, converted and compressed concurrently, with each texture's mips
+		// compressed in parallel as well. Finished textures are written strictly in texture order by
+		// whichever thread completes the next one due, so the archive is identical at any thread count.
+		// At most twice the thread count are in flight ahead of the next one due, bounding how many
+		// finished out of order wait in memory.
 		void WriteTextures()
 		{
-			for (size_t i = 0; i < m_modelData.TextureNames.size(); ++i)
+			size_t const numTextures = m_modelData.TextureNames.size();
+			auto const start = std::chrono::steady_clock::now();
+
+			std::vector<std::optional<PendingTexture>> finished(numTextures);
+			std::vector<bool> ready(numTextures, false);
+			std::vector<std::exception_ptr> errors(numTextures);
+			std::exception_ptr writeError;
+			std::mutex readyMutex;
+			size_t nextToWrite = 0;
+			bool writing = false;
+
+			// A slot is taken before a texture index, so slots are always held by the oldest unwritten
+			// textures and the next one due never waits for one.
+			std::counting_semaphore<> slots(2 * std::max(std::thread::hardware_concurrency(), 1u));
+			std::atomic<uint32_t> nextToPrepare = 0;
+
+			ParallelFor(static_cast<uint32_t>(numTextures), [&](uint32_t)
+				{
+					slots.acquire();
+					uint32_t const i = nextToPrepare++;
+
+					std::optional<PendingTexture> texture;
+					try
+					{
+						uint8_t flags = this->m_modelData.TextureOptions[i];
+						flags |= m_extraTextureFlags;
+						texture = this->PrepareTexture(m_modelData.TextureNames[i], flags);
+					}
+					catch (...)
+					{
+						errors[i] = std::current_exception();
+					}
+
+					std::unique_lock lock(readyMutex);
+					finished[i] = std::move(texture);
+					ready[i] = true;
+					if (writing)
+					{
+						// The thread writing picks this one up when its turn comes.
+						return;
+					}
+
+					writing = true;
+					while (nextToWrite < numTextures && ready[nextToWrite])
+					{
+						std::optional<PendingTexture> next = std::move(finished[nextToWrite]);
+						finished[nextToWrite].reset();
+						nextToWrite++;
+						lock.unlock();
+
+						if (next && !writeError)
+						{
+							try
+							{
+								ScopedStageTimer timer(m_stageTimes.Write);
+								this->WritePendingTexture(*next);
+							}
+							catch (...)
+							{
+								writeError = std::current_exception();
+							}
+						}
+
+						next.reset();
+						slots.release();
+						lock.lock();
+					}
+					writing = false;
+				});
+
+			for (std::exception_ptr const& error : errors)
 			{
-				std::string const& textureName = m_modelData.TextureNames[i];
-				uint8_t flags = this->m_modelData.TextureOptions[i];
-				flags |= m_extraTextureFlags;
-				this->WriteTexture(textureName, flags);
+				if (error)
+				{
+					std::rethrow_exception(error);
+				}
+			}
+
+			if (writeError)
+			{
+				std::rethrow_exception(writeError);
 			}
+
+			double const wallTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			size_t const numCached = this->m_numCachedTextures;
+			PHX_INFO("Textures: %zu spliced from the previous archive, %zu from the derived data cache, %zu converted",
+				this->m_numSplicedTextures, numCached, numTextures - this->m_numSplicedTextures - numCached);
+			PHX_INFO("Texture stages, summed over threads: hash %.2fs, convert %.2fs, compress %.2fs, write %.2fs. %.2fs wall time on %u threads",
+				ToSeconds(m_stageTimes.Hash), ToSeconds(m_stageTimes.Convert), ToSeconds(m_stageTimes.Compress), ToSeconds(m_stageTimes.Write),
+				wallTime, std::thread::hardware_concurrency());
 		}
 
-		void WriteTexture(std::string const& name, uint8_t flags)
+		// Runs on any thread. Only touches the graph through its thread safe lookups, and leaves
+		// everything that depends on archive offsets to WritePendingTexture.
+		PendingTexture PrepareTexture(std::string const& name, uint8_t flags)
 		{
 			std::filesystem::path texturePath = this->m_rootPath;
 			texturePath /= name;
 			texturePath = absolute(texturePath);
 
-			auto image = TextureCompiler::BuildDDS(texturePath.string().c_str(), flags);
+			uint64_t sourceHash = 0;
+			{
+				ScopedStageTimer timer(m_stageTimes.Hash);
+				if (!this->m_graph.HashSourceFile(name, sourceHash))
+				{
+					PHX_ERROR("'%s' could not be read", texturePath.string().c_str());
+					throw std::runtime_error("Texture load failed");
+				}
+			}
+
+			uint64_t const inputs[] = { sourceHash, flags, static_cast<uint64_t>(m_compression), m_stagingBufferSizeBytes };
+			uint64_t const inputHash = fnv1a_64(reinterpret_cast<char const*>(inputs), sizeof(inputs));
+
+			PendingTexture texture;
+			texture.Node.Name = name;
+			texture.Node.InputHash = inputHash;
+
+			if (TextureNode const* upToDate = this->m_graph.FindUpToDateTexture(name, inputHash); upToDate && this->CanSplice(*upToDate))
+			{
+				texture.Splice = upToDate;
+				return texture;
+			}
+
+			{
+				ScopedStageTimer timer(m_stageTimes.Convert);
+				this->ConvertTexture(texturePath, name, sourceHash, flags, texture);
+			}
+
+			std::vector<PendingRegion*> regions;
+			for (PendingRegion& region : texture.SingleMips)
+				regions.push_back(&region);
+			if (texture.RemainingMips)
+				regions.push_back(&*texture.RemainingMips);
+
+			std::vector<std::exception_ptr> errors(regions.size());
+			ParallelFor(static_cast<uint32_t>(regions.size()), [&](uint32_t i)
+				{
+					try
+					{
+						ScopedStageTimer timer(m_stageTimes.Compress);
+						this->CompressRegion(*regions[i]);
+					}
+					catch (...)
+					{
+						errors[i] = std::current_exception();
+					}
+				});
+
+			for (std::exception_ptr const& error : errors)
+			{
+				if (error)
+				{
+					std::rethrow_exception(error);
+				}
+			}
+
+			return texture;
+		}
+
+		// Converted images are cached as DDS, keyed on the source contents and conversion flags.
+		std::unique_ptr<DirectX::ScratchImage> BuildTextureImage(std::filesystem::path const& texturePath, uint64_t sourceHash, uint8_t flags)
+		{
+			if (!this->m_derivedData)
+			{
+				return TextureCompiler::BuildDDS(texturePath.string().c_str(), flags);
+			}
+
+			DerivedDataKey const key = DerivedDataKeyBuilder("TextureCompiler::BuildDDS", kTextureConverterVersion)
+				.AppendValue(sourceHash)
+				.AppendValue(flags)
+				.AppendValue(static_cast<uint32_t>(DIRECTX_TEX_VERSION))
+				.Finish();
+
+			std::unique_ptr<DirectX::ScratchImage> image;
+			std::unique_ptr<IBlob> artifact = this->m_derivedData->GetOrBuild(key, [&]()
+				{
+					// Throwing keeps a failed conversion out of the cache.
+					image = TextureCompiler::BuildDDS(texturePath.string().c_str(), flags);
+					if (!image)
+					{
+						throw std::runtime_error("Texture load failed");
+					}
+
+					DirectX::Blob dds;
+					if (FAILED(DirectX::SaveToDDSMemory(image->GetImages(), image->GetImageCount(), image->GetMetadata(), DirectX::DDS_FLAGS_NONE, dds)))
+					{
+						PHX_ERROR("'%s' could not be stored as DDS", texturePath.string().c_str());
+						throw std::runtime_error("Texture caching failed");
+					}
+
+					char const* bytes = static_cast<char const*>(dds.GetBufferPointer());
+					return std::vector<char>(bytes, bytes + dds.GetBufferSize());
+				});
+
+			if (image)
+			{
+				return image;
+			}
+
+			image = std::make_unique<DirectX::ScratchImage>();
+			if (IBlob::IsEmpty(artifact.get()) ||
+				FAILED(DirectX::LoadFromDDSMemory(artifact->Data(), artifact->Size(), DirectX::DDS_FLAGS_NONE, nullptr, *image)))
+			{
+				PHX_ERROR("Cached conversion of '%s' could not be loaded", texturePath.string().c_str());
+				throw std::runtime_error("Texture load failed");
+			}
+
+			this->m_numCachedTextures++;
+			return image;
+		}
+
+		void ConvertTexture(std::filesystem::path const& texturePath, std::string const& name, uint64_t sourceHash, uint8_t flags, PendingTexture& texture)
+		{
+			auto image = this->BuildTextureImage(texturePath, sourceHash, flags);
 			if (!image)
 			{
 				throw std::runtime_error("Texture load failed");
@@ -309,8 +590,6 @@ namespace
 
 			auto const totalSubresourceCount = CD3DX12_RESOURCE_DESC(desc).Subresources(m_device.Get());
 
-			std::vector<GpuRegion> regions;
-
 			std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> layouts(totalSubresourceCount);
 			std::vector<UINT> numRows(totalSubresourceCount);
 			std::vector<UINT64> rowSizes(totalSubresourceCount);
@@ -350,7 +629,7 @@ namespace
 				std::stringstream regionName;
 				regionName << name << " mip " << currentSubresource;
 
-				regions.push_back(WriteTextureRegion(
+				texture.SingleMips.push_back(GatherTextureRegion(
 					currentSubresource,
 					1,
 					layouts,
@@ -376,13 +655,11 @@ namespace
 				}
 			}
 
-			GpuRegion remainingMipsRegion{};
-
 			if (currentSubresource < totalSubresourceCount)
 			{
 				std::stringstream regionName;
 				regionName << name << " mips " << currentSubresource << " to " << totalSubresourceCount;
-				remainingMipsRegion = WriteTextureRegion(
+				texture.RemainingMips = GatherTextureRegion(
 					currentSubresource,
 					totalSubresourceCount - currentSubresource,
 					layouts,
@@ -393,13 +670,130 @@ namespace
 					regionName.str());
 			}
 
-			TextureMetadata textureMetadata;
-			textureMetadata.SingleMips = std::move(regions);
-			textureMetadata.RemainingMips = remainingMipsRegion;
+			texture.Desc = desc;
+			texture.Node.Width = desc.Width;
+			texture.Node.Height = desc.Height;
+			texture.Node.DepthOrArraySize = desc.DepthOrArraySize;
+			texture.Node.MipLevels = desc.MipLevels;
+			texture.Node.Format = static_cast<uint32_t>(desc.Format);
+			texture.Node.Dimension = static_cast<uint32_t>(desc.Dimension);
+		}
+
+		// Called in texture order, places the texture's regions at the end of the archive.
+		void WritePendingTexture(PendingTexture& texture)
+		{
+			if (texture.Splice)
+			{
+				if (!this->SpliceTexture(*texture.Splice))
+				{
+					throw std::runtime_error("Failed to splice texture from previous archive");
+				}
+				return;
+			}
+
+			TextureMetadata textureMetadata{};
+			for (PendingRegion const& region : texture.SingleMips)
+			{
+				textureMetadata.SingleMips.push_back(this->WriteRegion<void>(region));
+				texture.Node.SingleMips.push_back(ToRecord(textureMetadata.SingleMips.back()));
+			}
 
+			if (texture.RemainingMips)
+			{
+				textureMetadata.RemainingMips = this->WriteRegion<void>(*texture.RemainingMips);
+				texture.Node.RemainingMips = ToRecord(textureMetadata.RemainingMips);
+			}
+
+			this->m_graph.AddTexture(std::move(texture.Node));
 			m_textureMetadata.push_back(std::move(textureMetadata));
+			m_textureDescs.push_back(texture.Desc);
+		}
+
+		bool CanSplice(TextureNode const& previous) const
+		{
+			if (!this->m_previousArchive)
+			{
+				return false;
+			}
+
+			auto inPreviousArchive = [this](RegionRecord const& r)
+				{
+					return r.Offset + r.CompressedSize <= this->m_previousArchiveSize;
+				};
+
+			return std::all_of(previous.SingleMips.begin(), previous.SingleMips.end(), inPreviousArchive) &&
+				inPreviousArchive(previous.RemainingMips);
+		}
 
+		// Copies the regions of an unchanged texture from the previous archive. Returns false,
+		// having written nothing, if the previous archive doesn't hold them.
+		bool SpliceTexture(TextureNode const& previous)
+		{
+			if (!this->CanSplice(previous))
+			{
+				return false;
+			}
+
+			TextureNode node = previous;
+			TextureMetadata textureMetadata;
+			for (RegionRecord& record : node.SingleMips)
+			{
+				textureMetadata.SingleMips.push_back(this->SpliceRegion(record));
+				record = ToRecord(textureMetadata.SingleMips.back());
+			}
+
+			if (node.RemainingMips.CompressedSize > 0)
+			{
+				textureMetadata.RemainingMips = this->SpliceRegion(node.RemainingMips);
+				node.RemainingMips = ToRecord(textureMetadata.RemainingMips);
+			}
+
+			D3D12_RESOURCE_DESC desc{};
+			desc.Width = node.Width;
+			desc.Height = node.Height;
+			desc.MipLevels = node.MipLevels;
+			desc.DepthOrArraySize = node.DepthOrArraySize;
+			desc.Format = static_cast<DXGI_FORMAT>(node.Format);
+			desc.SampleDesc.Count = 1;
+			desc.Dimension = static_cast<D3D12_RESOURCE_DIMENSION>(node.Dimension);
+
+			this->m_graph.AddTexture(std::move(node));
+			m_textureMetadata.push_back(std::move(textureMetadata));
 			m_textureDescs.push_back(desc);
+			this->m_numSplicedTextures++;
+
+			return true;
+		}
+
+		GpuRegion SpliceRegion(RegionRecord const& record)
+		{
+			std::vector<char> data(record.CompressedSize);
+			this->m_previousArchive->seekg(record.Offset);
+			this->m_previousArchive->read(data.data(), data.size());
+			if (!*this->m_previousArchive)
+			{
+				throw std::runtime_error("Failed to read region from previous archive");
+			}
+
+			GpuRegion r;
+			r.Compression = static_cast<Compression>(record.Compression);
+			r.Data.Offset = static_cast<uint32_t>(m_out.tellp());
+			r.CompressedSize = record.CompressedSize;
+			r.UncompressedSize = record.UncompressedSize;
+
+			m_out.write(data.data(), data.size());
+
+			return r;
+		}
+
+		static RegionRecord ToRecord(GpuRegion const& r)
+		{
+			RegionRecord record;
+			record.Offset = r.Data.Offset;
+			record.CompressedSize = r.CompressedSize;
+			record.UncompressedSize = r.UncompressedSize;
+			record.Compression = static_cast<uint8_t>(r.Compression);
+			return record;
 		}
 
 		void WriteUnstructuredGpuData(BinaryBuilder& builder);
@@ -407,7 +801,7 @@ namespace
 		void WriteCpuData(BinaryBuilder& builder);
 
 
-		arc::GpuRegion WriteTextureRegion(
+		PendingRegion GatherTextureRegion(
 			uint32_t currentSubresource,
 			uint32_t numSubresources,
 			std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> const& layouts,
@@ -437,65 +831,80 @@ namespace
 					layout.Footprint.Depth);
 			}
 
-			return WriteRegion<void>(data, name.c_str());
+			PendingRegion region;
+			region.Name = name;
+			region.UncompressedSize = static_cast<uint32_t>(data.size());
+			region.Data = std::move(data);
+			return region;
 		}
 	private:
-		template<typename T, typename C>
-		Region<T> WriteRegion(C uncompressedRegion, char const* name)
+		// Thread safe. Leaves the region uncompressed when compressing doesn't make it smaller.
+		void CompressRegion(PendingRegion& region)
 		{
-			size_t uncompressedSize = uncompressedRegion.size();
-
-			C compressedRegion;
-
-			Compression compression = m_compression;
+			region.UncompressedSize = static_cast<uint32_t>(region.Data.size());
+			region.RegionCompression = Compression::None;
+			if (m_compression == Compression::None)
+			{
+				return;
+			}
 
-			if (compression == Compression::None)
+			std::vector<char> compressed = Compress(m_compression, region.Data);
+			if (compressed.size() > region.Data.size())
 			{
-				compressedRegion = std::move(uncompressedRegion);
+				return;
 			}
-			else
+
+			if (m_verify)
 			{
-				compressedRegion = Compress(m_compression, uncompressedRegion);
-				if (compressedRegion.size() > uncompressedSize)
+				std::vector<char> roundTrip(region.Data.size());
+				if (!Codec::Decompress(ToCodec(m_compression), compressed.data(), compressed.size(), roundTrip.data(), roundTrip.size()) ||
+					roundTrip != region.Data)
 				{
-					compression = Compression::None;
-					compressedRegion = std::move(uncompressedRegion);
+					PHX_ERROR("Region '%s' failed to round trip through %s", region.Name.c_str(), Codec::ToString(ToCodec(m_compression)));
+					throw std::runtime_error("Region verification failed");
 				}
 			}
 
+			region.Data = std::move(compressed);
+			region.RegionCompression = m_compression;
+		}
+
+		template<typename T>
+		Region<T> WriteRegion(PendingRegion const& region)
+		{
 			Region<T> r;
-			r.Compression = compression;
+			r.Compression = region.RegionCompression;
 			r.Data.Offset = static_cast<uint32_t>(m_out.tellp());
-			r.CompressedSize = static_cast<uint32_t>(compressedRegion.size());
-			r.UncompressedSize = static_cast<uint32_t>(uncompressedSize);
+			r.CompressedSize = static_cast<uint32_t>(region.Data.size());
+			r.UncompressedSize = region.UncompressedSize;
 
 			if (r.Compression == Compression::None)
 			{
 				assert(r.CompressedSize == r.UncompressedSize);
 			}
 
-			m_out.write(compressedRegion.data(), compressedRegion.size());
+			m_out.write(region.Data.data(), region.Data.size());
 
 			auto toString = [](Compression c)
 				{
-					switch (c)
-					{
-					case Compression::None:
-						return "Uncompressed";
-					case Compression::GDeflate:
-						return "GDeflate";
-					case Compression::Zlib:
-						return "Zlib";
-					default:
-						throw std::runtime_error("Unknown compression format");
-					}
+					return c == Compression::None ? "Uncompressed" : Codec::ToString(ToCodec(c));
 				};
 
-			std::cout << r.Data.Offset << ":  " << name << " " << toString(r.Compression) << " " << r.UncompressedSize
+			std::cout << r.Data.Offset << ":  " << region.Name << " " << toString(r.Compression) << " " << r.UncompressedSize
 				<< " --> " << r.CompressedSize << "\n";
 
 			return r;
 		}
+
+		template<typename T, typename C>
+		Region<T> WriteRegion(C uncompressedRegion, char const* name)
+		{
+			PendingRegion region;
+			region.Name = name;
+			region.Data.assign(uncompressedRegion.begin(), uncompressedRegion.end());
+			this->CompressRegion(region);
+			return this->WriteRegion<T>(region);
+		}
 	private:
 		struct TextureMetadata
 		{
@@ -505,13 +914,21 @@ namespace
 
 		std::vector<TextureMetadata> m_textureMetadata;
 		std::vector<D3D12_RESOURCE_DESC> m_textureDescs;
+		StageTimes m_stageTimes;
 		ComPtr<ID3D12Device> m_device;
 		std::ostream& m_out;
+		std::istream* m_previousArchive;
+		uint64_t m_previousArchiveSize = 0;
+		size_t m_numSplicedTextures = 0;
+		std::atomic<size_t> m_numCachedTextures = 0;
+		ArchiveDependencyGraph& m_graph;
 		Compression m_compression;
+		bool m_verify;
 		TexConversionFlags m_extraTextureFlags;
 		uint32_t m_stagingBufferSizeBytes;
 		std::filesystem::path m_rootPath;
 		const ModelData& m_modelData;
+		DerivedDataCache* m_derivedData;
 	};
 }
 
@@ -523,6 +940,7 @@ int main(int argc, const char** argv)
 	assert(SUCCEEDED(hr));
 
 	Log::Initialize();
+	phx::Memory::Initialize({});
 	if (argc == 0)
 	{
 		PHX_INFO("Input json is expected");
@@ -534,6 +952,9 @@ int main(int argc, const char** argv)
 	const std::string inputTag = "input";
 	const std::string outputTag = "output_file";
 	const std::string compressionTag = "compression";
+	const std::string incrementalTag = "incremental";
+	const std::string verifyTag = "verify";
+	const std::string derivedDataTag = "derived_data_cache";
 	if (!inputSettings.contains(inputTag))
 	{
 		PHX_ERROR("Input is required");
@@ -549,13 +970,33 @@ int main(int argc, const char** argv)
 	const std::string& gltfInput = inputSettings[inputTag];
 	const std::string& outputFilename = inputSettings[outputTag];
 
-	bool useGDeflate = false;
+	Compression compression = Compression::None;
 	if (inputSettings.contains(compressionTag))
 	{
-		const std::string& compressionStr = inputSettings[compressionTag];
-		useGDeflate = compressionStr == "gdeflate";
+		std::string compressionStr = inputSettings[compressionTag];
+		std::transform(compressionStr.begin(), compressionStr.end(), compressionStr.begin(), [](char c) { return static_cast<char>(std::tolower(c)); });
+		if (compressionStr == "gdeflate")
+			compression = Compression::GDeflate;
+		else if (compressionStr == "lz4")
+			compression = Compression::Lz4;
+		else if (compressionStr == "zstd")
+			compression = Compression::Zstd;
+		else if (compressionStr != "none")
+		{
+			PHX_ERROR("Unknown compression '%s', expected none, gdeflate, lz4 or zstd", compressionStr.c_str());
+			return -1;
+		}
+	}
+
+	if (!Codec::IsAvailable(ToCodec(compression)))
+	{
+		PHX_ERROR("%s compression isn't available in this build", Codec::ToString(ToCodec(compression)));
+		return -1;
 	}
 
+	// Decompresses every region after compressing it, so archives can be checked on any platform.
+	bool verify = inputSettings.value(verifyTag, false);
+
 	PHX_INFO("Creating PhxArchive '%s' from '%s'", outputFilename.c_str(), gltfInput.c_str());
 	std::filesystem::path gltfInputPath(gltfInput);
 	gltfInputPath.make_preferred();
@@ -570,21 +1011,6 @@ int main(int argc, const char** argv)
 	gltfImporter.Import(gltfInput, model);
 	PHX_INFO("Importing GLTF File took %f seconds", elapsedTime.Elapsed().GetSeconds());
 
-	if (useGDeflate)
-	{
-        // Get the buffer compression interface for DSTORAGE_COMPRESSION_FORMAT_GDEFLATE
-		constexpr uint32_t NumCompressionThreads = 6;
-		SUCCEEDED(
-			DStorageCreateCompressionCodec(
-				DSTORAGE_COMPRESSION_FORMAT_GDEFLATE,
-				NumCompressionThreads,
-				IID_PPV_ARGS(&g_bufferCompression)));
-	}
-
-	Compression compression = Compression::None;
-	if (useGDeflate)
-		compression = Compression::GDeflate;
-
 
 	bool useBC = true;
 	TexConversionFlags extraTextureFlags{};
@@ -597,11 +1023,87 @@ int main(int argc, const char** argv)
 	std::filesystem::path outputPath(outputFilename);
 	outputPath.make_preferred();
 
-	std::ofstream outStream(outputPath, std::ios::out | std::ios::trunc | std::ios::binary);
+	// The dependency graph lives next to the archive. Only trust it if it describes the archive on disk.
+	std::filesystem::path depsPath = outputPath;
+	depsPath += ".deps";
+	std::filesystem::path tempOutputPath = outputPath;
+	tempOutputPath += ".tmp";
+
+	bool incremental = inputSettings.value(incrementalTag, true);
+	ArchiveDependencyGraph previousGraph(gltfInputPath.parent_path());
+	std::ifstream previousArchive;
+	if (incremental && previousGraph.Load(depsPath))
+	{
+		std::error_code ec;
+		uint64_t archiveSize = std::filesystem::file_size(outputPath, ec);
+		if (!ec && archiveSize == previousGraph.GetArchiveSize())
+		{
+			previousArchive.open(outputPath, std::ios::in | std::ios::binary);
+		}
+	}
+
+	ArchiveDependencyGraph graph(gltfInputPath.parent_path(), previousArchive.is_open() ? &previousGraph : nullptr);
+
+	// Converted textures are kept beside the output by default and shared by every archive built
+	// there. An empty path turns the cache off.
+	std::filesystem::path derivedDataPath = outputPath.parent_path() / "assets_cache";
+	if (inputSettings.contains(derivedDataTag))
+	{
+		derivedDataPath = inputSettings[derivedDataTag].get<std::string>();
+	}
+
+	std::unique_ptr<DerivedDataCache> derivedData;
+	if (!derivedDataPath.empty())
+	{
+		std::error_code ec;
+		std::filesystem::create_directories(derivedDataPath, ec);
+		// Converted textures are large and compress well, zstd keeps the cache a fraction of their size.
+		auto cacheFs = std::make_shared<CompressedFileSystem>(FileSystemFactory::CreateNativeFileSystem(), Codec::IsAvailable(Codec::Type::Zstd) ? Codec::Type::Zstd : Codec::Type::Lz4);
+		derivedData = std::make_unique<DerivedDataCache>(cacheFs, derivedDataPath);
+	}
+
+	// Geometry is rebuilt from the imported model every run; its sources are recorded so the graph
+	// covers everything the archive was built from.
+	uint64_t sourceHash = 0;
+	graph.HashSourceFile(gltfInputPath.filename().string(), sourceHash);
+	for (std::string const& bufferName : model.BufferNames)
+	{
+		graph.HashSourceFile(bufferName, sourceHash);
+	}
+
 	elapsedTime.Begin();
-	Exporter::Export(outStream, compression, extraTextureFlags, stagingBufferSize, gltfInputPath.parent_path(), model);
+	{
+		// Written beside the output so the previous archive stays readable for splicing, and intact if export fails.
+		std::ofstream outStream(tempOutputPath, std::ios::out | std::ios::trunc | std::ios::binary);
+		Exporter::Export(
+			outStream,
+			previousArchive.is_open() ? &previousArchive : nullptr,
+			graph,
+			compression,
+			verify,
+			extraTextureFlags,
+			stagingBufferSize,
+			gltfInputPath.parent_path(),
+			model,
+			derivedData.get());
+		graph.SetArchiveSize(static_cast<uint64_t>(outStream.tellp()));
+	}
+	previousArchive.close();
+
+	// Drop the old graph first: a crash before the new one is saved leaves no graph and forces a full rebuild.
+	std::error_code ec;
+	std::filesystem::remove(depsPath, ec);
+	std::filesystem::rename(tempOutputPath, outputPath);
+	if (!graph.Save(depsPath))
+	{
+		PHX_ERROR("Failed to write dependency file '%s'", depsPath.string().c_str());
+	}
+
 	PHX_INFO("Exporting Archive file '%s' took %f seconds", outputFilename, elapsedTime.Elapsed().GetSeconds());
 
+	// Saves the cache index, before the memory it lives in goes away.
+	derivedData.reset();
+	phx::Memory::Finalize();
 }
 
 // Run program: Ctrl + F5 or Debug > Start Without Debugging menu
@@ -0,0 +1,244 @@
+#include "pch.h"
+
+#include "phxArchiveDependencies.h"
+
+#include <algorithm>
+#include <fstream>
+
+#include <Core/phxLog.h>
+#include <phxStringHash.h>
+
+#include "3rdParty/nlohmann/json.hpp"
+
+using namespace phx;
+using namespace nlohmann;
+
+namespace
+{
+	constexpr size_t kHashChunkSize = 1u << 20;
+
+	json ToJson(RegionRecord const& r)
+	{
+		return json::array({ r.Offset, r.CompressedSize, r.UncompressedSize, r.Compression });
+	}
+
+	RegionRecord FromJson(json const& j)
+	{
+		RegionRecord r;
+		r.Offset = j.at(0).get<uint64_t>();
+		r.CompressedSize = j.at(1).get<uint32_t>();
+		r.UncompressedSize = j.at(2).get<uint32_t>();
+		r.Compression = j.at(3).get<uint8_t>();
+		return r;
+	}
+
+	bool HashFileContents(std::filesystem::path const& path, uint64_t& outHash)
+	{
+		std::ifstream file(path, std::ios::in | std::ios::binary);
+		if (!file)
+			return false;
+
+		std::vector<char> chunk(kHashChunkSize);
+		uint64_t hash = kFnv1a64Basis;
+		while (file)
+		{
+			file.read(chunk.data(), chunk.size());
+			hash = fnv1a_64(chunk.data(), static_cast<size_t>(file.gcount()), hash);
+		}
+
+		outHash = hash;
+		return file.eof();
+	}
+}
+
+ArchiveDependencyGraph::ArchiveDependencyGraph(std::filesystem::path const& rootPath, ArchiveDependencyGraph const* previous)
+	: m_rootPath(rootPath)
+	, m_previous(previous)
+{
+}
+
+bool ArchiveDependencyGraph::Load(std::filesystem::path const& depsPath)
+{
+	std::ifstream file(depsPath);
+	if (!file)
+		return false;
+
+	json root = json::parse(file, nullptr, false);
+	if (root.is_discarded())
+	{
+		PHX_WARN("Ignoring unreadable dependency file '%s'", depsPath.string().c_str());
+		return false;
+	}
+
+	try
+	{
+		if (root.at("version").get<uint32_t>() != ArchiveDependencies::kFormatVersion ||
+			root.at("tool_version").get<uint32_t>() != ArchiveDependencies::kToolVersion)
+		{
+			return false;
+		}
+
+		this->m_archiveSize = root.at("archive_size").get<uint64_t>();
+
+		for (json const& s : root.at("sources"))
+		{
+			SourceFileRecord& record = this->m_sources.emplace_back();
+			record.Path = s.at("path").get<std::string>();
+			record.Size = s.at("size").get<uint64_t>();
+			record.WriteTime = s.at("write_time").get<int64_t>();
+			record.ContentHash = s.at("hash").get<uint64_t>();
+			this->m_sourceLookup[record.Path] = this->m_sources.size() - 1;
+		}
+
+		for (json const& t : root.at("textures"))
+		{
+			TextureNode node;
+			node.Name = t.at("name").get<std::string>();
+			node.InputHash = t.at("input_hash").get<uint64_t>();
+			node.Width = t.at("width").get<uint64_t>();
+			node.Height = t.at("height").get<uint32_t>();
+			node.DepthOrArraySize = t.at("depth_or_array_size").get<uint16_t>();
+			node.MipLevels = t.at("mip_levels").get<uint16_t>();
+			node.Format = t.at("format").get<uint32_t>();
+			node.Dimension = t.at("dimension").get<uint32_t>();
+			for (json const& r : t.at("single_mips"))
+				node.SingleMips.push_back(FromJson(r));
+			node.RemainingMips = FromJson(t.at("remaining_mips"));
+			this->AddTexture(std::move(node));
+		}
+	}
+	catch (json::exception const& e)
+	{
+		PHX_WARN("Ignoring malformed dependency file '%s': %s", depsPath.string().c_str(), e.what());
+		this->m_sources.clear();
+		this->m_sourceLookup.clear();
+		this->m_textures.clear();
+		this->m_textureLookup.clear();
+		return false;
+	}
+
+	return true;
+}
+
+bool ArchiveDependencyGraph::Save(std::filesystem::path const& depsPath) const
+{
+	json root;
+	root["version"] = ArchiveDependencies::kFormatVersion;
+	root["tool_version"] = ArchiveDependencies::kToolVersion;
+	root["archive_size"] = this->m_archiveSize;
+
+	// Sources are hashed in whatever order threads get to them, sort so the file is stable.
+	std::vector<SourceFileRecord const*> sortedSources;
+	for (SourceFileRecord const& record : this->m_sources)
+		sortedSources.push_back(&record);
+	std::sort(sortedSources.begin(), sortedSources.end(), [](SourceFileRecord const* a, SourceFileRecord const* b) { return a->Path < b->Path; });
+
+	json& sources = root["sources"] = json::array();
+	for (SourceFileRecord const* source : sortedSources)
+	{
+		SourceFileRecord const& record = *source;
+		sources.push_back({
+			{ "path", record.Path },
+			{ "size", record.Size },
+			{ "write_time", record.WriteTime },
+			{ "hash", record.ContentHash } });
+	}
+
+	json& textures = root["textures"] = json::array();
+	for (TextureNode const& node : this->m_textures)
+	{
+		json singleMips = json::array();
+		for (RegionRecord const& r : node.SingleMips)
+			singleMips.push_back(ToJson(r));
+
+		textures.push_back({
+			{ "name", node.Name },
+			{ "input_hash", node.InputHash },
+			{ "width", node.Width },
+			{ "height", node.Height },
+			{ "depth_or_array_size", node.DepthOrArraySize },
+			{ "mip_levels", node.MipLevels },
+			{ "format", node.Format },
+			{ "dimension", node.Dimension },
+			{ "single_mips", std::move(singleMips) },
+			{ "remaining_mips", ToJson(node.RemainingMips) } });
+	}
+
+	std::ofstream file(depsPath, std::ios::out | std::ios::trunc);
+	if (!file)
+		return false;
+
+	file << root.dump(1, '\t');
+	return file.good();
+}
+
+bool ArchiveDependencyGraph::HashSourceFile(std::string const& relativePath, uint64_t& outHash)
+{
+	std::unique_lock lock(this->m_sourceMutex);
+	if (auto itr = this->m_sourceLookup.find(relativePath); itr != this->m_sourceLookup.end())
+	{
+		outHash = this->m_sources[itr->second].ContentHash;
+		return true;
+	}
+	lock.unlock();
+
+	// Hash outside the lock. Two threads hashing the same file both get the same answer.
+	std::filesystem::path nativePath = this->m_rootPath / relativePath;
+
+	std::error_code ec;
+	SourceFileRecord record;
+	record.Path = relativePath;
+	record.Size = std::filesystem::file_size(nativePath, ec);
+	if (ec)
+		return false;
+
+	record.WriteTime = std::filesystem::last_write_time(nativePath, ec).time_since_epoch().count();
+	if (ec)
+		return false;
+
+	SourceFileRecord const* previousRecord = nullptr;
+	if (this->m_previous)
+	{
+		if (auto itr = this->m_previous->m_sourceLookup.find(relativePath); itr != this->m_previous->m_sourceLookup.end())
+			previousRecord = &this->m_previous->m_sources[itr->second];
+	}
+
+	if (previousRecord && previousRecord->Size == record.Size && previousRecord->WriteTime == record.WriteTime)
+	{
+		record.ContentHash = previousRecord->ContentHash;
+	}
+	else if (!HashFileContents(nativePath, record.ContentHash))
+	{
+		return false;
+	}
+
+	outHash = record.ContentHash;
+
+	lock.lock();
+	if (this->m_sourceLookup.find(relativePath) == this->m_sourceLookup.end())
+	{
+		this->m_sources.push_back(std::move(record));
+		this->m_sourceLookup[relativePath] = this->m_sources.size() - 1;
+	}
+	return true;
+}
+
+TextureNode const* ArchiveDependencyGraph::FindUpToDateTexture(std::string const& name, uint64_t inputHash) const
+{
+	if (!this->m_previous)
+		return nullptr;
+
+	auto itr = this->m_previous->m_textureLookup.find(name);
+	if (itr == this->m_previous->m_textureLookup.end())
+		return nullptr;
+
+	TextureNode const& node = this->m_previous->m_textures[itr->second];
+	return node.InputHash == inputHash ? &node : nullptr;
+}
+
+void ArchiveDependencyGraph::AddTexture(TextureNode&& node)
+{
+	std::string name = node.Name;
+	this->m_textures.push_back(std::move(node));
+	this->m_textureLookup[std::move(name)] = this->m_textures.size() - 1;
+}
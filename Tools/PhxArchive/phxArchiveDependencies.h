@@ -0,0 +1,91 @@
+#pragma once
+
+#include <stdint.h>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace phx
+{
+	// Dependency graph recorded next to an archive so a rebuild only re-converts what changed:
+	//   archive -> regions (one node per texture) -> source files, keyed by content hash.
+	// Bump kToolVersion whenever conversion output changes so older records are rebuilt.
+	namespace ArchiveDependencies
+	{
+		constexpr uint32_t kFormatVersion = 1;
+		constexpr uint32_t kToolVersion = 1;
+	}
+
+	struct SourceFileRecord
+	{
+		std::string Path;
+		uint64_t Size = 0;
+		int64_t WriteTime = 0;
+		uint64_t ContentHash = 0;
+	};
+
+	struct RegionRecord
+	{
+		uint64_t Offset = 0;
+		uint32_t CompressedSize = 0;
+		uint32_t UncompressedSize = 0;
+		uint8_t Compression = 0;
+	};
+
+	struct TextureNode
+	{
+		std::string Name;
+		uint64_t InputHash = 0;
+
+		// Enough of the resource desc to skip loading the source image
+		uint64_t Width = 0;
+		uint32_t Height = 0;
+		uint16_t DepthOrArraySize = 0;
+		uint16_t MipLevels = 0;
+		uint32_t Format = 0;
+		uint32_t Dimension = 0;
+
+		std::vector<RegionRecord> SingleMips;
+		RegionRecord RemainingMips;	// CompressedSize == 0 when every mip is a single region
+	};
+
+	class ArchiveDependencyGraph
+	{
+	public:
+		// previous is the graph of the archive being rebuilt, used to skip hashing unchanged files
+		// and to find nodes whose regions can be spliced. May be null for a full build.
+		ArchiveDependencyGraph(std::filesystem::path const& rootPath, ArchiveDependencyGraph const* previous = nullptr);
+
+		bool Load(std::filesystem::path const& depsPath);
+		bool Save(std::filesystem::path const& depsPath) const;
+
+		// Hashes a source file relative to the root and records it as a dependency of the archive.
+		// Files whose size and write time match the previous graph reuse the recorded hash. Safe to
+		// call from several threads.
+		bool HashSourceFile(std::string const& relativePath, uint64_t& outHash);
+
+		// Returns the previous node for name if it was built from the same inputs. Safe to call from
+		// several threads.
+		TextureNode const* FindUpToDateTexture(std::string const& name, uint64_t inputHash) const;
+
+		// Nodes are saved in the order they're added, which should be archive order.
+		void AddTexture(TextureNode&& node);
+
+		// Size of the archive the graph describes, checked on load so a stale record isn't trusted.
+		uint64_t GetArchiveSize() const { return this->m_archiveSize; }
+		void SetArchiveSize(uint64_t size) { this->m_archiveSize = size; }
+
+	private:
+		std::filesystem::path m_rootPath;
+		ArchiveDependencyGraph const* m_previous;
+		uint64_t m_archiveSize = 0;
+
+		std::mutex m_sourceMutex;
+		std::vector<SourceFileRecord> m_sources;
+		std::unordered_map<std::string, size_t> m_sourceLookup;
+		std::vector<TextureNode> m_textures;
+		std::unordered_map<std::string, size_t> m_textureLookup;
+	};
+}
@@ -57,6 +57,7 @@ namespace phx
 		std::vector<MaterialTextureData> MaterialTextures;
         std::vector<Mesh*> Meshes;
         std::vector<uint8_t> TextureOptions;
+        std::vector<std::string> BufferNames;    // External buffer files the geometry was read from
 
         std::vector<GraphNode> SceneGraph;
 	};
@@ -10,6 +10,7 @@
 #include <Core/phxMath.h>
 #include <Core/phxMemory.h>
 #include <Core/phxBinaryBuilder.h>
+#include <phxMemoryResource.h>
 
 #include <RHI/PhxRHI.h>
 
@@ -102,6 +103,13 @@ bool phx::phxModelImporterGltf::Import(std::string const& filename, ModelData& o
 		return false;
 	}
 
+	for (size_t i = 0; i < this->m_gltfData->buffers_count; ++i)
+	{
+		char const* uri = this->m_gltfData->buffers[i].uri;
+		if (uri && strncmp(uri, "data:", 5) != 0)
+			outModel.BufferNames.push_back(uri);
+	}
+
 	this->BuildMaterials(outModel);
 
 	outModel.SceneGraph.resize(this->m_gltfData->scene->nodes_count);
@@ -359,7 +367,10 @@ void phx::phxModelImporterGltf::CompileMesh(
 	Sphere sphereOS;
 	AABB bboxOS;
 
-	std::vector<MeshConverter::Primitive> primitives(srcMesh.primitives_count);
+	// The primitive lists are only needed while the mesh is compiled, so they live in scratch
+	// memory that is handed back on return. The staging buffer can be large and stays on the heap.
+	ScopedScratchMemoryResource scratch;
+	pmr::Vector<MeshConverter::Primitive> primitives(srcMesh.primitives_count, &scratch);
 
 	for (size_t i = 0; i < srcMesh.primitives_count; i++)
 	{
@@ -371,7 +382,7 @@ void phx::phxModelImporterGltf::CompileMesh(
 	boundingSphere = sphereOS;
 	boundingBox = bboxOS;
 
-	std::unordered_map<uint32_t, std::vector<MeshConverter::Primitive*>> renderMeshes;
+	pmr::UnorderedMap<uint32_t, pmr::Vector<MeshConverter::Primitive*>> renderMeshes(&scratch);
 	for (auto& prim : primitives)
 	{
 		const uint32_t hash = prim.Hash;
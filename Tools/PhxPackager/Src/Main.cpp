@@ -0,0 +1,85 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <phxLog.h>
+#include <phxPackageFile.h>
+
+using namespace phx;
+
+namespace
+{
+	void PrintUsage()
+	{
+		std::printf(
+			"Usage: PhxPackager <inputDir> <output> [--alignment <bytes>]\n"
+			"  inputDir     Directory to package, entries are named relative to it.\n"
+			"  output       Package file to write.\n"
+			"  alignment    Alignment of each entry's data, must be a power of two (default %u).\n",
+			PackageFormat::kDefaultAlignment);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	Log::Initialize();
+
+	std::string inputDir;
+	std::string output;
+	uint64_t alignment = PackageFormat::kDefaultAlignment;
+	for (int i = 1; i < argc; i++)
+	{
+		const std::string arg = argv[i];
+		if (arg == "--alignment" && i + 1 < argc)
+		{
+			// long is 32 bits on Windows, parse as 64 bits so large values are rejected rather than
+			// wrapped. strtoull accepts a sign and negates, which is never a valid alignment.
+			const char* value = argv[++i];
+			char* end = nullptr;
+			alignment = std::strtoull(value, &end, 10);
+			if (value[0] == '-' || end == value || *end != '\0')
+			{
+				alignment = 0;
+			}
+		}
+		else if (inputDir.empty() && !arg.starts_with("--"))
+		{
+			inputDir = arg;
+		}
+		else if (output.empty() && !arg.starts_with("--"))
+		{
+			output = arg;
+		}
+		else
+		{
+			PrintUsage();
+			return 1;
+		}
+	}
+
+	if (inputDir.empty() || output.empty())
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	if (alignment == 0 || alignment > UINT32_MAX || (alignment & (alignment - 1)) != 0)
+	{
+		PHX_ERROR("Alignment must be a power of two");
+		return 1;
+	}
+
+	PackageBuilder builder(static_cast<uint32_t>(alignment));
+	if (!builder.AddDirectory(inputDir))
+	{
+		return 1;
+	}
+
+	if (!builder.Write(output))
+	{
+		return 1;
+	}
+
+	PHX_INFO("Packaged {} files into '{}'", builder.GetNumEntries(), output);
+	return 0;
+}